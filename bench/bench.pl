@@ -0,0 +1,233 @@
+#!/usr/bin/perl
+#
+# Copyright (c) 2010 Tama Communications Corporation
+#
+# This file is part of GNU GLOBAL.
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Benchmark harness.
+#
+# usage: bench.pl [options] work-directory
+#
+#	--bindir=DIR	top of the build directory (default: use PATH)
+#	--output=FILE	result file (default: stdout)
+#	--repeat=N	number of runs of each test; the best is taken (3)
+#	--queries=N	number of queries of each kind (20)
+#	--modify=N	number of files modified before 'gtags -i' (10)
+#	--no-htags	don't run htags
+#	--keep		don't remove the work directory
+#
+# The other options (--files, --symbols, --lang, --skew, --per-dir, --seed)
+# are passed to gensrc.pl. The result is written in JSON format:
+#
+#	{
+#	  "params": { "files": 500, ... },
+#	  "results": {
+#	    "gtags": { "seconds": 1.234567, "runs": 3 },
+#	    ...
+#	  }
+#	}
+#
+use strict;
+use Time::HiRes qw(time);
+use Cwd;
+
+my $com = $0;
+$com =~ s/.*\///;
+my $libdir = $0;
+$libdir =~ s/[^\/]*$//;
+$libdir = '.' if ($libdir eq '');
+my %opt = (
+	repeat	=> 3,
+	queries	=> 20,
+	modify	=> 10,
+	output	=> '',
+	bindir	=> '',
+);
+my %genopt = (
+	files	=> 500,
+	symbols	=> 20,
+	lang	=> 'c,cpp,java,php',
+	skew	=> 0.1,
+	'per-dir' => 50,
+	seed	=> 1,
+);
+while (@ARGV && $ARGV[0] =~ /^--/) {
+	my $arg = shift;
+	if ($arg eq '--no-htags') {
+		$opt{'no-htags'} = 1;
+	} elsif ($arg eq '--keep') {
+		$opt{keep} = 1;
+	} elsif ($arg =~ /^--([\w-]+)=(.*)$/ && exists $opt{$1}) {
+		$opt{$1} = $2;
+	} elsif ($arg =~ /^--([\w-]+)=(.*)$/ && exists $genopt{$1}) {
+		$genopt{$1} = $2;
+	} else {
+		die("$com: unknown option '$arg'\n");
+	}
+}
+die("usage: $com [options] work-directory\n") unless (@ARGV == 1);
+my $cwd = getcwd();
+my $work = $ARGV[0];
+$work = $cwd . '/' . $work unless ($work =~ /^\//);
+$opt{output} = $cwd . '/' . $opt{output} if ($opt{output} && $opt{output} !~ /^\//);
+#
+# Use the programs in the build directory if specified.
+#
+if ($opt{bindir}) {
+	my $bindir = $opt{bindir};
+	$bindir = $cwd . '/' . $bindir unless ($bindir =~ /^\//);
+	$ENV{PATH} = join(':', map { "$bindir/$_" } qw(global gtags htags)) . ":$ENV{PATH}";
+}
+delete $ENV{$_} foreach (qw(GTAGSROOT GTAGSDBPATH GTAGSLIBPATH GTAGSCONF GTAGSLABEL MAKEOBJDIRPREFIX));
+#
+# Utilities.
+#
+sub run {
+	my($cmd) = @_;
+	system("$cmd >/dev/null 2>&1") == 0 || die("$com: '$cmd' failed.\n");
+}
+sub elapsed {
+	my($code) = @_;
+	my $start = time;
+	$code->();
+	time - $start;
+}
+my %results;
+my @order;
+#
+# measure: take the best of the runs.
+#
+#	$prepare is run before each run, and isn't measured.
+#
+sub measure {
+	my($name, $code, $prepare) = @_;
+	my $best;
+	for (1 .. $opt{repeat}) {
+		$prepare->() if ($prepare);
+		my $t = elapsed($code);
+		$best = $t if (!defined($best) || $t < $best);
+	}
+	$results{$name} = $best;
+	push(@order, $name);
+	printf STDERR "%-16s %10.6f\n", $name, $best;
+}
+#
+# Generate source tree.
+#
+my $src = "$work/src";
+system('rm', '-rf', $work);
+run("$^X $libdir/gensrc.pl " . join(' ', map { "--$_=$genopt{$_}" } sort keys %genopt) . " $src");
+chdir($src) || die("$com: cannot move to '$src'\n");
+#
+# Tag files.
+#
+measure('gtags', sub { run('gtags') }, sub { unlink('GTAGS', 'GRTAGS', 'GPATH') });
+my @files = sort split(/\n/, `global -P .`);
+die("$com: no source file found.\n") unless (@files);
+my $step = @files > $opt{modify} ? int(@files / $opt{modify}) : 1;
+my $generation = 0;
+measure('gtags-i', sub { run('gtags -i') }, sub {
+	#
+	# Add a definition to the files, and make them newer than tag files.
+	#
+	$generation++;
+	my $mtime = time + 2 * $generation;
+	for (my $i = 0, my $n = 0; $i < @files && $n < $opt{modify}; $i += $step, $n++) {
+		my $f = $files[$i];
+		open(FILE, ">>$f") || die("$com: cannot open '$f'\n");
+		if ($f =~ /\.php$/) {
+			print FILE "<?php function bench_${n}_$generation(\$a) { return \$a; } ?>\n";
+		} elsif ($f =~ /\.java$/) {
+			print FILE "class Bench${n}_$generation { int bench_${n}_$generation(int a) { return a; } }\n";
+		} else {
+			print FILE "int bench_${n}_$generation(int a) { return a; }\n";
+		}
+		close(FILE);
+		utime($mtime, $mtime, $f);
+	}
+});
+#
+# Queries.
+#
+#
+# sample: pick names evenly from the list.
+#
+sub sample {
+	my(@names) = @_;
+	my @sample;
+	for (my $i = 0; $i < $opt{queries}; $i++) {
+		push(@sample, $names[int($i * @names / $opt{queries})]);
+	}
+	@sample;
+}
+my @names = sort split(/\n/, `global -c`);
+die("$com: no definition found.\n") unless (@names);
+my @sample = sample(@names);
+my @symbols = sort split(/\n/, `global -cs`);
+die("$com: no symbol found.\n") unless (@symbols);
+my @ssample = sample(@symbols);
+sub queries {
+	my($option, $make, @list) = @_;
+	@list = @sample unless (@list);
+	my @cmd = map { "global $option '" . $make->($_) . "'" } @list;
+	sub { run($_) foreach (@cmd) };
+}
+measure('global-x', queries('-x', sub { $_[0] }));
+measure('global-r', queries('-rx', sub { $_[0] }));
+measure('global-s', queries('-sx', sub { $_[0] }, @ssample));
+measure('global-c', queries('-c', sub { substr($_[0], 0, 2) }));
+measure('global-g', queries('-gx', sub { $_[0] }));
+measure('global-P', queries('-P', sub { substr($_[0], 0, 3) }));
+#
+# Hypertext.
+#
+unless ($opt{'no-htags'}) {
+	measure('htags', sub { run("htags -q -n -s $work/html") }, sub {
+		system('rm', '-rf', "$work/html");
+		mkdir("$work/html", 0755);
+	});
+}
+chdir('/');
+system('rm', '-rf', $work) unless ($opt{keep});
+#
+# Write result.
+#
+sub quote {
+	my($s) = @_;
+	$s =~ s/(["\\])/\\$1/g;
+	"\"$s\"";
+}
+my $json = "{\n";
+$json .= "  \"params\": {\n";
+$json .= join(",\n", map {
+	my $v = $genopt{$_};
+	"    " . quote($_) . ": " . ($v =~ /^\d+(\.\d+)?$/ ? $v : quote($v));
+} sort keys %genopt);
+$json .= ",\n    \"repeat\": $opt{repeat},\n    \"queries\": $opt{queries},\n    \"modify\": $opt{modify}\n";
+$json .= "  },\n";
+$json .= "  \"results\": {\n";
+$json .= join(",\n", map {
+	sprintf("    %s: { \"seconds\": %.6f, \"runs\": %d }", quote($_), $results{$_}, $opt{repeat});
+} @order);
+$json .= "\n  }\n}\n";
+if ($opt{output}) {
+	open(OUT, ">$opt{output}") || die("$com: cannot make '$opt{output}'\n");
+	print OUT $json;
+	close(OUT);
+} else {
+	print $json;
+}
+exit 0;
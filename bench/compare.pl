@@ -0,0 +1,98 @@
+#!/usr/bin/perl
+#
+# Copyright (c) 2010 Tama Communications Corporation
+#
+# This file is part of GNU GLOBAL.
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Compare a benchmark result with the baseline.
+#
+# usage: compare.pl [--threshold=PERCENT][--min=SECONDS] baseline result
+#
+#	--threshold=PERCENT	slowdown regarded as a regression (10)
+#	--min=SECONDS		ignore differences smaller than this (0.005)
+#
+# Exit status is 1 if any regression is found, else 0.
+#
+use strict;
+
+my $com = $0;
+$com =~ s/.*\///;
+my $threshold = 10;
+my $min = 0.005;
+while (@ARGV && $ARGV[0] =~ /^--/) {
+	my $arg = shift;
+	if ($arg =~ /^--threshold=(\d+(\.\d+)?)$/) {
+		$threshold = $1;
+	} elsif ($arg =~ /^--min=(\d+(\.\d+)?)$/) {
+		$min = $1;
+	} else {
+		die("$com: unknown option '$arg'\n");
+	}
+}
+die("usage: $com [--threshold=PERCENT][--min=SECONDS] baseline result\n") unless (@ARGV == 2);
+#
+# load: read the file written by bench.pl.
+#
+#	r)	(\%params, \%seconds, \@order)
+#
+sub load {
+	my($file) = @_;
+	my(%params, %seconds, @order);
+	my $section = '';
+	open(IN, $file) || die("$com: cannot open '$file'\n");
+	while (<IN>) {
+		if (/^\s*"(\w+)": \{\s*$/) {
+			$section = $1;
+		} elsif ($section eq 'params' && /^\s*"([^"]+)": "?([^",]*)"?,?$/) {
+			$params{$1} = $2;
+		} elsif ($section eq 'results' && /^\s*"([^"]+)": \{ "seconds": ([\d.]+)/) {
+			$seconds{$1} = $2;
+			push(@order, $1);
+		}
+	}
+	close(IN);
+	die("$com: no result found in '$file'\n") unless (@order);
+	(\%params, \%seconds, \@order);
+}
+my($bparams, $base) = load($ARGV[0]);
+my($rparams, $result, $order) = load($ARGV[1]);
+foreach (sort keys %$rparams) {
+	if (defined($bparams->{$_}) && $bparams->{$_} ne $rparams->{$_}) {
+		print STDERR "$com: Warning: parameter '$_' differs ($bparams->{$_} vs $rparams->{$_}).\n";
+	}
+}
+my $regressions = 0;
+printf "%-16s %10s %10s %8s\n", 'test', 'baseline', 'result', 'change';
+foreach my $name (@$order) {
+	my $new = $result->{$name};
+	my $old = $base->{$name};
+	if (!defined($old)) {
+		printf "%-16s %10s %10.6f %8s\n", $name, '-', $new, 'new';
+		next;
+	}
+	my $change = $old > 0 ? ($new - $old) / $old * 100 : 0;
+	my $mark = '';
+	if ($change > $threshold && $new - $old >= $min) {
+		$mark = ' REGRESSION';
+		$regressions++;
+	}
+	printf "%-16s %10.6f %10.6f %+7.1f%%%s\n", $name, $old, $new, $change, $mark;
+}
+if ($regressions) {
+	print "$regressions regression(s) found.\n";
+	exit 1;
+}
+exit 0;
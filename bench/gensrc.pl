@@ -0,0 +1,193 @@
+#!/usr/bin/perl
+#
+# Copyright (c) 2010 Tama Communications Corporation
+#
+# This file is part of GNU GLOBAL.
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Synthetic source tree generator for the benchmark.
+#
+# usage: gensrc.pl [options] directory
+#
+#	--files=N	number of source files (500)
+#	--symbols=N	number of definitions per file (20)
+#	--lang=LIST	languages separated by comma (c,cpp,java,php)
+#	--skew=R	ratio of definitions which take a common name (0.1)
+#			Larger value makes more duplicate names.
+#	--per-dir=N	number of files per directory (50)
+#	--seed=N	seed of the random numbers (1)
+#
+# The same options always make the same tree.
+#
+use strict;
+
+my %opt = (
+	files	=> 500,
+	symbols	=> 20,
+	lang	=> 'c,cpp,java,php',
+	skew	=> 0.1,
+	'per-dir' => 50,
+	seed	=> 1,
+);
+my $com = $0;
+$com =~ s/.*\///;
+while (@ARGV && $ARGV[0] =~ /^--([\w-]+)=(.*)$/) {
+	die("$com: unknown option '$ARGV[0]'\n") unless (exists $opt{$1});
+	$opt{$1} = $2;
+	shift;
+}
+die("usage: $com [--files=N][--symbols=N][--lang=LIST][--skew=R][--per-dir=N][--seed=N] directory\n")
+	unless (@ARGV == 1);
+my $top = $ARGV[0];
+my @langs = split(/,/, $opt{lang});
+my %suffix = (c => 'c', cpp => 'cpp', java => 'java', php => 'php');
+foreach (@langs) {
+	die("$com: unknown language '$_'\n") unless ($suffix{$_});
+}
+#
+# Portable random numbers (same sequence on every platform).
+#
+my $seed = $opt{seed};
+sub rnd {
+	my($n) = @_;
+	$seed = ($seed * 1103515245 + 12345) % 2147483648;
+	int(($seed / 2147483648) * $n);
+}
+#
+# Names.
+#
+my @syllables = qw(ab ac ad al an ar as at ba be bi bo ca ce ci co da de
+	di do el em en er es et fa fe fi fo ga ge gi go ha he hi ho il im in
+	is it la le li lo ma me mi mo na ne ni no ol om on or os pa pe pi po
+	ra re ri ro sa se si so ta te ti to ul um un ur us va ve vi vo);
+sub word {
+	my $w = '';
+	$w .= $syllables[rnd(scalar @syllables)] for (1 .. 2 + rnd(3));
+	$w;
+}
+my @common = map { word() . '_' . $_ } (1 .. 50);
+my @defined;				# names defined so far
+my %used;
+sub newname {
+	my($file) = @_;
+	my $name;
+	if (rnd(1000) < $opt{skew} * 1000) {
+		$name = $common[rnd(scalar @common)];
+		return $name unless ($used{"$file:$name"}++);
+	}
+	do {
+		$name = word() . '_' . word();
+	} while ($used{$name}++);
+	$name;
+}
+sub callee {
+	@defined ? $defined[rnd(scalar @defined)] : $common[0];
+}
+#
+# Function body in C-like syntax.
+#
+sub body {
+	my($indent, $var, @args) = @_;
+	my $s = '';
+	my $n = 2 + rnd(4);
+	$s .= "${indent}int ${var}_v = $args[0];\n";
+	for (1 .. $n) {
+		my $f = callee();
+		if (rnd(2)) {
+			$s .= "${indent}${var}_v += $f(${var}_v, $args[-1]);\n";
+		} else {
+			$s .= "${indent}if (${var}_v > $_)\n${indent}\t${var}_v = $f($args[0], ${var}_v);\n";
+		}
+	}
+	$s .= "${indent}return ${var}_v;\n";
+	$s;
+}
+my %gen;
+$gen{c} = sub {
+	my($file, $names) = @_;
+	my $s = "#include \"common.h\"\n\n";
+	$s .= "static int count_$file;\n\n";
+	foreach my $name (@$names) {
+		$s .= "int\n$name(int a, int b)\n{\n";
+		$s .= body("\t", 'x', 'a', 'b', "count_$file");
+		$s .= "}\n";
+	}
+	$s;
+};
+$gen{cpp} = sub {
+	my($file, $names) = @_;
+	my $class = 'C' . word() . "_$file";
+	my $s = "#include \"common.h\"\n\nclass $class {\npublic:\n";
+	$s .= "\tint $_(int a, int b);\n" foreach (@$names);
+	$s .= "private:\n\tint count;\n};\n";
+	foreach my $name (@$names) {
+		$s .= "int\n${class}::$name(int a, int b)\n{\n";
+		$s .= body("\t", 'x', 'a', 'b', 'count');
+		$s .= "}\n";
+	}
+	$s;
+};
+$gen{java} = sub {
+	my($file, $names) = @_;
+	my $s = "package bench;\n\npublic class J$file {\n\tprivate int count;\n";
+	foreach my $name (@$names) {
+		$s .= "\tpublic int $name(int a, int b) {\n";
+		$s .= body("\t\t", 'x', 'a', 'b', 'count');
+		$s .= "\t}\n";
+	}
+	$s .= "}\n";
+	$s;
+};
+$gen{php} = sub {
+	my($file, $names) = @_;
+	my $s = "<?php\n\$count_$file = 0;\n";
+	foreach my $name (@$names) {
+		my $b = body("\t", 'x', '$a', '$b', "\$count_$file");
+		$b =~ s/int x_v/\$x_v/;
+		$b =~ s/\bx_v\b/\$x_v/g;
+		$b =~ s/\$\$/\$/g;
+		$s .= "function $name(\$a, \$b)\n{\n$b}\n";
+	}
+	$s .= "?>\n";
+	$s;
+};
+#
+# Main procedure.
+#
+sub mkdirs {
+	my($path) = @_;
+	my $dir = '';
+	foreach (split(/\//, $path)) {
+		$dir .= ($dir eq '' && $path !~ /^\//) ? $_ : "/$_";
+		next if ($dir eq '' || -d $dir);
+		mkdir($dir, 0755) || die("$com: cannot make directory '$dir'\n");
+	}
+}
+mkdirs($top);
+open(FILE, ">$top/common.h") || die("$com: cannot make '$top/common.h'\n");
+print FILE "#define $_(a, b) ((a) + (b))\n" foreach (@common);
+close(FILE);
+for (my $i = 0; $i < $opt{files}; $i++) {
+	my $lang = $langs[$i % @langs];
+	my $d = int($i / $opt{'per-dir'});
+	my $dir = sprintf("%s/d%d/s%d", $top, int($d / 10), $d % 10);
+	my @names = map { newname($i) } (1 .. $opt{symbols});
+	mkdirs($dir);
+	open(FILE, ">$dir/f$i.$suffix{$lang}") || die("$com: cannot make '$dir/f$i.$suffix{$lang}'\n");
+	print FILE $gen{$lang}->($i, \@names);
+	close(FILE);
+	push(@defined, @names);
+}
+exit 0;
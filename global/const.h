@@ -1,6 +1,9 @@
 /* This file is generated automatically by convert.pl from global/manual.in. */
 const char *progname = "global";
 const char *usage_const = "Usage: global [-aGilnqrstTvx][-e] pattern\n\
+       global --batch [-ailnqrstTvx]\n\
+       global --callers [-aGilnqstvx] pattern\n\
+       global --callees [-aGilnqtvx] pattern\n\
        global -c[iIqsv] prefix\n\
        global -f[anqrstvx][-L file-list] files\n\
        global -g[aGilnoOqtvVx][-L file-list][-e] pattern [files]\n\
@@ -12,6 +15,30 @@ const char *help_const = "Commands:\n\
 <no command> pattern\n\
        Print objects which match to the pattern.\n\
        By default, print object definitions.\n\
+--batch\n\
+       Read queries from the standard input, one per line, and print\n\
+       the results of each query followed by an empty line.\n\
+       A query is a pattern optionally preceded by flags\n\
+       like '-rs ', which are a combination of 'c', 'i', 'r' and 's'\n\
+       and have the same meaning as the options.\n\
+       Queries are executed when an empty line or the end of input\n\
+       is read. Tag files are kept open between queries.\n\
+       This command assumes use by tools which issue many queries.\n\
+--callees pattern\n\
+       Print the references in the definitions of the objects which\n\
+       match to the pattern, that is, what the objects call.\n\
+       References to the objects which are not defined as functions\n\
+       are omitted. Definitions of unknown kind are assumed to be functions.\n\
+       Each file is examined once even if the pattern matches\n\
+       several objects in it.\n\
+--callers pattern\n\
+       Print the definitions which include the references of the\n\
+       objects which match to the pattern, that is, what calls\n\
+       the objects. By default, references which are defined are examined.\n\
+       If the -s option is specified, other symbols are examined.\n\
+       These two commands use the symbol tables (GSYMTAB) made by\n\
+       gtags(1) with the --symbol-table option if any.\n\
+       Otherwise, they parse the source files which have the objects.\n\
 -c, --completion [prefix]\n\
        Print object names which start with the specified prefix.\n\
        If prefix is not specified, print all object names.\n\
@@ -62,6 +89,14 @@ Options:\n\
        The default is extended regular expression.\n\
 -i, --ignore-case\n\
        Ignore case distinctions in the pattern.\n\
+--kind kinds\n\
+       Print only definitions of the specified kinds.\n\
+       kinds is a comma separated list of function,\n\
+       macro, type and variable, or their first letters.\n\
+       The kind is recorded by the built-in parsers; definitions found by\n\
+       plug-in parsers and tag files made in compact format (-c)\n\
+       have no kind.\n\
+       This option is valid only for the definition search.\n\
 -l, --local\n\
        Print only objects which exist under the current directory.\n\
 -L, --file-list file-list\n\
@@ -85,8 +120,12 @@ Options:\n\
        With the -p option, print the root directory of the project.\n\
 --result format\n\
        Print out using the specified format.\n\
-       format may be path, ctags, ctags-x, grep or cscope.\n\
+       format may be path, ctags, ctags-x, grep, cscope or json.\n\
        The default is path.\n\
+       The json format prints each record as a JSON object in a line,\n\
+       which has the members 'tag', 'path', 'lineno' and 'line'.\n\
+       Bytes which are not valid UTF-8 are escaped\n\
+       as if they were Latin-1 characters (U+0080 to U+00FF).\n\
        The --result=ctags and --result=ctags-x are\n\
        equivalent to the -t and -x respectively.\n\
        The --result option is given to priority more than the -t and -x option.\n\
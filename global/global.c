@@ -50,14 +50,22 @@ static void help(void);
 static void setcom(int);
 int decide_tag_by_context(const char *, const char *, int);
 int main(int, char **);
+static GTOP *open_tags(const char *, const char *, int);
+static void close_tags(GTOP *);
+static FROZEN *open_frozen(const char *);
+static void close_frozen(FROZEN *);
 void completion(const char *, const char *, const char *);
 void completion_idutils(const char *, const char *, const char *);
 void idutils(const char *, const char *);
 void grep(const char *, char *const *, const char *);
 void pathlist(const char *, const char *);
 void parsefile(char *const *, const char *, const char *, const char *, int);
+static int search_frozen(FROZEN *, const char *, const char *, const char *, const char *, int);
 int search(const char *, const char *, const char *, const char *, int);
 void tagsearch(const char *, const char *, const char *, const char *, int);
+void callsearch(const char *, const char *, const char *, const char *, int);
+void batchsearch(const char *, const char *, const char *);
+static void cachedsearch(const char *, const char *, const char *, const char *, int);
 void encode(char *, int, const char *);
 
 const char *localprefix;		/* local prefix		*/
@@ -88,8 +96,10 @@ int show_version;
 int show_help;
 int nofilter;
 int nosource;				/* undocumented command */
+int batch;				/* --batch option	*/
 int debug;
 int print0;				/* -print0 option	*/
+char kinds[8];				/* --kind option	*/
 int format;
 int type;				/* path conversion type */
 char cwd[MAXPATHLEN];			/* current directory	*/
@@ -97,6 +107,11 @@ char root[MAXPATHLEN];			/* root of source tree	*/
 char dbpath[MAXPATHLEN];		/* dbpath directory	*/
 char *context_file;
 char *context_lineno;
+const char *encode_chars;		/* --encode-path option	*/
+/*
+ * Output of results. It is a temporary file in batch mode.
+ */
+static FILE *output;
 char *file_list;
 
 static void
@@ -117,6 +132,9 @@ help(void)
 #define RESULT		128
 #define FROM_HERE	129
 #define ENCODE_PATH	130
+#define CALLERS		131
+#define CALLEES		132
+#define KIND		133
 #define SORT_FILTER     1
 #define PATH_FILTER     2
 #define BOTH_FILTER     (SORT_FILTER|PATH_FILTER)
@@ -149,8 +167,12 @@ static struct option const long_options[] = {
 	{"cxref", no_argument, NULL, 'x'},
 
 	/* long name only */
+	{"callees", no_argument, NULL, CALLEES},
+	{"callers", no_argument, NULL, CALLERS},
 	{"encode-path", required_argument, NULL, ENCODE_PATH},
 	{"from-here", required_argument, NULL, FROM_HERE},
+	{"kind", required_argument, NULL, KIND},
+	{"batch", no_argument, &batch, 1},
 	{"debug", no_argument, &debug, 1},
 	{"print0", no_argument, &print0, 1},
 	{"version", no_argument, &show_version, 1},
@@ -173,6 +195,63 @@ setcom(int c)
 	else if (command != c)
 		usage();
 }
+/*
+ * setkind: set the kinds of definitions for the --kind option.
+ *
+ *	i)	list	comma separated list of kind names
+ */
+static void
+setkind(const char *list)
+{
+	static const char *names[] = {"function", "macro", "type", "variable", NULL};
+	STRBUF *sb = strbuf_open(0);
+	const char *p, *word;
+	int i, n = 0;
+
+	for (p = list; *p; ) {
+		strbuf_reset(sb);
+		for (; *p && *p != ','; p++)
+			strbuf_putc(sb, *p);
+		if (*p == ',')
+			p++;
+		word = strbuf_value(sb);
+		/* either the name or the letter stored in GTAGS */
+		for (i = 0; names[i]; i++)
+			if (!strcmp(word, names[i]) || (word[0] == names[i][0] && word[1] == '\0'))
+				break;
+		if (names[i] == NULL)
+			die_with_code(2, "unknown kind '%s' for the --kind option.", word);
+		if (!strchr(kinds, names[i][0]))
+			kinds[n++] = names[i][0];
+	}
+	kinds[n] = '\0';
+	strbuf_close(sb);
+}
+/*
+ * match_tag: whether or not the name of a definition is the tag.
+ *
+ *	i)	name		name in the symbol table
+ *	i)	tag		tag name
+ *	i)	extractmethod	'Class::method' is also the tag 'method'
+ *	r)			1: match, 0: not match
+ */
+static int
+match_tag(const char *name, const char *tag, int extractmethod)
+{
+	const char *p;
+
+	if (!strcmp(name, tag))
+		return 1;
+	if (!extractmethod)
+		return 0;
+	if ((p = locatestring(name, ".", MATCH_LAST)) != NULL)
+		p++;
+	else if ((p = locatestring(name, "::", MATCH_LAST)) != NULL)
+		p += 2;
+	else
+		return 0;
+	return !strcmp(p, tag);
+}
 /*
  * decide_tag_by_context: decide tag type by context
  *
@@ -192,6 +271,8 @@ decide_tag_by_context(const char *tag, const char *file, int lineno)
 	char path[MAXPATHLEN], s_fid[MAXFIDLEN];
 	const char *tagline, *p;
 	DBOP *dbop;
+	SYMTAB *symtab = NULL;
+	struct symtab_entry *entry;
 	int db = GSYMS;
 	int iscompline = 0;
 
@@ -205,6 +286,10 @@ decide_tag_by_context(const char *tag, const char *file, int lineno)
 	if ((p = gpath_path2fid(path, NULL)) == NULL)
 		die("path name in the context is not found.");
 	strlimcpy(s_fid, p, sizeof(s_fid));
+	if ((p = gpath_getsymtab(s_fid)) != NULL) {
+		symtab = symtab_open();
+		symtab_decode(symtab, p);
+	}
 	gpath_close();
 	/*
 	 * read btree records directly to avoid the overhead.
@@ -212,6 +297,27 @@ decide_tag_by_context(const char *tag, const char *file, int lineno)
 	dbop = dbop_open(makepath(dbpath, dbname(GTAGS), NULL), 0, 0, 0);
 	if (dbop == NULL)
 		die("cannot open GTAGS.");
+	/*
+	 * The symbol table of the file tells whether or not the context
+	 * is a definition without reading every definition of the tag.
+	 */
+	if (symtab != NULL) {
+		if (dbop_get(dbop, tag) != NULL) {
+			int extractmethod = getconfb("extractmethod");
+
+			db = GTAGS;
+			for (entry = symtab_first(symtab); entry; entry = symtab_next(symtab)) {
+				if (entry->lineno != lineno || entry->type != SYMTAB_DEF)
+					continue;
+				if (match_tag(entry->name, tag, extractmethod)) {
+					db = GRTAGS;
+					break;
+				}
+			}
+		}
+		symtab_close(symtab);
+		goto finish;
+	}
 	if (dbop_getoption(dbop, COMPLINEKEY))
 		iscompline = 1;
 	tagline = dbop_first(dbop, tag, NULL, 0);
@@ -308,6 +414,7 @@ main(int argc, char **argv)
 	int optchar;
 	int option_index = 0;
 
+	output = stdout;
 	while ((optchar = getopt_long(argc, argv, "ace:ifgGIlL:noOpPqrstTuvVx", long_options, &option_index)) != EOF) {
 		switch (optchar) {
 		case 0:
@@ -401,12 +508,20 @@ main(int argc, char **argv)
 		case 'x':
 			xflag++;
 			break;
+		case CALLERS:
+		case CALLEES:
+			setcom(optchar);
+			break;
+		case KIND:
+			setkind(optarg);
+			break;
 		case ENCODE_PATH:
 			if (strlen(optarg) > 255)
 				die("too many encode chars.");
 			if (strchr(optarg, '/') || strchr(optarg, '.'))
 				die("cannot encode '/' and '.' in the path.");
 			set_encode_chars((unsigned char *)optarg);
+			encode_chars = optarg;
 			break;
 		case FROM_HERE:
 			{
@@ -437,6 +552,8 @@ main(int argc, char **argv)
 				format = FORMAT_GREP;
 			else if (!strcmp(optarg, "cscope"))
 				format = FORMAT_CSCOPE;
+			else if (!strcmp(optarg, "json"))
+				format = FORMAT_JSON;
 			else
 				die_with_code(2, "unknown format type for the --result option.");
 			break;
@@ -469,8 +586,12 @@ main(int argc, char **argv)
 		version(av, vflag);
 	/*
 	 * only -c, -u, -P and -p allows no argument.
+	 * In batch mode, patterns are read from the standard input.
 	 */
-	if (!av) {
+	if (batch) {
+		if (av || (command != 0 && command != 'c') || context_file)
+			usage();
+	} else if (!av) {
 		switch (command) {
 		case 'c':
 		case 'u':
@@ -497,6 +618,11 @@ main(int argc, char **argv)
 			break;
 		}
 	}
+	/*
+	 * The kinds of definitions are recorded only in GTAGS.
+	 */
+	if (kinds[0] && (command != 0 || rflag || sflag))
+		die_with_code(2, "--kind option is available only for the definition search.");
 	if (tflag)
 		xflag = 0;
 	if (nflag > 1)
@@ -552,11 +678,11 @@ main(int argc, char **argv)
 	/*
 	 * complete function name
 	 */
-	if (cflag) {
+	if (cflag && !batch) {
 		if (Iflag)
 			completion_idutils(dbpath, root, av);
 		else
-			completion(dbpath, root, av);
+			cachedsearch(av, cwd, root, dbpath, 0);
 		exit(0);
 	}
 	/*
@@ -617,10 +743,16 @@ main(int argc, char **argv)
 		type = PATH_ABSOLUTE;
 	else
 		type = PATH_RELATIVE;
+	/*
+	 * read patterns from the standard input.
+	 */
+	if (batch) {
+		batchsearch(cwd, root, dbpath);
+	}
 	/*
 	 * exec lid(idutils).
 	 */
-	if (Iflag) {
+	else if (Iflag) {
 		chdir(root);
 		idutils(av, dbpath);
 	}
@@ -645,14 +777,120 @@ main(int argc, char **argv)
 		chdir(root);
 		parsefile(argv, cwd, root, dbpath, db);
 	}
+	/*
+	 * search callers or callees.
+	 */
+	else if (command == CALLERS || command == CALLEES) {
+		callsearch(av, cwd, root, dbpath, command);
+	}
 	/*
 	 * tag search.
 	 */
 	else {
-		tagsearch(av, cwd, root, dbpath, db);
+		cachedsearch(av, cwd, root, dbpath, db);
 	}
 	return 0;
 }
+/*
+ * Tag files kept open in batch mode.
+ *
+ * In batch mode, tag files and frozen snapshots are opened only once
+ * and kept open until the end of input, so that the cache of B-tree
+ * is kept warm between queries.
+ */
+#define MAXOPENED	16
+static struct {
+	char *dbpath;
+	int db;				/* -1: frozen snapshot */
+	GTOP *gtop;
+	FROZEN *fz;
+} opened[MAXOPENED];
+static int nopened;
+
+/*
+ * open_tags: open tag file for reading
+ *
+ *	i)	dbpath	dbpath directory
+ *	i)	root	root directory
+ *	i)	db	GTAGS, GRTAGS, GSYMS or GRTAGS + GSYMS
+ *	r)		GTOP structure
+ */
+static GTOP *
+open_tags(const char *dbpath, const char *root, int db)
+{
+	GTOP *gtop;
+	int i;
+
+	if (!batch)
+		return gtags_open(dbpath, root, db, GTAGS_READ, 0);
+	for (i = 0; i < nopened; i++)
+		if (opened[i].db == db && !strcmp(opened[i].dbpath, dbpath))
+			return opened[i].gtop;
+	gtop = gtags_open(dbpath, root, db, GTAGS_READ, 0);
+	if (nopened < MAXOPENED) {
+		opened[nopened].dbpath = check_strdup(dbpath);
+		opened[nopened].db = db;
+		opened[nopened].gtop = gtop;
+		nopened++;
+	}
+	return gtop;
+}
+/*
+ * close_tags: close tag file unless it is kept open
+ *
+ *	i)	gtop	GTOP structure
+ */
+static void
+close_tags(GTOP *gtop)
+{
+	int i;
+
+	for (i = 0; i < nopened; i++)
+		if (opened[i].db >= 0 && opened[i].gtop == gtop)
+			return;
+	gtags_close(gtop);
+}
+/*
+ * open_frozen: open frozen snapshot
+ *
+ *	i)	dbpath	dbpath directory
+ *	r)		FROZEN structure, NULL: not available
+ */
+static FROZEN *
+open_frozen(const char *dbpath)
+{
+	FROZEN *fz;
+	int i;
+
+	if (!batch)
+		return frozen_open(dbpath);
+	for (i = 0; i < nopened; i++)
+		if (opened[i].db < 0 && !strcmp(opened[i].dbpath, dbpath))
+			return opened[i].fz;
+	fz = frozen_open(dbpath);
+	if (nopened < MAXOPENED) {
+		opened[nopened].dbpath = check_strdup(dbpath);
+		opened[nopened].db = -1;
+		opened[nopened].fz = fz;
+		nopened++;
+	}
+	return fz;
+}
+/*
+ * close_frozen: close frozen snapshot unless it is kept open
+ *
+ *	i)	fz	FROZEN structure
+ */
+static void
+close_frozen(FROZEN *fz)
+{
+	int i;
+
+	for (i = 0; i < nopened; i++)
+		if (opened[i].db < 0 && opened[i].fz == fz)
+			return;
+	frozen_close(fz);
+}
 /*
  * completion: print completion list of specified prefix
  *
@@ -664,8 +902,9 @@ void
 completion(const char *dbpath, const char *root, const char *prefix)
 {
 	int flags = GTOP_KEY;
-	GTOP *gtop = gtags_open(dbpath, root, (sflag) ? GSYMS : GTAGS, GTAGS_READ, 0);
+	GTOP *gtop = open_tags(dbpath, root, (sflag) ? GSYMS : GTAGS);
 	GTP *gtp;
+	FROZEN *fz;
 
 	if (prefix && *prefix == 0)	/* In the case global -c '' */
 		prefix = NULL;
@@ -686,7 +925,7 @@ completion(const char *dbpath, const char *root, const char *prefix)
 		 */
 		strbuf_putc(sb, '^');
 		strbuf_puts(sb, prefix);
-		if (regcomp(&preg, strbuf_value(sb), REG_ICASE) != 0)
+		if (dfa_regcomp(&preg, strbuf_value(sb), REG_ICASE) != 0)
 			die("invalid regular expression.");
 		/*
 		 * Two prefix reading:
@@ -705,23 +944,33 @@ completion(const char *dbpath, const char *root, const char *prefix)
 			strbuf_reset(sb);
 			strbuf_putc(sb, firstchar[i]);
 			for (gtp = gtags_first(gtop, strbuf_value(sb), flags); gtp; gtp = gtags_next(gtop)) {
-				if (regexec(&preg, gtp->tag, 0, 0, 0) == 0) {
-					fputs(gtp->tag, stdout);
-					fputc('\n', stdout);
+				if (dfa_regexec(&preg, gtp->tag) == 0) {
+					fputs(gtp->tag, output);
+					fputc('\n', output);
 				}
 			}
 		}
+		dfa_regfree(&preg);
 		strbuf_close(sb);
+	} else if ((fz = open_frozen(dbpath)) != NULL) {
+		int db = (sflag) ? GSYMS : GTAGS;
+		int i, end;
+
+		for (i = frozen_prefix(fz, db, prefix, &end); i < end; i++) {
+			fputs(frozen_keyname(fz, db, i), output);
+			fputc('\n', output);
+		}
+		close_frozen(fz);
 	} else {
 		flags |= GTOP_NOREGEX;
 		if (prefix)
 			flags |= GTOP_PREFIX;
 		for (gtp = gtags_first(gtop, prefix, flags); gtp; gtp = gtags_next(gtop)) {
-			fputs(gtp->tag, stdout);
-			fputc('\n', stdout);
+			fputs(gtp->tag, output);
+			fputc('\n', output);
 		}
 	}
-	gtags_close(gtop);
+	close_tags(gtop);
 }
 /*
  * completion_idutils: print completion list of specified prefix
@@ -868,7 +1117,7 @@ idutils(const char *pattern, const char *dbpath)
 		fprintf(stderr, "idutils: %s\n", strbuf_value(ib));
 	if (!(ip = popen(strbuf_value(ib), "r")))
 		die("cannot execute '%s'.", strbuf_value(ib));
-	cv = convert_open(type, format, root, cwd, dbpath, stdout);
+	cv = convert_open(type, format, root, cwd, dbpath, output);
 	count = 0;
 	strcpy(path, "./");
 	while ((grep = strbuf_fgets(ib, ip, STRBUF_NOCRLF)) != NULL) {
@@ -954,9 +1203,9 @@ grep(const char *pattern, char *const *argv, const char *dbpath)
 		flags |= REG_EXTENDED;
 	if (iflag)
 		flags |= REG_ICASE;
-	if (regcomp(&preg, pattern, flags) != 0)
+	if (dfa_regcomp(&preg, pattern, flags) != 0)
 		die("invalid regular expression.");
-	cv = convert_open(type, format, root, cwd, dbpath, stdout);
+	cv = convert_open(type, format, root, cwd, dbpath, output);
 	count = 0;
 
 	if (*argv && file_list)
@@ -984,7 +1233,7 @@ grep(const char *pattern, char *const *argv, const char *dbpath)
 			die("cannot open file '%s'.", path);
 		linenum = 0;
 		while ((buffer = strbuf_fgets(ib, fp, STRBUF_NOCRLF)) != NULL) {
-			int result = regexec(&preg, buffer, 0, 0, 0);
+			int result = dfa_regexec(&preg, buffer);
 
 			linenum++;
 			if ((!Vflag && result == 0) || (Vflag && result != 0)) {
@@ -1003,7 +1252,7 @@ grep(const char *pattern, char *const *argv, const char *dbpath)
 	args_close();
 	convert_close(cv);
 	strbuf_close(ib);
-	regfree(&preg);
+	dfa_regfree(&preg);
 	if (vflag) {
 		print_count(count);
 		fprintf(stderr, " (no index used).\n");
@@ -1017,11 +1266,13 @@ grep(const char *pattern, char *const *argv, const char *dbpath)
 void
 pathlist(const char *pattern, const char *dbpath)
 {
-	GFIND *gp;
+	GFIND *gp = NULL;
+	FROZEN *fz;
 	CONVERT *cv;
-	const char *path, *p;
+	const char *path, *p, *fid;
+	char fidbuf[MAXFIDLEN];
 	regex_t preg;
-	int count;
+	int count, index = 0, end = 0;
 	int target = GPATH_SOURCE;
 
 	if (oflag)
@@ -1046,22 +1297,44 @@ pathlist(const char *pattern, const char *dbpath)
 			snprintf(edit, sizeof(edit), "^/%s", pattern + 1);
 			pattern = edit;
 		}
-		if (regcomp(&preg, pattern, flags) != 0)
+		if (dfa_regcomp(&preg, pattern, flags) != 0)
 			die("invalid regular expression.");
 	}
 	if (!localprefix)
 		localprefix = "./";
-	cv = convert_open(type, format, root, cwd, dbpath, stdout);
+	cv = convert_open(type, format, root, cwd, dbpath, output);
 	count = 0;
 
-	gp = gfind_open(dbpath, localprefix, target);
-	while ((path = gfind_read(gp)) != NULL) {
+	/*
+	 * The frozen snapshot has the path table sorted like GPATH.
+	 */
+	if ((fz = frozen_open(dbpath)) != NULL)
+		index = frozen_path_prefix(fz, localprefix, &end);
+	else
+		gp = gfind_open(dbpath, localprefix, target);
+	for (;;) {
+		if (fz) {
+			const struct frozen_path *ent;
+
+			if (index >= end)
+				break;
+			ent = frozen_path(fz, index++);
+			if (!(ent->type & target))
+				continue;
+			path = frozen_string(fz, ent->name);
+			snprintf(fidbuf, sizeof(fidbuf), "%u", ent->fid);
+			fid = fidbuf;
+		} else {
+			if ((path = gfind_read(gp)) == NULL)
+				break;
+			fid = gp->dbop->lastdat;
+		}
 		/*
 		 * skip localprefix because end-user doesn't see it.
 		 */
 		p = path + strlen(localprefix) - 1;
 		if (pattern) {
-			int result = regexec(&preg, p, 0, 0, 0);
+			int result = dfa_regexec(&preg, p);
 
 			if ((!Vflag && result != 0) || (Vflag && result == 0))
 				continue;
@@ -1070,13 +1343,16 @@ pathlist(const char *pattern, const char *dbpath)
 		if (format == FORMAT_PATH)
 			convert_put_path(cv, path);
 		else
-			convert_put_using(cv, "path", path, 1, " ", gp->dbop->lastdat);
+			convert_put_using(cv, "path", path, 1, " ", fid);
 		count++;
 	}
-	gfind_close(gp);
+	if (fz)
+		frozen_close(fz);
+	else
+		gfind_close(gp);
 	convert_close(cv);
 	if (pattern)
-		regfree(&preg);
+		dfa_regfree(&preg);
 	if (vflag) {
 		switch (count) {
 		case 0:
@@ -1120,7 +1396,7 @@ put_syms(int type, const char *tag, int lno, const char *path, const char *line_
 
 	if (format == FORMAT_PATH && data->count > 0)
 		return;
-	switch (type) {
+	switch (PARSER_TYPE(type)) {
 	case PARSER_DEF:
 		if (!(data->target & TARGET_DEF))
 			return;
@@ -1162,6 +1438,61 @@ put_syms(int type, const char *tag, int lno, const char *path, const char *line_
 	convert_put_using(data->cv, tag, path, lno, line_image, data->fid);
 	data->count++;
 }
+/*
+ * put_symtab: put symbols using the symbol table made by gtags.
+ *
+ *	i)	path	path name
+ *	i)	root	root directory of source tree
+ *	i)	mtime	modification time of GTAGS
+ *	i)	data	parsefile_data
+ *	r)		1: done, 0: symbol table is not available
+ *
+ * The symbol table is not used if the file is newer than GTAGS.
+ * Line images are read from the file like the compact format.
+ */
+static int
+put_symtab(const char *path, const char *root, time_t mtime, struct parsefile_data *data)
+{
+	static SYMTAB *symtab;
+	static STRBUF *ib;
+	struct symtab_entry *entry;
+	struct stat st;
+	const char *image, *src = "";
+	FILE *fp;
+	int lineno = 0;
+
+	if (stat(makepath(root, path, NULL), &st) < 0 || st.st_mtime > mtime)
+		return 0;
+	if ((image = gpath_getsymtab(data->fid)) == NULL)
+		return 0;
+	if (symtab == NULL) {
+		symtab = symtab_open();
+		ib = strbuf_open(0);
+	}
+	symtab_decode(symtab, image);
+	if ((fp = fopen(makepath(root, path, NULL), "r")) == NULL)
+		return 0;
+	for (entry = symtab_first(symtab); entry; entry = symtab_next(symtab)) {
+		/*
+		 * The parser may go back (see symtab.c).
+		 */
+		if (entry->lineno < lineno) {
+			rewind(fp);
+			lineno = 0;
+		}
+		while (lineno < entry->lineno) {
+			if (!(src = strbuf_fgets(ib, fp, STRBUF_NOCRLF))) {
+				src = "";
+				break;
+			}
+			lineno++;
+		}
+		put_syms(entry->type == SYMTAB_DEF ? PARSER_DEF : PARSER_REF_SYM,
+			entry->name, entry->lineno, path, src, data);
+	}
+	fclose(fp);
+	return 1;
+}
 void
 parsefile(char *const *argv, const char *cwd, const char *root, const char *dbpath, int db)
 {
@@ -1172,6 +1503,8 @@ parsefile(char *const *argv, const char *cwd, const char *root, const char *dbpa
 	const char *plugin_parser, *av;
 	char path[MAXPATHLEN];
 	struct parsefile_data data;
+	struct stat st;
+	time_t gtags_mtime;
 
 	if (db == GRTAGS + GSYMS)
 		data.target = TARGET_REF|TARGET_SYM;
@@ -1187,9 +1520,16 @@ parsefile(char *const *argv, const char *cwd, const char *root, const char *dbpa
 		plugin_parser = strbuf_value(sb);
 	else
 		plugin_parser = NULL;
-	data.cv = convert_open(type, format, root, cwd, dbpath, stdout);
+	data.cv = convert_open(type, format, root, cwd, dbpath, output);
 	if (gpath_open(dbpath, 0) < 0)
 		die("GPATH not found.");
+	/*
+	 * Symbol tables made by gtags are valid for the files not newer than GTAGS.
+	 */
+	if (stat(makepath(dbpath, dbname(GTAGS), NULL), &st) < 0)
+		gtags_mtime = 0;
+	else
+		gtags_mtime = st.st_mtime;
 	if (data.target == TARGET_REF || data.target == TARGET_SYM) {
 		data.dbop = dbop_open(makepath(dbpath, dbname(GTAGS), NULL), 0, 0, 0);
 		if (data.dbop == NULL)
@@ -1245,7 +1585,8 @@ parsefile(char *const *argv, const char *cwd, const char *root, const char *dbpa
 		if (lflag && !locatestring(path, localprefix, MATCH_AT_FIRST))
 			continue;
 		data.count = 0;
-		parse_file(path, 0, put_syms, &data);
+		if (!put_symtab(path, root, gtags_mtime, &data))
+			parse_file(path, 0, put_syms, &data);
 		count += data.count;
 		file_count++;
 	}
@@ -1264,6 +1605,96 @@ parsefile(char *const *argv, const char *cwd, const char *root, const char *dbpa
 		fprintf(stderr, " (no index used).\n");
 	}
 }
+/*
+ * search_frozen: search specified tag using frozen snapshot.
+ *
+ *	i)	fz		FROZEN structure
+ *	i)	pattern		tag name (not regular expression)
+ *	i)	root		root of source tree
+ *	i)	cwd		current directory
+ *	i)	dbpath		database directory
+ *	i)	db		GTAGS,GRTAGS,GSYMS
+ *	r)			count of output lines
+ */
+static int
+search_frozen(FROZEN *fz, const char *pattern, const char *root, const char *cwd, const char *dbpath, int db)
+{
+	CONVERT *cv;
+	const struct frozen_posting *posting = NULL;
+	const char *path, *lastpath = NULL, *src = "";
+	STRBUF *ib = NULL;
+	FILE *fp = NULL;
+	char fid[MAXFIDLEN];
+	int i, n, index, lineno = 0, count = 0;
+
+	cv = convert_open(type, format, root, cwd, dbpath, output);
+	/*
+	 * A tag name is either in GRTAGS or in GSYMS.
+	 */
+	if (db == GRTAGS + GSYMS)
+		db = (frozen_lookup(fz, GRTAGS, pattern) >= 0) ? GRTAGS : GSYMS;
+	if ((index = frozen_lookup(fz, db, pattern)) < 0)
+		n = 0;
+	else
+		posting = frozen_postings(fz, db, index, &n);
+	for (i = 0; i < n; i++, posting++) {
+		if ((path = frozen_fid2path(fz, posting->fid)) == NULL)
+			die("broken snapshot. Please remake it.");
+		if (lflag && !locatestring(path, localprefix, MATCH_AT_FIRST))
+			continue;
+		if (format == FORMAT_PATH) {
+			if (path != lastpath) {
+				convert_put_path(cv, path);
+				count++;
+			}
+			lastpath = path;
+			continue;
+		}
+		if (posting->image) {
+			src = nosource ? " " : frozen_string(fz, posting->image);
+		} else if (!nosource) {
+			/*
+			 * The line image is not included in compact format.
+			 * Reopen or rewind source file.
+			 */
+			if (path != lastpath) {
+				if (fp)
+					fclose(fp);
+				fp = fopen(makepath(root, path, NULL), "r");
+				if (fp == NULL)
+					warning("source file '%s' is not available.", path);
+				if (ib == NULL)
+					ib = strbuf_open(0);
+				lineno = 0;
+				src = "";
+			} else if (posting->lineno < lineno && fp != NULL) {
+				rewind(fp);
+				lineno = 0;
+			}
+			while (fp && lineno < posting->lineno) {
+				if (!(src = strbuf_fgets(ib, fp, STRBUF_NOCRLF))) {
+					src = "";
+					fclose(fp);
+					fp = NULL;
+					break;
+				}
+				lineno++;
+			}
+		}
+		lastpath = path;
+		snprintf(fid, sizeof(fid), "%u", posting->fid);
+		convert_put_using(cv,
+			posting->name ? frozen_string(fz, posting->name) : pattern,
+			path, posting->lineno, src, fid);
+		count++;
+	}
+	convert_close(cv);
+	if (ib)
+		strbuf_close(ib);
+	if (fp)
+		fclose(fp);
+	return count;
+}
 /*
  * search: search specified function 
  *
@@ -1292,16 +1723,40 @@ search(const char *pattern, const char *root, const char *cwd, const char *dbpat
 	STRBUF *sb = NULL, *ib = NULL;
 	char curpath[MAXPATHLEN], curtag[IDENTLEN];
 	FILE *fp = NULL;
+	FROZEN *fz;
 	const char *src = "";
 	int lineno, last_lineno;
 
+	/*
+	 * Exact name can be looked up in the frozen snapshot.
+	 * It always returns sorted output, so -n uses the tag files.
+	 * It doesn't know the kinds of definitions.
+	 */
+	if (!iflag && !(nofilter & SORT_FILTER) && !kinds[0] && *pattern && !isregex(pattern)
+	    && (fz = open_frozen(dbpath)) != NULL) {
+		count = search_frozen(fz, pattern, root, cwd, dbpath, db);
+		close_frozen(fz);
+		return count;
+	}
 	lineno = last_lineno = 0;
 	curpath[0] = curtag[0] = '\0';
 	/*
 	 * open tag file.
 	 */
-	gtop = gtags_open(dbpath, root, db, GTAGS_READ, 0);
-	cv = convert_open(type, format, root, cwd, dbpath, stdout);
+	gtop = open_tags(dbpath, root, db);
+	cv = convert_open(type, format, root, cwd, dbpath, output);
+	/*
+	 * The records out of the local directory are skipped by fid,
+	 * if GPATH knows the fid range of it.
+	 */
+	if (lflag)
+		gtags_setlocal(gtop, localprefix);
+	/*
+	 * The definitions of other kinds are skipped before the line image
+	 * is read.
+	 */
+	if (db == GTAGS && gtags_setkind(gtop, kinds) < 0)
+		die("%s is compact format. It doesn't have the kinds of definitions.", dbname(GTAGS));
 	/*
 	 * search through tag file.
 	 */
@@ -1494,7 +1949,7 @@ search(const char *pattern, const char *root, const char *cwd, const char *dbpat
 		strbuf_close(ib);
 	if (fp)
 		fclose(fp);
-	gtags_close(gtop);
+	close_tags(gtop);
 	return count;
 }
 /*
@@ -1557,6 +2012,587 @@ tagsearch(const char *pattern, const char *cwd, const char *root, const char *db
 		fputs(".\n", stderr);
 	}
 }
+/*
+ * getsource: get a line of the source file.
+ *
+ *	i)	fp	source file (NULL: not available)
+ *	i)	ib	line buffer
+ *	io)	lineno	line number of the line in ib
+ *	i)	target	line number to read
+ *	r)		line image
+ */
+static const char *
+getsource(FILE *fp, STRBUF *ib, int *lineno, int target)
+{
+	if (fp == NULL)
+		return "";
+	if (target < *lineno) {
+		rewind(fp);
+		*lineno = 0;
+	}
+	while (*lineno < target) {
+		if (strbuf_fgets(ib, fp, STRBUF_NOCRLF) == NULL) {
+			strbuf_reset(ib);
+			*lineno = target;
+			break;
+		}
+		(*lineno)++;
+	}
+	return strbuf_value(ib);
+}
+/*
+ * put_symtab_entry: callback function of parse_file() for callsearch().
+ *
+ * The symbol table is made like gtags(1) does.
+ */
+static void
+put_symtab_entry(int type, const char *tag, int lno, const char *path, const char *line_image, void *arg)
+{
+	switch (PARSER_TYPE(type)) {
+	case PARSER_DEF:
+		symtab_put((SYMTAB *)arg, SYMTAB_DEF, tag, lno, PARSER_BLOCK(type));
+		break;
+	case PARSER_REF_SYM:
+		symtab_put((SYMTAB *)arg, SYMTAB_REF, tag, lno, PARSER_BLOCK(type));
+		break;
+	default:
+		break;
+	}
+}
+/*
+ * put_found: print the entries found in a file.
+ *
+ *	i)	cv	CONVERT structure
+ *	i)	symtab	symbol table of the file
+ *	i)	found	set of index of the entries
+ *	i)	path	path name
+ *	i)	fid	file id
+ *	i)	root	root of source tree
+ *	r)		count of output lines
+ */
+static int
+put_found(CONVERT *cv, SYMTAB *symtab, IDSET *found, const char *path, const char *fid, const char *root)
+{
+	static STRBUF *ib;
+	struct symtab_entry *entry;
+	unsigned int id;
+	FILE *fp = NULL;
+	int count = 0, lineno = 0;
+
+	if (idset_empty(found))
+		return 0;
+	if (format == FORMAT_PATH) {
+		convert_put_path(cv, path);
+		return 1;
+	}
+	if (ib == NULL)
+		ib = strbuf_open(0);
+	if (!nosource) {
+		fp = fopen(makepath(root, path, NULL), "r");
+		if (fp == NULL)
+			warning("source file '%s' is not available.", path);
+	}
+	for (id = idset_first(found); id != END_OF_ID; id = idset_next(found)) {
+		entry = symtab_get(symtab, id);
+		convert_put_using(cv, entry->name, path, entry->lineno,
+			getsource(fp, ib, &lineno, entry->lineno), fid);
+		count++;
+	}
+	if (fp != NULL)
+		fclose(fp);
+	return count;
+}
+/*
+ * Tag found by callsearch().
+ */
+struct callsite {
+	const char *path;
+	const char *tag;
+};
+/*
+ * compare_callsite: compare function for sorting callsites by path.
+ */
+static int
+compare_callsite(const void *v1, const void *v2)
+{
+	const struct callsite *s1 = v1, *s2 = v2;
+	int r = strcmp(s1->path, s2->path);
+
+	return r ? r : strcmp(s1->tag, s2->tag);
+}
+/*
+ * callsearch: search callers or callees of the tag.
+ *
+ *	i)	pattern	tag name
+ *	i)	cwd	current directory
+ *	i)	root	root of source tree
+ *	i)	dbpath	database directory
+ *	i)	which	CALLERS or CALLEES
+ *
+ * The callers of a tag are the definitions which enclose the references
+ * of it, and the callees are the references enclosed by the definitions
+ * of it. They are found in the symbol tables of the files (see symtab.c).
+ * The symbol tables are read from GSYMTAB if it was made by
+ * 'gtags --symbol-table', else the files are parsed.
+ * The tags are grouped by file, so that each file is examined once even if
+ * the pattern matches several tags in it.
+ * Callees which are not defined in GTAGS as functions are omitted.
+ * Definitions of unknown kind (e.g. by plug-in parsers or in GTAGS made
+ * with the -c option) are assumed to be functions.
+ */
+void
+callsearch(const char *pattern, const char *cwd, const char *root, const char *dbpath, int which)
+{
+	CONVERT *cv;
+	GTOP *gtop;
+	GTP *gtp;
+	SYMTAB *symtab = symtab_open();
+	STRBUF *sb = NULL, *key = NULL, *plugin = NULL;
+	STRHASH *seen = NULL;
+	IDSET *found = NULL;
+	VARRAY *vb = varray_open(sizeof(struct callsite), 100);
+	POOL *pool = pool_open();
+	struct callsite *site;
+	struct symtab_entry *entry, *target;
+	char curpath[MAXPATHLEN], curtag[IDENTLEN], fid[MAXFIDLEN];
+	const char *p;
+	char *langmap = NULL;
+	int extractmethod = getconfb("extractmethod");
+	int i, j, n, db, flags = 0, count = 0, parsed = 0;
+
+	/*
+	 * The callers are found from the references, and the callees are
+	 * found from the definitions.
+	 */
+	if (which == CALLERS)
+		db = sflag ? GSYMS : GRTAGS;
+	else
+		db = GTAGS;
+	gtop = gtags_open(dbpath, root, db, GTAGS_READ, 0);
+	if (which == CALLEES) {
+		seen = strhash_open(64);
+		key = strbuf_open(0);
+	}
+	cv = convert_open(type, format, root, cwd, dbpath, output);
+	if (lflag)
+		gtags_setlocal(gtop, localprefix);
+	if (nofilter & SORT_FILTER)
+		flags |= GTOP_NOSORT;
+	if (iflag) {
+		if (!isregex(pattern)) {
+			sb = strbuf_open(0);
+			strbuf_putc(sb, '^');
+			strbuf_puts(sb, pattern);
+			strbuf_putc(sb, '$');
+			pattern = strbuf_value(sb);
+		}
+		flags |= GTOP_IGNORECASE;
+	}
+	if (Gflag)
+		flags |= GTOP_BASICREGEX;
+	for (gtp = gtags_first(gtop, pattern, flags); gtp; gtp = gtags_next(gtop)) {
+		if (lflag && !locatestring(gtp->path, localprefix, MATCH_AT_FIRST))
+			continue;
+		site = varray_append(vb);
+		site->path = pool_strdup(pool, gtp->path, 0);
+		site->tag = pool_strdup(pool, gtp->tag, 0);
+	}
+	if (vb->length > 0)
+		qsort(vb->vbuf, vb->length, sizeof(struct callsite), compare_callsite);
+	curpath[0] = curtag[0] = '\0';
+	for (n = 0; n < vb->length; n++) {
+		site = varray_assign(vb, n, 0);
+		/*
+		 * Load the symbol table of the file.
+		 */
+		if (strcmp(site->path, curpath)) {
+			if (found != NULL) {
+				count += put_found(cv, symtab, found, curpath, fid, root);
+				idset_close(found);
+				found = NULL;
+			}
+			strlimcpy(curpath, site->path, sizeof(curpath));
+			curtag[0] = '\0';
+			if (seen != NULL)
+				strhash_reset(seen);
+			if ((p = gpath_path2fid(curpath, NULL)) == NULL)
+				die("GPATH is corrupted.");
+			strlimcpy(fid, p, sizeof(fid));
+			if ((p = gpath_getsymtab(fid)) != NULL) {
+				symtab_decode(symtab, p);
+			} else {
+				if (plugin == NULL) {
+					plugin = strbuf_open(0);
+					if (getconfs("langmap", plugin))
+						langmap = check_strdup(strbuf_value(plugin));
+					strbuf_reset(plugin);
+					parser_init(langmap, getconfs("gtags_parser", plugin) ? strbuf_value(plugin) : NULL);
+				}
+				symtab_reset(symtab);
+				parse_file(makepath(root, curpath, NULL), PARSER_LEVEL, put_symtab_entry, symtab);
+				parsed++;
+			}
+			if (symtab->vb->length > 0)
+				found = idset_open(symtab->vb->length);
+		}
+		/*
+		 * The symbol table has every occurrence of the tag in the file.
+		 * It is enough to examine it once for each tag.
+		 */
+		if (found == NULL || !strcmp(site->tag, curtag))
+			continue;
+		strlimcpy(curtag, site->tag, sizeof(curtag));
+		for (i = 0; (entry = symtab_get(symtab, i)) != NULL; i++) {
+			if (which == CALLERS) {
+				if (entry->type == SYMTAB_REF && !strcmp(entry->name, site->tag) && entry->scope >= 0)
+					idset_add(found, entry->scope);
+			} else if (entry->type == SYMTAB_DEF && match_tag(entry->name, site->tag, extractmethod)) {
+				/*
+				 * The enclosed entries follow the definition.
+				 * A tag which appears twice in a line is put once,
+				 * as the -r command does.
+				 */
+				for (j = i + 1; (target = symtab_get(symtab, j)) != NULL; j++) {
+					if (target->scope != i || target->type != SYMTAB_REF
+					    || !gtags_isdefined(gtop, target->name, "f"))
+						continue;
+					strbuf_reset(key);
+					strbuf_sprintf(key, "%d %s", target->lineno, target->name);
+					if (strhash_assign(seen, strbuf_value(key), 0) == NULL) {
+						strhash_assign(seen, strbuf_value(key), 1);
+						idset_add(found, j);
+					}
+				}
+			}
+		}
+	}
+	if (found != NULL) {
+		count += put_found(cv, symtab, found, curpath, fid, root);
+		idset_close(found);
+	}
+	convert_close(cv);
+	gtags_close(gtop);
+	varray_close(vb);
+	pool_close(pool);
+	if (seen != NULL)
+		strhash_close(seen);
+	if (key != NULL)
+		strbuf_close(key);
+	if (sb != NULL)
+		strbuf_close(sb);
+	symtab_close(symtab);
+	if (plugin != NULL) {
+		parser_exit();
+		strbuf_close(plugin);
+		if (langmap != NULL)
+			free(langmap);
+	}
+	if (vflag) {
+		print_count(count);
+		if (parsed)
+			fprintf(stderr, " (parsing %d files).\n", parsed);
+		else
+			fprintf(stderr, " (using symbol tables).\n");
+	}
+}
+/*
+ * Result cache (GCACHE)
+ *
+ * If the configuration variable 'result_cache_size' is set, the output of
+ * tag search and completion is kept in the result cache in the dbpath.
+ * The key is made of the pattern and everything which affects the output.
+ * The cache is bound to the generation of the tag files, so it is never
+ * used after the tag files are updated.
+ */
+/*
+ * make_cachekey: make the key of a query.
+ *
+ *	o)	sb	key
+ *	i)	pattern	pattern
+ *	i)	cwd	current directory
+ *	i)	db	GTAGS, GRTAGS, GSYMS or GRTAGS+GSYMS
+ */
+static void
+make_cachekey(STRBUF *sb, const char *pattern, const char *cwd, int db)
+{
+	strbuf_sprintf(sb, "%s %d %d %d %d %d %d %d %d %d %d %d\n",
+		cflag ? "c" : "t", db, sflag, format, type,
+		iflag, Gflag, lflag, Tflag, nofilter, nosource, print0);
+	strbuf_sprintf(sb, "%s\n%s\n%s\n", kinds, cwd, encode_chars ? encode_chars : "");
+	strbuf_puts(sb, pattern ? pattern : "");
+}
+/*
+ * cachedsearch: tag search or completion through the result cache.
+ *
+ *	i)	pattern	pattern
+ *	i)	cwd	current directory
+ *	i)	root	root directory of source tree
+ *	i)	dbpath	dbpath directory
+ *	i)	db	GTAGS, GRTAGS, GSYMS or GRTAGS+GSYMS (not used for completion)
+ *
+ * The cache is not used if the output depends on other things than
+ * the tag files in the dbpath, that is, GTAGSLIBPATH and --from-here,
+ * or if messages are printed to stderr.
+ */
+static void
+cachedsearch(const char *pattern, const char *cwd, const char *root, const char *dbpath, int db)
+{
+	RESCACHE *rc;
+	STRBUF *key;
+	FILE *fp;
+	const char *data;
+	char *buf;
+	long size;
+	int limit = 0, generation, len;
+
+	if (!getconfn("result_cache_size", &limit) || limit <= 0
+	    || vflag || context_file || (getenv("GTAGSLIBPATH") && !cflag && db == GTAGS)) {
+		if (cflag)
+			completion(dbpath, root, pattern);
+		else
+			tagsearch(pattern, cwd, root, dbpath, db);
+		return;
+	}
+	generation = 0;
+	if (gpath_open(dbpath, 0) == 0) {
+		generation = gpath_generation();
+		gpath_close();
+	}
+	rc = rescache_open(dbpath, generation, limit);
+	key = strbuf_open(0);
+	make_cachekey(key, pattern, cwd, db);
+	if ((data = rescache_get(rc, strbuf_value(key), &len)) != NULL) {
+		fwrite(data, 1, len, output);
+		goto out;
+	}
+	/*
+	 * Search into a temporary file, and save the result.
+	 */
+	if ((output = tmpfile()) == NULL)
+		die("cannot make temporary file.");
+	if (cflag)
+		completion(dbpath, root, pattern);
+	else
+		tagsearch(pattern, cwd, root, dbpath, db);
+	fp = output;
+	output = stdout;
+	if ((size = ftell(fp)) < 0 || fseek(fp, 0, SEEK_SET) < 0)
+		die("cannot seek temporary file.");
+	buf = check_malloc(size + 1);
+	if (size > 0 && fread(buf, size, 1, fp) != 1)
+		die("cannot read temporary file.");
+	fclose(fp);
+	if (generation > 0)
+		rescache_put(rc, strbuf_value(key), buf, size);
+	fwrite(buf, 1, size, output);
+	free(buf);
+out:
+	strbuf_close(key);
+	rescache_close(rc);
+}
+/*
+ * Batch mode (--batch)
+ *
+ * Each line of the standard input is a query:
+ *
+ *	[-<flags> ]<pattern>
+ *
+ * <flags> is a combination of 'c' (completion), 'i', 'r' and 's',
+ * which have the same meaning as the command line options.
+ * An empty line or the end of input executes the pending queries.
+ * They are executed in the order of tag file and pattern so that the
+ * B-tree is accessed sequentially, and the results are printed in the
+ * input order. The results of each query are followed by an empty line.
+ */
+struct query {
+	char *pattern;
+	int cflag, iflag, rflag, sflag;
+	int db;
+	long start, end;		/* position in the temporary file */
+};
+
+static int
+compare_query(const void *s1, const void *s2)
+{
+	const struct query *q1 = *(const struct query *const *)s1;
+	const struct query *q2 = *(const struct query *const *)s2;
+
+	if (q1->pattern == NULL || q2->pattern == NULL)
+		return (q1->pattern != NULL) - (q2->pattern != NULL);
+	if (q1->cflag != q2->cflag)
+		return q1->cflag - q2->cflag;
+	if (q1->db != q2->db)
+		return q1->db - q2->db;
+	return strcmp(q1->pattern, q2->pattern);
+}
+/*
+ * parse_query: parse a line of batch input.
+ *
+ *	i)	line	query line
+ *	o)	q	query
+ *	r)		0: ok, -1: error
+ */
+static int
+parse_query(const char *line, struct query *q)
+{
+	const char *p = line;
+
+	q->cflag = cflag;
+	q->iflag = iflag;
+	q->rflag = rflag;
+	q->sflag = sflag;
+	if (*p == '-') {
+		for (p++; *p && *p != ' ' && *p != '\t'; p++) {
+			switch (*p) {
+			case 'c':
+				q->cflag = 1;
+				break;
+			case 'i':
+				q->iflag = 1;
+				break;
+			case 'r':
+				q->rflag = 1;
+				break;
+			case 's':
+				q->sflag = 1;
+				break;
+			default:
+				warning("unknown flag '%c' in batch query.", *p);
+				return -1;
+			}
+		}
+	}
+	for (; *p == ' ' || *p == '\t'; p++)
+		;
+	if (q->cflag) {
+		if (isregex(p)) {
+			warning("only name char is allowed with -c option.");
+			return -1;
+		}
+	} else if (*p == '\0') {
+		warning("pattern is not specified in batch query.");
+		return -1;
+	}
+	q->pattern = check_strdup(p);
+	if (q->rflag && q->sflag)
+		q->db = GRTAGS + GSYMS;
+	else
+		q->db = (q->rflag) ? GRTAGS : ((q->sflag) ? GSYMS : GTAGS);
+	return 0;
+}
+/*
+ * run_queries: execute queries and print the results.
+ *
+ *	i)	vb	queries
+ *	i)	cwd	current directory
+ *	i)	root	root directory of source tree
+ *	i)	dbpath	dbpath directory
+ */
+static void
+run_queries(VARRAY *vb, const char *cwd, const char *root, const char *dbpath)
+{
+	struct query *queries = (struct query *)vb->vbuf;
+	struct query **order = check_malloc(sizeof(struct query *) * vb->length);
+	int save_cflag = cflag, save_iflag = iflag, save_rflag = rflag, save_sflag = sflag;
+	char buf[MAXBUFLEN];
+	int i;
+
+	if ((output = tmpfile()) == NULL)
+		die("cannot make temporary file.");
+	for (i = 0; i < vb->length; i++)
+		order[i] = &queries[i];
+	qsort(order, vb->length, sizeof(struct query *), compare_query);
+	for (i = 0; i < vb->length; i++) {
+		struct query *q = order[i];
+
+		q->start = ftell(output);
+		if (q->pattern) {
+			cflag = q->cflag;
+			iflag = q->iflag;
+			rflag = q->rflag;
+			sflag = q->sflag;
+			if (cflag)
+				completion(dbpath, root, q->pattern);
+			else
+				tagsearch(q->pattern, cwd, root, dbpath, q->db);
+		}
+		fflush(output);
+		q->end = ftell(output);
+	}
+	cflag = save_cflag;
+	iflag = save_iflag;
+	rflag = save_rflag;
+	sflag = save_sflag;
+	/*
+	 * Print the results in the input order.
+	 */
+	for (i = 0; i < vb->length; i++) {
+		struct query *q = &queries[i];
+		long rest = q->end - q->start;
+
+		if (fseek(output, q->start, SEEK_SET) < 0)
+			die("cannot seek temporary file.");
+		while (rest > 0) {
+			size_t n = fread(buf, 1, rest < (long)sizeof(buf) ? (size_t)rest : sizeof(buf), output);
+
+			if (n == 0)
+				die("cannot read temporary file.");
+			fwrite(buf, 1, n, stdout);
+			rest -= n;
+		}
+		fputc('\n', stdout);
+		if (q->pattern)
+			free(q->pattern);
+	}
+	fflush(stdout);
+	fclose(output);
+	output = stdout;
+	free(order);
+}
+/*
+ * batchsearch: execute queries read from the standard input.
+ *
+ *	i)	cwd	current directory
+ *	i)	root	root directory of source tree
+ *	i)	dbpath	dbpath directory
+ */
+void
+batchsearch(const char *cwd, const char *root, const char *dbpath)
+{
+	STRBUF *ib = strbuf_open(0);
+	VARRAY *vb = varray_open(sizeof(struct query), 100);
+	const char *line;
+	int i;
+
+	for (;;) {
+		line = strbuf_fgets(ib, stdin, STRBUF_NOCRLF);
+		if (line != NULL && *line != '\0') {
+			struct query *q = varray_append(vb);
+
+			if (parse_query(line, q) < 0)
+				q->pattern = NULL;
+			continue;
+		}
+		if (vb->length > 0) {
+			run_queries(vb, cwd, root, dbpath);
+			varray_reset(vb);
+		}
+		if (line == NULL)
+			break;
+	}
+	for (i = 0; i < nopened; i++) {
+		if (opened[i].db < 0) {
+			if (opened[i].fz)
+				frozen_close(opened[i].fz);
+		} else {
+			gtags_close(opened[i].gtop);
+		}
+		free(opened[i].dbpath);
+	}
+	nopened = 0;
+	varray_close(vb);
+	strbuf_close(ib);
+}
 /*
  * encode: string copy with converting blank chars into %ff format.
  *
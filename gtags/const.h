@@ -2,6 +2,17 @@
 const char *progname = "gtags";
 const char *usage_const = "Usage: gtags [-ciIOqvw][-d tag-file][-f file][dbpath]\n";
 const char *help_const = "Options:\n\
+--atomic\n\
+       Make each generation of tag files in a new directory\n\
+       (.gtags.N) in dbpath, and publish it at once\n\
+       by replacing GCURRENT.\n\
+       global(1) running meanwhile keeps using the generation\n\
+       which was current when it started, and never sees tag files\n\
+       being updated.\n\
+       The incremental updating copies the current generation first.\n\
+       Once tag files are published in this way, gtags and\n\
+       global -u always update them in the same way.\n\
+       Remove GCURRENT to stop it.\n\
 -c, --compact\n\
        Make GTAGS in compact format.\n\
        This option does not influence GRTAGS,\n\
@@ -17,6 +28,12 @@ const char *help_const = "Options:\n\
        The argument file can  be set to - to accept a list of\n\
        files from the standard input.\n\
        File names must be separated by newline.\n\
+--freeze\n\
+       Also make a frozen snapshot (GFROZEN) of the tag files.\n\
+       global(1) looks up tag names, completion and path names\n\
+       in the snapshot instead of tag files as long as the tag files\n\
+       are not modified after freezing.\n\
+       This is suitable for tag files which are made once and only read.\n\
 --gtagsconf file\n\
        Set the GTAGSCONF environment variable to file.\n\
 --gtagslabel label\n\
@@ -26,6 +43,9 @@ const char *help_const = "Options:\n\
 -i, --incremental\n\
        Update tag files incrementally. You had better use\n\
        global(1) with the -u option.\n\
+       If another gtags is updating the tag files, it waits for\n\
+       the end of that, and does nothing if an update which started\n\
+       after the invocation has finished meanwhile.\n\
 -O, --objdir\n\
        Use BSD-style objdir as the location of tag files.\n\
        If $MAKEOBJDIRPREFIX directory exists, gtags creates\n\
@@ -42,12 +62,24 @@ const char *help_const = "Options:\n\
 --statistics\n\
        Print statistics information.\n\
        This option is valid only for normal creation of tag files.\n\
+--symbol-table\n\
+       Also make the symbol table of each source file (GSYMTAB).\n\
+       global(1) reads it instead of parsing source files\n\
+       for the --callers, --callees and -f commands.\n\
+       Once it is made, the incremental updating keeps it up to date.\n\
 -q, --quiet\n\
        Quiet mode.\n\
 -v, --verbose\n\
        Verbose mode.\n\
 -w, --warning\n\
        Print warning messages.\n\
+--watch\n\
+       After making or updating tag files, keep running and update\n\
+       them whenever source files are created, modified or removed.\n\
+       Changes are collected until nothing happens for half a second,\n\
+       and only the changed files are examined.\n\
+       This option is available only on systems which have inotify(7),\n\
+       and cannot be used with a file list.\n\
 dbpath\n\
        The directory in which tag files are generated.\n\
        The default is the current directory.\n\
@@ -25,6 +25,8 @@
 #include <sys/stat.h>
 
 #include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <utime.h>
 #include <signal.h>
 #include <stdio.h>
@@ -49,6 +51,11 @@
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>
 #endif
+#ifdef HAVE_SYS_INOTIFY_H
+#include <sys/inotify.h>
+#include <dirent.h>
+#include <poll.h>
+#endif
 #include "getopt.h"
 
 #include "global.h"
@@ -59,9 +66,20 @@ static void usage(void);
 static void help(void);
 int main(int, char **);
 int incremental(const char *, const char *);
+static int update(const char *, const char *, int);
+static void watchtags(const char *, const char *);
+static void open_target(const char *);
+static void put_plugin_identity(STRBUF *, const char *);
+static void prepare_fragcache(const char *);
+static void open_fragcache(void);
+static void close_fragcache(void);
+static void parse_target(const char *, int, void *);
 void updatetags(const char *, const char *, IDSET *, STRBUF *);
 void createtags(const char *, const char *);
+void freezetags(const char *, const char *);
 int printconf(const char *);
+static int update_lock(const char *, int);
+static void update_unlock(int);
 
 int cflag;					/* compact format */
 int iflag;					/* incremental update */
@@ -73,6 +91,11 @@ int vflag;					/* verbose mode */
 int show_version;
 int show_help;
 int show_config;
+int freeze;
+int atomic;					/* publish atomically */
+int symbol_table;				/* make GSYMTAB */
+int watch;					/* watch mode */
+int git_index;					/* read the git index */
 char *gtagsconf;
 char *gtagslabel;
 int debug;
@@ -84,6 +107,11 @@ int statistics = STATISTICS_STYLE_NONE;
 
 #define GTAGSFILES "gtags.files"
 
+/*
+ * Paths reported by the watch mode (NULL: inspect the whole tree).
+ */
+static STRBUF *watchlist;
+
 /*
  * Path filter
  */
@@ -132,9 +160,13 @@ static struct option const long_options[] = {
 	 * The following are long name only.
 	 */
 	/* flag value */
+	{"atomic", no_argument, &atomic, 1},
 	{"debug", no_argument, &debug, 1},
+	{"freeze", no_argument, &freeze, 1},
 	{"statistics", no_argument, &statistics, STATISTICS_STYLE_TABLE},
+	{"symbol-table", no_argument, &symbol_table, 1},
 	{"version", no_argument, &show_version, 1},
+	{"watch", no_argument, &watch, 1},
 	{"help", no_argument, &show_help, 1},
 
 	/* accept value */
@@ -156,11 +188,20 @@ static struct option const long_options[] = {
 static const char *langmap = DEFAULTLANGMAP;
 static const char *gtags_parser;
 
+/*
+ * Tag fragment cache (fragment_cache)
+ */
+static char *fragcache_dir;
+static STRBUF *fingerprint;
+static unsigned long fragcache_limit;
+static FRAGCACHE *fragcache;
+
 int
 main(int argc, char **argv)
 {
 	char dbpath[MAXPATHLEN];
 	char cwd[MAXPATHLEN];
+	char top[MAXPATHLEN];
 	STRBUF *sb = strbuf_open(0);
 	int optchar;
 	int option_index = 0;
@@ -350,6 +391,18 @@ main(int argc, char **argv)
 		else if (!test("r", file_list))
 			die("'%s' is not readable.", file_list);
 	}
+	/*
+	 * The watch mode keeps the tag files up to date incrementally.
+	 */
+	if (watch) {
+#ifdef HAVE_SYS_INOTIFY_H
+		if (file_list || single_update)
+			die("--watch option cannot be used with a file list.");
+		iflag++;
+#else
+		die("--watch option is not supported on this system.");
+#endif
+	}
 	/*
 	 * Regularize the path name for single updating (--single-update).
 	 */
@@ -396,6 +449,21 @@ main(int argc, char **argv)
 		} else
 			strlimcpy(dbpath, cwd, sizeof(dbpath));
 	}
+	/*
+	 * Once the tag files are published atomically, they are always
+	 * updated in the same way. Dbpath may be a generation directory
+	 * given by 'global -u'.
+	 */
+	if (publish_top(dbpath, top, sizeof(top)))
+		strlimcpy(dbpath, top, sizeof(dbpath));
+	if (atomic || published(dbpath)) {
+		const char *current;
+
+		atomic = 1;
+		strlimcpy(top, dbpath, sizeof(top));
+		if ((current = published(top)) != NULL)
+			strlimcpy(dbpath, current, sizeof(dbpath));
+	}
 	if (iflag && (!test("f", makepath(dbpath, dbname(GTAGS), NULL)) ||
 		!test("f", makepath(dbpath, dbname(GRTAGS), NULL)) ||
 		!test("f", makepath(dbpath, dbname(GPATH), NULL)))) {
@@ -408,8 +476,9 @@ main(int argc, char **argv)
 	if (vflag)
 		fprintf(stderr, "[%s] Gtags started.\n", now());
 	/*
-	 * load configuration file.
+	 * load configuration file. Gtags may update the cache of it.
 	 */
+	set_confcache(1);
 	openconf();
 	if (getconfb("extractmethod"))
 		extractmethod = 1;
@@ -419,14 +488,25 @@ main(int argc, char **argv)
 	strbuf_reset(sb);
 	if (getconfs("gtags_parser", sb))
 		gtags_parser = check_strdup(strbuf_value(sb));
+	if (file_list == NULL && getconfb("git_index"))
+		git_index = 1;
 	/*
 	 * initialize parser.
 	 */
 	if (vflag && gtags_parser)
 		fprintf(stderr, " Using plug-in parser.\n");
 	parser_init(langmap, gtags_parser);
+	/*
+	 * The records of parsers are reused through the fragment cache.
+	 * It is not used when the messages of parsers are needed.
+	 */
+	strbuf_reset(sb);
+	if (!debug && !wflag && getconfs("fragment_cache", sb))
+		prepare_fragcache(strbuf_value(sb));
 	if (vflag && file_list)
 		fprintf(stderr, " Using '%s' as a file list.\n", file_list);
+	if (vflag && git_index)
+		fprintf(stderr, " Using the git index as a file list.\n");
 	/*
 	 * Start statistics.
 	 */
@@ -434,28 +514,38 @@ main(int argc, char **argv)
 	/*
 	 * incremental update.
 	 */
+	if (atomic)
+		strlimcpy(dbpath, top, sizeof(dbpath));
 	if (iflag) {
-		/*
-		 * Version check. If existing tag files are old enough
-		 * gtagsopen() abort with error message.
-		 */
-		GTOP *gtop = gtags_open(dbpath, cwd, GTAGS, GTAGS_MODIFY, 0);
-		gtags_close(gtop);
-		/*
-		 * GPATH is needed for incremental updating.
-		 * Gtags check whether or not GPATH exist, since it may be
-		 * removed by mistake.
-		 */
-		if (!test("f", makepath(dbpath, dbname(GPATH), NULL)))
-			die("Old version tag file found. Please remake it.");
-		(void)incremental(dbpath, cwd);
+		update(dbpath, cwd, 1);
+		if (watch)
+			watchtags(dbpath, cwd);
+		parser_exit();
 		print_statistics(statistics);
 		exit(0);
 	}
+	/*
+	 * Only one gtags updates the tag files at a time.
+	 */
+	tim = statistics_time_start("Time of waiting for the update lock");
+	update_lock(dbpath, 0);
+	statistics_time_end(tim);
+	/*
+	 * Make the next generation in a new directory.
+	 */
+	if (atomic)
+		strlimcpy(dbpath, publish_open(top), sizeof(dbpath));
 	/*
 	 * create GTAGS and GRTAGS
 	 */
+	frozen_remove(dbpath);
+	rescache_remove(dbpath);
 	createtags(dbpath, cwd);
+	/*
+	 * create frozen snapshot.
+	 */
+	if (freeze)
+		freezetags(dbpath, cwd);
 	/*
 	 * create idutils index.
 	 */
@@ -484,14 +574,494 @@ main(int argc, char **argv)
 			die("cannot chmod ID file.");
 		statistics_time_end(tim);
 	}
+	if (atomic)
+		publish_close(top, dbpath, 1);
+	update_unlock(1);
 	if (vflag)
 		fprintf(stderr, "[%s] Done.\n", now());
+	if (watch)
+		watchtags(atomic ? top : dbpath, cwd);
+	parser_exit();
 	closeconf();
 	strbuf_close(sb);
 	print_statistics(statistics);
 
 	return 0;
 }
+/*
+ * Update lock (GLOCK)
+ *
+ * Gtags takes the lock of the file GLOCK in the dbpath while updating
+ * tag files. The file has three counters:
+ *
+ *	<started> <finished> <coalesced>
+ *
+ * <started> is the number of updates which took the lock, <finished> is
+ * the number of the last update which finished successfully, and
+ * <coalesced> is the number of incremental updates which were omitted.
+ * An incremental update remembers <started> before waiting for the lock.
+ * If an update whose number is larger than that has finished when the
+ * lock is taken, it started after the request and has already done the
+ * work, so the request is coalesced into it.
+ */
+#define LOCK_NAME	"GLOCK"
+#define LOCK_FORMAT	"%10u %10u %10u\n"
+#define LOCK_SIZE	33
+
+static int lockfd = -1;
+static unsigned int lock_started, lock_finished, lock_coalesced;
+static unsigned int lock_number;		/* number of this update */
+
+/*
+ * read_counters: read the counters of the lock file.
+ */
+static void
+read_counters(void)
+{
+	char buf[LOCK_SIZE + 1];
+	int n;
+
+	lock_started = lock_finished = lock_coalesced = 0;
+	if (lseek(lockfd, 0, SEEK_SET) < 0 || (n = read(lockfd, buf, LOCK_SIZE)) <= 0)
+		return;
+	buf[n] = '\0';
+	sscanf(buf, "%u %u %u", &lock_started, &lock_finished, &lock_coalesced);
+}
+/*
+ * write_counters: write the counters of the lock file in place.
+ */
+static void
+write_counters(void)
+{
+	char buf[LOCK_SIZE + 1];
+
+	snprintf(buf, sizeof(buf), LOCK_FORMAT, lock_started, lock_finished, lock_coalesced);
+	if (lseek(lockfd, 0, SEEK_SET) < 0 || write(lockfd, buf, LOCK_SIZE) != LOCK_SIZE)
+		warning("cannot write '%s'.", LOCK_NAME);
+}
+/*
+ * update_lock: take the update lock.
+ *
+ *	i)	dir	dbpath directory
+ *	i)	coalesce 1: coalesce with another update, 0: don't
+ *	r)		1: locked, 0: coalesced
+ *
+ * If the lock file cannot be made, gtags works without the lock.
+ */
+static int
+update_lock(const char *dir, int coalesce)
+{
+#if !defined(_WIN32) && !defined(__DJGPP__)
+	struct flock fl;
+	unsigned int requested;
+
+	if ((lockfd = open(makepath(dir, LOCK_NAME, NULL), O_RDWR|O_CREAT, 0644)) < 0)
+		return 1;
+	read_counters();
+	requested = lock_started;
+	memset(&fl, 0, sizeof(fl));
+	fl.l_type = F_WRLCK;
+	fl.l_whence = SEEK_SET;
+	while (fcntl(lockfd, F_SETLKW, &fl) < 0) {
+		if (errno != EINTR) {
+			close(lockfd);
+			lockfd = -1;
+			return 1;
+		}
+	}
+	read_counters();
+	if (coalesce && lock_finished > requested) {
+		lock_coalesced++;
+		write_counters();
+		if (vflag)
+			fprintf(stderr, " Tag files have been updated by another gtags (%u of %u updates coalesced).\n",
+				lock_coalesced, lock_started + lock_coalesced);
+		close(lockfd);
+		lockfd = -1;
+		return 0;
+	}
+	lock_number = ++lock_started;
+	write_counters();
+#endif
+	return 1;
+}
+/*
+ * update_unlock: release the update lock.
+ *
+ *	i)	success	1: the update finished successfully
+ */
+static void
+update_unlock(int success)
+{
+	if (lockfd < 0)
+		return;
+	if (success) {
+		read_counters();
+		lock_finished = lock_number;
+		write_counters();
+	}
+	close(lockfd);
+	lockfd = -1;
+}
+/*
+ * update: update tag files incrementally.
+ *
+ *	i)	dir	dbpath directory (top directory in the atomic mode)
+ *	i)	root	root directory of source tree
+ *	i)	coalesce 1: coalesce with another gtags, 0: don't
+ *	r)		0: not updated, 1: updated
+ */
+static int
+update(const char *dir, const char *root, int coalesce)
+{
+	STATISTICS_TIME *tim;
+	char dbpath[MAXPATHLEN];
+	GTOP *gtop;
+	int locked, updated;
+
+	/*
+	 * Only one gtags updates the tag files at a time. If another one
+	 * updated them while waiting, the incremental update is needless.
+	 */
+	tim = statistics_time_start("Time of waiting for the update lock");
+	locked = update_lock(dir, coalesce);
+	statistics_time_end(tim);
+	if (!locked)
+		return 0;
+	strlimcpy(dbpath, dir, sizeof(dbpath));
+	/*
+	 * Make the next generation in a new directory. The current
+	 * tag files are copied for incremental updating.
+	 */
+	if (atomic) {
+		const char *current, *gendir;
+
+		if ((current = published(dir)) != NULL)
+			strlimcpy(dbpath, current, sizeof(dbpath));
+		gendir = publish_open(dir);
+		publish_copy(dbpath, gendir);
+		strlimcpy(dbpath, gendir, sizeof(dbpath));
+	}
+	/*
+	 * Version check. If existing tag files are old enough
+	 * gtagsopen() abort with error message.
+	 */
+	gtop = gtags_open(dbpath, root, GTAGS, GTAGS_MODIFY, 0);
+	gtags_close(gtop);
+	/*
+	 * GPATH is needed for incremental updating.
+	 * Gtags check whether or not GPATH exist, since it may be
+	 * removed by mistake.
+	 */
+	if (!test("f", makepath(dbpath, dbname(GPATH), NULL)))
+		die("Old version tag file found. Please remake it.");
+	updated = incremental(dbpath, root);
+	/*
+	 * The frozen snapshot is made again only when it is out of date.
+	 */
+	if (freeze) {
+		FROZEN *fz = frozen_open(dbpath);
+
+		if (fz)
+			frozen_close(fz);
+		if (updated || fz == NULL)
+			freezetags(dbpath, root);
+	} else if (updated) {
+		frozen_remove(dbpath);
+	}
+	/*
+	 * The result cache is out of date by the generation anyway.
+	 * Remove it to save disk space.
+	 */
+	if (updated)
+		rescache_remove(dbpath);
+	if (atomic)
+		publish_close(dir, dbpath, updated);
+	update_unlock(1);
+	return updated;
+}
+/*
+ * Watch mode (--watch)
+ *
+ * Gtags keeps running and updates the tag files when source files are
+ * changed. The directories which find_read() would traverse are watched
+ * by inotify(7). Events are collected until nothing happens for
+ * WATCH_DEBOUNCE milliseconds, and then only the reported paths are
+ * inspected by incremental(). If the event queue overflows or a directory
+ * is removed, the whole tree is inspected as usual.
+ */
+#ifdef HAVE_SYS_INOTIFY_H
+#define WATCH_DEBOUNCE	500
+#define WATCH_EVENTS	(IN_CREATE|IN_DELETE|IN_CLOSE_WRITE|IN_MOVED_FROM|IN_MOVED_TO|IN_DELETE_SELF|IN_MOVE_SELF)
+
+static int inotify_fd = -1;
+static VARRAY *watch_dirs;		/* watch descriptor -> directory */
+static STRHASH *watch_paths;		/* paths in the watchlist */
+static int watch_rescan;		/* 1: inspect the whole tree */
+
+/*
+ * watch_slot: get the slot of a watch descriptor.
+ */
+static char **
+watch_slot(int wd)
+{
+	while (watch_dirs->length <= wd) {
+		char **slot = varray_append(watch_dirs);
+
+		*slot = NULL;
+	}
+	return varray_assign(watch_dirs, wd, 0);
+}
+/*
+ * watch_put: put a path into the watchlist.
+ *
+ *	i)	path	path name (must start with "./")
+ */
+static void
+watch_put(const char *path)
+{
+	struct sh_entry *entry;
+	int type = find_classify(path);
+
+	if (type != FIND_SOURCE && type != FIND_OTHER)
+		return;
+	entry = strhash_assign(watch_paths, path, 1);
+	if (entry->value)
+		return;
+	entry->value = entry->name;
+	if (type == FIND_OTHER)
+		strbuf_putc(watchlist, ' ');
+	strbuf_puts0(watchlist, path);
+}
+/*
+ * watch_dir: watch a directory and its subdirectories.
+ *
+ *	i)	dir	directory (must start with "./" and end with "/")
+ *	i)	scan	1: put the files in it into the watchlist
+ */
+static void
+watch_dir(const char *dir, int scan)
+{
+	char path[MAXPATHLEN];
+	char **slot;
+	DIR *dirp;
+	struct dirent *dp;
+	struct stat st;
+	int wd;
+
+	if ((wd = inotify_add_watch(inotify_fd, dir, WATCH_EVENTS)) < 0) {
+		warning("cannot watch '%s'. (Ignored)", dir);
+		return;
+	}
+	slot = watch_slot(wd);
+	if (*slot)
+		free(*slot);
+	*slot = check_strdup(dir);
+	if ((dirp = opendir(dir)) == NULL)
+		return;
+	while ((dp = readdir(dirp)) != NULL) {
+		if (!strcmp(dp->d_name, ".") || !strcmp(dp->d_name, ".."))
+			continue;
+		snprintf(path, sizeof(path), "%s%s", dir, dp->d_name);
+		if (stat(path, &st) < 0)
+			continue;
+		if (S_ISDIR(st.st_mode)) {
+			strlimcpy(path + strlen(path), "/", sizeof(path) - strlen(path));
+			if (find_classify(path) == FIND_DIRECTORY)
+				watch_dir(path, scan);
+		} else if (scan && S_ISREG(st.st_mode)) {
+			watch_put(path);
+		}
+	}
+	closedir(dirp);
+}
+/*
+ * watch_open: start watching the source tree.
+ */
+static void
+watch_open(void)
+{
+	if ((inotify_fd = inotify_init()) < 0)
+		die("cannot initialize inotify.");
+	watch_dirs = varray_open(sizeof(char *), 100);
+	find_open_classify();
+	watch_dir("./", 0);
+	find_close();
+}
+/*
+ * watch_close: stop watching the source tree.
+ */
+static void
+watch_close(void)
+{
+	int i;
+
+	for (i = 0; i < watch_dirs->length; i++) {
+		char **slot = varray_assign(watch_dirs, i, 0);
+
+		if (*slot)
+			free(*slot);
+	}
+	varray_close(watch_dirs);
+	close(inotify_fd);
+	inotify_fd = -1;
+}
+/*
+ * watch_event: process an event.
+ *
+ *	i)	event	inotify event
+ */
+static void
+watch_event(const struct inotify_event *event)
+{
+	char path[MAXPATHLEN];
+	char **slot;
+
+	if (event->mask & IN_Q_OVERFLOW) {
+		watch_rescan = 1;
+		return;
+	}
+	if (event->wd < 0 || event->wd >= watch_dirs->length)
+		return;
+	slot = varray_assign(watch_dirs, event->wd, 0);
+	if (*slot == NULL)
+		return;
+	if (event->mask & IN_IGNORED) {
+		free(*slot);
+		*slot = NULL;
+		return;
+	}
+	if (event->mask & (IN_DELETE_SELF|IN_MOVE_SELF)) {
+		if (!strcmp(*slot, "./"))
+			watch_rescan = 1;
+		return;
+	}
+	if (event->len == 0)
+		return;
+	snprintf(path, sizeof(path), "%s%s", *slot, event->name);
+	if (event->mask & IN_ISDIR) {
+		strlimcpy(path + strlen(path), "/", sizeof(path) - strlen(path));
+		if (find_classify(path) != FIND_DIRECTORY)
+			return;
+		/*
+		 * The files in a new directory are new. The files in a
+		 * removed directory are found by inspecting the whole tree.
+		 */
+		if (event->mask & (IN_CREATE|IN_MOVED_TO))
+			watch_dir(path, 1);
+		else if (event->mask & (IN_DELETE|IN_MOVED_FROM))
+			watch_rescan = 1;
+		return;
+	}
+	watch_put(path);
+}
+/*
+ * watchtags: update tag files whenever source files are changed.
+ *
+ *	i)	dbpath	dbpath directory (top directory in the atomic mode)
+ *	i)	root	root directory of source tree
+ *
+ * This function never returns.
+ */
+static void
+watchtags(const char *dbpath, const char *root)
+{
+	union {
+		struct inotify_event event;
+		char buf[16384];
+	} u;
+	STRBUF *list;
+
+	watchlist = list = strbuf_open(0);
+	watch_paths = strhash_open(256);
+	watch_open();
+	if (vflag)
+		fprintf(stderr, "[%s] Watching '%s'.\n", now(), root);
+	for (;;) {
+		struct pollfd pfd;
+		int pending = 0;
+
+		/*
+		 * Wait for the first event, and then collect events
+		 * until nothing happens for a while.
+		 */
+		find_open_classify();
+		for (;;) {
+			const char *p, *end;
+			int n;
+
+			pfd.fd = inotify_fd;
+			pfd.events = POLLIN;
+			n = poll(&pfd, 1, pending ? WATCH_DEBOUNCE : -1);
+			if (n < 0 && errno == EINTR)
+				continue;
+			if (n < 0)
+				die("poll failed.");
+			if (n == 0)
+				break;
+			n = read(inotify_fd, u.buf, sizeof(u.buf));
+			if (n < 0 && errno == EINTR)
+				continue;
+			if (n <= 0)
+				die("cannot read inotify events.");
+			end = u.buf + n;
+			for (p = u.buf; p < end; p += sizeof(struct inotify_event) + ((const struct inotify_event *)p)->len)
+				watch_event((const struct inotify_event *)p);
+			pending = watch_rescan || strbuf_getlen(list) > 0;
+		}
+		find_close();
+		/*
+		 * Watch the whole tree again, since some directories may
+		 * have been missed.
+		 */
+		if (watch_rescan) {
+			watch_close();
+			watch_open();
+			watchlist = NULL;
+		}
+		/*
+		 * Whether a file is a target depends on the git index.
+		 * Reading it is cheap enough to do at every change.
+		 */
+		if (git_index)
+			watchlist = NULL;
+		if (vflag)
+			fprintf(stderr, "[%s] %s changed.\n", now(), watch_rescan ? "Source tree" : "Source files");
+		update(dbpath, root, 0);
+		print_statistics(statistics);
+		init_statistics();
+		watchlist = list;
+		strbuf_reset(list);
+		strhash_reset(watch_paths);
+		watch_rescan = 0;
+	}
+}
+#else
+static void
+watchtags(const char *dbpath, const char *root)
+{
+	die("--watch option is not supported on this system.");
+}
+#endif /* HAVE_SYS_INOTIFY_H */
+/*
+ * open_target: start reading target files with find_read().
+ *
+ *	i)	root	root directory of source tree
+ */
+static void
+open_target(const char *root)
+{
+	if (file_list) {
+		find_open_filelist(file_list, root);
+		return;
+	}
+	if (git_index) {
+		if (find_open_gitindex(root) == 0)
+			return;
+		warning("git index not found. Traversing the source tree.");
+	}
+	find_open(NULL);
+}
 /*
  * incremental: incremental update
  *
@@ -563,12 +1133,44 @@ incremental(const char *dbpath, const char *root)
 			idset_add(deleteset, atoi(fid));
 			total++;
 		}
+	} else if (watchlist) {
+		/*
+		 * Only the paths reported by the watch mode are inspected.
+		 * They are in the format of find_read().
+		 */
+		const char *start = strbuf_value(watchlist);
+		const char *end = start + strbuf_getlen(watchlist);
+		const char *p;
+
+		for (p = start; p < end; p += strlen(p) + 1) {
+			const char *fid;
+			int type, other = 0;
+
+			path = p;
+			if (*path == ' ') {
+				path++;
+				other = 1;
+			}
+			fid = gpath_path2fid(path, &type);
+			if (!test("f", path) || (other && test("b", path))) {
+				if (fid) {
+					strbuf_puts0(deletelist, path);
+					if (type == GPATH_SOURCE)
+						idset_add(deleteset, atoi(fid));
+				}
+			} else if (other) {
+				if (fid == NULL)
+					strbuf_puts0(addlist_other, path);
+			} else {
+				strbuf_puts0(addlist, path);
+				total++;
+				if (fid)
+					idset_add(deleteset, atoi(fid));
+			}
+		}
 	} else {
 normal_update:
-		if (file_list)
-			find_open_filelist(file_list, root);
-		else
-			find_open(NULL);
+		open_target(root);
 		while ((path = find_read()) != NULL) {
 			const char *fid;
 			int n_fid = 0;
@@ -580,7 +1182,7 @@ normal_update:
 					continue;
 				other = 1;
 			}
-			if (stat(path, &statp) < 0)
+			if (find_stat(path, &statp) < 0)
 				die("stat failed '%s'.", path);
 			fid = gpath_path2fid(path, NULL);
 			if (fid) { 
@@ -697,18 +1299,26 @@ normal_update:
 struct put_func_data {
 	GTOP *gtop[GTAGLIM];
 	const char *fid;
+	SYMTAB *symtab;			/* symbol table of the file (NULL: not made) */
 };
 static void
 put_syms(int type, const char *tag, int lno, const char *path, const char *line_image, void *arg)
 {
 	const struct put_func_data *data = arg;
 	GTOP *gtop;
+	int level = PARSER_BLOCK(type);
+	int kind = 0;
 
-	switch (type) {
+	switch (PARSER_TYPE(type)) {
 	case PARSER_DEF:
+		if (data->symtab)
+			symtab_put(data->symtab, SYMTAB_DEF, tag, lno, level);
 		gtop = data->gtop[GTAGS];
+		kind = PARSER_KIND(type);
 		break;
 	case PARSER_REF_SYM:
+		if (data->symtab)
+			symtab_put(data->symtab, SYMTAB_REF, tag, lno, level);
 		gtop = data->gtop[GRTAGS];
 		if (gtop == NULL)
 			return;
@@ -716,7 +1326,134 @@ put_syms(int type, const char *tag, int lno, const char *path, const char *line_
 	default:
 		return;
 	}
-	gtags_put_using(gtop, tag, lno, data->fid, line_image);
+	gtags_put_using(gtop, tag, lno, data->fid, line_image, kind);
+}
+/*
+ * put_plugin_identity: put the identity of plug-in parsers.
+ *
+ *	o)	sb		fingerprint
+ *	i)	pluginspec	value of gtags_parser (see load_plugin_parser())
+ *
+ * A plug-in parser rebuilt at the same path may extract other records,
+ * so the size and the modification time of the shared object are put.
+ */
+static void
+put_plugin_identity(STRBUF *sb, const char *pluginspec)
+{
+	STRBUF *spec = strbuf_open(0);
+	struct stat st;
+	char *p, *next, *dso_name, *q;
+
+	strbuf_puts(spec, pluginspec);
+	for (p = strbuf_value(spec); p != NULL; p = next) {
+		if ((next = strchr(p, ',')) != NULL)
+			*next++ = '\0';
+		if ((dso_name = strchr(p, ':')) == NULL)
+			continue;
+		dso_name++;
+		if ((q = strchr(dso_name, ':')) != NULL)
+			*q = '\0';
+		strbuf_sprintf(sb, "plugin=%s", dso_name);
+		if (stat(dso_name, &st) == 0) {
+			char buf[64];
+
+			snprintf(buf, sizeof(buf), " %lu %lu", (unsigned long)st.st_size, (unsigned long)st.st_mtime);
+			strbuf_puts(sb, buf);
+		}
+		strbuf_putc(sb, '\n');
+	}
+	strbuf_close(spec);
+}
+/*
+ * prepare_fragcache: prepare the tag fragment cache.
+ *
+ *	i)	dir	cache directory
+ *
+ * The fingerprint consists of everything which affects the records
+ * of parsers except for the contents and the suffix of files.
+ */
+static void
+prepare_fragcache(const char *dir)
+{
+	char buf[MAXBUFLEN];
+	FILE *fp;
+	int size;
+
+	fragcache_dir = check_strdup(dir);
+	fingerprint = strbuf_open(0);
+	strbuf_sprintf(fingerprint, "GLOBAL-%s\n", get_version());
+	strbuf_sprintf(fingerprint, "langmap=%s\n", langmap);
+	strbuf_sprintf(fingerprint, "gtags_parser=%s\n", gtags_parser ? gtags_parser : "");
+	if (gtags_parser)
+		put_plugin_identity(fingerprint, gtags_parser);
+	strbuf_sprintf(fingerprint, "flags=%d\n", PARSER_LEVEL);
+	if (getenv("GTAGSFORCECPP"))
+		strbuf_puts(fingerprint, "GTAGSFORCECPP\n");
+	/*
+	 * See parser_init().
+	 */
+	if ((fp = fopen(".notfunction", "r")) != NULL) {
+		strbuf_puts(fingerprint, "notfunction=\n");
+		while (fgets(buf, sizeof(buf), fp) != NULL)
+			strbuf_puts(fingerprint, buf);
+		fclose(fp);
+	}
+	if (getconfn("fragment_cache_size", &size) && size > 0)
+		fragcache_limit = (unsigned long)size * 1024 * 1024;
+}
+/*
+ * open_fragcache: open the tag fragment cache if it is specified.
+ */
+static void
+open_fragcache(void)
+{
+	if (fragcache_dir == NULL)
+		return;
+	fragcache = fragcache_open(fragcache_dir, strbuf_value(fingerprint), fragcache_limit);
+	if (fragcache == NULL)
+		warning("cannot open fragment cache '%s'. (Ignored)", fragcache_dir);
+}
+/*
+ * close_fragcache: close the tag fragment cache.
+ */
+static void
+close_fragcache(void)
+{
+	if (fragcache == NULL)
+		return;
+	if (vflag)
+		fprintf(stderr, " %d files were read from the fragment cache.\n", fragcache->hits);
+	fragcache_close(fragcache);
+	fragcache = NULL;
+}
+/*
+ * record_syms: callback function which records tags into the fragment cache.
+ */
+static void
+record_syms(int type, const char *tag, int lno, const char *path, const char *line_image, void *arg)
+{
+	fragcache_put(fragcache, type, tag, lno, line_image);
+	put_syms(type, tag, lno, path, line_image, arg);
+}
+/*
+ * parse_target: extract tags of a file.
+ *
+ *	i)	path	path name
+ *	i)	flags	flags for parse_file()
+ *	i)	data	put_func_data structure
+ *
+ * If the file is found in the fragment cache, the records are
+ * replayed instead of parsing the file.
+ */
+static void
+parse_target(const char *path, int flags, void *data)
+{
+	if (fragcache == NULL) {
+		parse_file(path, flags, put_syms, data);
+	} else if (!fragcache_get(fragcache, path, put_syms, data)) {
+		parse_file(path, flags, record_syms, data);
+		fragcache_commit(fragcache);
+	}
 }
 /*
  * updatetags: update tag file.
@@ -777,14 +1514,20 @@ updatetags(const char *dbpath, const char *root, IDSET *deleteset, STRBUF *addli
 	if (extractmethod)
 		data.gtop[GTAGS]->flags |= GTAGS_EXTRACTMETHOD;
 	data.gtop[GRTAGS]->flags = data.gtop[GTAGS]->flags;
-	flags = 0;
+	/*
+	 * The block level of tags is needed to know the enclosing definitions.
+	 */
+	flags = PARSER_LEVEL;
 	if (debug)
 		flags |= PARSER_DEBUG;
 	if (wflag)
 		flags |= PARSER_WARNING;
 	/*
 	 * Add tags to GTAGS and GRTAGS.
+	 * GSYMTAB is kept up to date once it was made.
 	 */
+	data.symtab = (symbol_table || gpath_symtab()) ? symtab_open() : NULL;
+	open_fragcache();
 	start = strbuf_value(addlist);
 	end = start + strbuf_getlen(addlist);
 	seqno = 0;
@@ -797,12 +1540,18 @@ updatetags(const char *dbpath, const char *root, IDSET *deleteset, STRBUF *addli
 			fprintf(stderr, " [%d/%d] extracting tags of %s\n", ++seqno, total, path + 2);
 		if (debug)
 			fprintf(stderr, "[%s]\n", path + 2);
-		parse_file(path, flags, put_syms, &data);
+		parse_target(path, flags, &data);
 		gtags_flush(data.gtop[GTAGS], data.fid);
 		if (data.gtop[GRTAGS] != NULL)
 			gtags_flush(data.gtop[GRTAGS], data.fid);
+		if (data.symtab) {
+			gpath_putsymtab(data.fid, symtab_encode(data.symtab));
+			symtab_reset(data.symtab);
+		}
 	}
-	parser_exit();
+	close_fragcache();
+	if (data.symtab)
+		symtab_close(data.symtab);
 	gtags_close(data.gtop[GTAGS]);
 	if (data.gtop[GRTAGS] != NULL)
 		gtags_close(data.gtop[GRTAGS]);
@@ -832,7 +1581,10 @@ createtags(const char *dbpath, const char *root)
 		data.gtop[GTAGS]->flags |= GTAGS_EXTRACTMETHOD;
 	data.gtop[GRTAGS] = gtags_open(dbpath, root, GRTAGS, GTAGS_CREATE, openflags);
 	data.gtop[GRTAGS]->flags = data.gtop[GTAGS]->flags;
-	flags = 0;
+	/*
+	 * The block level of tags is needed to know the enclosing definitions.
+	 */
+	flags = PARSER_LEVEL;
 	if (debug)
 		flags |= PARSER_DEBUG;
 	if (wflag)
@@ -840,10 +1592,9 @@ createtags(const char *dbpath, const char *root)
 	/*
 	 * Add tags to GTAGS and GRTAGS.
 	 */
-	if (file_list)
-		find_open_filelist(file_list, root);
-	else
-		find_open(NULL);
+	data.symtab = symbol_table ? symtab_open() : NULL;
+	open_fragcache();
+	open_target(root);
 	seqno = 0;
 	while ((path = find_read()) != NULL) {
 		if (*path == ' ') {
@@ -861,12 +1612,18 @@ createtags(const char *dbpath, const char *root)
 			fprintf(stderr, " [%d] extracting tags of %s\n", seqno, path + 2);
 		if (debug)
 			fprintf(stderr, "[%s]\n", path + 2);
-		parse_file(path, flags, put_syms, &data);
+		parse_target(path, flags, &data);
 		gtags_flush(data.gtop[GTAGS], data.fid);
 		gtags_flush(data.gtop[GRTAGS], data.fid);
+		if (data.symtab) {
+			gpath_putsymtab(data.fid, symtab_encode(data.symtab));
+			symtab_reset(data.symtab);
+		}
 	}
 	total = seqno;
-	parser_exit();
+	close_fragcache();
+	if (data.symtab)
+		symtab_close(data.symtab);
 	find_close();
 	statistics_time_end(tim);
 	tim = statistics_time_start("Time of flushing B-tree cache");
@@ -915,3 +1672,19 @@ printconf(const char *name)
 	}
 	return exist;
 }
+/*
+ * freezetags: create frozen snapshot of tag files
+ *
+ *	i)	dbpath	dbpath directory
+ *	i)	root	root directory of source tree
+ */
+void
+freezetags(const char *dbpath, const char *root)
+{
+	STATISTICS_TIME *tim = statistics_time_start("Time of creating %s", FROZEN_NAME);
+
+	if (vflag)
+		fprintf(stderr, "[%s] Creating '%s'.\n", now(), FROZEN_NAME);
+	frozen_create(dbpath, root);
+	statistics_time_end(tim);
+}
@@ -37,7 +37,24 @@
 #include "htags.h"
 #include "path2url.h"
 
-static XARGS *anchor_input[GTAGLIM];
+/*
+ * Anchor records of all files.
+ *
+ * Anchor_prepare() reads GTAGS and GRTAGS at once and arranges the records
+ * by the file id. Anchor_load() picks up the records of a file from them.
+ */
+struct anchor_record {
+	int fid;			/* file id			*/
+	int lineno;			/* line number			*/
+	int type;			/* 0: definition (not decided yet) */
+	const char *tag;		/* tag name (in record_names)	*/
+};
+static VARRAY *records;			/* records in reading order	*/
+static struct anchor_record *record_table;	/* records sorted by fid */
+static int *record_index;		/* fid -> first record		*/
+static int record_fids;			/* size of record_index - 1	*/
+static STRHASH *record_names;		/* pool of tag names		*/
+
 static struct anchor *table;
 static VARRAY *vb;
 
@@ -60,43 +77,155 @@ static int LAST;
 static struct anchor *CURRENTDEF;
 
 /*
- * anchor_prepare: setup input stream.
+ * put_record: put a record into the anchor records.
+ *
+ *	i)	fid	file id
+ *	i)	lineno	line number
+ *	i)	type	anchor type
+ *	i)	tag	tag name
+ */
+static void
+put_record(int fid, int lineno, int type, const char *tag)
+{
+	struct anchor_record *r = varray_append(records);
+
+	r->fid = fid;
+	r->lineno = lineno;
+	r->type = type;
+	r->tag = tag;
+	if (fid > record_fids)
+		record_fids = fid;
+}
+/*
+ * kindtype: anchor type of the kind of a definition.
+ *
+ *	i)	kind	kind letter in GTAGS
+ *	r)		D: function, M: macro, T: type, 0: unknown
+ */
+static int
+kindtype(int kind)
+{
+	switch (kind) {
+	case 'f':
+		return 'D';
+	case 'm':
+		return 'M';
+	case 't':
+	case 'v':
+		return 'T';
+	default:
+		return 0;
+	}
+}
+/*
+ * load_records: load the records of a tag file.
+ *
+ *	i)	db	GTAGS or GRTAGS
+ *
+ * The type of definitions is taken from the kind written by gtags(1).
+ * If it is unknown, it is decided later by anchor_load().
+ * In GRTAGS, the tags defined in GTAGS are references (R) and
+ * the others are symbols (Y).
+ */
+static void
+load_records(int db)
+{
+	GTOP *gtop = gtags_open(dbpath, cwdpath, db, GTAGS_READ, 0);
+	DBOP *dbop = gtop->dbop;
+	const char *tagline;
+	char prev[IDENTLEN];
+	int type = 0;
+
+	prev[0] = '\0';
+	for (tagline = dbop_first(dbop, NULL, NULL, 0); tagline; tagline = dbop_next(dbop)) {
+		const char *key = dbop->lastkey;
+		const char *tag;
+		GTREC rec;
+		int ok, fid;
+
+		if (db == GRTAGS && strcmp(key, prev)) {
+			strlimcpy(prev, key, sizeof(prev));
+			type = dbop_get(gtop->gtags, key) ? 'R' : 'Y';
+		}
+		if (type && gtags_exist[type == 'R' ? GRTAGS : GSYMS] != 1)
+			continue;
+		ok = gtags_decode(gtop, &rec, tagline, key, NULL);
+		if (!ok)
+			continue;
+		fid = atoi(rec.fid);
+		tag = strhash_assign(record_names, rec.name, 1)->name;
+		for (; ok; ok = gtags_decode_next(&rec))
+			put_record(fid, rec.lineno, db == GTAGS ? kindtype(rec.kind) : type, tag);
+	}
+	gtags_close(gtop);
+}
+/*
+ * anchor_prepare: load anchor records of all files.
  *
- *	i)	anchor_stream	file pointer of path list
+ * Htags(1) doesn't invoke the parser. The tags are read from the tag files
+ * made by gtags(1), so that the anchors agree with the other indexes.
  */
 void
-anchor_prepare(FILE *anchor_stream)
+anchor_prepare(void)
 {
+	struct anchor_record *r;
+	int i, fid, n;
+
+	records = varray_open(sizeof(struct anchor_record), 10000);
+	record_names = strhash_open(2048);
+	record_fids = 0;
+	if (gtags_exist[GTAGS] == 1)
+		load_records(GTAGS);
+	if (gtags_exist[GRTAGS] == 1 || gtags_exist[GSYMS] == 1)
+		load_records(GRTAGS);
 	/*
-	 * Option table:
-	 * We use blank string as null option instead of null string("")
-	 * not to change the command length. This length influences
-	 * the number of arguments in the xargs processing.
+	 * Arrange the records by the file id keeping the order.
 	 */
-	static const char *const options[] = {NULL, " ", "r", "s"};
-	char comline[MAXFILLEN];
-	int db;
+	n = records->length;
+	r = varray_assign(records, 0, 0);
+	record_index = (int *)check_calloc(sizeof(int), record_fids + 2);
+	for (i = 0; i < n; i++)
+		record_index[r[i].fid + 1]++;
+	for (fid = 1; fid <= record_fids + 1; fid++)
+		record_index[fid] += record_index[fid - 1];
+	record_table = (struct anchor_record *)check_malloc(sizeof(struct anchor_record) * (n > 0 ? n : 1));
+	for (i = 0; i < n; i++)
+		record_table[record_index[r[i].fid]++] = r[i];
+	for (fid = record_fids + 1; fid > 0; fid--)
+		record_index[fid] = record_index[fid - 1];
+	record_index[0] = 0;
+	varray_close(records);
+	records = NULL;
+}
+/*
+ * deftype: decide the type of a definition anchor.
+ *
+ *	i)	image	line image
+ *	i)	tag	tag name
+ *	r)		D: function, M: macro, T: type
+ *
+ * Function header is applied only to the anchor whoes type is 'D'.
+ */
+static int
+deftype(const char *image, const char *tag)
+{
+	const char *p = image;
 
-	for (db = GTAGS; db < GTAGLIM; db++) {
-		anchor_input[db] = NULL;
-		/*
-		 * Htags(1) should not use gtags-parser(1) directly;
-		 * it should use global(1) with the -f option instead.
-		 * Because gtags-parser is part of the implementation of
-		 * gtags(1) and global(1), and htags is only an application
-		 * program which uses global(1). If htags depends on
-		 * gtags-parser, it will become difficult to change the
-		 * implementation of gtags and global.
-		 *
-		 * Though the output of global -f is not necessarily sorted
-		 * by the path, it is guaranteed that the records concerning
-		 * the same file are consecutive.
-		 */
-		if (gtags_exist[db] == 1) {
-			snprintf(comline, sizeof(comline), "%s -f%s --encode-path=\" \t\" --result=ctags-xid --nofilter=path", global_path, options[db]);
-			anchor_input[db] = xargs_open_with_file(comline, 0, anchor_stream);
-		}
+	for (; *p && isspace((unsigned char)*p); p++)
+		;
+	if (*p == '#')
+		return 'M';
+	if (locatestring(p, "typedef", MATCH_AT_FIRST))
+		return 'T';
+	if ((p = locatestring(p, tag, MATCH_FIRST)) != NULL) {
+		/* skip a tag and the following blanks */
+		p += strlen(tag);
+		for (; *p && isspace((unsigned char)*p); p++)
+			;
+		if (*p == '(')
+			return 'D';
 	}
+	return 'T';
 }
 /*
  * anchor_load: load anchor table
@@ -106,7 +235,7 @@ anchor_prepare(FILE *anchor_stream)
 void
 anchor_load(const char *path)
 {
-	int db, current_fid;
+	int current_fid, undecided = 0;
 
 	/* Get fid of the path */
 	{
@@ -123,74 +252,20 @@ anchor_load(const char *path)
 	else
 		varray_reset(vb);
 
-	for (db = GTAGS; db < GTAGLIM; db++) {
-		XARGS *xp;
-		char *ctags_xid;
-
-		if ((xp = anchor_input[db]) == NULL)
-			continue;
-		/*
-		 * Read from input stream until it reaches end of file
-		 * or the line of another file appears.
-		 */
-		while ((ctags_xid = xargs_read(xp)) != NULL) {
-			SPLIT ptable;
-			struct anchor *a;
-			int type, fid;
-			const char *ctags_x = parse_xid(ctags_xid, NULL, &fid);
-
-			/*
-			 * It is the following file.
-			 */
-			if (current_fid != fid) {
-				xargs_unread(xp);
-				break;
-			}
-			if (split(ctags_x, 4, &ptable) < 4) {
-				recover(&ptable);
-				die("too small number of parts in anchor_load().\n'%s'", ctags_x);
-			}
-			if (db == GTAGS) {
-				char *p = ptable.part[PART_LINE].start;
+	if (current_fid > 0 && current_fid <= record_fids) {
+		struct anchor_record *r = &record_table[record_index[current_fid]];
+		struct anchor_record *last = &record_table[record_index[current_fid + 1]];
 
-				for (; *p && isspace((unsigned char)*p); p++)
-					;
-				if (!*p) {
-					recover(&ptable);
-					die("The output of parser is illegal.\n%s", ctags_x);
-				}
-				/*
-				 * Function header is applied only to the anchor whoes type is 'D'.
-				 * (D: function, M: macro, T: type)
-				 */
-				type = 'T';
-				if (*p == '#')
-					type = 'M';
-				else if (locatestring(p, "typedef", MATCH_AT_FIRST))
-					type = 'T';
-				else if ((p = locatestring(p, ptable.part[PART_TAG].start, MATCH_FIRST)) != NULL) {
-					/* skip a tag and the following blanks */
-					p += strlen(ptable.part[PART_TAG].start);
-					for (; *p && isspace((unsigned char)*p); p++)
-						;
-					if (*p == '(')
-						type = 'D';
-				}
-			}  else if (db == GRTAGS)
-				type = 'R';
-			else
-				type = 'Y';
+		for (; r < last; r++) {
 			/* allocate an entry */
-			a = varray_append(vb);
-			a->lineno = atoi(ptable.part[PART_LNO].start);
-			a->type = type;
+			struct anchor *a = varray_append(vb);
+
+			a->lineno = r->lineno;
+			a->type = r->type;
 			a->done = 0;
-			settag(a, ptable.part[PART_TAG].start);
-			recover(&ptable);
-		}
-		if (ctags_xid == NULL) {
-			xargs_close(anchor_input[db]);
-			anchor_input[db] = NULL;
+			settag(a, (char *)r->tag);
+			if (a->type == 0)
+				undecided++;
 		}
 	}
 	if (vb->length == 0) {
@@ -202,6 +277,33 @@ anchor_load(const char *path)
 		 */
 		table = varray_assign(vb, 0, 0);
 		qsort(table, used, sizeof(struct anchor), cmp); 
+		/*
+		 * Decide the type of definitions by the line image.
+		 */
+		if (undecided) {
+			STRBUF *sb = strbuf_open(0);
+			FILE *ip = fopen(path, "r");
+			const char *image = "";
+			int lineno = 0;
+
+			for (i = 0; i < used; i++) {
+				if (table[i].type != 0)
+					continue;
+				while (ip && lineno < table[i].lineno) {
+					if ((image = strbuf_fgets(sb, ip, STRBUF_NOCRLF)) == NULL) {
+						image = "";
+						fclose(ip);
+						ip = NULL;
+						break;
+					}
+					lineno++;
+				}
+				table[i].type = deftype(image, gettag((&table[i])));
+			}
+			if (ip)
+				fclose(ip);
+			strbuf_close(sb);
+		}
 		/*
 		 * Setup some lineno.
 		 */
@@ -282,6 +384,7 @@ struct anchor *
 anchor_get(const char *name, int length, int type, int lineno)
 {
 	struct anchor *p = curp ? curp : start;
+	struct anchor *used = NULL;
 
 	if (table == NULL)
 		return NULL;
@@ -296,10 +399,18 @@ anchor_get(const char *name, int length, int type, int lineno)
 		return NULL;
 	curp = p;
 	for (; p < end && p->lineno == lineno; p++)
-		if (!p->done && p->length == length && !strcmp(gettag(p), name))
-			if (!type || p->type == type)
-				return p;
-	return NULL;
+		if (p->length == length && !strcmp(gettag(p), name))
+			if (!type || p->type == type) {
+				if (!p->done)
+					return p;
+				if (!used)
+					used = p;
+			}
+	/*
+	 * The compact format holds a tag once per line. If all anchors of
+	 * the name are already used, the name appears again in the line.
+	 */
+	return used;
 }
 /*
  * define_line: check whether or not this is a define line.
@@ -22,6 +22,11 @@
 #ifdef STDC_HEADERS
 #include <stdlib.h>
 #endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#else
+#include <strings.h>
+#endif
 
 #include "checkalloc.h"
 #include "die.h"
@@ -29,24 +34,112 @@
 #include "assoc.h"
 
 /*
- * assoc_open: open associate array.
+ * Associative array.
  *
- *	r)		descriptor
+ * The names and the values are kept in a string hash table (STRHASH).
+ * If the memory used by an array exceeds the budget (the 'cache_size'
+ * configuration variable), the contents are moved into an invisible
+ * temporary file (libdb B-tree) and the array works on it after that.
  */
-ASSOC *
-assoc_open()
+#define INITIAL_SIZE	1024
+#define MEGABYTE	(1024 * 1024)
+/*
+ * Approximate memory used by an entry except for the name and the value:
+ * the entry itself, its value header and the slots (the table is kept
+ * less than three quarters full).
+ */
+#define ENTRY_OVERHEAD	(sizeof(struct sh_entry) + sizeof(struct assoc_value) + sizeof(struct sh_slot) * 2)
+
+/*
+ * open_table: make an empty in-memory table.
+ *
+ *	i)	assoc	descriptor
+ */
+static void
+open_table(ASSOC *assoc)
+{
+	assoc->hash = strhash_open(INITIAL_SIZE);
+	assoc->used = 0;
+}
+/*
+ * close_table: free the in-memory table.
+ *
+ *	i)	assoc	descriptor
+ */
+static void
+close_table(ASSOC *assoc)
+{
+	strhash_close(assoc->hash);
+	assoc->hash = NULL;
+	assoc->used = 0;
+}
+/*
+ * spill: move the contents into a temporary file.
+ *
+ *	i)	assoc	descriptor
+ */
+static void
+spill(ASSOC *assoc)
 {
-	ASSOC *assoc = (ASSOC *)check_malloc(sizeof(ASSOC));
+	struct sh_entry *entry;
 
 	/*
 	 * Use invisible temporary file.
+	 * Since a value may start with a blank, sequential read must not
+	 * skip it as a meta record (DBOP_RAW).
 	 */
-	assoc->dbop = dbop_open(NULL, 1, 0600, 0);
+	assoc->dbop = dbop_open(NULL, 1, 0600, DBOP_RAW);
 	if (assoc->dbop == NULL)
 		abort();
 	assoc->dbop->put_errmsg = "cannot write to temporary file.\nYou can specify the directory for the temporary file using environment variable 'TMPDIR'.";
+	for (entry = strhash_first(assoc->hash); entry; entry = strhash_next(assoc->hash)) {
+		struct assoc_value *v = entry->value;
+
+		dbop_put_withlen(assoc->dbop, entry->name, v->data, v->len);
+	}
+	close_table(assoc);
+}
+/*
+ * assoc_open: open associate array.
+ *
+ *	r)		descriptor
+ */
+ASSOC *
+assoc_open()
+{
+	ASSOC *assoc = (ASSOC *)check_calloc(sizeof(ASSOC), 1);
+
+	open_table(assoc);
 	return assoc;
 }
+/*
+ * assoc_load: load associate array into the memory.
+ *
+ *	i)	assoc	descriptor
+ *
+ * After this call, every operation is done in the memory regardless of
+ * the budget. Since nothing refers to the temporary file any longer,
+ * the descriptor can be used by forked processes independently.
+ */
+void
+assoc_load(ASSOC *assoc)
+{
+	DBOP *dbop = assoc->dbop;
+	const char *name;
+
+	assoc->pinned = 1;
+	if (dbop == NULL)
+		return;
+	assoc->dbop = NULL;
+	open_table(assoc);
+	for (name = dbop_first(dbop, NULL, NULL, DBOP_KEY); name; name = dbop_next(dbop)) {
+		int len;
+		const char *value = dbop_lastdat(dbop, &len);
+
+		assoc_put_withlen(assoc, name, value, len);
+	}
+	dbop_close(dbop);
+}
 /*
  * assoc_close: close associate array.
  *
@@ -57,9 +150,12 @@ assoc_close(ASSOC *assoc)
 {
 	if (assoc == NULL)
 		return;
-	if (assoc->dbop == NULL)
+	if (assoc->dbop)
+		dbop_close(assoc->dbop);
+	else if (assoc->hash)
+		close_table(assoc);
+	else
 		abort();
-	dbop_close(assoc->dbop);
 	free(assoc);
 }
 /*
@@ -72,9 +168,7 @@ assoc_close(ASSOC *assoc)
 void
 assoc_put(ASSOC *assoc, const char *name, const char *value)
 {
-	if (assoc->dbop == NULL)
-		abort();
-	dbop_put(assoc->dbop, name, value);
+	assoc_put_withlen(assoc, name, value, strlen(value) + 1);
 }
 /*
  * assoc_put_withlen: put data into associate array.
@@ -87,9 +181,30 @@ assoc_put(ASSOC *assoc, const char *name, const char *value)
 void
 assoc_put_withlen(ASSOC *assoc, const char *name, const char *value, int len)
 {
-	if (assoc->dbop == NULL)
+	struct sh_entry *entry;
+	struct assoc_value *v;
+
+	if (assoc->dbop) {
+		dbop_put_withlen(assoc->dbop, name, value, len);
+		return;
+	}
+	if (assoc->hash == NULL)
 		abort();
-	dbop_put_withlen(assoc->dbop, name, value, len);
+	entry = strhash_assign(assoc->hash, name, 1);
+	if (entry->value == NULL) {
+		entry->value = pool_malloc(assoc->hash->pool, sizeof(struct assoc_value));
+		assoc->used += strlen(name) + 1 + ENTRY_OVERHEAD;
+	}
+	/*
+	 * The old value is left in the pool.
+	 */
+	v = entry->value;
+	v->data = pool_malloc(assoc->hash->pool, len);
+	memcpy(v->data, value, len);
+	v->len = len;
+	assoc->used += len;
+	if (!assoc->pinned && cache_size > 0 && assoc->used > (unsigned long)cache_size * MEGABYTE)
+		spill(assoc);
 }
 /*
  * assoc_get: get data from associate array.
@@ -101,7 +216,12 @@ assoc_put_withlen(ASSOC *assoc, const char *name, const char *value, int len)
 const char *
 assoc_get(ASSOC *assoc, const char *name)
 {
-	if (assoc->dbop == NULL)
+	struct sh_entry *entry;
+
+	if (assoc->dbop)
+		return dbop_get(assoc->dbop, name);
+	if (assoc->hash == NULL)
 		abort();
-	return dbop_get(assoc->dbop, name);
+	entry = strhash_assign(assoc->hash, name, 0);
+	return entry ? ((struct assoc_value *)entry->value)->data : NULL;
 }
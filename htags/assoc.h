@@ -20,12 +20,28 @@
 #define _ASSOC_H_
 
 #include "dbop.h"
+#include "strhash.h"
+
+struct assoc_value {
+	int len;			/* length of the value		*/
+	char *data;
+};
 
 typedef struct {
+	/*
+	 * in-memory table (value: struct assoc_value)
+	 */
+	STRHASH *hash;
+	unsigned long used;		/* memory used by the table	*/
+	int pinned;			/* 1: never spill (assoc_load)	*/
+	/*
+	 * temporary file (after spilling)
+	 */
 	DBOP *dbop;
 } ASSOC;
 
 ASSOC *assoc_open(void);
+void assoc_load(ASSOC *);
 void assoc_close(ASSOC *);
 void assoc_put(ASSOC *, const char *, const char *);
 void assoc_put_withlen(ASSOC *, const char *, const char *, int);
@@ -92,6 +92,20 @@ cache_get(int db, const char *tag)
 		die("I don't know such tag file.");
 	return assoc_get(assoc[db], tag);
 }
+/*
+ * cache_load: load cache file into the memory.
+ *
+ * After this call, the cache can be shared by forked processes.
+ */
+void
+cache_load(void)
+{
+	int i;
+
+	for (i = GTAGS; i < GTAGLIM; i++)
+		if (assoc[i])
+			assoc_load(assoc[i]);
+}
 /*
  * cache_close: close cache file.
  */
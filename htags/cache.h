@@ -22,6 +22,7 @@
 void cache_open(void);
 void cache_put(int, const char *, const char *, int);
 const char *cache_get(int, const char *);
+void cache_load(void);
 void cache_close(void);
 
 #endif /* ! _CACHE_H_ */
@@ -636,6 +636,47 @@ gen_list_begin(void)
 	}
 	return strbuf_value(sb);
 }
+/*
+ * Generate a record of ctags-x format.
+ *
+ *	i)	tag	tag name
+ *	i)	lineno	line number
+ *	i)	path	path name
+ *	i)	image	line image
+ *	r)		ctags_x with the --encode-path=" \t"
+ *
+ * The record is the same as a line of the output of global -x.
+ */
+const char *
+gen_ctags_x(const char *tag, int lineno, const char *path, const char *image)
+{
+	STATIC_STRBUF(sb);
+	static const char hex[] = "0123456789abcdef";
+	char lno[32];
+	const char *p;
+	int len;
+
+	strbuf_clear(sb);
+	strbuf_puts(sb, tag);
+	for (len = strlen(tag); len < 16; len++)
+		strbuf_putc(sb, ' ');
+	snprintf(lno, sizeof(lno), " %4d ", lineno);
+	strbuf_puts(sb, lno);
+	for (len = 0, p = path; *p; p++, len++) {
+		if (*p == ' ' || *p == '\t' || *p == '%') {
+			strbuf_putc(sb, '%');
+			strbuf_putc(sb, hex[(unsigned char)*p / 16]);
+			strbuf_putc(sb, hex[(unsigned char)*p % 16]);
+			len += 2;
+		} else
+			strbuf_putc(sb, *p);
+	}
+	for (; len < 16; len++)
+		strbuf_putc(sb, ' ');
+	strbuf_putc(sb, ' ');
+	strbuf_puts(sb, image);
+	return strbuf_value(sb);
+}
 /*
  * Generate list body.
  *
@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2010 Tama Communications Corporation
+ *
+ * This file is part of GNU GLOBAL.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#include <stdio.h>
+#ifdef HAVE_STRING_H
+#include <string.h>
+#else
+#include <strings.h>
+#endif
+#include "global.h"
+#include "manifest.h"
+#include "htags.h"
+
+/*
+ * Completion index for the auto completion facility.
+ *
+ * The names of a tag file are sorted and divided into chunks by prefix.
+ * The browser loads the chunk list first, and then only the chunks
+ * whose prefix is compatible with the input.
+ *
+ * js/completion/<kind>.txt		chunk list
+ *	<prefix in hex> <number of names>
+ *	...
+ * js/completion/<kind>/<prefix in hex>.txt	chunk (front coded)
+ *	0 <first name>
+ *	<length shared with the previous name> <rest of the name>
+ *	...
+ *
+ * Each name of a chunk begins with the prefix. A prefix is MINPREFIX bytes
+ * at first, and it is extended while the chunk has more than CHUNKSIZE names.
+ * Names shorter than MINPREFIX are not included, since the form doesn't
+ * ask for them.
+ */
+#define MINPREFIX	2
+#define CHUNKSIZE	1000
+
+static const char *kinds[] = {NULL, "definition", NULL, "symbol"};
+
+static void
+puthex(STRBUF *sb, const char *s, int len)
+{
+	static const char hex[] = "0123456789abcdef";
+
+	while (len-- > 0) {
+		unsigned char c = *s++;
+
+		strbuf_putc(sb, hex[c >> 4]);
+		strbuf_putc(sb, hex[c & 0xf]);
+	}
+}
+/*
+ * keylen: length of the prefix of a name at the depth.
+ */
+#define keylen(name, depth)	((int)strlen(name) < (depth) ? (int)strlen(name) : (depth))
+/*
+ * write_chunk: write a chunk file.
+ *
+ *	i)	kind	kind of the index
+ *	i)	names	names
+ *	i)	count	number of names
+ *	i)	prefix	prefix
+ *	i)	len	length of the prefix
+ *	o)	list	chunk list
+ */
+static void
+write_chunk(const char *kind, char **names, int count, const char *prefix, int len, STRBUF *list)
+{
+	STRBUF *key = strbuf_open(0);
+	STRBUF *sb = strbuf_open(0);
+	const char *prev = "";
+	char path[MAXPATHLEN];
+	int i;
+
+	puthex(key, prefix, len);
+	for (i = 0; i < count; i++) {
+		const char *p = prev, *q = names[i];
+
+		while (*p && *p == *q) {
+			p++;
+			q++;
+		}
+		strbuf_putn(sb, q - names[i]);
+		strbuf_putc(sb, ' ');
+		strbuf_puts_nl(sb, q);
+		prev = names[i];
+	}
+	if (snprintf(path, sizeof(path), "%s/%s/%s/%s.txt", distpath, COMPLETION_DIR, kind, strbuf_value(key)) >= sizeof(path))
+		die("path name too long. '%s/%s'", distpath, COMPLETION_DIR);
+	manifest_write(path, sb, 0);
+	strbuf_sprintf(list, "%s %d\n", strbuf_value(key), count);
+	strbuf_close(key);
+	strbuf_close(sb);
+}
+/*
+ * split_chunks: divide names into chunks.
+ *
+ *	i)	kind	kind of the index
+ *	i)	names	sorted names
+ *	i)	count	number of names
+ *	i)	depth	length of prefix
+ *	o)	list	chunk list
+ */
+static void
+split_chunks(const char *kind, char **names, int count, int depth, STRBUF *list)
+{
+	int i, j;
+
+	for (i = 0; i < count; i = j) {
+		int len = keylen(names[i], depth);
+
+		for (j = i + 1; j < count; j++)
+			if (keylen(names[j], depth) != len || strncmp(names[i], names[j], len))
+				break;
+		if (j - i > CHUNKSIZE && len == depth)
+			split_chunks(kind, names + i, j - i, depth + 1, list);
+		else
+			write_chunk(kind, names + i, j - i, names[i], len, list);
+	}
+}
+/*
+ * make_index: make the completion index of a tag file.
+ *
+ *	i)	db	GTAGS or GSYMS
+ *	r)		number of names
+ */
+static int
+make_index(int db)
+{
+	GTOP *gtop = gtags_open(dbpath, cwdpath, db, GTAGS_READ, 0);
+	GTP *gtp;
+	STRBUF *pool = strbuf_open(0);
+	STRBUF *list = strbuf_open(0);
+	VARRAY *vb = varray_open(sizeof(int), 1000);
+	char **names;
+	char path[MAXPATHLEN];
+	int i, count;
+
+	/*
+	 * GTOP_KEY returns each name once in the order of the tag file.
+	 */
+	for (gtp = gtags_first(gtop, NULL, GTOP_KEY); gtp; gtp = gtags_next(gtop)) {
+		if (strlen(gtp->tag) < MINPREFIX)
+			continue;
+		*(int *)varray_append(vb) = strbuf_getlen(pool);
+		strbuf_puts0(pool, gtp->tag);
+	}
+	gtags_close(gtop);
+	count = vb->length;
+	names = check_malloc(sizeof(char *) * (count + 1));
+	for (i = 0; i < count; i++)
+		names[i] = strbuf_value(pool) + *(int *)varray_assign(vb, i, 0);
+	split_chunks(kinds[db], names, count, MINPREFIX, list);
+	if (snprintf(path, sizeof(path), "%s/%s/%s.txt", distpath, COMPLETION_DIR, kinds[db]) >= sizeof(path))
+		die("path name too long. '%s/%s'", distpath, COMPLETION_DIR);
+	manifest_write(path, list, 0);
+	free(names);
+	varray_close(vb);
+	strbuf_close(list);
+	strbuf_close(pool);
+	return count;
+}
+/*
+ * makecompletionindex: make completion index.
+ *
+ * The directories COMPLETION_DIR/<kind> must exist.
+ *
+ *	r)		number of names
+ */
+int
+makecompletionindex(void)
+{
+	int count;
+
+	count = make_index(GTAGS);
+	if (test("f", makepath(dbpath, dbname(GRTAGS), NULL)))
+		count += make_index(GSYMS);
+	return count;
+}
@@ -8,6 +8,9 @@ const char *help_const = "Options:\n\
        Enable auto completion facility for the input form.\n\
        If limit is specified, the number of candidates is limited to the value.\n\
        Please note that this function requires javascript language in your browser.\n\
+       Candidates of definitions and symbols are looked up in the browser\n\
+       using the completion index in HTML/js/completion.\n\
+       The other types are still answered by CGI program completion.cgi.\n\
 --caution\n\
        Display a caution message on the top page.\n\
 --cflow cflowfile\n\
@@ -29,6 +32,9 @@ const char *help_const = "Options:\n\
        Generate object lists dynamically using CGI program.\n\
        Though this option decrease both the size and generation time of hypertext,\n\
        you need to start up HTTP server.\n\
+       Instead of setting up the CGI programs, you can also browse the hypertext\n\
+       with htags-server, which serves directory HTML and answers\n\
+       the search form on http://127.0.0.1:8080/ (see EXAMPLES).\n\
 -d, --dbpath dbpath\n\
        Specify a directory in which GTAGS exist.\n\
        The default is the current directory.\n\
@@ -63,6 +69,15 @@ const char *help_const = "Options:\n\
        Insert header records derived from file into the HTML header.\n\
 -I, --icon\n\
        Use icons instead of text for some links.\n\
+--incremental\n\
+       Regenerate only the files affected by the changes since the\n\
+       last run. Htags records the signature of each generated file\n\
+       in HTML/MANIFEST. A source page is converted again only\n\
+       when the source file or the tags it refers to changed, and the\n\
+       other pages are rewritten only when their contents changed.\n\
+       The files which are no longer generated are removed.\n\
+       If the version, the configuration or the options differ from\n\
+       the last run, every file is generated again.\n\
 --insert-footer file\n\
        Insert custom footer derived from file before </body> tag.\n\
 --insert-header file\n\
@@ -74,6 +89,10 @@ const char *help_const = "Options:\n\
        c: caution, s: search form,\n\
        m: mains, d: definition, f: files, t: call tree.\n\
        The default is csmdf.\n\
+--jobs number\n\
+       Convert source files into hypertext using number processes\n\
+       in parallel. The result is the same as that of a serial run.\n\
+       The default is 1.\n\
 -m, --main-func name\n\
        Specify startup function name. The default is main.\n\
 -n, --line-number[=columns]\n\
@@ -34,6 +34,7 @@
 #include "htags.h"
 #include "path2url.h"
 #include "common.h"
+#include "manifest.h"
 
 /*
  * makedefineindex: make definition index (including alphabetic index)
@@ -50,14 +51,14 @@ makedefineindex(const char *file, int total, STRBUF *defines)
 	int alpha_count = 0;
 	FILEOP *fileop_MAP = NULL, *fileop_DEFINES, *fileop_ALPHA = NULL;
 	FILE *MAP = NULL;
-	FILE *DEFINES, *STDOUT, *TAGS, *ALPHA = NULL;
-	STRBUF *sb = strbuf_open(0);
+	FILE *DEFINES, *STDOUT, *ALPHA = NULL;
 	STRBUF *url = strbuf_open(0);
 	/* Index link */
 	const char *target = (Fflag) ? "mains" : "_top";
 	const char *indexlink;
 	const char *index_string = "Index Page";
-	char command[1024], buf[1024], alpha[32], alpha_f[32], *_;
+	char buf[1024], alpha[32], alpha_f[32];
+	const char *tag;
 
 	if (!aflag && !Fflag)
 		indexlink = "mains";
@@ -97,16 +98,15 @@ makedefineindex(const char *file, int total, STRBUF *defines)
 	 * map DEFINES to STDOUT.
 	 */
 	STDOUT = DEFINES;
-	snprintf(command, sizeof(command), "%s -c", global_path);
-	if ((TAGS = popen(command, "r")) == NULL)
-		die("cannot fork.");
+	/*
+	 * The definition names are collected by makedupindex().
+	 */
 	alpha[0] = '\0';
-	while ((_ = strbuf_fgets(sb, TAGS, STRBUF_NOCRLF)) != NULL) {
-		const char *tag, *line;
+	for (tag = first_definition(); tag; tag = next_definition()) {
+		const char *line;
 		char guide[1024], url_for_map[1024];
 
 		count++;
-		tag = _;
 		message(" [%d/%d] adding %s", count, total, tag);
 		if (aflag && (alpha[0] == '\0' || !locatestring(tag, alpha, MATCH_AT_FIRST))) {
 			const char *msg = (alpha_count == 1) ? "definition" : "definitions";
@@ -131,7 +131,7 @@ makedefineindex(const char *file, int total, STRBUF *defines)
 				fputs_nl(gen_href_end(), ALPHA);
 				fputs_nl(body_end, ALPHA);
 				fputs_nl(gen_page_end(), ALPHA);
-				close_file(fileop_ALPHA);
+				manifest_close_output(fileop_ALPHA);
 				html_count++;
 			}
 			/*
@@ -169,7 +169,7 @@ makedefineindex(const char *file, int total, STRBUF *defines)
 				snprintf(alpha_f, sizeof(alpha_f), "%03d", c);
 			}
 			snprintf(buf, sizeof(buf), "%s/defines/%s.%s", distpath, alpha_f, HTML);
-			fileop_ALPHA = open_output_file(buf, cflag);
+			fileop_ALPHA = manifest_open_output(buf, cflag);
 			ALPHA = get_descripter(fileop_ALPHA);
 			snprintf(buf, sizeof(buf), "[%s]", alpha);
 			fputs_nl(gen_page_begin(buf, SUBDIR), ALPHA);
@@ -242,8 +242,6 @@ makedefineindex(const char *file, int total, STRBUF *defines)
 		if (map_file)
 			fprintf(MAP, "%s\t%s\n", tag, url_for_map);
 	}
-	if (pclose(TAGS) != 0)
-		die("'%s' failed.", command);
 	if (aflag && alpha[0]) {
 		char tmp[128];
 		const char *msg = (alpha_count == 1) ? "definition" : "definitions";
@@ -264,7 +262,7 @@ makedefineindex(const char *file, int total, STRBUF *defines)
 		fputs_nl(gen_href_end(), ALPHA);
 		fputs_nl(body_end, ALPHA);
 		fputs_nl(gen_page_end(), ALPHA);
-		close_file(fileop_ALPHA);
+		manifest_close_output(fileop_ALPHA);
 		html_count++;
 
 		fputs(strbuf_value(defines), DEFINES);
@@ -285,7 +283,6 @@ makedefineindex(const char *file, int total, STRBUF *defines)
 	html_count++;
 	if (map_file)
 		close_file(fileop_MAP);
-	strbuf_close(sb);
 	strbuf_close(url);
 	return count;
 }
@@ -26,9 +26,10 @@
 #else
 #include <strings.h>
 #endif
+#include "global.h"
 #include "cache.h"
 #include "common.h"
-#include "global.h"
+#include "manifest.h"
 #include "htags.h"
 
 /*
@@ -38,170 +39,350 @@
  */
 static const char *dirs[]    = {NULL, DEFS,         REFS,        SYMS};
 static const char *kinds[]   = {NULL, "definition", "reference", "symbol"};
-static const char *options[] = {NULL, "",           "r",         "s"};
 
 /*
- * Make duplicate object index.
+ * Writer of duplicate object index for each tag file.
+ */
+struct dupindex {
+	int writing;			/* 1: writing a tag list	*/
+	int count;			/* number of tags		*/
+	int entry_count;		/* number of entries of the tag	*/
+	STRBUF *page;			/* contents of the tag list	*/
+	char prev[IDENTLEN];		/* current tag name		*/
+	char first_line[MAXBUFLEN];	/* first entry (ctags_xid)	*/
+};
+static struct dupindex dupindex[GTAGLIM];
+
+/*
+ * Definition names in the order of GTAGS.
+ * They are used by makedefineindex() instead of reading GTAGS again.
+ */
+static STRBUF *definitions;
+static const char *curdef;
+
+/*
+ * put_single: put a cache record of the tag which has only one entry.
  *
- * If referred tag is only one, direct link which points the tag is generated.
- * Else if two or more tag exists, indirect link which points the tag list
- * is generated.
+ *	i)	db	tag file
  */
-int
-makedupindex(void)
+static void
+put_single(int db)
 {
-	STRBUF *sb = strbuf_open(0);
-	STRBUF *tmp = strbuf_open(0);
-	STRBUF *command = strbuf_open(0);
-	int definition_count = 0;
+	struct dupindex *d = &dupindex[db];
+	STATIC_STRBUF(tmp);
+	char fid[MAXFIDLEN];
+	const char *ctags_x = parse_xid(d->first_line, fid, NULL);
+	const char *lno = nextelement(ctags_x);
+
+	strbuf_clear(tmp);
+	strbuf_puts_withterm(tmp, lno, ' ');
+	strbuf_putc(tmp, '\0');
+	strbuf_puts(tmp, fid);
+	cache_put(db, d->prev, strbuf_value(tmp), strbuf_getlen(tmp) + 1);
+}
+/*
+ * close_list: close the tag list and put a cache record of it.
+ *
+ *	i)	db	tag file
+ *	i)	no	number of the tag list
+ */
+static void
+close_list(int db, int no)
+{
+	struct dupindex *d = &dupindex[db];
+	STATIC_STRBUF(tmp);
+
+	if (!dynamic) {
+		char path[MAXPATHLEN];
+
+		strbuf_puts_nl(d->page, gen_list_end());
+		strbuf_puts_nl(d->page, body_end);
+		strbuf_puts_nl(d->page, gen_page_end());
+		snprintf(path, sizeof(path), "%s/%s/%d.%s", distpath, dirs[db], no, HTML);
+		manifest_write(path, d->page, cflag);
+		html_count++;
+	}
+	d->writing = 0;
+	/*
+	 * cache record: " <fid>\0<entry number>\0"
+	 */
+	strbuf_clear(tmp);
+	strbuf_putc(tmp, ' ');
+	strbuf_putn(tmp, no);
+	strbuf_putc(tmp, '\0');
+	strbuf_putn(tmp, d->entry_count);
+	cache_put(db, d->prev, strbuf_value(tmp), strbuf_getlen(tmp) + 1);
+}
+/*
+ * put_entry: put an entry into duplicate object index.
+ *
+ *	i)	db		tag file
+ *	i)	ctags_xid	entry
+ *
+ * The entries of a tag must be consecutive.
+ */
+static void
+put_entry(int db, const char *ctags_xid)
+{
+	struct dupindex *d = &dupindex[db];
 	char srcdir[MAXPATHLEN];
-	int db;
-	FILEOP *fileop = NULL;
-	FILE *op = NULL;
-	FILE *ip = NULL;
+	char tag[IDENTLEN], fid[MAXFIDLEN];
+	const char *ctags_x;
 
 	snprintf(srcdir, sizeof(srcdir), "../%s", SRCS);
-	for (db = GTAGS; db < GTAGLIM; db++) {
-		const char *kind = kinds[db];
-		const char *option = options[db];
-		int writing = 0;
-		int count = 0;
-		int entry_count = 0;
-		const char *ctags_xid, *ctags_x;
-		char tag[IDENTLEN], prev[IDENTLEN], first_line[MAXBUFLEN];
-
-		if (gtags_exist[db] == 0)
-			continue;
-		prev[0] = 0;
-		first_line[0] = 0;
+	ctags_x = parse_xid(ctags_xid, fid, NULL);
+	/* tag name */
+	(void)strcpy_withterm(tag, ctags_x, sizeof(tag), ' ');
+	if (strcmp(d->prev, tag)) {
+		d->count++;
+		if (vflag)
+			fprintf(stderr, " [%d] adding %s %s\n", d->count, kinds[db], tag);
+		if (d->writing)
+			close_list(db, d->count - 1);
+		/* single entry */
+		if (d->first_line[0])
+			put_single(db);
 		/*
-		 * construct command line.
+		 * Chop the tail of the line. It is not important.
+		 * strlimcpy(first_line, ctags_x, sizeof(first_line));
 		 */
-		strbuf_reset(command);
-		strbuf_sprintf(command, "%s -x%s --result=ctags-xid --encode-path=\" \t\" --nofilter=path", global_path, option);
-		/*
-		 * Optimization when the --dynamic option is specified.
-		 */
-		if (dynamic) {
-			strbuf_puts(command, " --nosource");
-			if (db != GSYMS)
-				strbuf_puts(command, " --nofilter=sort");
+		strncpy(d->first_line, ctags_xid, sizeof(d->first_line));
+		d->first_line[sizeof(d->first_line) - 1] = '\0';
+		strlimcpy(d->prev, tag, sizeof(d->prev));
+		d->entry_count = 0;
+	} else {
+		/* duplicate entry */
+		if (d->first_line[0]) {
+			char first_fid[MAXFIDLEN];
+			const char *first_x = parse_xid(d->first_line, first_fid, NULL);
+
+			if (!dynamic) {
+				strbuf_reset(d->page);
+				strbuf_puts_nl(d->page, gen_page_begin(tag, SUBDIR));
+				strbuf_puts_nl(d->page, body_begin);
+				strbuf_puts_nl(d->page, gen_list_begin());
+				strbuf_puts_nl(d->page, gen_list_body(srcdir, first_x, first_fid));
+			}
+			d->writing = 1;
+			d->entry_count++;
+			d->first_line[0] = 0;
 		}
-		strbuf_puts(command, " \".*\"");
-		if ((ip = popen(strbuf_value(command), "r")) == NULL)
-			die("cannot execute command '%s'.", strbuf_value(command));
-		while ((ctags_xid = strbuf_fgets(sb, ip, STRBUF_NOCRLF)) != NULL) {
-			char fid[MAXFIDLEN];
-
-			ctags_x = parse_xid(ctags_xid, fid, NULL);
-			/* tag name */
-			(void)strcpy_withterm(tag, ctags_x, sizeof(tag), ' ');
-			if (strcmp(prev, tag)) {
-				count++;
-				if (vflag)
-					fprintf(stderr, " [%d] adding %s %s\n", count, kind, tag);
-				if (writing) {
-					if (!dynamic) {
-						fputs_nl(gen_list_end(), op);
-						fputs_nl(body_end, op);
-						fputs_nl(gen_page_end(), op);
-						close_file(fileop);
-						html_count++;
-					}
-					writing = 0;
-					/*
-					 * cache record: " <fid>\0<entry number>\0"
-					 */
-					strbuf_reset(tmp);
-					strbuf_putc(tmp, ' ');
-					strbuf_putn(tmp, count - 1);
-					strbuf_putc(tmp, '\0');
-					strbuf_putn(tmp, entry_count);
-					cache_put(db, prev, strbuf_value(tmp), strbuf_getlen(tmp) + 1);
-				}				
-				/* single entry */
-				if (first_line[0]) {
-					char fid[MAXFIDLEN];
-					const char *ctags_x = parse_xid(first_line, fid, NULL);
-					const char *lno = nextelement(ctags_x);
-
-					strbuf_reset(tmp);
-					strbuf_puts_withterm(tmp, lno, ' ');
-					strbuf_putc(tmp, '\0');
-					strbuf_puts(tmp, fid);
-					cache_put(db, prev, strbuf_value(tmp), strbuf_getlen(tmp) + 1);
-				}
-				/*
-				 * Chop the tail of the line. It is not important.
-				 * strlimcpy(first_line, ctags_x, sizeof(first_line));
-				 */
-				strncpy(first_line, ctags_xid, sizeof(first_line));
-				first_line[sizeof(first_line) - 1] = '\0';
-				strlimcpy(prev, tag, sizeof(prev));
-				entry_count = 0;
-			} else {
-				/* duplicate entry */
-				if (first_line[0]) {
-					char fid[MAXFIDLEN];
-					const char *ctags_x = parse_xid(first_line, fid, NULL);
-
-					if (!dynamic) {
-						char path[MAXPATHLEN];
-
-						snprintf(path, sizeof(path), "%s/%s/%d.%s", distpath, dirs[db], count, HTML);
-						fileop = open_output_file(path, cflag);
-						op = get_descripter(fileop);
-						fputs_nl(gen_page_begin(tag, SUBDIR), op);
-						fputs_nl(body_begin, op);
-						fputs_nl(gen_list_begin(), op);
-						fputs_nl(gen_list_body(srcdir, ctags_x, fid), op);
-					}
-					writing = 1;
-					entry_count++;
-					first_line[0] = 0;
-				}
-				if (!dynamic) {
-					fputs_nl(gen_list_body(srcdir, ctags_x, fid), op);
+		if (!dynamic) {
+			strbuf_puts_nl(d->page, gen_list_body(srcdir, ctags_x, fid));
+		}
+		d->entry_count++;
+	}
+}
+/*
+ * Reader of the line image of the source files.
+ *
+ * The records of a tag are sorted by the path name, so the source files
+ * are visited again and again. The offsets of the lines are memorized
+ * for each file, not to read it from the head each time.
+ */
+static STRHASH *src_index;		/* path -> line offsets		*/
+static VARRAY *src_offsets;		/* line offsets of current file	*/
+static FILE *src_fp;
+static STRBUF *src_sb;
+static char src_path[MAXPATHLEN];
+static int src_lineno;
+static const char *src_image;
+
+/*
+ * get_image: get the line image of the source file.
+ *
+ *	i)	path	path name
+ *	i)	lineno	line number
+ *	r)		line image
+ */
+static const char *
+get_image(const char *path, int lineno)
+{
+	if (src_sb == NULL) {
+		src_sb = strbuf_open(0);
+		src_index = strhash_open(1024);
+	}
+	if (strcmp(src_path, path)) {
+		struct sh_entry *entry;
+
+		if (src_fp)
+			fclose(src_fp);
+		strlimcpy(src_path, path, sizeof(src_path));
+		src_fp = fopen(path, "r");
+		src_lineno = 0;
+		src_image = "";
+		entry = strhash_assign(src_index, path, 1);
+		if (entry->value == NULL) {
+			VARRAY *vb = varray_open(sizeof(long), 1000);
+
+			if (src_fp == NULL)
+				warning("source file '%s' is not available.", path);
+			else {
+				long offset = 0;
+
+				while (strbuf_fgets(src_sb, src_fp, 0) != NULL) {
+					*(long *)varray_append(vb) = offset;
+					offset = ftell(src_fp);
 				}
-				entry_count++;
+				rewind(src_fp);
 			}
+			entry->value = vb;
 		}
-		if (db == GTAGS)
-			definition_count = count;
-		if (pclose(ip) != 0)
-			die("'%s' failed.", strbuf_value(command));
-		if (writing) {
-			if (!dynamic) {
-				fputs_nl(gen_list_end(), op);
-				fputs_nl(body_end, op);
-				fputs_nl(gen_page_end(), op);
-				close_file(fileop);
-				html_count++;
+		src_offsets = entry->value;
+	}
+	if (src_fp == NULL || lineno < 1 || lineno > src_offsets->length)
+		return "";
+	if (lineno != src_lineno) {
+		if (lineno != src_lineno + 1)
+			fseek(src_fp, *(long *)varray_assign(src_offsets, lineno - 1, 0), SEEK_SET);
+		src_image = strbuf_fgets(src_sb, src_fp, STRBUF_NOCRLF);
+		if (src_image == NULL)
+			src_image = "";
+		src_lineno = lineno;
+	}
+	return src_image;
+}
+/*
+ * close_images: close the reader of the line image.
+ */
+static void
+close_images(void)
+{
+	struct sh_entry *entry;
+
+	if (src_fp)
+		fclose(src_fp);
+	src_fp = NULL;
+	src_path[0] = '\0';
+	if (src_index) {
+		for (entry = strhash_first(src_index); entry; entry = strhash_next(src_index))
+			varray_close(entry->value);
+		strhash_close(src_index);
+		src_index = NULL;
+		strbuf_close(src_sb);
+		src_sb = NULL;
+	}
+}
+/*
+ * scan_tags: read a tag file and put the entries into the indexes.
+ *
+ *	i)	db	GTAGS, GRTAGS, GSYMS or GRTAGS + GSYMS
+ *
+ * With GRTAGS + GSYMS, the real GRTAGS is read at once and each tag
+ * is put into GRTAGS or GSYMS according to whether it is defined.
+ */
+static void
+scan_tags(int db)
+{
+	GTOP *gtop = gtags_open(dbpath, cwdpath, db, GTAGS_READ, 0);
+	GTP *gtp;
+	STRBUF *sb = strbuf_open(0);
+	char key[IDENTLEN];
+	int target = db;
+
+	key[0] = '\0';
+	for (gtp = gtags_first(gtop, NULL, dynamic ? GTOP_NOSORT : 0); gtp; gtp = gtags_next(gtop)) {
+		GTREC rec;
+		int ok;
+
+		if (strcmp(gtp->tag, key)) {
+			strlimcpy(key, gtp->tag, sizeof(key));
+			if (db == GRTAGS + GSYMS)
+				target = dbop_get(gtop->gtags, key) ? GRTAGS : GSYMS;
+			else if (db == GTAGS) {
+				strbuf_puts(definitions, key);
+				strbuf_putc(definitions, '\0');
 			}
-			/*
-			 * cache record: " <fid>\0<entry number>\0"
-			 */
-			strbuf_reset(tmp);
-			strbuf_putc(tmp, ' ');
-			strbuf_putn(tmp, count);
-			strbuf_putc(tmp, '\0');
-			strbuf_putn(tmp, entry_count);
-			cache_put(db, prev, strbuf_value(tmp), strbuf_getlen(tmp) + 1);
 		}
-		if (first_line[0]) {
-			char fid[MAXFIDLEN];
-			const char *ctags_x = parse_xid(first_line, fid, NULL);
-			const char *lno = nextelement(ctags_x);
-
-			strbuf_reset(tmp);
-			strbuf_puts_withterm(tmp, lno, ' ');
-			strbuf_putc(tmp, '\0');
-			strbuf_puts(tmp, fid);
-			cache_put(db, prev, strbuf_value(tmp), strbuf_getlen(tmp) + 1);
+		for (ok = gtags_decode(gtop, &rec, gtp->tagline, gtp->tag, gtp->path); ok; ok = gtags_decode_next(&rec)) {
+			const char *image = " ";
+
+			if (!dynamic)
+				image = rec.image ? rec.image : get_image(rec.path, rec.lineno);
+			strbuf_reset(sb);
+			strbuf_puts(sb, rec.fid);
+			strbuf_putc(sb, ' ');
+			strbuf_puts(sb, gen_ctags_x(rec.name, rec.lineno, rec.path, image));
+			put_entry(target, strbuf_value(sb));
 		}
 	}
+	close_images();
 	strbuf_close(sb);
-	strbuf_close(tmp);
-	strbuf_close(command);
-	return definition_count;
+	gtags_close(gtop);
+}
+/*
+ * Make duplicate object index.
+ *
+ * If referred tag is only one, direct link which points the tag is generated.
+ * Else if two or more tag exists, indirect link which points the tag list
+ * is generated.
+ *
+ * The tag files are read directly, and the real GRTAGS is read only once
+ * for both of GRTAGS and GSYMS.
+ */
+int
+makedupindex(void)
+{
+	int db;
+
+	if (definitions == NULL)
+		definitions = strbuf_open(0);
+	else
+		strbuf_reset(definitions);
+	for (db = GTAGS; db < GTAGLIM; db++) {
+		struct dupindex *d = &dupindex[db];
+
+		d->writing = d->count = d->entry_count = 0;
+		d->prev[0] = d->first_line[0] = '\0';
+		d->page = strbuf_open(0);
+	}
+	if (gtags_exist[GTAGS])
+		scan_tags(GTAGS);
+	if (gtags_exist[GRTAGS] && gtags_exist[GSYMS])
+		scan_tags(GRTAGS + GSYMS);
+	else if (gtags_exist[GRTAGS])
+		scan_tags(GRTAGS);
+	else if (gtags_exist[GSYMS])
+		scan_tags(GSYMS);
+	for (db = GTAGS; db < GTAGLIM; db++) {
+		struct dupindex *d = &dupindex[db];
+
+		if (gtags_exist[db] == 0)
+			continue;
+		if (d->writing)
+			close_list(db, d->count);
+		if (d->first_line[0])
+			put_single(db);
+	}
+	for (db = GTAGS; db < GTAGLIM; db++) {
+		strbuf_close(dupindex[db].page);
+		dupindex[db].page = NULL;
+	}
+	return dupindex[GTAGS].count;
+}
+/*
+ * first_definition: return the first definition name.
+ *
+ *	r)		name (NULL: no definition)
+ */
+const char *
+first_definition(void)
+{
+	curdef = strbuf_value(definitions);
+	return next_definition();
+}
+/*
+ * next_definition: return the next definition name.
+ *
+ *	r)		name (NULL: end of definitions)
+ */
+const char *
+next_definition(void)
+{
+	const char *name = curdef;
+
+	if (curdef >= strbuf_value(definitions) + strbuf_getlen(definitions))
+		return NULL;
+	curdef += strlen(curdef) + 1;
+	return name;
 }
@@ -34,6 +34,7 @@
 
 #include "global.h"
 #include "incop.h"
+#include "manifest.h"
 #include "htags.h"
 #include "path2url.h"
 #include "common.h"
@@ -347,7 +348,7 @@ print_directory(int level, char *basedir)
 		char name[MAXPATHLEN];
 
 		snprintf(name, sizeof(name), "%s/files/%s.%s", distpath, path2fid(basedir), HTML);
-		fileop = open_output_file(name, cflag);
+		fileop = manifest_open_output(name, cflag);
 		op = get_descripter(fileop);
 		print_directory_header(op, level, basedir);
 		if (tree_view) {
@@ -447,7 +448,7 @@ print_directory(int level, char *basedir)
 		PUT(fline_end);
 	if (level > 0) {
 		print_directory_footer(op, level, basedir);
-		close_file(fileop);
+		manifest_close_output(fileop);
 		if (tree_view)
 			strbuf_puts(files, "</ul>\n");
 	}
@@ -779,13 +780,14 @@ makefileindex(const char *file, STRBUF *a_files)
 void
 makeincludeindex(void)
 {
-	FILE *PIPE;
+	GFIND *gp;
+	FILE *ip;
 	STRBUF *input = strbuf_open(0);
-	char *ctags_x;
+	const char *path, *image, *p;
 	struct data *inc;
 	char *target = (Fflag) ? "mains" : "_top";
-	char command[MAXFILLEN];
-
+	char name[IDENTLEN], *q;
+	regex_t preg;
 	/*
 	 * Pick up include pattern.
 	 *
@@ -796,35 +798,53 @@ makeincludeindex(void)
 	 * Unlike Perl regular expression, POSIX regular expression doesn't support C-style escape sequence.
 	 * Therefore, we can not use "\\t" here.
 	 */
-	snprintf(command, sizeof(command), "%s -gnx --encode-path=\" \t\" \"^[ \t]*(#[ \t]*(import|include)|include[ \t]*\\()\"", global_path);
-	if ((PIPE = popen(command, "r")) == NULL)
-		die("cannot fork.");
-	strbuf_reset(input);
-	while ((ctags_x = strbuf_fgets(input, PIPE, STRBUF_NOCRLF)) != NULL) {
-		SPLIT ptable;
-		char buf[MAXBUFLEN];
-		int is_php = 0;
-		const char *last, *lang, *suffix;
-
-		if (split(ctags_x, 4, &ptable) < 4) {
-			recover(&ptable);
-			die("too small number of parts in makefileindex().");
-		}
-		if ((suffix = locatestring(ptable.part[PART_PATH].start, ".", MATCH_LAST)) != NULL
-		    && (lang = decide_lang(suffix)) != NULL
-		    && strcmp(lang, "php") == 0)
-			is_php = 1;
-		last = extract_lastname(ptable.part[PART_LINE].start, is_php);
-		if (last == NULL || (inc = get_inc(last)) == NULL)
-			continue;
-		recover(&ptable);
-		/*
-		 * s/^[^ \t]+/$last/;
-		 */
-		{
-			const char *p;
-			char *q = buf;
+	const char *pattern = "^[ 	]*(#[ 	]*(import|include)|include[ 	]*\\()";
 
+	/*
+	 * The lines are picked up from the source files in the same way
+	 * as 'global -gx' does. The first column is the encoded pattern.
+	 */
+	for (p = pattern, q = name; *p && q < name + sizeof(name) - 4; p++) {
+		if (*p == ' ' || *p == '\t' || *p == '%')
+			q += sprintf(q, "%%%02x", *p);
+		else
+			*q++ = *p;
+	}
+	*q = '\0';
+	if (dfa_regcomp(&preg, pattern, REG_EXTENDED) != 0)
+		die("invalid regular expression.");
+	gp = gfind_open(dbpath, NULL, GPATH_SOURCE);
+	while ((path = gfind_read(gp)) != NULL) {
+		int lineno = 0;
+
+		if (!(ip = fopen(path, "r")))
+			die("cannot open file '%s'.", path);
+		while ((image = strbuf_fgets(input, ip, STRBUF_NOCRLF)) != NULL) {
+			SPLIT ptable;
+			char buf[MAXBUFLEN];
+			int is_php = 0;
+			const char *ctags_x, *last, *lang, *suffix;
+
+			lineno++;
+			if (dfa_regexec(&preg, image) != 0)
+				continue;
+			ctags_x = gen_ctags_x(name, lineno, path, image);
+			if (split((char *)ctags_x, 4, &ptable) < 4) {
+				recover(&ptable);
+				die("too small number of parts in makefileindex().");
+			}
+			if ((suffix = locatestring(ptable.part[PART_PATH].start, ".", MATCH_LAST)) != NULL
+			    && (lang = decide_lang(suffix)) != NULL
+			    && strcmp(lang, "php") == 0)
+				is_php = 1;
+			last = extract_lastname(ptable.part[PART_LINE].start, is_php);
+			if (last == NULL || (inc = get_inc(last)) == NULL)
+				continue;
+			recover(&ptable);
+			/*
+			 * s/^[^ \t]+/$last/;
+			 */
+			q = buf;
 			for (p = last; *p; p++)
 				*q++ = *p;
 			for (p = ctags_x; *p && *p != ' ' && *p != '\t'; p++)
@@ -832,11 +852,12 @@ makeincludeindex(void)
 			for (; *p; p++)
 				*q++ = *p;
 			*q = '\0';
+			put_included(inc, buf);
 		}
-		put_included(inc, buf);
+		fclose(ip);
 	}
-	if (pclose(PIPE) != 0)
-		die("terminated abnormally.");
+	gfind_close(gp);
+	dfa_regfree(&preg);
 
 	for (inc = first_inc(); inc; inc = next_inc()) {
 		const char *last = inc->name;
@@ -848,7 +869,7 @@ makeincludeindex(void)
 			char path[MAXPATHLEN];
 
 			snprintf(path, sizeof(path), "%s/%s/%d.%s", distpath, INCS, no, HTML);
-			fileop_INCLUDE = open_output_file(path, cflag);
+			fileop_INCLUDE = manifest_open_output(path, cflag);
 			INCLUDE = get_descripter(fileop_INCLUDE);
 			fputs_nl(gen_page_begin(last, SUBDIR), INCLUDE);
 			fputs_nl(body_begin, INCLUDE);
@@ -866,7 +887,7 @@ makeincludeindex(void)
 			fputs_nl(verbatim_end, INCLUDE);
 			fputs_nl(body_end, INCLUDE);
 			fputs_nl(gen_page_end(), INCLUDE);
-			close_file(fileop_INCLUDE);
+			manifest_close_output(fileop_INCLUDE);
 			html_count++;
 			/*
 			 * inc->contents == NULL means that information already
@@ -893,7 +914,7 @@ makeincludeindex(void)
 			char path[MAXPATHLEN];
 
 			snprintf(path, sizeof(path), "%s/%s/%d.%s", distpath, INCREFS, no, HTML);
-			fileop_INCLUDE = open_output_file(path, cflag);
+			fileop_INCLUDE = manifest_open_output(path, cflag);
 			INCLUDE = get_descripter(fileop_INCLUDE);
 			fputs_nl(gen_page_begin(last, SUBDIR), INCLUDE);
 			fputs_nl(body_begin, INCLUDE);
@@ -908,7 +929,7 @@ makeincludeindex(void)
 			fputs_nl(gen_list_end(), INCLUDE);
 			fputs_nl(body_end, INCLUDE);
 			fputs_nl(gen_page_end(), INCLUDE);
-			close_file(fileop_INCLUDE);
+			manifest_close_output(fileop_INCLUDE);
 			html_count++;
 			/*
 			 * inc->ref_contents == NULL means that information already
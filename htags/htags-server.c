@@ -0,0 +1,1311 @@
+/*
+ * Copyright (c) 2010 Tama Communications Corporation
+ *
+ * This file is part of GNU GLOBAL.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#include <ctype.h>
+#include <stdio.h>
+#ifdef STDC_HEADERS
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#else
+#include <strings.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#include <fcntl.h>
+#include <signal.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <poll.h>
+
+#include "getopt.h"
+#include "regex.h"
+#include "global.h"
+
+/*
+ * htags-server: serve a hypertext made by htags(1) over local HTTP.
+ *
+ * The search form (global.cgi) and the auto completion (completion.cgi)
+ * are answered in process from the tag files, which each worker keeps
+ * open until they are updated. Grep and idutils requests are passed to global(1)
+ * like the CGI scripts do.
+ *
+ * The server listens only on the loopback interface. The parent process
+ * pre-forks a fixed number of workers sharing the listening socket, and
+ * each worker multiplexes its connections with poll(2).
+ */
+const char *progname = "htags-server";
+
+static void usage(void);
+static void help(void);
+
+int qflag;
+int vflag;
+int show_version;
+int show_help;
+
+static const char *const usage_const =
+	"Usage: htags-server [-qv][-p port][-w workers][dir]\n";
+static const char *const help_const =
+	"Options:\n"
+	"     -p, --port port\n"
+	"            Listen on port of 127.0.0.1. The default is 8080.\n"
+	"     -q, --quiet\n"
+	"            Quiet mode.\n"
+	"     -v, --verbose\n"
+	"            Verbose mode. Each request is logged to stderr.\n"
+	"     -w, --workers number\n"
+	"            Number of worker processes. The default is 4.\n"
+	"     --version\n"
+	"            Show version number.\n"
+	"     --help\n"
+	"            Show help.\n"
+	"     dir\n"
+	"            The directory in which HTML exists. The default is\n"
+	"            the current directory.\n";
+
+static struct option const long_options[] = {
+	{"port", required_argument, NULL, 'p'},
+	{"quiet", no_argument, NULL, 'q'},
+	{"verbose", no_argument, NULL, 'v'},
+	{"workers", required_argument, NULL, 'w'},
+	{"version", no_argument, &show_version, 1},
+	{"help", no_argument, &show_help, 1},
+	{ 0 }
+};
+
+#define MAXWORKERS	64
+#define MAXCLIENTS	64		/* connections per worker */
+#define MAXREQUEST	8192		/* size limit of request header */
+#define TIMEOUT		30		/* idle timeout in seconds */
+
+static char htmldir[MAXPATHLEN];	/* the HTML directory */
+static char cwd[MAXPATHLEN];
+static char root[MAXPATHLEN];
+static char dbpath[MAXPATHLEN];
+static const char *html_suffix = "html";/* suffix of the source pages */
+static int compressed;			/* pages were made with -c */
+
+/*
+ * Pieces of html which htags used for the CGI scripts.
+ * They are loaded from 'HTML/SERVER' which htags(1) writes.
+ */
+struct macro {
+	const char *name;
+	const char *value;
+};
+static struct macro macros[] = {
+	{"page_begin", "<html>\n<head>\n<title>Result</title>\n</head>"},
+	{"page_end", "</html>"},
+	{"body_begin", "<body>"},
+	{"body_end", "</body>"},
+	{"title_begin", "<h1>"},
+	{"title_end", "</h1>"},
+	{"error_begin", "<h1>"},
+	{"error_end", "</h1>"},
+	{"message_begin", "<h3>"},
+	{"message_end", "</h3>"},
+	{"verbatim_begin", "<pre>"},
+	{"verbatim_end", "</pre>"},
+	{"normal_suffix", "html"},
+	{"hr", "<hr>"},
+	{"globalpath", "global"},
+};
+#define MACRO(name)	macro_value(name)
+
+/*
+ * macro_value: return the value of a macro.
+ *
+ *	i)	name	macro name
+ *	r)		value
+ */
+static const char *
+macro_value(const char *name)
+{
+	int i;
+
+	for (i = 0; i < sizeof(macros) / sizeof(struct macro); i++)
+		if (!strcmp(macros[i].name, name))
+			return macros[i].value;
+	die("unknown macro '%s'.", name);
+	/* NOTREACHED */
+	return NULL;
+}
+/*
+ * load_macros: load 'HTML/SERVER'.
+ *
+ * Each line is '<name>\t<value>'. A newline in the value is written
+ * as '\n' and a backslash as '\\'.
+ */
+static void
+load_macros(void)
+{
+	STRBUF *sb = strbuf_open(0);
+	STRBUF *val = strbuf_open(0);
+	FILE *ip = fopen(makepath(htmldir, "SERVER", NULL), "r");
+	const char *line, *p;
+	int i;
+
+	if (ip == NULL) {
+		warning("'%s' not found. Using the default style.", makepath(htmldir, "SERVER", NULL));
+		strbuf_close(sb);
+		strbuf_close(val);
+		return;
+	}
+	while ((line = strbuf_fgets(sb, ip, STRBUF_NOCRLF)) != NULL) {
+		if ((p = strchr(line, '\t')) == NULL)
+			continue;
+		strbuf_reset(val);
+		for (p++; *p; p++) {
+			if (*p == '\\' && *(p + 1) == 'n') {
+				strbuf_putc(val, '\n');
+				p++;
+			} else if (*p == '\\' && *(p + 1) == '\\') {
+				strbuf_putc(val, '\\');
+				p++;
+			} else
+				strbuf_putc(val, *p);
+		}
+		for (i = 0; i < sizeof(macros) / sizeof(struct macro); i++)
+			if (!strncmp(macros[i].name, line, strlen(macros[i].name))
+			    && line[strlen(macros[i].name)] == '\t')
+				macros[i].value = check_strdup(strbuf_value(val));
+	}
+	fclose(ip);
+	strbuf_close(sb);
+	strbuf_close(val);
+}
+/*
+ * Warm tag files of a worker.
+ */
+static GTOP *gtop[GTAGLIM];
+
+/*
+ * Stamps of the tag files which the handles were opened on.
+ * With 'gtags --atomic', only GCURRENT is watched, since every
+ * generation is published by renaming it.
+ */
+static struct stamp {
+	dev_t dev;
+	ino_t ino;
+	time_t mtime;
+	off_t size;
+} stamps[GTAGLIM];
+
+/*
+ * get_stamps: get the stamps of the tag files.
+ *
+ *	o)	s	stamps
+ */
+static void
+get_stamps(struct stamp *s)
+{
+	char top[MAXPATHLEN];
+	struct stat st;
+	int i;
+
+	memset(s, 0, sizeof(struct stamp) * GTAGLIM);
+	for (i = GPATH; i <= GRTAGS; i++) {
+		const char *path;
+
+		if (publish_top(dbpath, top, sizeof(top)))
+			path = (i == GPATH) ? makepath(top, PUBLISH_NAME, NULL) : NULL;
+		else
+			path = makepath(dbpath, dbname(i), NULL);
+		if (path == NULL || stat(path, &st) < 0)
+			continue;
+		s[i].dev = st.st_dev;
+		s[i].ino = st.st_ino;
+		s[i].mtime = st.st_mtime;
+		s[i].size = st.st_size;
+	}
+}
+/*
+ * check_db: reopen the tag files if they were updated.
+ *
+ * Gtags -u rewrites the tag files in place, and gtags --atomic publishes
+ * a new generation directory and removes old ones. In either case, the
+ * dbpath is located again and the handles are opened on demand.
+ */
+static void
+check_db(void)
+{
+	struct stamp now[GTAGLIM];
+	int i;
+
+	get_stamps(now);
+	if (!memcmp(now, stamps, sizeof(now)))
+		return;
+	for (i = 0; i < GTAGLIM; i++) {
+		if (gtop[i]) {
+			gtags_close(gtop[i]);
+			gtop[i] = NULL;
+		}
+	}
+	getdbpath(cwd, root, dbpath, 0);
+	get_stamps(stamps);
+	if (vflag)
+		fprintf(stderr, "tag files were updated. using '%s'.\n", dbpath);
+}
+/*
+ * open_db: return the handle of a tag file.
+ *
+ *	i)	db	GTAGS, GRTAGS or GSYMS
+ *	r)		GTOP structure, NULL: tag file not found
+ *
+ * The handle is kept open until the tag files are updated.
+ */
+static GTOP *
+open_db(int db)
+{
+	if (gtop[db] == NULL) {
+		if (!test("f", makepath(dbpath, dbname(db == GSYMS ? GRTAGS : db), NULL)))
+			return NULL;
+		gtop[db] = gtags_open(dbpath, root, db, GTAGS_READ, 0);
+	}
+	return gtop[db];
+}
+/*
+ * Sequential reader of source files for the compact format.
+ */
+static struct {
+	char path[MAXPATHLEN];
+	FILE *fp;
+	int lineno;
+	STRBUF *sb;
+	const char *line;
+} src;
+
+/*
+ * source_line: return a line of a source file.
+ *
+ *	i)	path	path name of the source file
+ *	i)	n	line number
+ *	r)		line image, "" if not available
+ */
+static const char *
+source_line(const char *path, int n)
+{
+	if (src.sb == NULL)
+		src.sb = strbuf_open(0);
+	if (strcmp(src.path, path)) {
+		if (src.fp)
+			fclose(src.fp);
+		strlimcpy(src.path, path, sizeof(src.path));
+		src.fp = fopen(makepath(root, path, NULL), "r");
+		src.lineno = 0;
+		src.line = "";
+	} else if (n == src.lineno) {
+		return src.line;
+	} else if (n < src.lineno && src.fp) {
+		rewind(src.fp);
+		src.lineno = 0;
+	}
+	while (src.fp && src.lineno < n) {
+		if (!(src.line = strbuf_fgets(src.sb, src.fp, STRBUF_NOCRLF))) {
+			src.line = "";
+			fclose(src.fp);
+			src.fp = NULL;
+			break;
+		}
+		src.lineno++;
+	}
+	return (src.lineno == n) ? src.line : "";
+}
+/*
+ * put_xid: put a record in the ctags-xid format.
+ */
+static void
+put_xid(STRBUF *sb, const char *fid, const char *tag, int lineno, const char *path, const char *image)
+{
+	if (*path == '.' && *(path + 1) == '/')
+		path += 2;
+	strbuf_sprintf(sb, "%s %-16s %4d %-16s %s\n", fid, tag, lineno, path, image);
+}
+/*
+ * search_tags: search a tag file like 'global --result=ctags-xid'.
+ *
+ *	o)	result	ctags-xid records
+ *	i)	pattern	pattern
+ *	i)	db	GTAGS, GRTAGS or GSYMS
+ *	i)	icase	ignore case distinction
+ *	r)		number of records
+ */
+static int
+search_tags(STRBUF *result, const char *pattern, int db, int icase)
+{
+	GTOP *gtop = open_db(db);
+	GTP *gtp;
+	STRBUF *sb;
+	int flags = 0, count = 0;
+
+	if (gtop == NULL)
+		return 0;
+	sb = strbuf_open(0);
+	if (icase) {
+		if (!isregex(pattern)) {
+			strbuf_putc(sb, '^');
+			strbuf_puts(sb, pattern);
+			strbuf_putc(sb, '$');
+			pattern = strbuf_value(sb);
+		}
+		flags |= GTOP_IGNORECASE;
+	}
+	for (gtp = gtags_first(gtop, pattern, flags); gtp; gtp = gtags_next(gtop)) {
+		GTREC rec;
+		int ok;
+
+		for (ok = gtags_decode(gtop, &rec, gtp->tagline, gtp->tag, gtp->path); ok; ok = gtags_decode_next(&rec)) {
+			put_xid(result, rec.fid, rec.name, rec.lineno, rec.path,
+				rec.image ? rec.image : source_line(rec.path, rec.lineno));
+			count++;
+		}
+	}
+	/*
+	 * The source files may be changed before the next request.
+	 */
+	if (src.fp)
+		fclose(src.fp);
+	src.fp = NULL;
+	src.path[0] = '\0';
+	strbuf_close(sb);
+	return count;
+}
+/*
+ * search_path: search GPATH like 'global --result=ctags-xid -P'.
+ *
+ *	o)	result	ctags-xid records, or path names if names_only is set
+ *	i)	pattern	pattern
+ *	i)	icase	ignore case distinction
+ *	i)	other	include other files
+ *	i)	names_only print only path names
+ *	r)		number of records
+ */
+static int
+search_path(STRBUF *result, const char *pattern, int icase, int other, int names_only)
+{
+	GFIND *gp;
+	const char *path;
+	char edit[IDENTLEN];
+	regex_t preg;
+	int flags = REG_EXTENDED, count = 0;
+
+	if (icase || getconfb("icase_path"))
+		flags |= REG_ICASE;
+	/*
+	 * We assume '^aaa' as '^/aaa'.
+	 */
+	if (*pattern == '^' && *(pattern + 1) != '/') {
+		snprintf(edit, sizeof(edit), "^/%s", pattern + 1);
+		pattern = edit;
+	}
+	if (dfa_regcomp(&preg, pattern, flags) != 0)
+		return 0;
+	gp = gfind_open(dbpath, "./", other ? GPATH_BOTH : GPATH_SOURCE);
+	while ((path = gfind_read(gp)) != NULL) {
+		if (dfa_regexec(&preg, path + 1) != 0)
+			continue;
+		if (names_only)
+			strbuf_puts_nl(result, path + 2);
+		else
+			put_xid(result, gp->dbop->lastdat, "path", 1, path, " ");
+		count++;
+	}
+	gfind_close(gp);
+	dfa_regfree(&preg);
+	return count;
+}
+/*
+ * run_global: execute global(1) and read the output.
+ *
+ *	o)	result	output of global
+ *	i)	flags	command flags
+ *	i)	pattern	pattern
+ *	i)	xid	use the ctags-xid format
+ *	r)		0: succeeded, -1: failed
+ */
+static int
+run_global(STRBUF *result, const char *flags, const char *pattern, int xid)
+{
+	const char *argv[6];
+	char buf[BUFSIZ];
+	int fd[2], status, n, i = 0;
+	pid_t pid;
+
+	argv[i++] = MACRO("globalpath");
+	if (xid)
+		argv[i++] = "--result=ctags-xid";
+	argv[i++] = flags;
+	argv[i++] = "-e";
+	argv[i++] = pattern;
+	argv[i] = NULL;
+	if (pipe(fd) < 0)
+		return -1;
+	if ((pid = fork()) < 0) {
+		close(fd[0]);
+		close(fd[1]);
+		return -1;
+	}
+	if (pid == 0) {
+		int null = open("/dev/null", O_RDWR);
+
+		dup2(fd[1], 1);
+		if (null >= 0)
+			dup2(null, 2);
+		close(fd[0]);
+		close(fd[1]);
+		execvp(argv[0], (char *const *)argv);
+		_exit(127);
+	}
+	close(fd[1]);
+	while ((n = read(fd[0], buf, sizeof(buf))) != 0) {
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+		strbuf_nputs(result, buf, n);
+	}
+	close(fd[0]);
+	while (waitpid(pid, &status, 0) < 0 && errno == EINTR)
+		;
+	if (!WIFEXITED(status) || WEXITSTATUS(status) == 127)
+		return -1;
+	return 0;
+}
+/*
+ * Query string.
+ */
+#define MAXPARAMS	16
+struct param {
+	char *name;
+	char *value;
+};
+
+/*
+ * url_decode: decode %XX and '+' in place.
+ */
+static void
+url_decode(char *s, int plus)
+{
+	char *d = s;
+
+	for (; *s; s++) {
+		if (*s == '+' && plus)
+			*d++ = ' ';
+		else if (*s == '%' && isxdigit((unsigned char)s[1]) && isxdigit((unsigned char)s[2])) {
+			char hex[3];
+
+			hex[0] = s[1];
+			hex[1] = s[2];
+			hex[2] = '\0';
+			*d++ = (char)strtol(hex, NULL, 16);
+			s += 2;
+		} else
+			*d++ = *s;
+	}
+	*d = '\0';
+}
+/*
+ * parse_query: split a query string into parameters.
+ *
+ *	io)	query	query string (broken)
+ *	o)	params	parameters
+ *	r)		number of parameters
+ */
+static int
+parse_query(char *query, struct param *params)
+{
+	char *p, *next;
+	int n = 0;
+
+	for (p = query; p && *p && n < MAXPARAMS; p = next) {
+		char *eq;
+
+		if ((next = strchr(p, '&')) != NULL)
+			*next++ = '\0';
+		params[n].name = p;
+		if ((eq = strchr(p, '=')) != NULL) {
+			*eq++ = '\0';
+			params[n].value = eq;
+		} else
+			params[n].value = "";
+		url_decode(params[n].name, 1);
+		url_decode(params[n].value, 1);
+		n++;
+	}
+	return n;
+}
+static const char *
+get_param(struct param *params, int n, const char *name)
+{
+	int i;
+
+	for (i = 0; i < n; i++)
+		if (!strcmp(params[i].name, name))
+			return params[i].value;
+	return "";
+}
+/*
+ * put_escaped: put a string escaping html special characters.
+ */
+static void
+put_escaped(STRBUF *sb, const char *s, int len)
+{
+	for (; len-- > 0 && *s; s++) {
+		if (*s == '&')
+			strbuf_puts(sb, "&amp;");
+		else if (*s == '<')
+			strbuf_puts(sb, "&lt;");
+		else if (*s == '>')
+			strbuf_puts(sb, "&gt;");
+		else
+			strbuf_putc(sb, *s);
+	}
+}
+/*
+ * Pieces of the result page. They are the same as those of global.cgi.
+ */
+static void
+page_header(STRBUF *sb)
+{
+	strbuf_puts_nl(sb, MACRO("page_begin"));
+	strbuf_puts_nl(sb, MACRO("body_begin"));
+}
+static void
+page_tailer(STRBUF *sb)
+{
+	strbuf_puts_nl(sb, MACRO("body_end"));
+	strbuf_puts_nl(sb, MACRO("page_end"));
+}
+static void
+page_error(STRBUF *sb, const char *msg)
+{
+	page_header(sb);
+	strbuf_sprintf(sb, "%sError%s\n", MACRO("error_begin"), MACRO("error_end"));
+	strbuf_sprintf(sb, "%s%s<a href='../mains.%s'>[return]</a>%s\n",
+		MACRO("message_begin"), msg, MACRO("normal_suffix"), MACRO("message_end"));
+	page_tailer(sb);
+}
+/*
+ * Response of a request.
+ */
+struct response {
+	int status;
+	const char *content_type;
+	const char *encoding;
+	STRBUF *location;
+	STRBUF *body;
+};
+
+/*
+ * do_search: answer to 'cgi-bin/global.cgi'.
+ *
+ *	i)	query	query string
+ *	o)	res	response
+ */
+static void
+do_search(char *query, struct response *res)
+{
+	struct param params[MAXPARAMS];
+	int nparams = parse_query(query, params);
+	const char *pattern = get_param(params, nparams, "pattern");
+	const char *type = get_param(params, nparams, "type");
+	int icase = *get_param(params, nparams, "icase") != '\0';
+	int other = *get_param(params, nparams, "other") != '\0';
+	const char *words = "definitions";
+	const char *missed = NULL;
+	STRBUF *result = strbuf_open(0);
+	STRBUF *sb = res->body;
+	const char *p, *line;
+	int count = 0, failed = 0;
+
+	res->status = 200;
+	res->content_type = "text/html";
+	if (*pattern == '\0') {
+		page_error(sb, "Pattern not specified.");
+		goto out;
+	}
+	if (!test("f", makepath(dbpath, "GTAGS", NULL)))
+		missed = "GTAGS";
+	else if (!test("f", makepath(dbpath, "GPATH", NULL)))
+		missed = "GPATH";
+	else if (!strcmp(type, "reference") && !test("f", makepath(dbpath, "GRTAGS", NULL)))
+		missed = "GRTAGS";
+	else if (!strcmp(type, "idutils") && !test("f", makepath(dbpath, "ID", NULL)))
+		missed = "ID";
+	if (missed) {
+		STRBUF *msg = strbuf_open(0);
+
+		strbuf_sprintf(msg, "Tag file (%s) not found.", missed);
+		page_error(sb, strbuf_value(msg));
+		strbuf_close(msg);
+		goto out;
+	}
+	if (!strcmp(type, "reference")) {
+		words = "references";
+		count = search_tags(result, pattern, GRTAGS, icase);
+	} else if (!strcmp(type, "symbol")) {
+		words = "symbols";
+		count = search_tags(result, pattern, GSYMS, icase);
+	} else if (!strcmp(type, "path")) {
+		words = "paths";
+		count = search_path(result, pattern, icase, other, 0);
+	} else if (!strcmp(type, "grep") || !strcmp(type, "idutils")) {
+		char flags[8], *f = flags;
+
+		words = "patterns";
+		*f++ = '-';
+		*f++ = !strcmp(type, "grep") ? 'g' : 'I';
+		if (icase)
+			*f++ = 'i';
+		if (other && !strcmp(type, "grep"))
+			*f++ = 'o';
+		*f = '\0';
+		failed = run_global(result, flags, pattern, 1);
+		for (p = strbuf_value(result); *p; p++)
+			if (*p == '\n')
+				count++;
+	} else {
+		count = search_tags(result, pattern, GTAGS, icase);
+	}
+	if (failed) {
+		page_error(sb, "Cannot execute global.");
+		goto out;
+	}
+	if (count == 0) {
+		/* not found */
+		page_header(sb);
+		strbuf_puts(sb, MACRO("title_begin"));
+		put_escaped(sb, pattern, strlen(pattern));
+		strbuf_puts_nl(sb, MACRO("title_end"));
+		strbuf_sprintf(sb, "%sPattern not found. <a href='../mains.%s'>[return]</a>%s\n",
+			MACRO("message_begin"), MACRO("normal_suffix"), MACRO("message_end"));
+		page_tailer(sb);
+		goto out;
+	}
+	if (count == 1) {
+		/* direct jump */
+		int fid, lineno;
+
+		if (sscanf(strbuf_value(result), "%d %*s %d", &fid, &lineno) == 2) {
+			res->status = 302;
+			res->location = strbuf_open(0);
+			strbuf_sprintf(res->location, "../S/%d.%s#L%d", fid, html_suffix, lineno);
+			goto out;
+		}
+	}
+	page_header(sb);
+	strbuf_puts(sb, "<h1 class='title'>");
+	put_escaped(sb, pattern, strlen(pattern));
+	strbuf_puts_nl(sb, "</h1>");
+	strbuf_sprintf(sb, "Following %s are matched to above pattern.%s\n", words, MACRO("hr"));
+	strbuf_puts_nl(sb, MACRO("verbatim_begin"));
+	count = 0;
+	for (line = strbuf_value(result); *line; line = p) {
+		const char *fid, *tag, *end;
+		int fidlen, lineno;
+
+		for (end = line; *end && *end != '\n'; end++)
+			;
+		p = *end ? end + 1 : end;
+		count++;
+		/*
+		 * fid tag   lno filename
+		 * ---------------------------------------------
+		 * 100 main  32 ./main.c main(argc, argv)
+		 */
+		fid = line;
+		for (tag = fid; tag < end && isdigit((unsigned char)*tag); tag++)
+			;
+		fidlen = tag - fid;
+		while (tag < end && (*tag == ' ' || *tag == '\t'))
+			tag++;
+		{
+			const char *q = tag;
+
+			while (q < end && !isspace((unsigned char)*q))
+				q++;
+			lineno = atoi(q);
+			strbuf_puts(sb, "<span class='curline'><a href='../S/");
+			strbuf_nputs(sb, fid, fidlen);
+			strbuf_sprintf(sb, ".%s#L%d'>", html_suffix, lineno);
+			put_escaped(sb, tag, q - tag);
+			strbuf_puts(sb, "</a>");
+			put_escaped(sb, q, end - q);
+			strbuf_puts_nl(sb, "</span>");
+		}
+	}
+	strbuf_puts_nl(sb, MACRO("verbatim_end"));
+	strbuf_sprintf(sb, "%s%d objects located.\n", MACRO("hr"), count);
+	page_tailer(sb);
+out:
+	strbuf_close(result);
+}
+/*
+ * do_completion: answer to 'cgi-bin/completion.cgi'.
+ *
+ *	i)	query	query string
+ *	o)	res	response
+ */
+static void
+do_completion(char *query, struct response *res)
+{
+	struct param params[MAXPARAMS];
+	int nparams = parse_query(query, params);
+	const char *q = get_param(params, nparams, "q");
+	const char *type = get_param(params, nparams, "type");
+	int icase = *get_param(params, nparams, "icase") != '\0';
+	int other = *get_param(params, nparams, "other") != '\0';
+	int limit = atoi(get_param(params, nparams, "limit"));
+	STRBUF *result = strbuf_open(0);
+	const char *p, *end;
+	int db = GTAGS;
+
+	res->status = 200;
+	res->content_type = "text/html";
+	/*
+	 * Completion.cgi only complains to the server log.
+	 */
+	if (*q == '\0') {
+		warning("completion.cgi: request value is null.");
+		res->status = 500;
+		goto out;
+	}
+	if (!strcmp(type, "definition") || !strcmp(type, "reference"))
+		db = GTAGS;
+	else if (!strcmp(type, "symbol") || !strcmp(type, "grep"))
+		db = GSYMS;
+	else if (!strcmp(type, "path")) {
+		search_path(result, q, icase, other, 1);
+		db = -1;
+	} else if (!strcmp(type, "idutils")) {
+		run_global(result, icase ? "-cIi" : "-cI", q, 0);
+		db = -1;
+	} else {
+		warning("completion.cgi: invalid type name.");
+		res->status = 500;
+		goto out;
+	}
+	if (db >= 0 && open_db(db) != NULL) {
+		GTOP *gtop = open_db(db);
+		GTP *gtp;
+		int flags = GTOP_KEY | GTOP_NOREGEX | GTOP_PREFIX;
+
+		if (icase && isalpha((unsigned char)*q)) {
+			/*
+			 * Two prefix reading like global -ci.
+			 */
+			STRBUF *sb = strbuf_open(0);
+			regex_t preg;
+			int i, firstchar[2];
+
+			strbuf_putc(sb, '^');
+			strbuf_puts(sb, q);
+			if (dfa_regcomp(&preg, strbuf_value(sb), REG_ICASE) == 0) {
+				firstchar[0] = toupper((unsigned char)*q);
+				firstchar[1] = tolower((unsigned char)*q);
+				for (i = 0; i < 2; i++) {
+					strbuf_reset(sb);
+					strbuf_putc(sb, firstchar[i]);
+					for (gtp = gtags_first(gtop, strbuf_value(sb), flags); gtp; gtp = gtags_next(gtop))
+						if (dfa_regexec(&preg, gtp->tag) == 0)
+							strbuf_puts_nl(result, gtp->tag);
+				}
+				dfa_regfree(&preg);
+			}
+			strbuf_close(sb);
+		} else {
+			for (gtp = gtags_first(gtop, q, flags); gtp; gtp = gtags_next(gtop))
+				strbuf_puts_nl(result, gtp->tag);
+		}
+	}
+	if (limit <= 0) {
+		strbuf_puts(res->body, strbuf_value(result));
+		goto out;
+	}
+	for (p = strbuf_value(result); *p && limit-- > 0; p = end) {
+		end = strchr(p, '\n');
+		end = end ? end + 1 : p + strlen(p);
+		strbuf_nputs(res->body, p, end - p);
+	}
+out:
+	strbuf_close(result);
+}
+/*
+ * Content types of static files.
+ */
+static struct {
+	const char *suffix;
+	const char *type;
+} content_types[] = {
+	{"html", "text/html"},
+	{"htm", "text/html"},
+	{"xhtml", "application/xhtml+xml"},
+	{"css", "text/css"},
+	{"js", "application/javascript"},
+	{"png", "image/png"},
+	{"gif", "image/gif"},
+	{"jpg", "image/jpeg"},
+	{"txt", "text/plain"},
+};
+/*
+ * do_file: answer a static file in the HTML directory.
+ *
+ *	i)	path	decoded path (begins with '/')
+ *	o)	res	response
+ */
+static void
+do_file(const char *path, struct response *res)
+{
+	STRBUF *sb = strbuf_open(0);
+	struct stat st;
+	const char *suffix;
+	char buf[BUFSIZ];
+	FILE *ip;
+	int i, n;
+
+	res->content_type = "application/octet-stream";
+	strbuf_puts(sb, htmldir);
+	strbuf_puts(sb, path);
+	if (stat(strbuf_value(sb), &st) == 0 && S_ISDIR(st.st_mode)) {
+		strbuf_unputc(sb, '/');
+		strbuf_puts(sb, "/index.html");
+		if (stat(strbuf_value(sb), &st) < 0) {
+			strbuf_setlen(sb, strbuf_getlen(sb) - strlen("html"));
+			strbuf_puts(sb, "ghtml");
+		}
+	}
+	if (stat(strbuf_value(sb), &st) < 0 || !S_ISREG(st.st_mode)
+	    || (ip = fopen(strbuf_value(sb), "r")) == NULL) {
+		res->status = 404;
+		res->content_type = "text/html";
+		strbuf_puts_nl(res->body, "<html><body><h1>404 Not Found</h1></body></html>");
+		strbuf_close(sb);
+		return;
+	}
+	if ((suffix = locatestring(strbuf_value(sb), ".", MATCH_LAST)) != NULL) {
+		suffix++;
+		if (!strcmp(suffix, "ghtml") || (compressed && !strcmp(suffix, html_suffix))) {
+			res->content_type = "text/html";
+			res->encoding = "gzip";
+		} else {
+			for (i = 0; i < sizeof(content_types) / sizeof(content_types[0]); i++)
+				if (!strcmp(suffix, content_types[i].suffix))
+					res->content_type = content_types[i].type;
+		}
+	}
+	res->status = 200;
+	while ((n = fread(buf, 1, sizeof(buf), ip)) > 0)
+		strbuf_nputs(res->body, buf, n);
+	fclose(ip);
+	strbuf_close(sb);
+}
+/*
+ * Connections of a worker.
+ */
+#define READING	1
+#define WRITING	2
+static struct client {
+	int fd;
+	int state;
+	time_t start;
+	STRBUF *ib;			/* request */
+	STRBUF *ob;			/* response */
+	int done;			/* bytes already written */
+} clients[MAXCLIENTS];
+static int nclients;
+
+/*
+ * handle_request: make the response of a request.
+ *
+ *	i)	request	request header
+ *	o)	ob	response
+ */
+static void
+handle_request(char *request, STRBUF *ob)
+{
+	struct response res;
+	char *method, *uri = "", *query, *p;
+	int head = 0;
+
+	memset(&res, 0, sizeof(res));
+	res.body = strbuf_open(0);
+	method = request;
+	if ((p = strchr(method, ' ')) == NULL) {
+		res.status = 400;
+		goto reply;
+	}
+	*p++ = '\0';
+	uri = p;
+	if ((p = strpbrk(uri, " \r\n")) != NULL)
+		*p = '\0';
+	if (!strcmp(method, "HEAD"))
+		head = 1;
+	else if (strcmp(method, "GET")) {
+		res.status = 501;
+		goto reply;
+	}
+	if ((query = strchr(uri, '?')) != NULL)
+		*query++ = '\0';
+	else
+		query = "";
+	url_decode(uri, 0);
+	if (*uri != '/' || strstr(uri, "/..") || strstr(uri, "\\")) {
+		res.status = 400;
+		goto reply;
+	}
+	if (!strncmp(uri, "/cgi-bin/", 9))
+		check_db();
+	if (!strcmp(uri, "/cgi-bin/global.cgi"))
+		do_search(query, &res);
+	else if (!strcmp(uri, "/cgi-bin/completion.cgi"))
+		do_completion(query, &res);
+	else if (!strncmp(uri, "/cgi-bin/", 9))
+		res.status = 403;
+	else
+		do_file(uri, &res);
+reply:
+	switch (res.status) {
+	case 200: p = "OK"; break;
+	case 302: p = "Found"; break;
+	case 400: p = "Bad Request"; break;
+	case 403: p = "Forbidden"; break;
+	case 404: p = "Not Found"; break;
+	case 500: p = "Internal Server Error"; break;
+	default: p = "Not Implemented"; break;
+	}
+	if (res.status != 200 && res.status != 302 && strbuf_getlen(res.body) == 0)
+		strbuf_sprintf(res.body, "<html><body><h1>%d %s</h1></body></html>\n", res.status, p);
+	strbuf_sprintf(ob, "HTTP/1.0 %d %s\r\n", res.status, p);
+	strbuf_puts(ob, "Server: htags-server\r\nConnection: close\r\n");
+	if (res.location) {
+		strbuf_sprintf(ob, "Location: %s\r\n", strbuf_value(res.location));
+		strbuf_close(res.location);
+	}
+	strbuf_sprintf(ob, "Content-Type: %s\r\n", res.content_type ? res.content_type : "text/html");
+	if (res.encoding)
+		strbuf_sprintf(ob, "Content-Encoding: %s\r\n", res.encoding);
+	strbuf_sprintf(ob, "Content-Length: %d\r\n\r\n", (int)strbuf_getlen(res.body));
+	if (!head)
+		strbuf_nputs(ob, strbuf_value(res.body), strbuf_getlen(res.body));
+	if (vflag)
+		fprintf(stderr, "%s %s %d\n", method, uri, res.status);
+	strbuf_close(res.body);
+}
+static void
+close_client(struct client *c)
+{
+	close(c->fd);
+	c->fd = -1;
+	c->state = 0;
+	nclients--;
+}
+/*
+ * worker: event loop of a worker process.
+ *
+ *	i)	sock	listening socket (non-blocking)
+ */
+static void
+worker(int sock)
+{
+	struct pollfd pfd[MAXCLIENTS + 1];
+	int index[MAXCLIENTS + 1];
+	pid_t parent = getppid();
+	char buf[BUFSIZ];
+	int i, n, npfd;
+
+	signal(SIGPIPE, SIG_IGN);
+	signal(SIGTERM, SIG_DFL);
+	signal(SIGINT, SIG_DFL);
+	signal(SIGHUP, SIG_DFL);
+	if (chdir(root) < 0)
+		die("cannot move to '%s'.", root);
+	for (i = 0; i < MAXCLIENTS; i++) {
+		clients[i].fd = -1;
+		clients[i].ib = strbuf_open(0);
+		clients[i].ob = strbuf_open(0);
+	}
+	for (;;) {
+		time_t now;
+
+		npfd = 0;
+		if (nclients < MAXCLIENTS) {
+			pfd[npfd].fd = sock;
+			pfd[npfd].events = POLLIN;
+			index[npfd++] = -1;
+		}
+		for (i = 0; i < MAXCLIENTS; i++) {
+			if (clients[i].fd < 0)
+				continue;
+			pfd[npfd].fd = clients[i].fd;
+			pfd[npfd].events = (clients[i].state == READING) ? POLLIN : POLLOUT;
+			index[npfd++] = i;
+		}
+		if (poll(pfd, npfd, 1000) < 0) {
+			if (errno == EINTR)
+				continue;
+			die("poll failed.");
+		}
+		if (getppid() != parent)
+			exit(0);
+		now = time(NULL);
+		for (n = 0; n < npfd; n++) {
+			struct client *c;
+
+			if (index[n] < 0) {
+				int fd;
+
+				if (!(pfd[n].revents & POLLIN))
+					continue;
+				/*
+				 * The other workers may have taken it.
+				 */
+				while (nclients < MAXCLIENTS && (fd = accept(sock, NULL, NULL)) >= 0) {
+					for (i = 0; clients[i].fd >= 0; i++)
+						;
+					fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+					c = &clients[i];
+					c->fd = fd;
+					c->state = READING;
+					c->start = now;
+					c->done = 0;
+					strbuf_reset(c->ib);
+					strbuf_reset(c->ob);
+					nclients++;
+				}
+				continue;
+			}
+			c = &clients[index[n]];
+			if (pfd[n].revents & (POLLERR|POLLNVAL)) {
+				close_client(c);
+			} else if (c->state == READING && pfd[n].revents & (POLLIN|POLLHUP)) {
+				int len = read(c->fd, buf, sizeof(buf));
+
+				if (len < 0 && (errno == EAGAIN || errno == EINTR))
+					continue;
+				if (len <= 0) {
+					close_client(c);
+					continue;
+				}
+				strbuf_nputs(c->ib, buf, len);
+				if (strstr(strbuf_value(c->ib), "\r\n\r\n") || strstr(strbuf_value(c->ib), "\n\n")) {
+					handle_request(strbuf_value(c->ib), c->ob);
+					c->state = WRITING;
+				} else if (strbuf_getlen(c->ib) > MAXREQUEST) {
+					close_client(c);
+				}
+			} else if (c->state == WRITING && pfd[n].revents & POLLOUT) {
+				int len = write(c->fd, strbuf_value(c->ob) + c->done, strbuf_getlen(c->ob) - c->done);
+
+				if (len < 0 && (errno == EAGAIN || errno == EINTR))
+					continue;
+				if (len < 0) {
+					close_client(c);
+					continue;
+				}
+				c->done += len;
+				if (c->done >= strbuf_getlen(c->ob))
+					close_client(c);
+			}
+		}
+		for (i = 0; i < MAXCLIENTS; i++)
+			if (clients[i].fd >= 0 && now - clients[i].start > TIMEOUT)
+				close_client(&clients[i]);
+	}
+}
+/*
+ * Worker pool of the parent.
+ */
+static pid_t workers[MAXWORKERS];
+static volatile sig_atomic_t terminated;
+
+static void
+onsignal(int signo)
+{
+	terminated = 1;
+}
+static pid_t
+spawn_worker(int sock)
+{
+	pid_t pid = fork();
+
+	if (pid < 0)
+		die("cannot fork worker.");
+	if (pid == 0) {
+		worker(sock);
+		exit(0);
+	}
+	return pid;
+}
+static void
+usage(void)
+{
+	if (!qflag)
+		fputs(usage_const, stderr);
+	exit(2);
+}
+static void
+help(void)
+{
+	fputs(usage_const, stdout);
+	fputs(help_const, stdout);
+	exit(0);
+}
+int
+main(int argc, char **argv)
+{
+	struct sockaddr_in addr;
+	struct sigaction sa;
+	int port = 8080;
+	int nworkers = 4;
+	int sock, optchar, i, on = 1;
+	const char *dir = ".";
+	FILE *ip;
+
+	while ((optchar = getopt_long(argc, argv, "p:qvw:", long_options, NULL)) != EOF) {
+		switch (optchar) {
+		case 0:
+			break;
+		case 'p':
+			port = atoi(optarg);
+			if (port <= 0 || port > 65535)
+				die("invalid port number '%s'.", optarg);
+			break;
+		case 'q':
+			qflag++;
+			setquiet();
+			break;
+		case 'v':
+			vflag++;
+			setverbose();
+			break;
+		case 'w':
+			nworkers = atoi(optarg);
+			if (nworkers <= 0 || nworkers > MAXWORKERS)
+				die("number of workers must be between 1 and %d.", MAXWORKERS);
+			break;
+		default:
+			usage();
+			break;
+		}
+	}
+	if (show_version)
+		version(NULL, vflag);
+	if (show_help)
+		help();
+	argc -= optind;
+	argv += optind;
+	if (argc > 1)
+		usage();
+	if (argc == 1)
+		dir = argv[0];
+	/*
+	 * Locate the hypertext and the tag files like global.cgi does.
+	 */
+	if (chdir(dir) < 0 || chdir("HTML") < 0)
+		die("directory '%s/HTML' not found.", dir);
+	if (!getcwd(htmldir, sizeof(htmldir)))
+		die("cannot get current directory.");
+	load_macros();
+	if (test("s", "compress")) {
+		compressed = 1;
+		html_suffix = "ghtml";
+	}
+	if ((ip = fopen("GTAGSROOT", "r")) != NULL) {
+		STRBUF *sb = strbuf_open(0);
+		const char *gtagsroot = strbuf_fgets(sb, ip, STRBUF_NOCRLF);
+
+		fclose(ip);
+		if (gtagsroot == NULL || chdir(gtagsroot) < 0)
+			die("GTAGSROOT directory not found.");
+		strbuf_close(sb);
+	} else if (chdir("..") < 0)
+		die("GTAGSROOT directory not found.");
+	if (!getcwd(cwd, sizeof(cwd)))
+		die("cannot get current directory.");
+	getdbpath(cwd, root, dbpath, 0);
+	get_stamps(stamps);
+	openconf();
+	/*
+	 * Listen only on the loopback interface.
+	 */
+	if ((sock = socket(AF_INET, SOCK_STREAM, 0)) < 0)
+		die("cannot make socket.");
+	setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+		die("cannot bind to 127.0.0.1:%d (%s).", port, strerror(errno));
+	if (listen(sock, 128) < 0)
+		die("cannot listen.");
+	fcntl(sock, F_SETFL, fcntl(sock, F_GETFL) | O_NONBLOCK);
+	if (!qflag)
+		fprintf(stderr, "%s: serving %s at http://127.0.0.1:%d/\n", progname, htmldir, port);
+	/*
+	 * Start the workers and keep their number.
+	 */
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = onsignal;
+	sigemptyset(&sa.sa_mask);
+	sigaction(SIGTERM, &sa, NULL);
+	sigaction(SIGINT, &sa, NULL);
+	sigaction(SIGHUP, &sa, NULL);
+	for (i = 0; i < nworkers; i++)
+		workers[i] = spawn_worker(sock);
+	while (!terminated) {
+		int status;
+		pid_t pid = wait(&status);
+
+		if (pid < 0) {
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+		for (i = 0; i < nworkers; i++) {
+			if (workers[i] == pid) {
+				if (!terminated) {
+					warning("worker %d exited. restarting.", (int)pid);
+					sleep(1);
+					workers[i] = spawn_worker(sock);
+				}
+				break;
+			}
+		}
+	}
+	for (i = 0; i < nworkers; i++)
+		kill(workers[i], SIGTERM);
+	while (wait(NULL) > 0 || errno == EINTR)
+		;
+	close(sock);
+	return 0;
+}
@@ -38,6 +38,9 @@
 #include <sys/stat.h>
 #include <sys/param.h>
 #include <errno.h>
+#if !defined(_WIN32) && !defined(__DJGPP__)
+#include <sys/wait.h>
+#endif
 
 #include "checkalloc.h"
 #include "getopt.h"
@@ -48,15 +51,18 @@
 #include "common.h"
 #include "htags.h"
 #include "incop.h"
+#include "manifest.h"
 #include "path2url.h"
 #include "const.h"
 
 void src2html(const char *, const char *, int);
+const char *src2html_signature(const char *, int);
 int makedupindex(void);
 int makedefineindex(const char *, int, STRBUF *);
 int makefileindex(const char *, STRBUF *);
 void makeincludeindex(void);
 int makecflowindex(const char *, const char *);
+int makecompletionindex(void);
 
 #if defined(_WIN32) && !defined(__CYGWIN__)
 #define mkdir(path,mode) mkdir(path)
@@ -118,6 +124,7 @@ int debug;				/* --debug option		*/
 int show_help;				/* --help command		*/
 int show_version;			/* --version command		*/
 int caution;				/* --caution option		*/
+int incremental;			/* --incremental option		*/
 int dynamic;				/* --dynamic(-D) option		*/
 int symbol;				/* --symbol(-s) option          */
 int suggest;				/* --suggest option		*/
@@ -226,6 +233,8 @@ const char *icon_files[] = {
  */
 int ncol = 4;				/* columns of line number	*/
 int tabs = 8;				/* tab skip			*/
+int jobs = 1;				/* --jobs option		*/
+int cache_size = 256;			/* memory budget of cache (MB)	*/
 int flist_fields = 5;			/* fields number of file list	*/
 int full_path = 0;			/* file index format		*/
 int map_file = 1;			/* 1: create MAP file		*/
@@ -285,6 +294,7 @@ static struct option const long_options[] = {
         {"disable-idutils", no_argument, &enable_idutils, 0},
         {"full-path", no_argument, &full_path, 1},
         {"html", no_argument, &enable_xhtml, 0},
+        {"incremental", no_argument, &incremental, 1},
         {"no-map-file", no_argument, &map_file, 0},
         {"overwrite-key", no_argument, &overwrite_key, 1},
         {"show-position", no_argument, &show_position, 1},
@@ -309,6 +319,7 @@ static struct option const long_options[] = {
 #define OPT_AUTO_COMPLETION	138
 #define OPT_TREE_VIEW		139
 #define OPT_HTML_HEADER		140
+#define OPT_JOBS		141
         {"auto-completion", optional_argument, NULL, OPT_AUTO_COMPLETION},
         {"cflow", required_argument, NULL, OPT_CFLOW},
         {"cvsweb", required_argument, NULL, OPT_CVSWEB},
@@ -320,6 +331,7 @@ static struct option const long_options[] = {
         {"insert-footer", required_argument, NULL, OPT_INSERT_FOOTER},
         {"insert-header", required_argument, NULL, OPT_INSERT_HEADER},
         {"item-order", required_argument, NULL, OPT_ITEM_ORDER},
+        {"jobs", required_argument, NULL, OPT_JOBS},
 	{"tabs", required_argument, NULL, OPT_TABS},
         {"tree-view",  optional_argument, NULL, OPT_TREE_VIEW},
         { 0 }
@@ -880,34 +892,83 @@ makehtaccess(const char *cgidir, const char *file)
 	fclose(op);
 }
 /*
- * makehtml: make html files
+ * makeserverconf: make the style file for htags-server(1).
+ *
+ *	i)	file	file name
+ *
+ * Htags-server answers the search form in place of global.cgi.
+ * This file passes the same pieces of html to it.
+ * Each line is '<name>\t<value>' and newlines in the value are escaped.
+ */
+static void
+makeserverconf(const char *file)
+{
+	FILE *op;
+	const char *p;
+	int i;
+	struct map {
+		const char *name;
+		const char *value;
+	} tab[] = {
+		{"page_begin", NULL},
+		{"page_end", NULL},
+		{"body_begin", body_begin},
+		{"body_end", body_end},
+		{"title_begin", title_begin},
+		{"title_end", title_end},
+		{"error_begin", error_begin},
+		{"error_end", error_end},
+		{"message_begin", message_begin},
+		{"message_end", message_end},
+		{"verbatim_begin", verbatim_begin},
+		{"verbatim_end", verbatim_end},
+		{"normal_suffix", normal_suffix},
+		{"hr", hr},
+		{"globalpath", global_path},
+	};
+
+	tab[0].value = gen_page_begin("Result", CGIDIR);
+	tab[1].value = gen_page_end();
+	op = fopen(makepath(distpath, file, NULL), "w");
+	if (!op)
+		die("cannot make file '%s'.", file);
+	for (i = 0; i < sizeof(tab) / sizeof(struct map); i++) {
+		fputs(tab[i].name, op);
+		fputc('\t', op);
+		for (p = tab[i].value; *p; p++) {
+			/*
+			 * The pages are always seen from the cgi-bin directory.
+			 */
+			if (!strncmp(p, "$basedir", 8)) {
+				fputs("..", op);
+				p += 7;
+			} else if (*p == '\n')
+				fputs("\\n", op);
+			else if (*p == '\\')
+				fputs("\\\\", op);
+			else
+				fputc(*p, op);
+		}
+		fputc('\n', op);
+	}
+	fclose(op);
+}
+/*
+ * convert_files: convert a part of source files into HTML files.
  *
  *	i)	total	number of files.
+ *	i)	n	number of parts
+ *	i)	k	part to convert (0 - n-1)
+ *
+ * The k'th part consists of the files whose index in GPATH modulo n is k.
  */
 static void
-makehtml(int total)
+convert_files(int total, int n, int k)
 {
 	GFIND *gp;
-	FILE *anchor_stream;
 	const char *path;
 	int count = 0;
 
-	/*
-	 * Create anchor stream for anchor_load().
-	 */
-	anchor_stream = tmpfile();
-	gp = gfind_open(dbpath, NULL, other_files ? GPATH_BOTH : GPATH_SOURCE);
-	while ((path = gfind_read(gp)) != NULL) {
-		if (gp->type == GPATH_OTHER)
-			fputc(' ', anchor_stream);
-		fputs(path, anchor_stream);
-		fputc('\n', anchor_stream);
-	}
-	gfind_close(gp);
-	/*
-	 * Prepare anchor stream for anchor_load().
-	 */
-	anchor_prepare(anchor_stream);
 	/*
 	 * For each path in GPATH, convert the path into HTML file.
 	 */
@@ -917,6 +978,8 @@ makehtml(int total)
 
 		if (gp->type == GPATH_OTHER && !other_files)
 			continue;
+		if (count++ % n != k)
+			continue;
 		/*
 		 * load tags belonging to the path.
 		 * The path must be start "./".
@@ -926,14 +989,89 @@ makehtml(int total)
 		 * inform the current path name to lex() function.
 		 */
 		save_current_path(path);
-		count++;
 		path += 2;		/* remove './' at the head */
-		message(" [%d/%d] converting %s", count, total, path);
 		snprintf(html, sizeof(html), "%s/%s/%s.%s", distpath, SRCS, path2fid(path), HTML);
+		if (incremental) {
+			const char *sig = src2html_signature(path, gp->type == GPATH_OTHER);
+
+			manifest_put(html, sig);
+			if (manifest_check(html, sig)) {
+				message(" [%d/%d] skipping %s", count, total, path);
+				anchor_unload();
+				continue;
+			}
+		}
+		message(" [%d/%d] converting %s", count, total, path);
 		src2html(path, html, gp->type == GPATH_OTHER);
 	}
 	gfind_close(gp);
 }
+/*
+ * makehtml: make html files
+ *
+ *	i)	total	number of files.
+ *
+ * With --jobs=N, the files are divided into N parts and each part is
+ * converted by a child process. Since the lexical analyzers and the
+ * anchor table are global, each process has its own copies of them.
+ * The anchor records, the tag cache and the path table are moved into
+ * the memory before forking, not to share the temporary files between
+ * the processes.
+ */
+static void
+makehtml(int total)
+{
+	/*
+	 * Load anchor records for anchor_load().
+	 */
+	anchor_prepare();
+#if !defined(_WIN32) && !defined(__DJGPP__)
+	if (jobs > 1 && total > 1) {
+		int n = (jobs < total) ? jobs : total;
+		pid_t *pids = (pid_t *)check_calloc(sizeof(pid_t), n);
+		int k, status, failed = 0;
+
+		cache_load();
+		fix_gpath();
+		fflush(NULL);
+		for (k = 0; k < n; k++) {
+			pid_t pid = fork();
+
+			if (pid < 0)
+				die("cannot fork.");
+			if (pid == 0) {
+				/*
+				 * GPATH is reopened not to share the file offset.
+				 */
+				gpath_close();
+				if (gpath_open(dbpath, 0) < 0)
+					die("GPATH not found.");
+				manifest_begin_part();
+				convert_files(total, n, k);
+				manifest_save_part(k);
+				gpath_close();
+				exit(0);
+			}
+			pids[k] = pid;
+		}
+		for (k = 0; k < n; k++) {
+			while (waitpid(pids[k], &status, 0) < 0) {
+				if (errno != EINTR)
+					die("waitpid failed.");
+			}
+			if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+				failed++;
+		}
+		free(pids);
+		if (failed)
+			die("%d of %d conversion processes failed.", failed, n);
+		for (k = 0; k < n; k++)
+			manifest_merge_part(k);
+		return;
+	}
+#endif
+	convert_files(total, 1, 0);
+}
 /*
  * Load file.
  */
@@ -954,6 +1092,65 @@ loadfile(const char *file, STRBUF *result)
 {
 	load_with_replace(file, result, 0);
 }
+/*
+ * config_signature: compute signature of the configuration.
+ *
+ *	r)		signature string
+ *
+ * The signature covers everything which affects all of the generated
+ * files: the version, the configuration, the arguments and the files
+ * inserted into each page. The options which don't change the result
+ * (--jobs, --incremental, --quiet, --verbose and --statistics) are
+ * excluded.
+ */
+static const char *
+config_signature(void)
+{
+	SIGNATURE sig;
+	STRBUF *sb = strbuf_open(0);
+	char *p, *q;
+
+	signature_init(&sig);
+	signature_puts(&sig, get_version());
+	signature_puts(&sig, save_config);
+	strbuf_puts(sb, save_argv);
+	for (p = strbuf_value(sb); *p; p = q) {
+		while (*p == ' ')
+			p++;
+		for (q = p; *q && *q != ' '; q++)
+			;
+		if (*q)
+			*q++ = '\0';
+		if (!strcmp(p, "--incremental") || !strncmp(p, "--jobs=", 7)
+		 || !strcmp(p, "-q") || !strcmp(p, "--quiet")
+		 || !strcmp(p, "-v") || !strcmp(p, "--verbose")
+		 || !strcmp(p, "--statistics"))
+			continue;
+		if (!strcmp(p, "--jobs")) {
+			while (*q == ' ')
+				q++;
+			while (*q && *q != ' ')
+				q++;
+			continue;
+		}
+		signature_puts(&sig, p);
+	}
+	signature_puts(&sig, sitekey);
+	if (html_header)
+		signature_puts(&sig, html_header);
+	if (insert_header) {
+		strbuf_reset(sb);
+		loadfile_asis(insert_header, sb);
+		signature_puts(&sig, strbuf_value(sb));
+	}
+	if (insert_footer) {
+		strbuf_reset(sb);
+		loadfile_asis(insert_footer, sb);
+		signature_puts(&sig, strbuf_value(sb));
+	}
+	strbuf_close(sb);
+	return signature_value(&sig);
+}
 /*
  * copy file.
  */
@@ -1209,8 +1406,9 @@ configuration(int argc, char *const *argv)
 			set_env("GTAGSLABEL", label);
 	}
 	/*
-	 * Config variables.
+	 * Config variables. Htags may update the cache of config file.
 	 */
+	set_confcache(1);
 	strbuf_reset(sb);
 	if (!getconfs("datadir", sb))
 		die("cannot get datadir directory name.");
@@ -1231,6 +1429,12 @@ configuration(int argc, char *const *argv)
 		else
 			tabs = n;
 	}
+	if (getconfn("cache_size", &n)) {
+		if (n < 0)
+			warning("parameter 'cache_size' ignored because the value (=%d) is too small.", n);
+		else
+			cache_size = n;
+	}
 	strbuf_reset(sb);
 	if (getconfs("gzipped_suffix", sb))
 		gzipped_suffix = check_strdup(strbuf_value(sb));
@@ -1573,6 +1777,12 @@ main(int argc, char **argv)
 		case OPT_ITEM_ORDER:
 			item_order = optarg;
 			break;
+		case OPT_JOBS:
+			if (atoi(optarg) > 0)
+				jobs = atoi(optarg);
+			else
+				die("--jobs option requires numeric value.");
+			break;
 		case OPT_TABS:
 			if (atoi(optarg) > 0)
 				tabs = atoi(optarg);
@@ -1693,10 +1903,10 @@ main(int argc, char **argv)
 		definition_header = AFTER_HEADER;
 		other_files = symbol = show_position = table_flist = 1;
 		if (arg_dbpath[0]) {
-			if (!test("f", makepath(arg_dbpath, dbname(GTAGS), NULL)))
+			if (!test("f", makepath(arg_dbpath, dbname(GTAGS), NULL)) && !published(arg_dbpath))
 				gtags_not_found = 1;
 		} else {
-			if (!test("f", dbname(GTAGS)))
+			if (!test("f", dbname(GTAGS)) && !published("."))
 				gtags_not_found = 1;
 		}
 		if (gtags_not_found)
@@ -1772,6 +1982,16 @@ main(int argc, char **argv)
 		set_env("GTAGSDBPATH", dbpath);
 	} else
 		strlimcpy(dbpath, cwdpath, sizeof(dbpath));
+	/*
+	 * Use the current generation if the tag files are published
+	 * by 'gtags --atomic'.
+	 */
+	{
+		const char *current = published(dbpath);
+
+		if (current)
+			strlimcpy(dbpath, current, sizeof(dbpath));
+	}
 	setupdbpath(0);				/* for parsers */
 	if (cflag && !usable("gzip")) {
 		warning("'gzip' command not found. -c option ignored.");
@@ -1989,6 +2209,15 @@ main(int argc, char **argv)
 		make_directory_in_distpath("icons");
 	if (auto_completion || tree_view)
 		 make_directory_in_distpath("js");
+	if (auto_completion) {
+		make_directory_in_distpath(COMPLETION_DIR);
+		make_directory_in_distpath(COMPLETION_DIR "/definition");
+		make_directory_in_distpath(COMPLETION_DIR "/symbol");
+	}
+	/*
+	 * (#) load the manifest of the last run.
+	 */
+	manifest_open(config_signature());
 	/*
 	 * (1) make CGI program
 	 */
@@ -2020,6 +2249,7 @@ main(int argc, char **argv)
 		makehtaccess(cgidir, ".htaccess");
 		if (chmod(makepath(distpath, ".htaccess", NULL), 0644) < 0)
 			die("cannot chmod .htaccess skeleton.");
+		makeserverconf("SERVER");
 		/*
 		 * Always make bless.sh.
 		 * Don't grant execute permission to bless script.
@@ -2080,6 +2310,18 @@ main(int argc, char **argv)
 		message("[%s] (4) making search index ...", now());
 		makesearchindex("search.html");
 	}
+	/*
+	 * (#) completion index. (js/completion/)
+	 */
+	if (auto_completion) {
+		int name_total;
+
+		message("[%s] (#) making completion index ...", now());
+		tim = statistics_time_start("Time of making completion index");
+		name_total = makecompletionindex();
+		statistics_time_end(tim);
+		message("Total %d names.", name_total);
+	}
 	{
 		STRBUF *defines = strbuf_open(0);
 		STRBUF *files = strbuf_open(0);
@@ -2149,6 +2391,10 @@ main(int argc, char **argv)
 	tim = statistics_time_start("Time of making hypertext");
 	makehtml(file_total);
 	statistics_time_end(tim);
+	/*
+	 * (#) write the manifest for the next run.
+	 */
+	manifest_close();
 	/*
 	 * (10) rebuild script. (rebuild.sh)
 	 *
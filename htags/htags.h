@@ -49,6 +49,7 @@
 #define INCS	"I"
 #define INCREFS "J"
 #define SYMS	"Y"
+#define COMPLETION_DIR	"js/completion"
 
 extern int w32;
 extern const char *www;
@@ -86,6 +87,7 @@ extern int debug;
 extern int show_help;
 extern int show_version;
 extern int caution;
+extern int incremental;
 extern int auto_completion;
 extern int tree_view;
 extern int dynamic;
@@ -126,6 +128,8 @@ extern const char *file_icon;
 
 extern int ncol;
 extern int tabs;
+extern int jobs;
+extern int cache_size;
 extern int flist_fields;
 extern int full_path;
 extern int map_file;
@@ -146,4 +150,8 @@ extern int definition_header;
 extern const char *htags_options;
 extern const char *include_file_suffixes;
 
+/* dupindex.c */
+const char *first_definition(void);
+const char *next_definition(void);
+
 #endif /* _HTAGS_H_ */
@@ -0,0 +1,466 @@
+/*
+ * Copyright (c) 2010 Tama Communications Corporation
+ *
+ * This file is part of GNU GLOBAL.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#include <stdio.h>
+#ifdef STDC_HEADERS
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#else
+#include <strings.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#include "global.h"
+#include "hash-string.h"
+#include "htags.h"
+#include "manifest.h"
+
+/*
+ * Manifest of the generated files.
+ *
+ * With the --incremental option, htags records a signature for each
+ * generated file in HTML/MANIFEST. The signature of a source page (S/)
+ * is computed from everything the page depends on: the source file,
+ * its tag records and the records of the tags it refers to. The
+ * signature of the other pages (D/, R/, Y/, I/, J/, files/ and defines/)
+ * is computed from their contents.
+ *
+ * On rerun, a source page whose signature is unchanged is not converted
+ * again, and the other pages are rewritten only when the contents changed.
+ * They are made in the memory (manifest_write()) or in a temporary file
+ * (manifest_open_output()). The pages which are recorded in the old
+ * manifest but were not generated this time are removed.
+ *
+ * Format of the manifest:
+ *
+ *	# htags manifest
+ *	config <signature>		... signature of the configuration
+ *	<signature> <file>		... file is relative to HTML/
+ *	...
+ */
+static STRHASH *old_entries;		/* entries of the last run	*/
+static STRHASH *new_entries;		/* entries of this run		*/
+static char config_signature[32];
+static int config_matched;
+
+/*
+ * signature_init: initialize signature.
+ *
+ *	o)	sig	signature
+ */
+void
+signature_init(SIGNATURE *sig)
+{
+	sig->h1 = 0;
+	sig->h2 = 0;
+}
+/*
+ * signature_update: add data to signature.
+ *
+ *	io)	sig	signature
+ *	i)	data	data
+ *	i)	len	length of data
+ *
+ * The signature is made of two functions of __hash_buffer() family.
+ * Since the second one depends on how the data is divided, the same
+ * data should be added in the same way.
+ */
+void
+signature_update(SIGNATURE *sig, const char *data, int len)
+{
+	sig->h1 = (unsigned int)__hash_buffer(data, len, sig->h1, 0);
+	sig->h2 = (unsigned int)__hash_buffer(data, len, sig->h2, 1);
+}
+/*
+ * signature_puts: add string to signature.
+ *
+ *	io)	sig	signature
+ *	i)	s	string
+ *
+ * The terminating null character is also added to separate fields.
+ */
+void
+signature_puts(SIGNATURE *sig, const char *s)
+{
+	signature_update(sig, s, strlen(s) + 1);
+}
+/*
+ * signature_putn: add number to signature.
+ *
+ *	io)	sig	signature
+ *	i)	n	number
+ */
+void
+signature_putn(SIGNATURE *sig, int n)
+{
+	char buf[32];
+
+	snprintf(buf, sizeof(buf), "%d", n);
+	signature_puts(sig, buf);
+}
+/*
+ * signature_value: return signature string.
+ *
+ *	i)	sig	signature
+ *	r)		signature string
+ */
+const char *
+signature_value(SIGNATURE *sig)
+{
+	static char buf[32];
+
+	snprintf(buf, sizeof(buf), "%08x%08x", sig->h1, sig->h2);
+	return buf;
+}
+/*
+ * file_signature: compute signature of file contents.
+ *
+ *	i)	path	path of file
+ *	r)		signature string
+ */
+static const char *
+file_signature(const char *path)
+{
+	SIGNATURE sig;
+	char buf[8192];
+	FILE *ip = fopen(path, "rb");
+	int n;
+
+	if (ip == NULL)
+		die("cannot open file '%s'.", path);
+	signature_init(&sig);
+	while ((n = fread(buf, 1, sizeof(buf), ip)) > 0)
+		signature_update(&sig, buf, n);
+	fclose(ip);
+	return signature_value(&sig);
+}
+/*
+ * relative_path: return path name relative to the dist directory.
+ *
+ *	i)	path	path name
+ *	r)		relative path name
+ */
+static const char *
+relative_path(const char *path)
+{
+	int len = strlen(distpath);
+
+	if (!strncmp(path, distpath, len) && path[len] == '/')
+		return path + len + 1;
+	return path;
+}
+/*
+ * put_entry: put an entry into the hash.
+ *
+ *	i)	sh	hash
+ *	i)	file	relative path name
+ *	i)	sig	signature string
+ */
+static void
+put_entry(STRHASH *sh, const char *file, const char *sig)
+{
+	struct sh_entry *entry = strhash_assign(sh, file, 1);
+
+	entry->value = strhash_strdup(sh, sig, 0);
+}
+/*
+ * read_entries: read entries of manifest file.
+ *
+ *	i)	path	manifest file
+ *	i)	sh	hash
+ *	o)	config	configuration signature (if not NULL)
+ *	i)	size	size of config
+ *	r)		0: succeeded, -1: file not found
+ */
+static int
+read_entries(const char *path, STRHASH *sh, char *config, int size)
+{
+	STRBUF *sb = strbuf_open(0);
+	FILE *ip = fopen(path, "r");
+	char *line, *p;
+
+	if (ip == NULL) {
+		strbuf_close(sb);
+		return -1;
+	}
+	while ((line = strbuf_fgets(sb, ip, STRBUF_NOCRLF)) != NULL) {
+		if (*line == '#' || *line == '\0')
+			continue;
+		p = locatestring(line, " ", MATCH_FIRST);
+		if (p == NULL)
+			die("invalid manifest file '%s'.", path);
+		*p++ = '\0';
+		if (!strcmp(line, "config")) {
+			if (config)
+				strlimcpy(config, p, size);
+		} else {
+			put_entry(sh, p, line);
+		}
+	}
+	fclose(ip);
+	strbuf_close(sb);
+	return 0;
+}
+/*
+ * write_entries: write entries into file.
+ *
+ *	i)	path	file
+ *	i)	sh	hash
+ *	i)	config	configuration signature (if not NULL)
+ */
+static void
+write_entries(const char *path, STRHASH *sh, const char *config)
+{
+	struct sh_entry *entry;
+	FILE *op = fopen(path, "w");
+
+	if (op == NULL)
+		die("cannot make file '%s'.", path);
+	if (config) {
+		fputs("# htags manifest\n", op);
+		fprintf(op, "config %s\n", config);
+	}
+	for (entry = strhash_first(sh); entry; entry = strhash_next(sh))
+		fprintf(op, "%s %s\n", (const char *)entry->value, entry->name);
+	if (fclose(op) != 0)
+		die("cannot write file '%s'.", path);
+}
+/*
+ * manifest_open: load the manifest of the last run.
+ *
+ *	i)	config	signature of the configuration
+ *
+ * If the configuration differs from the last run, every file is
+ * generated again.
+ */
+void
+manifest_open(const char *config)
+{
+	char path[MAXPATHLEN];
+	char last_config[32];
+
+	if (!incremental)
+		return;
+	old_entries = strhash_open(1024);
+	new_entries = strhash_open(1024);
+	strlimcpy(config_signature, config, sizeof(config_signature));
+	strlimcpy(path, makepath(distpath, MANIFEST_NAME, NULL), sizeof(path));
+	last_config[0] = '\0';
+	if (read_entries(path, old_entries, last_config, sizeof(last_config)) < 0)
+		return;
+	config_matched = !strcmp(last_config, config);
+	/*
+	 * The manifest is removed until this run completes, not to trust
+	 * the files which might be rewritten by an interrupted run.
+	 */
+	if (unlink(path) < 0)
+		die("cannot remove file '%s'.", path);
+}
+/*
+ * manifest_check: check whether the file is up to date.
+ *
+ *	i)	path	generated file
+ *	i)	sig	signature string
+ *	r)		1: up to date, 0: should be generated
+ */
+int
+manifest_check(const char *path, const char *sig)
+{
+	struct sh_entry *entry;
+
+	if (!incremental || !config_matched)
+		return 0;
+	entry = strhash_assign(old_entries, relative_path(path), 0);
+	if (entry == NULL || strcmp((const char *)entry->value, sig))
+		return 0;
+	return test("f", path) ? 1 : 0;
+}
+/*
+ * manifest_put: record the signature of the generated file.
+ *
+ *	i)	path	generated file
+ *	i)	sig	signature string
+ */
+void
+manifest_put(const char *path, const char *sig)
+{
+	if (!incremental)
+		return;
+	put_entry(new_entries, relative_path(path), sig);
+}
+/*
+ * manifest_open_output: open output file.
+ *
+ *	i)	path	path of output file
+ *	i)	compress 1: compress, 0: doesn't compress
+ *	r)		file operator
+ *
+ * With the --incremental option, the output is written into a temporary
+ * file, which is moved to the path by manifest_close_output() only when
+ * the contents changed.
+ */
+FILEOP *
+manifest_open_output(const char *path, int compress)
+{
+	char tmp[MAXPATHLEN];
+
+	if (!incremental)
+		return open_output_file(path, compress);
+	snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+	return open_output_file(tmp, compress);
+}
+/*
+ * manifest_close_output: close output file.
+ *
+ *	i)	fileop	file operator
+ */
+void
+manifest_close_output(FILEOP *fileop)
+{
+	char tmp[MAXPATHLEN], path[MAXPATHLEN];
+	const char *sig;
+	int len;
+
+	if (!incremental) {
+		close_file(fileop);
+		return;
+	}
+	strlimcpy(tmp, fileop->path, sizeof(tmp));
+	close_file(fileop);
+	strlimcpy(path, tmp, sizeof(path));
+	len = strlen(path) - strlen(".tmp");
+	path[len] = '\0';
+	sig = file_signature(tmp);
+	if (manifest_check(path, sig)) {
+		if (unlink(tmp) < 0)
+			die("cannot remove file '%s'.", tmp);
+	} else {
+#if defined(_WIN32) || defined(__DJGPP__)
+		unlink(path);
+#endif
+		if (rename(tmp, path) < 0)
+			die("cannot rename file '%s'.", tmp);
+	}
+	manifest_put(path, sig);
+}
+/*
+ * manifest_write: write the contents into file if it changed.
+ *
+ *	i)	path	path of output file
+ *	i)	sb	contents
+ *	i)	compress 1: compress, 0: doesn't compress
+ */
+void
+manifest_write(const char *path, STRBUF *sb, int compress)
+{
+	const char *sig = NULL;
+	FILEOP *fileop;
+
+	if (incremental) {
+		SIGNATURE signature;
+
+		signature_init(&signature);
+		signature_update(&signature, strbuf_value(sb), strbuf_getlen(sb));
+		sig = signature_value(&signature);
+		if (manifest_check(path, sig)) {
+			manifest_put(path, sig);
+			return;
+		}
+	}
+	fileop = open_output_file(path, compress);
+	fputs(strbuf_value(sb), get_descripter(fileop));
+	close_file(fileop);
+	if (incremental)
+		manifest_put(path, sig);
+}
+/*
+ * manifest_begin_part: begin recording in a child process.
+ *
+ * The entries recorded before fork(2) are left to the parent process.
+ */
+void
+manifest_begin_part(void)
+{
+	if (!incremental)
+		return;
+	strhash_reset(new_entries);
+}
+/*
+ * manifest_save_part: save the entries recorded by a child process.
+ *
+ *	i)	k	part number
+ */
+void
+manifest_save_part(int k)
+{
+	char name[32];
+
+	if (!incremental)
+		return;
+	snprintf(name, sizeof(name), "%s.%d", MANIFEST_NAME, k);
+	write_entries(makepath(distpath, name, NULL), new_entries, NULL);
+}
+/*
+ * manifest_merge_part: merge the entries saved by a child process.
+ *
+ *	i)	k	part number
+ */
+void
+manifest_merge_part(int k)
+{
+	char name[32], path[MAXPATHLEN];
+
+	if (!incremental)
+		return;
+	snprintf(name, sizeof(name), "%s.%d", MANIFEST_NAME, k);
+	strlimcpy(path, makepath(distpath, name, NULL), sizeof(path));
+	if (read_entries(path, new_entries, NULL, 0) < 0)
+		die("cannot open file '%s'.", path);
+	if (unlink(path) < 0)
+		die("cannot remove file '%s'.", path);
+}
+/*
+ * manifest_close: remove obsolete files and write the manifest.
+ */
+void
+manifest_close(void)
+{
+	struct sh_entry *entry;
+
+	if (!incremental)
+		return;
+	for (entry = strhash_first(old_entries); entry; entry = strhash_next(old_entries)) {
+		if (strhash_assign(new_entries, entry->name, 0) == NULL) {
+			const char *path = makepath(distpath, entry->name, NULL);
+
+			if (test("f", path) && unlink(path) < 0)
+				die("cannot remove file '%s'.", path);
+		}
+	}
+	write_entries(makepath(distpath, MANIFEST_NAME, NULL), new_entries, config_signature);
+	strhash_close(old_entries);
+	strhash_close(new_entries);
+	old_entries = new_entries = NULL;
+}
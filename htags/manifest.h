@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2010 Tama Communications Corporation
+ *
+ * This file is part of GNU GLOBAL.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _MANIFEST_H_
+#define _MANIFEST_H_
+
+#include "fileop.h"
+#include "strbuf.h"
+
+#define MANIFEST_NAME	"MANIFEST"
+
+/*
+ * Signature of the things which a generated file depends on.
+ */
+typedef struct {
+	unsigned int h1;
+	unsigned int h2;
+} SIGNATURE;
+
+void signature_init(SIGNATURE *);
+void signature_update(SIGNATURE *, const char *, int);
+void signature_puts(SIGNATURE *, const char *);
+void signature_putn(SIGNATURE *, int);
+const char *signature_value(SIGNATURE *);
+
+void manifest_open(const char *);
+int manifest_check(const char *, const char *);
+void manifest_put(const char *, const char *);
+FILEOP *manifest_open_output(const char *, int);
+void manifest_close_output(FILEOP *);
+void manifest_write(const char *, STRBUF *, int);
+void manifest_begin_part(void);
+void manifest_save_part(int);
+void manifest_merge_part(int);
+void manifest_close(void);
+
+#endif /* ! _MANIFEST_H_ */
@@ -64,6 +64,16 @@ load_gpath(const char *dbpath)
 	}
 	dbop_close(dbop);
 }
+/*
+ * fix_gpath: move the loaded gpath into the memory.
+ *
+ * After this call, the path table can be shared by forked processes.
+ */
+void
+fix_gpath(void)
+{
+	assoc_load(assoc);
+}
 /*
  * unload_gpath: load gpath tag file.
  *
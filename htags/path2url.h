@@ -22,6 +22,7 @@
 void load_gpath(const char *);
 const char *path2fid(const char *);
 const char *path2fid_readonly(const char *);
+void fix_gpath(void);
 void unload_gpath(void);
 
 #endif /* ! _GPATH_H_ */
@@ -27,12 +27,15 @@
 #include <stdlib.h>
 #endif
 #include <ctype.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 
 #include "global.h"
 #include "anchor.h"
 #include "cache.h"
 #include "common.h"
 #include "incop.h"
+#include "manifest.h"
 #include "path2url.h"
 #include "htags.h"
 
@@ -901,3 +904,124 @@ src2html(const char *src, const char *html, int notsource)
 	close_file(fileop_out);
 	close_file(fileop_in);
 }
+/*
+ * include_signature: compute signature of the include file table.
+ *
+ *	r)		signature string
+ *
+ * The include lines of a source file refer to this table.
+ */
+static const char *
+include_signature(void)
+{
+	static char buf[32];
+
+	if (buf[0] == '\0') {
+		SIGNATURE sig;
+		struct data *inc;
+
+		signature_init(&sig);
+		for (inc = first_inc(); inc; inc = next_inc()) {
+			signature_puts(&sig, inc->name);
+			signature_putn(&sig, inc->id);
+			signature_putn(&sig, inc->count);
+			if (inc->contents)
+				signature_puts(&sig, strbuf_value(inc->contents));
+		}
+		strlimcpy(buf, signature_value(&sig), sizeof(buf));
+	}
+	return buf;
+}
+/*
+ * src2html_signature: compute signature of the hypertext of source code.
+ *
+ *	i)	src	source file
+ *	i)	notsource 1: isn't source, 0: source.
+ *	r)		signature string
+ *
+ * The signature covers what src2html() reads: the source file, the
+ * directories, the anchors of the file, the tag records which the
+ * anchors refer to and the include file tables.
+ * The anchors must be loaded by anchor_load() before this call.
+ */
+const char *
+src2html_signature(const char *src, int notsource)
+{
+	SIGNATURE sig;
+	struct stat st;
+	char buf[MAXPATHLEN], *p;
+
+	signature_init(&sig);
+	signature_puts(&sig, src);
+	signature_puts(&sig, path2fid(src));
+	if (stat(src, &st) < 0)
+		die("cannot stat file '%s'.", src);
+	signature_putn(&sig, (int)st.st_mtime);
+	signature_putn(&sig, (int)st.st_size);
+	/*
+	 * directories referred to by fill_anchor().
+	 */
+	strlimcpy(buf, src, sizeof(buf));
+	for (p = buf; *p; p++) {
+		if (*p == sep) {
+			*p = '\0';
+			signature_puts(&sig, path2fid(buf));
+			*p = sep;
+		}
+	}
+	if (!notsource) {
+		const char *basename;
+		struct data *incref;
+		struct anchor *a;
+
+		basename = locatestring(src, "/", MATCH_LAST);
+		if (basename)
+			basename++;
+		else
+			basename = src;
+		incref = get_included(basename);
+		if (incref) {
+			signature_putn(&sig, incref->id);
+			signature_putn(&sig, incref->ref_count);
+			if (incref->ref_contents)
+				signature_puts(&sig, strbuf_value(incref->ref_contents));
+		}
+		signature_puts(&sig, include_signature());
+		for (a = anchor_first(); a; a = anchor_next()) {
+			const char *name = gettag(a);
+			const char *line;
+			int db;
+
+			signature_putn(&sig, a->lineno);
+			signature_update(&sig, &a->type, 1);
+			signature_puts(&sig, name);
+			if (a->type == 'R')
+				db = GTAGS;
+			else if (a->type == 'Y')
+				db = GSYMS;
+			else
+				db = GRTAGS;
+			if (db == GSYMS && !symbol)
+				continue;
+			/*
+			 * About the format of 'line', please see the head comment of cache.c.
+			 */
+			line = cache_get(db, name);
+			if (line == NULL) {
+				signature_puts(&sig, "");
+			} else if (*line == ' ') {
+				const char *fid = line + 1;
+
+				signature_puts(&sig, fid);
+				signature_puts(&sig, nextstring(fid));
+			} else {
+				const char *fid = nextstring(line);
+
+				signature_puts(&sig, line);
+				signature_puts(&sig, fid);
+				signature_puts(&sig, gpath_fid2path(fid, NULL));
+			}
+		}
+	}
+	return signature_value(&sig);
+}
@@ -10,7 +10,7 @@
  *
  *	jquery.suggest 1.1+ - 2010-07-08
  *
- *	A little code for extraParams was added by Tama Communications Corporation.
+ *	A little code for extraParams and lookup was added by Tama Communications Corporation.
  *	Since it was put on the public domain, you can use and distribute this file
  *	according to the original license.
  */
@@ -135,7 +135,7 @@
 					
 				} else {
 				
-					$.get(options.source, params, function(txt) {
+					var receive = function(txt) {
 
 						$results.hide();
 						
@@ -144,7 +144,11 @@
 						displayItems(items);
 						addToCache(cachekey, items, txt.length);
 						
-					});
+					};
+
+					// options.lookup may answer without the server.
+					if (!options.lookup || !options.lookup(params, receive))
+						$.get(options.source, params, receive);
 					
 				}
 				
@@ -310,6 +314,7 @@
 		options.delimiter = options.delimiter || '\n';
 		options.onSelect = options.onSelect || false;
 		options.maxCacheSize = options.maxCacheSize || 65536;
+		options.lookup = options.lookup || false;
 
 		this.each(function() {
 			new $.suggest(this, options);
@@ -50,6 +50,7 @@ static char sccsid[] = "@(#)bt_seq.c	8.7 (Berkeley) 7/20/94";
 #include "btree.h"
 
 static int __bt_first(BTREE *, const DBT *, EPG *, int *);
+static int __bt_upper(BTREE *, const DBT *, EPG *);
 static int __bt_seqadv(BTREE *, EPG *, int);
 static int __bt_seqset(BTREE *, EPG *, DBT *, int);
 
@@ -69,7 +70,10 @@ static int __bt_seqset(BTREE *, EPG *, DBT *, int);
  *	dbp:	pointer to access method
  *	key:	key for positioning and return value
  *	data:	data return value
- *	flags:	R_CURSOR, R_FIRST, R_LAST, R_NEXT, R_PREV.
+ *	flags:	R_CURSOR, R_FIRST, R_LAST, R_NEXT, R_PREV, R_NEXTKEY.
+ *
+ * R_NEXTKEY positions the scan at the first key strictly greater than
+ * the specified key, skipping all of its duplicate records at once.
  *
  * Returns:
  *	RET_ERROR, RET_SUCCESS or RET_SPECIAL if there's no next key.
@@ -110,6 +114,13 @@ __bt_seq(dbp, key, data, flags)
 	case R_CURSOR:
 		status = __bt_seqset(t, &e, key, flags);
 		break;
+	case R_NEXTKEY:
+		if (key->data == NULL || key->size == 0) {
+			errno = EINVAL;
+			return (RET_ERROR);
+		}
+		status = __bt_upper(t, key, &e);
+		break;
 	default:
 		errno = EINVAL;
 		return (RET_ERROR);
@@ -431,6 +442,68 @@ __bt_first(t, key, erval, exactp)
 	return (RET_SUCCESS);
 }
 
+/*
+ * __bt_upper --
+ *	Find the first entry greater than the key.
+ *
+ * Parameters:
+ *	t:	the tree
+ *    key:	the key
+ *  erval:	return EPG
+ *
+ * Returns:
+ *	RET_SUCCESS, RET_ERROR or RET_SPECIAL if no such key exists.
+ *
+ * Unlike __bt_first, this descends the tree on the rightmost path whose
+ * separator is not greater than the key, so no duplicate record of the
+ * key is visited.  Side effects: pins the page of the returned entry.
+ */
+static int
+__bt_upper(t, key, erval)
+	BTREE *t;
+	const DBT *key;
+	EPG *erval;
+{
+	PAGE *h;
+	EPG e;
+	indx_t base, index, lim;
+	pgno_t pg;
+
+	for (pg = P_ROOT;;) {
+		if ((h = mpool_get(t->bt_mp, pg, 0)) == NULL)
+			return (RET_ERROR);
+
+		/* Find the smallest index whose key is greater than the key. */
+		e.page = h;
+		for (base = 0, lim = NEXTINDEX(h); lim; lim >>= 1) {
+			e.index = index = base + (lim >> 1);
+			if (__bt_cmp(t, key, &e) >= 0) {
+				base = index + 1;
+				--lim;
+			}
+		}
+		if (h->flags & P_BLEAF)
+			break;
+		index = base ? base - 1 : 0;
+		pg = GETBINTERNAL(h, index)->pgno;
+		mpool_put(t->bt_mp, h, 0);
+	}
+
+	/* If at the end of a page, find the next entry. */
+	while (base == NEXTINDEX(h)) {
+		pg = h->nextpg;
+		mpool_put(t->bt_mp, h, 0);
+		if (pg == P_INVALID)
+			return (RET_SPECIAL);
+		if ((h = mpool_get(t->bt_mp, pg, 0)) == NULL)
+			return (RET_ERROR);
+		base = 0;
+	}
+	erval->page = h;
+	erval->index = base;
+	return (RET_SUCCESS);
+}
+
 /*
  * __bt_setcur --
  *	Set the cursor to an entry in the tree.
@@ -72,6 +72,7 @@ typedef struct {
 #define	R_PREV		9		/* seq (BTREE, RECNO) */
 #define	R_SETCURSOR	10		/* put (RECNO) */
 #define	R_RECNOSYNC	11		/* sync (RECNO) */
+#define	R_NEXTKEY	12		/* seq (BTREE) */
 
 typedef enum { DB_BTREE, DB_HASH, DB_RECNO } DBTYPE;
 
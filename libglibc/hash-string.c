@@ -45,3 +45,37 @@ __hash_string (str_param)
     }
   return hval;
 }
+
+
+/* The same function for LEN bytes of BUF_PARAM, which may include null
+   characters.  The computation starts from HVAL, so that data can be
+   hashed in pieces by passing the value for the previous piece (0 at
+   first).  SEED selects a function of a family: each byte is XORed with
+   a byte of a sequence generated from SEED before it is added.  The
+   functions for different seeds are independent enough to be used for
+   perfect hashing.  With HVAL 0 and SEED 0, the value for a string is
+   equal to __hash_string().  */
+unsigned long int
+__hash_buffer (buf_param, len, hval, seed)
+     const char *buf_param;
+     size_t len;
+     unsigned long int hval;
+     unsigned long int seed;
+{
+  unsigned long int g, key = 0;
+  const char *buf = buf_param;
+
+  while (len-- > 0)
+    {
+      key = (key * 0x9e3779b9UL + seed) & 0xffffffffUL;
+      hval <<= 4;
+      hval += (unsigned char) *buf++ ^ (key >> 24);
+      g = hval & ((unsigned long int) 0xf << (HASHWORDBITS - 4));
+      if (g != 0)
+	{
+	  hval ^= g >> (HASHWORDBITS - 8);
+	  hval ^= g;
+	}
+    }
+  return hval;
+}
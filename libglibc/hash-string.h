@@ -19,6 +19,8 @@
 
 /* @@ end of prolog @@ */
 
+#include <stddef.h>
+
 #ifndef PARAMS
 # if __STDC__ || defined __GNUC__ || defined __SUNPRO_C || defined __cplusplus || __PROTOTYPES
 #  define PARAMS(Args) Args
@@ -35,3 +37,11 @@
    [see Aho/Sethi/Ullman, COMPILERS: Principles, Techniques and Tools,
    1986, 1987 Bell Telephone Laboratories, Inc.]  */
 extern unsigned long int __hash_string PARAMS ((const char *__str_param));
+
+/* The same function for a buffer which may include null characters.
+   It can be computed in pieces, and a seed selects a function of a
+   family of hash functions.  */
+extern unsigned long int __hash_buffer PARAMS ((const char *__buf_param,
+						size_t __len,
+						unsigned long int __hval,
+						unsigned long int __seed));
@@ -184,7 +184,7 @@ C_family(const struct parser_param *param, int type)
 							strlimcpy(savetok, "sys_", sizeof("sys_"));
 							strlimcpy(savetok+4, arg, sizeof(savetok)-4);
 						}
-						PUT(PARSER_DEF, savetok, savelineno, saveline);
+						PUT(PARSER_DEF|PARSER_KIND_FUNCTION, savetok, savelineno, saveline);
 					} else {
 						/* for Linux kernel */
 						if (*arg && (!strcmp(savetok, "DEFINE_SPINLOCK") ||
@@ -194,19 +194,19 @@ C_family(const struct parser_param *param, int type)
 							     !strcmp(savetok, "DECLARE_WAIT_QUEUE_HEAD") ||
 							     !strcmp(savetok, "LIST_HEAD") ||
 							     !strcmp(savetok, "HLIST_HEAD"))) {
-							PUT(PARSER_DEF, arg, savelineno, saveline);
+							PUT(PARSER_DEF|PARSER_KIND_VARIABLE, arg, savelineno, saveline);
 						} else if (!strncmp(savetok, "DEFINE_PER_CPU", 14) && *arg) {
 							/* we want 'name' in DEFINE_PER_CPU(type, name) */
 							message("saving percpu symbol: %s(%s).", savetok, arg);
-							PUT(PARSER_DEF, arg, savelineno, saveline);
+							PUT(PARSER_DEF|PARSER_KIND_VARIABLE, arg, savelineno, saveline);
 						} else if (!strncmp(savetok, "TRACE_EVENT", 11) && *arg) {
 							strlimcpy(savetok, "trace_", sizeof("trace_"));
 							strlimcpy(savetok+6, arg, sizeof(savetok)-6);
-							PUT(PARSER_DEF, savetok, savelineno, saveline);
+							PUT(PARSER_DEF|PARSER_KIND_FUNCTION, savetok, savelineno, saveline);
 						} else if (!strncmp(savetok, "DEFINE_EVENT", 12) && *arg) {
 							strlimcpy(savetok, "trace_", sizeof("trace_"));
 							strlimcpy(savetok+6, arg, sizeof(savetok)-6);
-							PUT(PARSER_DEF, savetok, savelineno, saveline);
+							PUT(PARSER_DEF|PARSER_KIND_FUNCTION, savetok, savelineno, saveline);
 						} else {
 							PUT(PARSER_REF_SYM, savetok, savelineno, saveline);
 						}
@@ -229,11 +229,11 @@ C_family(const struct parser_param *param, int type)
 					c = peekc(0);
 					if (c == '=') {
 						initializer = 1;
-						PUT(PARSER_DEF, savetok, savelineno, saveline);
+						PUT(PARSER_DEF|PARSER_KIND_VARIABLE, savetok, savelineno, saveline);
 						break;
 					} else if (c == ';' || c == ',') {
 						if (!initializer) {
-							PUT(PARSER_DEF, savetok, savelineno, saveline);
+							PUT(PARSER_DEF|PARSER_KIND_VARIABLE, savetok, savelineno, saveline);
 							break;
 						}
 						initializer = 0;
@@ -326,7 +326,7 @@ C_family(const struct parser_param *param, int type)
 				level = 0;
 			}
 			if (yaccstatus == DECLARATIONS) {
-				PUT(PARSER_DEF, "yyparse", lineno, sp);
+				PUT(PARSER_DEF|PARSER_KIND_FUNCTION, "yyparse", lineno, sp);
 				yaccstatus = RULES;
 			} else if (yaccstatus == RULES)
 				yaccstatus = PROGRAMS;
@@ -354,7 +354,7 @@ C_family(const struct parser_param *param, int type)
 			break;
 		case YACC_UNION:	/* %union {...} */
 			if (yaccstatus == DECLARATIONS)
-				PUT(PARSER_DEF, "YYSTYPE", lineno, sp);
+				PUT(PARSER_DEF|PARSER_KIND_TYPE, "YYSTYPE", lineno, sp);
 			break;
 		/*
 		 * #xxx
@@ -368,14 +368,14 @@ C_family(const struct parser_param *param, int type)
 				break;
 			}
 			if (peekc(1) == '('/* ) */) {
-				PUT(PARSER_DEF, token, lineno, sp);
+				PUT(PARSER_DEF|PARSER_KIND_MACRO, token, lineno, sp);
 				while ((c = nexttoken("()", c_reserved_word)) != EOF && c != '\n' && c != /* ( */ ')')
 					if (c == SYMBOL)
 						PUT(PARSER_REF_SYM, token, lineno, sp);
 				if (c == '\n')
 					pushbacktoken();
 			} else {
-				PUT(PARSER_DEF, token, lineno, sp);
+				PUT(PARSER_DEF|PARSER_KIND_MACRO, token, lineno, sp);
 			}
 			break;
 		case SHARP_IMPORT:
@@ -423,7 +423,7 @@ C_family(const struct parser_param *param, int type)
 			c = nexttoken(interested, c_reserved_word);
 			if (c == SYMBOL) {
 				if (peekc(0) == '{') /* } */ {
-					PUT(PARSER_DEF, token, lineno, sp);
+					PUT(PARSER_DEF|PARSER_KIND_TYPE, token, lineno, sp);
 				} else {
 					PUT(PARSER_REF_SYM, token, lineno, sp);
 				}
@@ -451,7 +451,7 @@ C_family(const struct parser_param *param, int type)
 						if (--level == savelevel)
 							break;
 					} else if (c == SYMBOL) {
-						PUT(PARSER_DEF, token, lineno, sp);
+						PUT(PARSER_DEF|PARSER_KIND_MACRO, token, lineno, sp);
 					}
 				}
 			} else {
@@ -502,7 +502,7 @@ C_family(const struct parser_param *param, int type)
 					/* read enum name if exist */
 					if (c == SYMBOL) {
 						if (peekc(0) == '{') /* } */ {
-							PUT(PARSER_DEF, token, lineno, sp);
+							PUT(PARSER_DEF|PARSER_KIND_TYPE, token, lineno, sp);
 						} else {
 							PUT(PARSER_REF_SYM, token, lineno, sp);
 						}
@@ -523,7 +523,7 @@ C_family(const struct parser_param *param, int type)
 						}
 						if (c == ';' && level == typedef_savelevel) {
 							if (savetok[0])
-								PUT(PARSER_DEF, savetok, savelineno, sp);
+								PUT(PARSER_DEF|PARSER_KIND_TYPE, savetok, savelineno, sp);
 							break;
 						} else if (c == '{')
 							level++;
@@ -533,7 +533,7 @@ C_family(const struct parser_param *param, int type)
 						} else if (c == SYMBOL) {
 							if (c_ == C_ENUM) {
 								if (level > typedef_savelevel)
-									PUT(PARSER_DEF, token, lineno, sp);
+									PUT(PARSER_DEF|PARSER_KIND_MACRO, token, lineno, sp);
 								else if (level == typedef_savelevel)
 									PUT(PARSER_REF_SYM, token, lineno, sp);
 							} else {
@@ -589,7 +589,7 @@ C_family(const struct parser_param *param, int type)
 						}
 					} else if (c == ',' || c == ';') {
 						if (savetok[0]) {
-							PUT(PARSER_DEF, savetok, lineno, sp);
+							PUT(PARSER_DEF|PARSER_KIND_TYPE, savetok, lineno, sp);
 							savetok[0] = 0;
 						}
 					}
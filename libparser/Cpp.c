@@ -114,7 +114,7 @@ Cpp(const struct parser_param *param)
 					if (function_definition(param)) {
 						/* ignore constructor */
 						if (strcmp(stack[classlevel].classname, savetok))
-							PUT(PARSER_DEF, savetok, savelineno, saveline);
+							PUT(PARSER_DEF|PARSER_KIND_FUNCTION, savetok, savelineno, saveline);
 					} else {
 						PUT(PARSER_REF_SYM, savetok, savelineno, saveline);
 					}
@@ -146,7 +146,7 @@ Cpp(const struct parser_param *param)
 			 * namespace [name] { ... }
 			 */
 			if ((c = nexttoken(interested, cpp_reserved_word)) == SYMBOL) {
-				PUT(PARSER_DEF, token, lineno, sp);
+				PUT(PARSER_DEF|PARSER_KIND_TYPE, token, lineno, sp);
 				if ((c = nexttoken(interested, cpp_reserved_word)) == '=') {
 					crflag = 1;
 					break;
@@ -187,7 +187,7 @@ Cpp(const struct parser_param *param)
 				 */
 				if (peekc(0) != ';') {
 					startclass = 1;
-					PUT(PARSER_DEF, token, lineno, sp);
+					PUT(PARSER_DEF|PARSER_KIND_TYPE, token, lineno, sp);
 				}
 			}
 			break;
@@ -267,14 +267,14 @@ Cpp(const struct parser_param *param)
 				break;
 			}
 			if (peekc(1) == '('/* ) */) {
-				PUT(PARSER_DEF, token, lineno, sp);
+				PUT(PARSER_DEF|PARSER_KIND_MACRO, token, lineno, sp);
 				while ((c = nexttoken("()", cpp_reserved_word)) != EOF && c != '\n' && c != /* ( */ ')')
 					if (c == SYMBOL)
 						PUT(PARSER_REF_SYM, token, lineno, sp);
 				if (c == '\n')
 					pushbacktoken();
 			}  else {
-				PUT(PARSER_DEF, token, lineno, sp);
+				PUT(PARSER_DEF|PARSER_KIND_MACRO, token, lineno, sp);
 			}
 			break;
 		case SHARP_IMPORT:
@@ -310,7 +310,7 @@ Cpp(const struct parser_param *param)
 			c = nexttoken(interested, cpp_reserved_word);
 			if (c == SYMBOL) {
 				if (peekc(0) == '{') /* } */ {
-					PUT(PARSER_DEF, token, lineno, sp);
+					PUT(PARSER_DEF|PARSER_KIND_TYPE, token, lineno, sp);
 				} else {
 					PUT(PARSER_REF_SYM, token, lineno, sp);
 				}
@@ -338,7 +338,7 @@ Cpp(const struct parser_param *param)
 						if (--level == savelevel)
 							break;
 					} else if (c == SYMBOL) {
-						PUT(PARSER_DEF, token, lineno, sp);
+						PUT(PARSER_DEF|PARSER_KIND_MACRO, token, lineno, sp);
 					}
 				}
 			} else {
@@ -426,7 +426,7 @@ Cpp(const struct parser_param *param)
 					/* read enum name if exist */
 					if (c == SYMBOL) {
 						if (peekc(0) == '{') /* } */ {
-							PUT(PARSER_DEF, token, lineno, sp);
+							PUT(PARSER_DEF|PARSER_KIND_TYPE, token, lineno, sp);
 						} else {
 							PUT(PARSER_REF_SYM, token, lineno, sp);
 						}
@@ -447,7 +447,7 @@ Cpp(const struct parser_param *param)
 						}
 						if (c == ';' && level == typedef_savelevel) {
 							if (savetok[0])
-								PUT(PARSER_DEF, savetok, savelineno, sp);
+								PUT(PARSER_DEF|PARSER_KIND_TYPE, savetok, savelineno, sp);
 							break;
 						} else if (c == '{')
 							level++;
@@ -457,7 +457,7 @@ Cpp(const struct parser_param *param)
 						} else if (c == SYMBOL) {
 							if (c_ == CPP_ENUM) {
 								if (level > typedef_savelevel)
-									PUT(PARSER_DEF, token, lineno, sp);
+									PUT(PARSER_DEF|PARSER_KIND_MACRO, token, lineno, sp);
 								else if (level == typedef_savelevel)
 									PUT(PARSER_REF_SYM, token, lineno, sp);
 							} else {
@@ -513,7 +513,7 @@ Cpp(const struct parser_param *param)
 						}
 					} else if (c == ',' || c == ';') {
 						if (savetok[0]) {
-							PUT(PARSER_DEF, savetok, lineno, sp);
+							PUT(PARSER_DEF|PARSER_KIND_TYPE, savetok, lineno, sp);
 							savetok[0] = 0;
 						}
 					}
@@ -90,7 +90,7 @@ kconfig(const struct parser_param *param)
 			if (config_item) {
 				char buf[256];
 				snprintf(buf, 256, "CONFIG_%s", token);
-				PUT(PARSER_DEF, buf, lineno, sp);
+				PUT(PARSER_DEF|PARSER_KIND_MACRO, buf, lineno, sp);
 				items++;
 			}
 			symbols++;
@@ -1464,7 +1464,7 @@ yyreduce:
 #line 88 "asm_parse.y"
     {
 			PUT(PARSER_REF_SYM, GET_SYM((yyvsp[(1) - (6)])), (yylsp[(1) - (6)]));
-			PUT(PARSER_DEF, GET_SYM((yyvsp[(3) - (6)])), (yylsp[(3) - (6)]));
+			PUT(PARSER_DEF|PARSER_KIND_FUNCTION, GET_SYM((yyvsp[(3) - (6)])), (yylsp[(3) - (6)]));
 			strbuf_reset(asm_symtable);
 		;}
     break;
@@ -1502,7 +1502,7 @@ yyreduce:
 /* Line 1455 of yacc.c  */
 #line 112 "asm_parse.y"
     {
-			PUT(PARSER_DEF, GET_SYM((yyvsp[(2) - (4)])), (yylsp[(2) - (4)]));
+			PUT(PARSER_DEF|PARSER_KIND_MACRO, GET_SYM((yyvsp[(2) - (4)])), (yylsp[(2) - (4)]));
 			strbuf_reset(asm_symtable);
 		;}
     break;
@@ -1512,7 +1512,7 @@ yyreduce:
 /* Line 1455 of yacc.c  */
 #line 117 "asm_parse.y"
     {
-			PUT(PARSER_DEF, GET_SYM((yyvsp[(2) - (4)])), (yylsp[(2) - (4)]));
+			PUT(PARSER_DEF|PARSER_KIND_MACRO, GET_SYM((yyvsp[(2) - (4)])), (yylsp[(2) - (4)]));
 			strbuf_reset(asm_symtable);
 		;}
     break;
@@ -1522,7 +1522,7 @@ yyreduce:
 /* Line 1455 of yacc.c  */
 #line 122 "asm_parse.y"
     {
-			PUT(PARSER_DEF, GET_SYM((yyvsp[(2) - (4)])), (yylsp[(2) - (4)]));
+			PUT(PARSER_DEF|PARSER_KIND_MACRO, GET_SYM((yyvsp[(2) - (4)])), (yylsp[(2) - (4)]));
 			strbuf_reset(asm_symtable);
 		;}
     break;
@@ -1532,7 +1532,7 @@ yyreduce:
 /* Line 1455 of yacc.c  */
 #line 127 "asm_parse.y"
     {
-			PUT(PARSER_DEF, GET_SYM((yyvsp[(1) - (4)])), (yylsp[(1) - (4)]));
+			PUT(PARSER_DEF|PARSER_KIND_MACRO, GET_SYM((yyvsp[(1) - (4)])), (yylsp[(1) - (4)]));
 			strbuf_reset(asm_symtable);
 		;}
     break;
@@ -1542,7 +1542,7 @@ yyreduce:
 /* Line 1455 of yacc.c  */
 #line 132 "asm_parse.y"
     {
-			PUT(PARSER_DEF, GET_SYM((yyvsp[(2) - (5)])), (yylsp[(2) - (5)]));
+			PUT(PARSER_DEF|PARSER_KIND_MACRO, GET_SYM((yyvsp[(2) - (5)])), (yylsp[(2) - (5)]));
 			strbuf_reset(asm_symtable);
 		;}
     break;
@@ -1552,7 +1552,7 @@ yyreduce:
 /* Line 1455 of yacc.c  */
 #line 137 "asm_parse.y"
     {
-			PUT(PARSER_DEF, GET_SYM((yyvsp[(1) - (4)])), (yylsp[(1) - (4)]));
+			PUT(PARSER_DEF|PARSER_KIND_MACRO, GET_SYM((yyvsp[(1) - (4)])), (yylsp[(1) - (4)]));
 			strbuf_reset(asm_symtable);
 		;}
     break;
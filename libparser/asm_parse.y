@@ -87,7 +87,7 @@ input:	/* empty */
 line:	ASM_ENTRY '(' ASM_SYMBOL ')' error '\n'
 		{
 			PUT(PARSER_REF_SYM, GET_SYM($1), @1);
-			PUT(PARSER_DEF, GET_SYM($3), @3);
+			PUT(PARSER_DEF|PARSER_KIND_FUNCTION, GET_SYM($3), @3);
 			strbuf_reset(asm_symtable);
 		}
 	| ASM_CALL ASM_SYMBOL error '\n'
@@ -110,32 +110,32 @@ line:	ASM_ENTRY '(' ASM_SYMBOL ')' error '\n'
 		}
 	| "#define" ASM_SYMBOL error '\n'
 		{
-			PUT(PARSER_DEF, GET_SYM($2), @2);
+			PUT(PARSER_DEF|PARSER_KIND_MACRO, GET_SYM($2), @2);
 			strbuf_reset(asm_symtable);
 		}
 	| "#undef" ASM_SYMBOL error '\n'
 		{
-			PUT(PARSER_DEF, GET_SYM($2), @2);
+			PUT(PARSER_DEF|PARSER_KIND_MACRO, GET_SYM($2), @2);
 			strbuf_reset(asm_symtable);
 		}
 	| ASM_MACRO ASM_SYMBOL error '\n'
 		{
-			PUT(PARSER_DEF, GET_SYM($2), @2);
+			PUT(PARSER_DEF|PARSER_KIND_MACRO, GET_SYM($2), @2);
 			strbuf_reset(asm_symtable);
 		}
 	| ASM_LABEL ASM_MACRO error '\n'
 		{
-			PUT(PARSER_DEF, GET_SYM($1), @1);
+			PUT(PARSER_DEF|PARSER_KIND_MACRO, GET_SYM($1), @1);
 			strbuf_reset(asm_symtable);
 		}
 	| ASM_EQU ASM_SYMBOL ',' error '\n'
 		{
-			PUT(PARSER_DEF, GET_SYM($2), @2);
+			PUT(PARSER_DEF|PARSER_KIND_MACRO, GET_SYM($2), @2);
 			strbuf_reset(asm_symtable);
 		}
 	| ASM_LABEL ASM_EQU error '\n'
 		{
-			PUT(PARSER_DEF, GET_SYM($1), @1);
+			PUT(PARSER_DEF|PARSER_KIND_MACRO, GET_SYM($1), @1);
 			strbuf_reset(asm_symtable);
 		}
 	| ASM_LABEL ':' error '\n'
@@ -27,7 +27,9 @@
 
 #define PUT(type, tag, lno, line) do {					\
 	DBG_PRINT(level, line);						\
-	param->put(type, tag, lno, curfile, line, param->arg);		\
+	param->put((param->flags & PARSER_LEVEL) ?			\
+		PARSER_MAKETYPE(type, level) : (type),			\
+		tag, lno, curfile, line, param->arg);			\
 } while (0)
 
 #define DBG_PRINT(level, a) do {					\
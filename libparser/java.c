@@ -78,7 +78,7 @@ java(const struct parser_param *param)
 				if (level == stack[classlevel].level && !startequal)
 					/* ignore constructor */
 					if (strcmp(stack[classlevel].classname, token))
-						PUT(PARSER_DEF, token, lineno, sp);
+						PUT(PARSER_DEF|PARSER_KIND_FUNCTION, token, lineno, sp);
 				if (level > stack[classlevel].level || startequal)
 					PUT(PARSER_REF_SYM, token, lineno, sp);
 			} else {
@@ -130,7 +130,7 @@ java(const struct parser_param *param)
 			if ((c = nexttoken(interested, java_reserved_word)) == SYMBOL) {
 				strlimcpy(classname, token, sizeof(classname));
 				startclass = 1;
-				PUT(PARSER_DEF, token, lineno, sp);
+				PUT(PARSER_DEF|PARSER_KIND_TYPE, token, lineno, sp);
 			}
 			break;
 		case JAVA_NEW:
@@ -32,12 +32,34 @@ void parser_exit(void);
 #define PARSER_DEF		1	/* definition */
 #define PARSER_REF_SYM		2	/* reference or other symbol */
 
+/*
+ * kind of definition: passed with PARSER_DEF.
+ * The value is the letter stored in the tag record (see gtagsop.c).
+ */
+#define PARSER_KIND_FUNCTION	('f' << 8)	/* function, method */
+#define PARSER_KIND_MACRO	('m' << 8)	/* macro, constant */
+#define PARSER_KIND_TYPE	('t' << 8)	/* type, class, namespace */
+#define PARSER_KIND_VARIABLE	('v' << 8)	/* variable, member */
+
 /* flags */
 #define PARSER_DEBUG		1	/* debug mode */
 #define PARSER_VERBOSE		2	/* verbose mode */
 #define PARSER_WARNING		4	/* print warning message */
 #define PARSER_END_BLOCK	8	/* force level 1 block end */
 #define PARSER_BEGIN_BLOCK	16	/* force level 1 block start */
+#define PARSER_LEVEL		32	/* pass block level with tag type */
+
+/*
+ * The tag type consists of the type (PARSER_DEF or PARSER_REF_SYM), the kind
+ * of definition (PARSER_KIND_XXX, 0 if unknown) and the block level.
+ * If PARSER_LEVEL is specified, built-in parsers pass the block level
+ * of the tag in the upper bits of the tag type. Plug-in parsers don't.
+ */
+#define PARSER_TYPE(type)	((type) & 0xff)
+#define PARSER_KIND(type)	(((type) >> 8) & 0xff)
+#define PARSER_BLOCK(type)	((type) >> 16)
+#define PARSER_MAKETYPE(type, level) \
+	(((level) > 0 ? (level) : 0) << 16 | (type))
 
 typedef void (*PARSER_CALLBACK)(int, const char *, int, const char *, const char *, void *);
 
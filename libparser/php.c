@@ -794,7 +794,9 @@ debug_print(const char *s, ...)
 	char *nl = strchr(line_image, '\n');				\
 	if (nl != NULL)							\
 		*nl = '\0';						\
-	param->put(type, tag, lno, param->file, line_image, param->arg);\
+	param->put((param->flags & PARSER_LEVEL) ?			\
+		PARSER_MAKETYPE(type, level) : (type),			\
+		tag, lno, param->file, line_image, param->arg);		\
 	if (nl != NULL)							\
 		*nl = '\n';						\
 } while (0)
@@ -810,7 +812,7 @@ debug_print(const char *s, ...)
 /* Definitions */
 /* We accept multi-bytes character */
 
-#line 814 "php.c"
+#line 816 "php.c"
 
 #define INITIAL 0
 #define PHP 1
@@ -1002,9 +1004,9 @@ YY_DECL
 	register char *yy_cp, *yy_bp;
 	register int yy_act;
     
-#line 124 "php.l"
+#line 126 "php.l"
 
-#line 1008 "php.c"
+#line 1010 "php.c"
 
 	if ( !(yy_init) )
 		{
@@ -1097,7 +1099,7 @@ do_action:	/* This label is used only to access EOF actions. */
 case 1:
 /* rule 1 can match eol */
 YY_RULE_SETUP
-#line 125 "php.l"
+#line 127 "php.l"
 {
 				ECHO;
 				if (pre_here_document == 1) {
@@ -1110,55 +1112,55 @@ YY_RULE_SETUP
 /* Start PHP */
 case 2:
 YY_RULE_SETUP
-#line 134 "php.l"
+#line 136 "php.l"
 ECHO; BEGIN PHP;
 	YY_BREAK
 case 3:
 YY_RULE_SETUP
-#line 135 "php.l"
+#line 137 "php.l"
 ECHO; BEGIN PHP;
 	YY_BREAK
 case 4:
 YY_RULE_SETUP
-#line 136 "php.l"
+#line 138 "php.l"
 ECHO; BEGIN PHP;
 	YY_BREAK
 case 5:
 YY_RULE_SETUP
-#line 137 "php.l"
+#line 139 "php.l"
 ECHO; BEGIN PHP;
 	YY_BREAK
 case 6:
 YY_RULE_SETUP
-#line 138 "php.l"
+#line 140 "php.l"
 ECHO; BEGIN PHP;
 	YY_BREAK
 /* Ignore HTML */
 case 7:
 YY_RULE_SETUP
-#line 140 "php.l"
+#line 142 "php.l"
 ECHO;
 	YY_BREAK
 /* End of PHP */
 case 8:
 YY_RULE_SETUP
-#line 142 "php.l"
+#line 144 "php.l"
 ECHO; BEGIN INITIAL;
 	YY_BREAK
 case 9:
 YY_RULE_SETUP
-#line 143 "php.l"
+#line 145 "php.l"
 ECHO; BEGIN INITIAL;
 	YY_BREAK
 case 10:
 YY_RULE_SETUP
-#line 144 "php.l"
+#line 146 "php.l"
 ECHO; BEGIN INITIAL;
 	YY_BREAK
 /* Comment */
 case 11:
 YY_RULE_SETUP
-#line 147 "php.l"
+#line 149 "php.l"
 {
 				int c;
 
@@ -1180,23 +1182,23 @@ YY_RULE_SETUP
 	YY_BREAK
 case 12:
 YY_RULE_SETUP
-#line 165 "php.l"
+#line 167 "php.l"
 DBG_PRINT("<%s>", LEXTEXT);
 	YY_BREAK
 case 13:
 YY_RULE_SETUP
-#line 166 "php.l"
+#line 168 "php.l"
 DBG_PRINT("<%s>", LEXTEXT);
 	YY_BREAK
 /* String */
 case 14:
 YY_RULE_SETUP
-#line 169 "php.l"
+#line 171 "php.l"
 { strbuf_reset(string); BEGIN STRING; }
 	YY_BREAK
 case 15:
 YY_RULE_SETUP
-#line 170 "php.l"
+#line 172 "php.l"
 {
 				DBG_PRINT("<S:%s>", strbuf_value(string));
 				BEGIN PHP;
@@ -1206,23 +1208,23 @@ YY_RULE_SETUP
 	YY_BREAK
 case 16:
 YY_RULE_SETUP
-#line 176 "php.l"
+#line 178 "php.l"
 strbuf_puts(string, LEXTEXT);
 	YY_BREAK
 case 17:
 YY_RULE_SETUP
-#line 177 "php.l"
+#line 179 "php.l"
 strbuf_putc(string, LEXTEXT[0]);
 	YY_BREAK
 /* Literal */
 case 18:
 YY_RULE_SETUP
-#line 180 "php.l"
+#line 182 "php.l"
 { strbuf_reset(string); BEGIN LITERAL; }
 	YY_BREAK
 case 19:
 YY_RULE_SETUP
-#line 181 "php.l"
+#line 183 "php.l"
 {
 				DBG_PRINT("<L:%s>", strbuf_value(string));
 				BEGIN PHP;
@@ -1232,18 +1234,18 @@ YY_RULE_SETUP
 	YY_BREAK
 case 20:
 YY_RULE_SETUP
-#line 187 "php.l"
+#line 189 "php.l"
 strbuf_puts(string, LEXTEXT);
 	YY_BREAK
 case 21:
 YY_RULE_SETUP
-#line 188 "php.l"
+#line 190 "php.l"
 strbuf_putc(string, LEXTEXT[0]);
 	YY_BREAK
 /* Here document */
 case 22:
 YY_RULE_SETUP
-#line 191 "php.l"
+#line 193 "php.l"
 {
 				DBG_PRINT("<L:%s>", LEXTEXT);
 				/* extract word and save */
@@ -1256,7 +1258,7 @@ YY_RULE_SETUP
 	YY_BREAK
 case 23:
 YY_RULE_SETUP
-#line 200 "php.l"
+#line 202 "php.l"
 {
 				const char *keyword = strtrim((const char *)LEXTEXT, TRIM_HEAD, NULL);
 				ECHO;
@@ -1270,17 +1272,17 @@ YY_RULE_SETUP
 /* Cast */
 case 24:
 YY_RULE_SETUP
-#line 211 "php.l"
+#line 213 "php.l"
 
 	YY_BREAK
 case 25:
 YY_RULE_SETUP
-#line 212 "php.l"
+#line 214 "php.l"
 
 	YY_BREAK
 case 26:
 YY_RULE_SETUP
-#line 213 "php.l"
+#line 215 "php.l"
 {
 				/*
 				 * 0123456	php_leng = 6
@@ -1298,7 +1300,7 @@ YY_RULE_SETUP
 	YY_BREAK
 case 27:
 YY_RULE_SETUP
-#line 227 "php.l"
+#line 229 "php.l"
 {
 				/*
 				 * 01234	php_leng = 4
@@ -1316,17 +1318,17 @@ YY_RULE_SETUP
 	YY_BREAK
 case 28:
 YY_RULE_SETUP
-#line 241 "php.l"
+#line 243 "php.l"
 ECHO;
 	YY_BREAK
 case 29:
 YY_RULE_SETUP
-#line 243 "php.l"
+#line 245 "php.l"
 DBG_PRINT("<N:%s>", LEXTEXT);
 	YY_BREAK
 case 30:
 YY_RULE_SETUP
-#line 244 "php.l"
+#line 246 "php.l"
 {
 				int id = php_reserved_word(LEXTEXT, LEXLENG);
 				if (id) {
@@ -1341,7 +1343,7 @@ YY_RULE_SETUP
 /* Operator */
 case 31:
 YY_RULE_SETUP
-#line 255 "php.l"
+#line 257 "php.l"
 {
 				int c = LEXTEXT[0];
 				if (c == PHP_LBRACE)
@@ -1355,47 +1357,47 @@ YY_RULE_SETUP
 	YY_BREAK
 case 32:
 YY_RULE_SETUP
-#line 265 "php.l"
+#line 267 "php.l"
 {
 				return LEXTEXT[0];
 			}
 	YY_BREAK
 case 33:
 YY_RULE_SETUP
-#line 268 "php.l"
+#line 270 "php.l"
 ECHO;
 	YY_BREAK
 case 34:
 YY_RULE_SETUP
-#line 269 "php.l"
+#line 271 "php.l"
 ECHO;
 	YY_BREAK
 case 35:
 YY_RULE_SETUP
-#line 270 "php.l"
+#line 272 "php.l"
 ECHO;
 	YY_BREAK
 case 36:
 YY_RULE_SETUP
-#line 271 "php.l"
+#line 273 "php.l"
 ECHO;
 	YY_BREAK
 case 37:
 YY_RULE_SETUP
-#line 272 "php.l"
+#line 274 "php.l"
 { ECHO; return PHP_DOLLAR; }
 	YY_BREAK
 case 38:
 YY_RULE_SETUP
-#line 273 "php.l"
+#line 275 "php.l"
 ECHO;
 	YY_BREAK
 case 39:
 YY_RULE_SETUP
-#line 275 "php.l"
+#line 277 "php.l"
 ECHO;
 	YY_BREAK
-#line 1399 "php.c"
+#line 1401 "php.c"
 case YY_STATE_EOF(INITIAL):
 case YY_STATE_EOF(PHP):
 case YY_STATE_EOF(STRING):
@@ -2367,7 +2369,7 @@ void php_free (void * ptr )
 
 #define YYTABLES_NAME "yytables"
 
-#line 275 "php.l"
+#line 277 "php.l"
 
 
 /*
@@ -2392,19 +2394,19 @@ php(const struct parser_param *param)
 				break;
 			if (LEXLEX(param) != PHP_STRING)
 				break;
-			PUT(PARSER_DEF, strbuf_value(string), LEXLINENO);
+			PUT(PARSER_DEF|PARSER_KIND_MACRO, strbuf_value(string), LEXLINENO);
 			break;
 		case PHP_CLASS:
 			if (LEXLEX(param) != PHP_TOKEN)
 				break;
-			PUT(PARSER_DEF, LEXTEXT, LEXLINENO);
+			PUT(PARSER_DEF|PARSER_KIND_TYPE, LEXTEXT, LEXLINENO);
 			break;
 		case PHP_FUNCTION:
 		case PHP_CFUNCTION:
 		case PHP_OLD_FUNCTION:
 			if (LEXLEX(param) != PHP_TOKEN)
 				break;
-			PUT(PARSER_DEF, LEXTEXT, LEXLINENO);
+			PUT(PARSER_DEF|PARSER_KIND_FUNCTION, LEXTEXT, LEXLINENO);
 			break;
 		case PHP_VARIABLE:
 			if (php_reserved_variable(LEXTEXT, LEXLENG)) {
@@ -21,6 +21,8 @@
 #ifdef HAVE_CONFIG_H
 #include <config.h>
 #endif
+#include <sys/types.h>
+#include <sys/stat.h>
 #include <assert.h>
 #include <ctype.h>
 #ifdef STDC_HEADERS
@@ -31,17 +33,22 @@
 #else
 #include <strings.h>
 #endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
 
 #include "gparam.h"
 #include "checkalloc.h"
 #include "conf.h"
 #include "die.h"
 #include "env.h"
+#include "hash-string.h"
 #include "langmap.h"
 #include "locatestring.h"
 #include "makepath.h"
 #include "path.h"
 #include "strbuf.h"
+#include "strhash.h"
 #include "strlimcpy.h"
 #include "strmake.h"
 #include "test.h"
@@ -50,15 +57,33 @@
 static FILE *fp;
 static STRBUF *ib;
 static char *confline;
+static STRHASH *property;
 /*
  * 8 level nested tc= or include= is allowed.
  */
 static int allowed_nest_level = 8;
 static int opened;
 
+/*
+ * Key of the configuration cache.
+ */
+struct confkey {
+	unsigned int dev;
+	unsigned int ino;
+	unsigned int mtime;
+	unsigned int size;
+	unsigned int hash;		/* valid if hashed is 1 */
+	int hashed;
+};
+
 static void trim(char *);
 static const char *readrecord(const char *);
 static void includelabel(STRBUF *, const char *, int);
+static int confstamp(const char *, struct confkey *);
+static int confhash(const char *, struct confkey *);
+static char *readcache(const char *, const char *, struct confkey *);
+static void writecache(const char *, const char *, struct confkey *, const char *);
+static void makeindex(void);
 
 #ifndef isblank
 #define isblank(c)	((c) == ' ' || (c) == '\t')
@@ -191,6 +216,349 @@ includelabel(STRBUF *sb, const char *label, int	level)
 	strbuf_puts(sb, p);
 	free((void *)savep);
 }
+/*
+ * Configuration cache.
+ *
+ * Resolving tc= (or include=) rescans the config file for each label.
+ * The resolved record is saved in $HOME/.gtags.conf.cache, keyed by the
+ * path of the config file and the label.
+ *
+ * The entry is valid if the device, inode, modification time and size of
+ * the config file are unchanged. Since a file rewritten within a second
+ * may keep them, the hash value of the contents is also compared, but
+ * only when they match. If they differ, the entry is made again without
+ * hashing twice.
+ *
+ * Only the commands which call set_confcache() (gtags and htags) write
+ * the cache. The others (global etc.) only read it.
+ *
+ * cache  = <magic> <entry> ...
+ * entry  = <length> <dev> <ino> <mtime> <size> <hash> <path>'\0' <label>'\0' <record>'\0'
+ *
+ * The numbers are unsigned int. <length> is the length of the following
+ * strings. <dev> and <ino> may be truncated. <hash> is __hash_string() of
+ * the contents. The latest entry comes first.
+ */
+#define CACHE_MAGIC	"GTAGSCONFCACHE3"
+#define CACHE_ENTRIES	16
+#define CACHE_LIMIT	(1024 * 1024)
+#define CACHE_FIELDS	6
+
+static int cache_writable;
+
+/*
+ * set_confcache: allow writing the configuration cache.
+ *
+ *	i)	writable	1: write, 0: read only (default)
+ */
+void
+set_confcache(int writable)
+{
+	cache_writable = writable;
+}
+static const char *
+cachepath(void)
+{
+	const char *home = get_home_directory();
+
+	if (home == NULL || !isabspath(home) || !test("d", home))
+		return NULL;
+	return makepath(home, GTAGSCONFCACHE, NULL);
+}
+/*
+ * confstamp: get the stamp of config file.
+ *
+ *	i)	config	path of config file
+ *	o)	key	cache key (the hash value is not computed)
+ *	r)		0: normal, -1: cannot stat
+ */
+static int
+confstamp(const char *config, struct confkey *key)
+{
+	struct stat st;
+
+	if (stat(config, &st) < 0)
+		return -1;
+	key->dev = (unsigned int)st.st_dev;
+	key->ino = (unsigned int)st.st_ino;
+	key->mtime = (unsigned int)st.st_mtime;
+	key->size = (unsigned int)st.st_size;
+	key->hashed = 0;
+	return 0;
+}
+/*
+ * confhash: compute the hash value of the contents of config file.
+ *
+ *	i)	config	path of config file
+ *	io)	key	cache key
+ *	r)		0: normal, -1: cannot read
+ */
+static int
+confhash(const char *config, struct confkey *key)
+{
+	STRBUF *sb;
+	char buf[BUFSIZ];
+	size_t n;
+	FILE *ip;
+
+	if (key->hashed)
+		return 0;
+	if ((ip = fopen(config, "rb")) == NULL)
+		return -1;
+	sb = strbuf_open(0);
+	while ((n = fread(buf, 1, sizeof(buf), ip)) > 0)
+		strbuf_nputs(sb, buf, n);
+	fclose(ip);
+	key->hash = (unsigned int)__hash_string(strbuf_value(sb));
+	key->hashed = 1;
+	strbuf_close(sb);
+	return 0;
+}
+/*
+ * loadcache: load whole cache file.
+ *
+ *	o)	size	size of cache
+ *	r)		cache image (the magic is skipped)
+ *			NULL: cache not found
+ */
+static char *
+loadcache(unsigned int *size)
+{
+	const char *path = cachepath();
+	char *buf;
+	FILE *ip;
+	long len;
+
+	if (path == NULL || (ip = fopen(path, "rb")) == NULL)
+		return NULL;
+	if (fseek(ip, 0, SEEK_END) < 0 || (len = ftell(ip)) < (long)sizeof(CACHE_MAGIC) || len > CACHE_LIMIT) {
+		fclose(ip);
+		return NULL;
+	}
+	rewind(ip);
+	buf = check_malloc(len);
+	if (fread(buf, len, 1, ip) != 1 || memcmp(buf, CACHE_MAGIC, sizeof(CACHE_MAGIC))) {
+		fclose(ip);
+		free(buf);
+		return NULL;
+	}
+	fclose(ip);
+	*size = len;
+	return buf;
+}
+/*
+ * nextentry: pick up an entry of the cache.
+ *
+ *	i)	buf	cache image
+ *	i)	size	size of cache
+ *	io)	offset	offset of the entry
+ *	o)	ent	unsigned int fields
+ *	o)	str	path, label and record
+ *	r)		1: picked up, 0: end of cache or broken
+ */
+static int
+nextentry(const char *buf, unsigned int size, unsigned int *offset, unsigned int ent[CACHE_FIELDS], const char *str[3])
+{
+	unsigned int p = *offset, end;
+	int i;
+
+	if (p + sizeof(unsigned int) * CACHE_FIELDS > size)
+		return 0;
+	memcpy(ent, buf + p, sizeof(unsigned int) * CACHE_FIELDS);
+	p += sizeof(unsigned int) * CACHE_FIELDS;
+	if (ent[0] > size - p || ent[0] == 0 || buf[p + ent[0] - 1] != '\0')
+		return 0;
+	end = p + ent[0];
+	for (i = 0; i < 3; i++) {
+		if (p >= end)
+			return 0;
+		str[i] = buf + p;
+		p += strlen(str[i]) + 1;
+	}
+	*offset = end;
+	return 1;
+}
+/*
+ * readcache: read resolved record from the cache.
+ *
+ *	i)	config	path of config file
+ *	i)	label	label
+ *	io)	key	cache key of config file
+ *	r)		record (allocated)
+ *			NULL: not found or out of date
+ */
+static char *
+readcache(const char *config, const char *label, struct confkey *key)
+{
+	unsigned int size, offset = sizeof(CACHE_MAGIC);
+	unsigned int ent[CACHE_FIELDS];
+	const char *str[3];
+	char *buf, *record = NULL;
+
+	if ((buf = loadcache(&size)) == NULL)
+		return NULL;
+	while (nextentry(buf, size, &offset, ent, str)) {
+		if (!strcmp(str[0], config) && !strcmp(str[1], label)) {
+			if (ent[1] == key->dev && ent[2] == key->ino
+			    && ent[3] == key->mtime && ent[4] == key->size
+			    && confhash(config, key) == 0 && ent[5] == key->hash)
+				record = check_strdup(str[2]);
+			break;
+		}
+	}
+	free(buf);
+	return record;
+}
+/*
+ * writecache: write resolved record into the cache.
+ *
+ *	i)	config	path of config file
+ *	i)	label	label
+ *	i)	key	cache key of config file
+ *	i)	record	resolved record
+ *
+ * Any error is ignored, since the cache is not indispensable.
+ */
+static void
+writecache(const char *config, const char *label, struct confkey *key, const char *record)
+{
+	STRBUF *sb;
+	unsigned int size, offset = sizeof(CACHE_MAGIC);
+	unsigned int ent[CACHE_FIELDS];
+	const char *str[3], *path;
+	char *buf, tmp[MAXPATHLEN];
+	int count = 1;
+	FILE *op;
+
+	if (!cache_writable || (path = cachepath()) == NULL)
+		return;
+	if (confhash(config, key) < 0)
+		return;
+	sb = strbuf_open(0);
+	strbuf_nputs(sb, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	ent[0] = strlen(config) + strlen(label) + strlen(record) + 3;
+	ent[1] = key->dev;
+	ent[2] = key->ino;
+	ent[3] = key->mtime;
+	ent[4] = key->size;
+	ent[5] = key->hash;
+	strbuf_nputs(sb, (const char *)ent, sizeof(ent));
+	strbuf_puts0(sb, config);
+	strbuf_puts0(sb, label);
+	strbuf_puts0(sb, record);
+	/*
+	 * Keep other entries.
+	 */
+	if ((buf = loadcache(&size)) != NULL) {
+		unsigned int start = offset;
+
+		while (count < CACHE_ENTRIES && nextentry(buf, size, &offset, ent, str)) {
+			if (strcmp(str[0], config) || strcmp(str[1], label)) {
+				strbuf_nputs(sb, buf + start, offset - start);
+				count++;
+			}
+			start = offset;
+		}
+		free(buf);
+	}
+	snprintf(tmp, sizeof(tmp), "%s.%d", path, (int)getpid());
+	if ((op = fopen(tmp, "wb")) != NULL) {
+		int error = fwrite(strbuf_value(sb), strbuf_getlen(sb), 1, op) != 1;
+
+		if (fclose(op) != 0 || error)
+			(void)unlink(tmp);
+		else {
+#if defined(_WIN32) || defined(__DJGPP__)
+			(void)unlink(path);
+#endif
+			if (rename(tmp, path) < 0)
+				(void)unlink(tmp);
+		}
+	}
+	strbuf_close(sb);
+}
+/*
+ * isall: whether or not all values of the variable are concatenated.
+ */
+static int
+isall(const char *name)
+{
+	return (!strcmp(name, "suffixes") || !strcmp(name, "skip")
+	 || !strcmp(name, "gtags_parser") || !strcmp(name, "langmap"));
+}
+/*
+ * makeindex: make index of confline for getconfX().
+ *
+ * Each field of confline is registered with its type character.
+ *
+ *	:name=value:	'=name' -> value (the first one or all of them)
+ *	:name#number:	'#name' -> number
+ *	:name:		':name' -> ""
+ */
+static void
+makeindex(void)
+{
+	STRBUF *key = strbuf_open(0);
+	STRBUF *val = strbuf_open(0);
+	const char *p = confline, *name;
+	struct sh_entry *entry;
+	int type;
+
+	if (property)
+		strhash_reset(property);
+	else
+		property = strhash_open(64);
+	while (*p) {
+		if (*p == ':') {
+			p++;
+			continue;
+		}
+		for (name = p; *p && *p != ':' && *p != '=' && *p != '#'; p++)
+			;
+		type = (*p == '=' || *p == '#') ? *p++ : ':';
+		strbuf_reset(key);
+		strbuf_putc(key, type);
+		strbuf_nputs(key, name, p - name - (type == ':' ? 0 : 1));
+		strbuf_reset(val);
+		for (; *p && *p != ':'; p++) {
+			if (*p == '\\' && *(p + 1))	/* quoted character */
+				p++;
+			strbuf_putc(val, *p);
+		}
+		entry = strhash_assign(property, strbuf_value(key), 0);
+		if (entry == NULL) {
+			entry = strhash_assign(property, strbuf_value(key), 1);
+			entry->value = strhash_strdup(property, strbuf_value(val), 0);
+		} else if (type == '=' && isall(strbuf_value(key) + 1)) {
+			STRBUF *sb = strbuf_open(0);
+
+			strbuf_puts(sb, entry->value);
+			strbuf_putc(sb, ',');
+			strbuf_puts(sb, strbuf_value(val));
+			entry->value = strhash_strdup(property, strbuf_value(sb), 0);
+			strbuf_close(sb);
+		}
+	}
+	strbuf_close(val);
+	strbuf_close(key);
+}
+/*
+ * lookup: look up a property in the index.
+ *
+ *	i)	type	'=', '#' or ':'
+ *	i)	name	property name
+ *	r)		value, NULL: not found
+ */
+static const char *
+lookup(int type, const char *name)
+{
+	char buf[MAXPROPLEN];
+	struct sh_entry *entry;
+
+	snprintf(buf, sizeof(buf), "%c%s", type, name);
+	entry = strhash_assign(property, buf, 0);
+	return entry ? entry->value : NULL;
+}
 /*
  * configpath: get path of configuration file.
  */
@@ -239,6 +607,7 @@ openconf(void)
 {
 	STRBUF *sb;
 	const char *config;
+	struct confkey key;
 	extern int vflag;
 
 	assert(opened == 0);
@@ -274,19 +643,24 @@ openconf(void)
 			die("config file '%s' is not readable.", config);
 		if ((label = getenv("GTAGSLABEL")) == NULL)
 			label = "default";
-	
-		if (!(fp = fopen(config, "r")))
-			die("cannot open '%s'.", config);
 		if (vflag)
 			fprintf(stderr, " Using config file '%s'.\n", config);
-		ib = strbuf_open(MAXBUFLEN);
-		sb = strbuf_open(0);
-		includelabel(sb, label, 0);
-		confline = check_strdup(strbuf_value(sb));
-		strbuf_close(ib);
-		strbuf_close(sb);
-		fclose(fp);
+		if (confstamp(config, &key) < 0)
+			die("cannot open '%s'.", config);
+		if ((confline = readcache(config, label, &key)) == NULL) {
+			if (!(fp = fopen(config, "r")))
+				die("cannot open '%s'.", config);
+			ib = strbuf_open(MAXBUFLEN);
+			sb = strbuf_open(0);
+			includelabel(sb, label, 0);
+			confline = check_strdup(strbuf_value(sb));
+			strbuf_close(ib);
+			strbuf_close(sb);
+			fclose(fp);
+			writecache(config, label, &key, confline);
+		}
 	}
+	makeindex();
 	/*
 	 * make up required variables.
 	 */
@@ -319,6 +693,7 @@ openconf(void)
 	confline = check_strdup(strbuf_value(sb));
 	strbuf_close(sb);
 	trim(confline);
+	makeindex();
 	return;
 }
 /*
@@ -332,13 +707,10 @@ int
 getconfn(const char *name, int *num)
 {
 	const char *p;
-	char buf[MAXPROPLEN];
 
 	if (!opened)
 		openconf();
-	snprintf(buf, sizeof(buf), ":%s#", name);
-	if ((p = locatestring(confline, buf, MATCH_FIRST)) != NULL) {
-		p += strlen(buf);
+	if ((p = lookup('#', name)) != NULL) {
 		if (num != NULL)
 			*num = atoi(p);
 		return 1;
@@ -356,29 +728,14 @@ int
 getconfs(const char *name, STRBUF *sb)
 {
 	const char *p;
-	char buf[MAXPROPLEN];
-	int all = 0;
 	int exist = 0;
 
 	if (!opened)
 		openconf();
-	if (!strcmp(name, "suffixes") || !strcmp(name, "skip")
-	 || !strcmp(name, "gtags_parser") || !strcmp(name, "langmap"))
-		all = 1;
-	snprintf(buf, sizeof(buf), ":%s=", name);
-	p = confline;
-	while ((p = locatestring(p, buf, MATCH_FIRST)) != NULL) {
-		if (exist && sb)
-			strbuf_putc(sb, ',');		
+	if ((p = lookup('=', name)) != NULL) {
+		if (sb)
+			strbuf_puts(sb, p);
 		exist = 1;
-		for (p += strlen(buf); *p && *p != ':'; p++) {
-			if (*p == '\\')	/* quoted character */
-				p++;
-			if (sb)
-				strbuf_putc(sb, *p);
-		}
-		if (!all)
-			break;
 	}
 	/*
 	 * If 'bindir' and 'datadir' are not defined then
@@ -425,12 +782,9 @@ getconfs(const char *name, STRBUF *sb)
 int
 getconfb(const char *name)
 {
-	char buf[MAXPROPLEN];
-
 	if (!opened)
 		openconf();
-	snprintf(buf, sizeof(buf), ":%s:", name);
-	if (locatestring(confline, buf, MATCH_FIRST) != NULL)
+	if (lookup(':', name) != NULL)
 		return 1;
 	return 0;
 }
@@ -451,5 +805,7 @@ closeconf(void)
 		return;
 	free(confline);
 	confline = NULL;
+	strhash_close(property);
+	property = NULL;
 	opened = 0;
 }
@@ -35,7 +35,9 @@
 #define DOS_GTAGSRC	"_globalrc"
 #endif
 #define DEFAULTLABEL    "default"
+#define GTAGSCONFCACHE	".gtags.conf.cache"
 
+void set_confcache(int);
 void openconf(void);
 int getconfn(const char *, int *);
 int getconfs(const char *, STRBUF *);
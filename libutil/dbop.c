@@ -43,6 +43,7 @@
 #include "char.h"
 #include "checkalloc.h"
 #include "dbop.h"
+#include "dfa.h"
 #include "die.h"
 #include "env.h"
 #include "locatestring.h"
@@ -451,6 +452,43 @@ dbop_update(DBOP *dbop, const char *key, const char *dat)
 {
 	dbop_put(dbop, key, dat);
 }
+/*
+ * dbop_seq: advance the cursor to the next record.
+ *
+ *	i)	dbop	dbop descripter
+ *	o)	key	key of the record
+ *	o)	dat	data of the record
+ *	i)	flags	DBOP_KEY: skip the rest of records which have the same key
+ *	r)		status of db->seq()
+ *
+ * When DBOP_KEY is specified, dbop->prev must hold the current key.
+ * The btree library jumps from it to the first greater key directly
+ * (R_NEXTKEY), so duplicate records are never read.
+ */
+static int
+dbop_seq(DBOP *dbop, DBT *key, DBT *dat, int flags)
+{
+	DB *db = dbop->db;
+
+#ifdef R_NEXTKEY
+	if (flags & DBOP_KEY) {
+		key->data = dbop->prev;
+		key->size = strlen(dbop->prev) + 1;
+		return (*db->seq)(db, key, dat, R_NEXTKEY);
+	}
+#endif
+	return (*db->seq)(db, key, dat, R_NEXT);
+}
+/*
+ * dbop_setprev: remember the current key for DBOP_KEY.
+ */
+static void
+dbop_setprev(DBOP *dbop, const char *key)
+{
+	if (strlen(key) > MAXKEYLEN)
+		die("primary key too long.");
+	strlimcpy(dbop->prev, key, sizeof(dbop->prev));
+}
 /*
  * dbop_first: get first record. 
  * 
@@ -489,7 +527,9 @@ dbop_first(DBOP *dbop, const char *name, regex_t *preg, int flags)
 		dbop->keylen = key.size;
 		for (status = (*db->seq)(db, &key, &dat, R_CURSOR);
 			status == RET_SUCCESS;
-			status = (*db->seq)(db, &key, &dat, R_NEXT)) {
+			status = dbop_seq(dbop, &key, &dat, flags)) {
+			if (flags & DBOP_KEY)
+				dbop_setprev(dbop, (char *)key.data);
 			if (flags & DBOP_PREFIX) {
 				if (strncmp((char *)key.data, dbop->key, dbop->keylen))
 					return NULL;
@@ -497,7 +537,7 @@ dbop_first(DBOP *dbop, const char *name, regex_t *preg, int flags)
 				if (strcmp((char *)key.data, dbop->key))
 					return NULL;
 			}
-			if (preg && regexec(preg, (char *)key.data, 0, 0, 0) != 0)
+			if (preg && dfa_regexec(preg, (char *)key.data) != 0)
 				continue;
 			break;
 		}
@@ -505,11 +545,13 @@ dbop_first(DBOP *dbop, const char *name, regex_t *preg, int flags)
 		dbop->keylen = dbop->key[0] = 0;
 		for (status = (*db->seq)(db, &key, &dat, R_FIRST);
 			status == RET_SUCCESS;
-			status = (*db->seq)(db, &key, &dat, R_NEXT)) {
+			status = dbop_seq(dbop, &key, &dat, flags)) {
+			if (flags & DBOP_KEY)
+				dbop_setprev(dbop, (char *)key.data);
 			/* skip meta records */
 			if (ismeta(key.data) && !(dbop->openflags & DBOP_RAW))
 				continue;
-			if (preg && regexec(preg, (char *)key.data, 0, 0, 0) != 0)
+			if (preg && dfa_regexec(preg, (char *)key.data) != 0)
 				continue;
 			break;
 		}
@@ -527,10 +569,8 @@ dbop_first(DBOP *dbop, const char *name, regex_t *preg, int flags)
 		return (NULL);
 	}
 	dbop->ioflags = flags;
-	if (flags & DBOP_KEY) {
-		strlimcpy(dbop->prev, (char *)key.data, sizeof(dbop->prev));
+	if (flags & DBOP_KEY)
 		return (char *)key.data;
-	}
 	return ((char *)dat.data);
 }
 /*
@@ -540,11 +580,12 @@ dbop_first(DBOP *dbop, const char *name, regex_t *preg, int flags)
  *	r)		data
  *
  * Db_next always skip meta records.
+ * With DBOP_KEY, each key is returned only once, and the duplicate
+ * records are skipped without being read.
  */
 const char *
 dbop_next(DBOP *dbop)
 {
-	DB *db = dbop->db;
 	int flags = dbop->ioflags;
 	DBT key, dat;
 	int status;
@@ -553,8 +594,13 @@ dbop_next(DBOP *dbop)
 		dbop->unread = 0;
 		return dbop->lastdat;
 	}
-	while ((status = (*db->seq)(db, &key, &dat, R_NEXT)) == RET_SUCCESS) {
+	while ((status = dbop_seq(dbop, &key, &dat, flags)) == RET_SUCCESS) {
 		assert(dat.data != NULL);
+		if (flags & DBOP_KEY) {
+			if (!strcmp(dbop->prev, (char *)key.data))
+				continue;
+			dbop_setprev(dbop, (char *)key.data);
+		}
 		/* skip meta records */
 		if (!(dbop->openflags & DBOP_RAW)) {
 			if (flags & DBOP_KEY && ismeta(key.data))
@@ -562,13 +608,6 @@ dbop_next(DBOP *dbop)
 			else if (ismeta(dat.data))
 				continue;
 		}
-		if (flags & DBOP_KEY) {
-			if (!strcmp(dbop->prev, (char *)key.data))
-				continue;
-			if (strlen((char *)key.data) > MAXKEYLEN)
-				die("primary key too long.");
-			strlimcpy(dbop->prev, (char *)key.data, sizeof(dbop->prev));
-		}
 		dbop->lastdat	= (char *)dat.data;
 		dbop->lastsize	= dat.size;
 		dbop->lastkey = (char *)key.data;
@@ -580,7 +619,7 @@ dbop_next(DBOP *dbop)
 			if (strcmp((char *)key.data, dbop->key))
 				return NULL;
 		}
-		if (dbop->preg && regexec(dbop->preg, (char *)key.data, 0, 0, 0) != 0)
+		if (dbop->preg && dfa_regexec(dbop->preg, (char *)key.data) != 0)
 			continue;
 		return (flags & DBOP_KEY) ? (char *)key.data : (char *)dat.data;
 	}
@@ -0,0 +1,988 @@
+/*
+ * Copyright (c) 2010 Tama Communications Corporation
+ *
+ * This file is part of GNU GLOBAL.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#include <ctype.h>
+#ifdef STDC_HEADERS
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#else
+#include <strings.h>
+#endif
+
+#include "checkalloc.h"
+#include "dfa.h"
+#include "pool.h"
+#include "regex.h"
+#include "varray.h"
+
+/*
+
+DFA matcher: usage
+
+	regex_t preg;
+
+	if (dfa_regcomp(&preg, "^str.*hash", REG_EXTENDED) != 0)
+		die("invalid regular expression.");
+	if (dfa_regexec(&preg, "strhash_open") == 0)
+		// matched
+	dfa_regfree(&preg);
+
+Dfa_regcomp() compiles the pattern by regcomp(3) as usual. In addition,
+if the pattern is within the subset which this module understands, it
+builds a Thompson NFA for it and registers the NFA with the regex_t.
+Dfa_regexec() uses the registered automaton if any, otherwise it calls
+regexec(3). Since no submatch is required by the callers, the automaton
+answers only whether or not the string includes a match.
+
+The DFA states are built lazily. Each state is a set of NFA states, and
+its transition table is filled in one byte at a time as the input demands.
+So, the cost of matching is linear in the length of the string, and the
+cost of building is paid only for the states which are actually visited.
+If the number of states exceeds DFA_MAXSTATES, the cache is flushed and
+rebuilt from the current position.
+
+Supported syntax (others fall back to regex.c):
+
+	ERE:	c . [...] ^ $ ( ) | * + ? {m,n} \c (c is not alphanumeric)
+	BRE:	c . [...] ^(head) $(tail) \( \) * \{m,n\} \c (c is special)
+
+Back references, GNU operators (\w, \b, \<, ...), equivalence classes,
+collating symbols and REG_NEWLINE are left to regex.c.
+
+*/
+
+#define DFA_MAXNODES	4096		/* limit of NFA nodes */
+#define DFA_MAXSTATES	1024		/* limit of cached DFA states */
+#define DFA_HASHSIZE	1024		/* hash buckets for DFA states */
+#define DFA_MAXREPEAT	255		/* limit of {m,n} */
+#define DFA_SLOTS	8		/* limit of registered patterns */
+
+/*
+ * Parse tree
+ */
+#define T_SET		0		/* character set */
+#define T_CAT		1		/* concatenation */
+#define T_ALT		2		/* alternation */
+#define T_REPEAT	3		/* {min,max} (max = -1: infinite) */
+#define T_BOL		4		/* ^ */
+#define T_EOL		5		/* $ */
+#define T_EMPTY		6		/* empty string */
+
+struct tree {
+	int type;
+	int set;			/* index of character set */
+	int min, max;			/* range of repetition */
+	struct tree *left, *right;
+};
+typedef struct {
+	unsigned char bits[32];
+} CHARSET;
+
+#define CS_SET(cs, c)	((cs)->bits[(unsigned char)(c) >> 3] |= 1 << ((unsigned char)(c) & 7))
+#define CS_ISSET(cs, c)	((cs)->bits[(unsigned char)(c) >> 3] & (1 << ((unsigned char)(c) & 7)))
+
+/*
+ * NFA
+ */
+#define N_SET		0		/* consume a byte in the set */
+#define N_SPLIT		1		/* epsilon move to out1 and out2 */
+#define N_BOL		2		/* epsilon move at the head */
+#define N_EOL		3		/* epsilon move at the tail */
+#define N_MATCH		4		/* accept */
+
+struct nfa_node {
+	int type;
+	int set;
+	int out1, out2;
+};
+
+/*
+ * DFA state: a set of NFA states.
+ * Only N_SET, N_EOL and N_MATCH nodes are recorded in the set.
+ */
+struct dstate {
+	struct dstate *next[256];	/* transition table (NULL: not yet built) */
+	struct dstate *hnext;		/* hash chain */
+	int *ids;			/* sorted NFA node ids */
+	int nids;
+	int match;			/* includes N_MATCH */
+	int accept_end;			/* accept at the end of string */
+};
+
+typedef struct {
+	VARRAY *nodes;			/* NFA nodes */
+	VARRAY *sets;			/* character sets */
+	int start;			/* NFA start node */
+	int *inject;			/* closure of the start (not at the head) */
+	int ninject;
+	/*
+	 * Work area.
+	 */
+	int *mark;			/* visit mark for each NFA node */
+	int gen;			/* generation of visit mark */
+	int *stack;
+	int *work;
+	int nwork;
+	/*
+	 * Cache of DFA states.
+	 */
+	struct dstate *initial;
+	struct dstate *htab[DFA_HASHSIZE];
+	int nstates;
+	POOL *pool;			/* memory for id lists */
+} DFA;
+
+/*
+ * Parser
+ */
+struct parser {
+	const unsigned char *pattern;
+	const unsigned char *p;
+	int extended;
+	int icase;
+	int depth;
+	int error;			/* not supported or illegal */
+	POOL *pool;
+	VARRAY *sets;
+};
+
+static struct tree *parse_alt(struct parser *);
+static struct tree *parse_cat(struct parser *);
+static struct tree *parse_piece(struct parser *);
+static struct tree *parse_atom(struct parser *);
+
+static struct tree *
+make_tree(struct parser *ps, int type, struct tree *left, struct tree *right)
+{
+	struct tree *t = pool_malloc(ps->pool, sizeof(struct tree));
+
+	t->type = type;
+	t->set = -1;
+	t->min = t->max = 0;
+	t->left = left;
+	t->right = right;
+	return t;
+}
+/*
+ * new_set: allocate an empty character set and return the index of it.
+ */
+static int
+new_set(struct parser *ps)
+{
+	CHARSET *cs = varray_append(ps->sets);
+
+	memset(cs, 0, sizeof(CHARSET));
+	return ps->sets->length - 1;
+}
+static CHARSET *
+get_set(struct parser *ps, int index)
+{
+	return varray_assign(ps->sets, index, 0);
+}
+/*
+ * fold_set: apply REG_ICASE to the character set.
+ */
+static void
+fold_set(struct parser *ps, CHARSET *cs)
+{
+	int c;
+
+	if (!ps->icase)
+		return;
+	for (c = 0; c < 256; c++) {
+		if (CS_ISSET(cs, c)) {
+			CS_SET(cs, tolower(c));
+			CS_SET(cs, toupper(c));
+		}
+	}
+}
+static struct tree *
+make_char(struct parser *ps, int c)
+{
+	struct tree *t = make_tree(ps, T_SET, NULL, NULL);
+	CHARSET *cs;
+
+	t->set = new_set(ps);
+	cs = get_set(ps, t->set);
+	CS_SET(cs, c);
+	fold_set(ps, cs);
+	return t;
+}
+/*
+ * Character classes in bracket expression.
+ */
+static int
+add_class(CHARSET *cs, const char *name, int len)
+{
+	static const char *const names[] = {
+		"alpha", "digit", "alnum", "upper", "lower", "space",
+		"blank", "punct", "print", "graph", "cntrl", "xdigit", NULL
+	};
+	int i, c;
+
+	for (i = 0; names[i]; i++)
+		if (strlen(names[i]) == len && !strncmp(names[i], name, len))
+			break;
+	if (names[i] == NULL)
+		return -1;
+	for (c = 1; c < 256; c++) {
+		int in = 0;
+
+		switch (i) {
+		case 0:	in = isalpha(c); break;
+		case 1:	in = isdigit(c); break;
+		case 2:	in = isalnum(c); break;
+		case 3:	in = isupper(c); break;
+		case 4:	in = islower(c); break;
+		case 5:	in = isspace(c); break;
+		case 6:	in = (c == ' ' || c == '\t'); break;
+		case 7:	in = ispunct(c); break;
+		case 8:	in = isprint(c); break;
+		case 9:	in = isgraph(c); break;
+		case 10: in = iscntrl(c); break;
+		case 11: in = isxdigit(c); break;
+		}
+		if (in)
+			CS_SET(cs, c);
+	}
+	return 0;
+}
+static struct tree *
+parse_bracket(struct parser *ps)
+{
+	struct tree *t = make_tree(ps, T_SET, NULL, NULL);
+	CHARSET *cs;
+	int negate = 0, first = 1;
+	int c, i;
+
+	t->set = new_set(ps);
+	cs = get_set(ps, t->set);
+	if (*ps->p == '^') {
+		negate = 1;
+		ps->p++;
+	}
+	while (first || *ps->p != ']') {
+		first = 0;
+		if (*ps->p == '\0') {
+			ps->error = 1;
+			return t;
+		}
+		if (*ps->p == '[' && ps->p[1] == ':') {
+			const unsigned char *name = ps->p + 2;
+			const unsigned char *end = (const unsigned char *)strstr((const char *)name, ":]");
+
+			if (end == NULL || add_class(cs, (const char *)name, end - name) < 0) {
+				ps->error = 1;
+				return t;
+			}
+			ps->p = end + 2;
+			continue;
+		}
+		if (*ps->p == '[' && (ps->p[1] == '=' || ps->p[1] == '.')) {
+			ps->error = 1;
+			return t;
+		}
+		c = *ps->p++;
+		if (*ps->p == '-' && ps->p[1] != ']' && ps->p[1] != '\0') {
+			int hi = ps->p[1];
+
+			if (hi == '[' || hi < c) {
+				ps->error = 1;
+				return t;
+			}
+			ps->p += 2;
+			for (i = c; i <= hi; i++)
+				CS_SET(cs, i);
+		} else {
+			CS_SET(cs, c);
+		}
+	}
+	ps->p++;		/* skip ']' */
+	fold_set(ps, cs);
+	if (negate) {
+		for (i = 0; i < 32; i++)
+			cs->bits[i] = ~cs->bits[i];
+	}
+	cs->bits[0] &= ~1;	/* never match '\0' */
+	return t;
+}
+/*
+ * parse_interval: parse '{m,n}' (ERE) or '\{m,n\}' (BRE).
+ * The opening brace has already been skipped.
+ */
+static int
+parse_interval(struct parser *ps, int *min, int *max)
+{
+	int n;
+
+	if (!isdigit(*ps->p))
+		return -1;
+	for (n = 0; isdigit(*ps->p); ps->p++)
+		if ((n = n * 10 + *ps->p - '0') > DFA_MAXREPEAT)
+			return -1;
+	*min = *max = n;
+	if (*ps->p == ',') {
+		ps->p++;
+		if (isdigit(*ps->p)) {
+			for (n = 0; isdigit(*ps->p); ps->p++)
+				if ((n = n * 10 + *ps->p - '0') > DFA_MAXREPEAT)
+					return -1;
+			*max = n;
+		} else {
+			*max = -1;
+		}
+	}
+	if (!ps->extended) {
+		if (*ps->p != '\\')
+			return -1;
+		ps->p++;
+	}
+	if (*ps->p != '}')
+		return -1;
+	ps->p++;
+	if (*max >= 0 && *max < *min)
+		return -1;
+	return 0;
+}
+static struct tree *
+parse_alt(struct parser *ps)
+{
+	struct tree *t = parse_cat(ps);
+
+	while (!ps->error && ps->extended && *ps->p == '|') {
+		ps->p++;
+		t = make_tree(ps, T_ALT, t, parse_cat(ps));
+	}
+	return t;
+}
+static struct tree *
+parse_cat(struct parser *ps)
+{
+	struct tree *t = NULL;
+
+	while (!ps->error && *ps->p) {
+		struct tree *piece;
+
+		if (ps->extended) {
+			if (*ps->p == '|')
+				break;
+			if (*ps->p == ')') {
+				if (ps->depth == 0)
+					ps->error = 1;
+				break;
+			}
+		} else {
+			if (ps->p[0] == '\\' && ps->p[1] == ')') {
+				if (ps->depth == 0)
+					ps->error = 1;
+				break;
+			}
+		}
+		piece = parse_piece(ps);
+		t = (t == NULL) ? piece : make_tree(ps, T_CAT, t, piece);
+	}
+	return t ? t : make_tree(ps, T_EMPTY, NULL, NULL);
+}
+static struct tree *
+parse_piece(struct parser *ps)
+{
+	struct tree *t = parse_atom(ps);
+
+	while (!ps->error) {
+		int min, max;
+
+		if (*ps->p == '*') {
+			ps->p++;
+			min = 0;
+			max = -1;
+		} else if (ps->extended && *ps->p == '+') {
+			ps->p++;
+			min = 1;
+			max = -1;
+		} else if (ps->extended && *ps->p == '?') {
+			ps->p++;
+			min = 0;
+			max = 1;
+		} else if (ps->extended && *ps->p == '{') {
+			ps->p++;
+			if (parse_interval(ps, &min, &max) < 0) {
+				ps->error = 1;
+				break;
+			}
+		} else if (!ps->extended && ps->p[0] == '\\' && ps->p[1] == '{') {
+			ps->p += 2;
+			if (parse_interval(ps, &min, &max) < 0) {
+				ps->error = 1;
+				break;
+			}
+		} else {
+			break;
+		}
+		if (t->type == T_BOL || t->type == T_EOL) {
+			ps->error = 1;
+			break;
+		}
+		t = make_tree(ps, T_REPEAT, t, NULL);
+		t->min = min;
+		t->max = max;
+	}
+	return t;
+}
+static struct tree *
+parse_atom(struct parser *ps)
+{
+	struct tree *t;
+	int c = *ps->p;
+
+	if (ps->extended) {
+		switch (c) {
+		case '(':
+			ps->p++;
+			if (*ps->p == ')') {
+				ps->error = 1;
+				return make_tree(ps, T_EMPTY, NULL, NULL);
+			}
+			ps->depth++;
+			t = parse_alt(ps);
+			ps->depth--;
+			if (*ps->p != ')')
+				ps->error = 1;
+			else
+				ps->p++;
+			return t;
+		case '^':
+			ps->p++;
+			return make_tree(ps, T_BOL, NULL, NULL);
+		case '$':
+			ps->p++;
+			return make_tree(ps, T_EOL, NULL, NULL);
+		case '*':
+		case '+':
+		case '?':
+		case '{':
+			ps->error = 1;
+			return make_tree(ps, T_EMPTY, NULL, NULL);
+		case '\\':
+			c = ps->p[1];
+			if (c == '\0' || isalnum(c)) {
+				ps->error = 1;
+				return make_tree(ps, T_EMPTY, NULL, NULL);
+			}
+			ps->p += 2;
+			return make_char(ps, c);
+		}
+	} else {
+		switch (c) {
+		case '^':
+			/* '^' is an anchor only at the head. */
+			if (ps->p != ps->pattern) {
+				ps->error = 1;
+				return make_tree(ps, T_EMPTY, NULL, NULL);
+			}
+			ps->p++;
+			return make_tree(ps, T_BOL, NULL, NULL);
+		case '$':
+			/* '$' is an anchor only at the tail. */
+			if (ps->p[1] != '\0') {
+				ps->error = 1;
+				return make_tree(ps, T_EMPTY, NULL, NULL);
+			}
+			ps->p++;
+			return make_tree(ps, T_EOL, NULL, NULL);
+		case '*':
+			ps->error = 1;
+			return make_tree(ps, T_EMPTY, NULL, NULL);
+		case '\\':
+			c = ps->p[1];
+			if (c == '(') {
+				ps->p += 2;
+				if (ps->p[0] == '\\' && ps->p[1] == ')') {
+					ps->error = 1;
+					return make_tree(ps, T_EMPTY, NULL, NULL);
+				}
+				ps->depth++;
+				t = parse_cat(ps);
+				ps->depth--;
+				if (ps->p[0] != '\\' || ps->p[1] != ')')
+					ps->error = 1;
+				else
+					ps->p += 2;
+				return t;
+			}
+			if (c == '\0' || !strchr(".[]*^$\\", c)) {
+				ps->error = 1;
+				return make_tree(ps, T_EMPTY, NULL, NULL);
+			}
+			ps->p += 2;
+			return make_char(ps, c);
+		}
+	}
+	switch (c) {
+	case '.':
+		ps->p++;
+		t = make_tree(ps, T_SET, NULL, NULL);
+		t->set = new_set(ps);
+		memset(get_set(ps, t->set)->bits, 0xff, sizeof(CHARSET));
+		get_set(ps, t->set)->bits[0] &= ~1;
+		return t;
+	case '[':
+		ps->p++;
+		return parse_bracket(ps);
+	}
+	ps->p++;
+	return make_char(ps, c);
+}
+/*
+ * NFA construction.
+ *
+ * The tree is compiled backward: compile(t, next) returns the entry node
+ * of the fragment which matches 't' and then continues to 'next'.
+ */
+static int
+new_node(DFA *dfa, int type, int set, int out1, int out2)
+{
+	struct nfa_node *n;
+
+	if (dfa->nodes->length >= DFA_MAXNODES)
+		return -1;
+	n = varray_append(dfa->nodes);
+	n->type = type;
+	n->set = set;
+	n->out1 = out1;
+	n->out2 = out2;
+	return dfa->nodes->length - 1;
+}
+static struct nfa_node *
+get_node(DFA *dfa, int id)
+{
+	return varray_assign(dfa->nodes, id, 0);
+}
+static int
+compile(DFA *dfa, struct tree *t, int next)
+{
+	int i, e, s, body;
+
+	if (next < 0)
+		return -1;
+	switch (t->type) {
+	case T_SET:
+		return new_node(dfa, N_SET, t->set, next, -1);
+	case T_CAT:
+		return compile(dfa, t->left, compile(dfa, t->right, next));
+	case T_ALT:
+		e = compile(dfa, t->right, next);
+		s = compile(dfa, t->left, next);
+		if (e < 0 || s < 0)
+			return -1;
+		return new_node(dfa, N_SPLIT, -1, s, e);
+	case T_BOL:
+		return new_node(dfa, N_BOL, -1, next, -1);
+	case T_EOL:
+		return new_node(dfa, N_EOL, -1, next, -1);
+	case T_EMPTY:
+		return next;
+	case T_REPEAT:
+		if (t->max < 0) {
+			/* loop: s -> body -> s, s -> next */
+			if ((s = new_node(dfa, N_SPLIT, -1, -1, next)) < 0)
+				return -1;
+			if ((body = compile(dfa, t->left, s)) < 0)
+				return -1;
+			get_node(dfa, s)->out1 = body;
+			e = s;
+		} else {
+			e = next;
+			for (i = t->min; i < t->max; i++) {
+				if ((body = compile(dfa, t->left, e)) < 0)
+					return -1;
+				if ((e = new_node(dfa, N_SPLIT, -1, body, next)) < 0)
+					return -1;
+			}
+		}
+		for (i = 0; i < t->min; i++)
+			if ((e = compile(dfa, t->left, e)) < 0)
+				return -1;
+		return e;
+	}
+	return -1;
+}
+/*
+ * closure: add the epsilon closure of the node to dfa->work.
+ *
+ *	i)	dfa	DFA
+ *	i)	id	NFA node
+ *	i)	bol	at the head of string
+ */
+static void
+closure(DFA *dfa, int id, int bol)
+{
+	int sp = 0;
+
+	dfa->stack[sp++] = id;
+	while (sp > 0) {
+		struct nfa_node *n;
+
+		id = dfa->stack[--sp];
+		if (dfa->mark[id] == dfa->gen)
+			continue;
+		dfa->mark[id] = dfa->gen;
+		n = get_node(dfa, id);
+		switch (n->type) {
+		case N_SPLIT:
+			dfa->stack[sp++] = n->out2;
+			dfa->stack[sp++] = n->out1;
+			break;
+		case N_BOL:
+			if (bol)
+				dfa->stack[sp++] = n->out1;
+			break;
+		default:
+			dfa->work[dfa->nwork++] = id;
+			break;
+		}
+	}
+}
+/*
+ * reach_match: whether or not N_MATCH is reachable at the end of string.
+ */
+static int
+reach_match(DFA *dfa, int id, int bol)
+{
+	int sp = 0;
+
+	dfa->gen++;
+	dfa->stack[sp++] = id;
+	while (sp > 0) {
+		struct nfa_node *n;
+
+		id = dfa->stack[--sp];
+		if (dfa->mark[id] == dfa->gen)
+			continue;
+		dfa->mark[id] = dfa->gen;
+		n = get_node(dfa, id);
+		switch (n->type) {
+		case N_MATCH:
+			return 1;
+		case N_SPLIT:
+			dfa->stack[sp++] = n->out2;
+			dfa->stack[sp++] = n->out1;
+			break;
+		case N_BOL:
+			if (bol)
+				dfa->stack[sp++] = n->out1;
+			break;
+		case N_EOL:
+			dfa->stack[sp++] = n->out1;
+			break;
+		}
+	}
+	return 0;
+}
+static int
+compare_id(const void *v1, const void *v2)
+{
+	return *(const int *)v1 - *(const int *)v2;
+}
+static void
+flush_states(DFA *dfa)
+{
+	int i;
+
+	for (i = 0; i < DFA_HASHSIZE; i++) {
+		struct dstate *d, *next;
+
+		for (d = dfa->htab[i]; d; d = next) {
+			next = d->hnext;
+			free(d);
+		}
+		dfa->htab[i] = NULL;
+	}
+	pool_reset(dfa->pool);
+	dfa->nstates = 0;
+	dfa->initial = NULL;
+}
+/*
+ * lookup_state: get the DFA state for the set in dfa->work.
+ *
+ *	i)	dfa	DFA
+ *	i)	bol	the state is at the head of string
+ *	r)		DFA state
+ */
+static struct dstate *
+lookup_state(DFA *dfa, int bol)
+{
+	struct dstate *d;
+	unsigned int h = 0;
+	int i;
+
+	qsort(dfa->work, dfa->nwork, sizeof(int), compare_id);
+	for (i = 0; i < dfa->nwork; i++)
+		h = h * 31 + dfa->work[i];
+	h = (h + bol) % DFA_HASHSIZE;
+	for (d = dfa->htab[h]; d; d = d->hnext)
+		if (d->nids == dfa->nwork && !memcmp(d->ids, dfa->work, dfa->nwork * sizeof(int)))
+			if ((d == dfa->initial) == (bol != 0))
+				return d;
+	d = check_calloc(sizeof(struct dstate), 1);
+	d->nids = dfa->nwork;
+	d->ids = pool_malloc(dfa->pool, dfa->nwork * sizeof(int) + 1);
+	memcpy(d->ids, dfa->work, dfa->nwork * sizeof(int));
+	for (i = 0; i < d->nids; i++) {
+		struct nfa_node *n = get_node(dfa, d->ids[i]);
+
+		if (n->type == N_MATCH)
+			d->match = 1;
+		else if (n->type == N_EOL && !d->accept_end)
+			d->accept_end = reach_match(dfa, n->out1, bol);
+	}
+	d->hnext = dfa->htab[h];
+	dfa->htab[h] = d;
+	dfa->nstates++;
+	return d;
+}
+static struct dstate *
+initial_state(DFA *dfa)
+{
+	if (dfa->initial == NULL) {
+		dfa->gen++;
+		dfa->nwork = 0;
+		closure(dfa, dfa->start, 1);
+		dfa->initial = lookup_state(dfa, 1);
+	}
+	return dfa->initial;
+}
+/*
+ * next_state: build the transition of the state by the byte.
+ */
+static struct dstate *
+next_state(DFA *dfa, struct dstate *d, int c)
+{
+	struct dstate *nd;
+	int i;
+
+	dfa->gen++;
+	dfa->nwork = 0;
+	for (i = 0; i < d->nids; i++) {
+		struct nfa_node *n = get_node(dfa, d->ids[i]);
+
+		if (n->type == N_SET) {
+			CHARSET *cs = varray_assign(dfa->sets, n->set, 0);
+
+			if (CS_ISSET(cs, c))
+				closure(dfa, n->out1, 0);
+		}
+	}
+	/*
+	 * A match may start at any position.
+	 */
+	for (i = 0; i < dfa->ninject; i++)
+		if (dfa->mark[dfa->inject[i]] != dfa->gen) {
+			dfa->mark[dfa->inject[i]] = dfa->gen;
+			dfa->work[dfa->nwork++] = dfa->inject[i];
+		}
+	if (dfa->nstates >= DFA_MAXSTATES) {
+		flush_states(dfa);
+		return lookup_state(dfa, 0);
+	}
+	nd = lookup_state(dfa, 0);
+	d->next[c] = nd;
+	return nd;
+}
+static DFA *
+dfa_compile(const char *pattern, int cflags)
+{
+	struct parser ps;
+	struct tree *t;
+	DFA *dfa;
+	int n, i;
+
+	if (cflags & REG_NEWLINE)
+		return NULL;
+	ps.pattern = ps.p = (const unsigned char *)pattern;
+	ps.extended = (cflags & REG_EXTENDED) ? 1 : 0;
+	ps.icase = (cflags & REG_ICASE) ? 1 : 0;
+	ps.depth = 0;
+	ps.error = 0;
+	ps.pool = pool_open();
+	ps.sets = varray_open(sizeof(CHARSET), 32);
+	t = parse_alt(&ps);
+	if (ps.error || *ps.p != '\0') {
+		pool_close(ps.pool);
+		varray_close(ps.sets);
+		return NULL;
+	}
+	dfa = check_calloc(sizeof(DFA), 1);
+	dfa->sets = ps.sets;
+	dfa->nodes = varray_open(sizeof(struct nfa_node), 64);
+	dfa->start = compile(dfa, t, new_node(dfa, N_MATCH, -1, -1, -1));
+	pool_close(ps.pool);
+	if (dfa->start < 0) {
+		varray_close(dfa->nodes);
+		varray_close(dfa->sets);
+		free(dfa);
+		return NULL;
+	}
+	n = dfa->nodes->length;
+	dfa->mark = check_calloc(sizeof(int), n);
+	dfa->stack = check_malloc(sizeof(int) * (n * 2 + 1));
+	dfa->work = check_malloc(sizeof(int) * (n + 1));
+	dfa->pool = pool_open();
+	/*
+	 * Closure of the start node except at the head of string.
+	 */
+	dfa->gen++;
+	dfa->nwork = 0;
+	closure(dfa, dfa->start, 0);
+	dfa->ninject = dfa->nwork;
+	dfa->inject = check_malloc(sizeof(int) * (dfa->nwork + 1));
+	for (i = 0; i < dfa->nwork; i++)
+		dfa->inject[i] = dfa->work[i];
+	return dfa;
+}
+static int
+dfa_exec(DFA *dfa, const char *string)
+{
+	const unsigned char *p = (const unsigned char *)string;
+	struct dstate *d = initial_state(dfa);
+
+	for (; *p; p++) {
+		struct dstate *nd;
+
+		if (d->match)
+			return 0;
+		if ((nd = d->next[*p]) == NULL)
+			nd = next_state(dfa, d, *p);
+		d = nd;
+		if (d->nids == 0)
+			return REG_NOMATCH;
+	}
+	return (d->match || d->accept_end) ? 0 : REG_NOMATCH;
+}
+static void
+dfa_close(DFA *dfa)
+{
+	flush_states(dfa);
+	pool_close(dfa->pool);
+	varray_close(dfa->nodes);
+	varray_close(dfa->sets);
+	free(dfa->mark);
+	free(dfa->stack);
+	free(dfa->work);
+	free(dfa->inject);
+	free(dfa);
+}
+/*
+ * Registry of compiled patterns.
+ */
+static struct {
+	const regex_t *preg;
+	DFA *dfa;
+} slot[DFA_SLOTS];
+static int last_slot;
+
+static DFA *
+lookup_dfa(const regex_t *preg)
+{
+	int i;
+
+	if (slot[last_slot].preg == preg)
+		return slot[last_slot].dfa;
+	for (i = 0; i < DFA_SLOTS; i++)
+		if (slot[i].preg == preg) {
+			last_slot = i;
+			return slot[i].dfa;
+		}
+	return NULL;
+}
+static void
+unregister_dfa(const regex_t *preg)
+{
+	int i;
+
+	for (i = 0; i < DFA_SLOTS; i++)
+		if (slot[i].preg == preg) {
+			dfa_close(slot[i].dfa);
+			slot[i].preg = NULL;
+			slot[i].dfa = NULL;
+		}
+}
+/*
+ * dfa_regcomp: compile regular expression.
+ *
+ *	o)	preg	compiled regular expression
+ *	i)	pattern	regular expression
+ *	i)	cflags	flags for regcomp(3)
+ *	r)		return value of regcomp(3)
+ *
+ * If the pattern can be handled by the DFA matcher, it is associated
+ * with the preg.
+ */
+int
+dfa_regcomp(regex_t *preg, const char *pattern, int cflags)
+{
+	DFA *dfa;
+	int ret, i;
+
+	unregister_dfa(preg);
+	if ((ret = regcomp(preg, pattern, cflags)) != 0)
+		return ret;
+	if ((dfa = dfa_compile(pattern, cflags)) == NULL)
+		return ret;
+	for (i = 0; i < DFA_SLOTS; i++)
+		if (slot[i].preg == NULL) {
+			slot[i].preg = preg;
+			slot[i].dfa = dfa;
+			return ret;
+		}
+	/* No room. Regexec(3) will be used for the pattern. */
+	dfa_close(dfa);
+	return ret;
+}
+/*
+ * dfa_regexec: whether or not the string matches the pattern.
+ *
+ *	i)	preg	compiled regular expression by dfa_regcomp()
+ *	i)	string	string
+ *	r)		0: match, REG_NOMATCH: not match
+ */
+int
+dfa_regexec(const regex_t *preg, const char *string)
+{
+	DFA *dfa = lookup_dfa(preg);
+
+	if (dfa)
+		return dfa_exec(dfa, string);
+	return regexec(preg, string, 0, 0, 0);
+}
+/*
+ * dfa_regfree: free compiled regular expression.
+ *
+ *	i)	preg	compiled regular expression by dfa_regcomp()
+ */
+void
+dfa_regfree(regex_t *preg)
+{
+	unregister_dfa(preg);
+	regfree(preg);
+}
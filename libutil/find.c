@@ -53,6 +53,7 @@
 #include "conf.h"
 #include "die.h"
 #include "find.h"
+#include "gitindex.h"
 #include "is_unixy.h"
 #include "locatestring.h"
 #include "makepath.h"
@@ -96,14 +97,19 @@ static FILE *ip;
 static FILE *temp;
 static char rootdir[MAXPATHLEN];
 static char cwddir[MAXPATHLEN];
+static GITINDEX *gitindex;
+static struct stat gitindex_stat;	/* stat of the last path of the index */
 static int find_mode;
 static int find_eof;
 #define FIND_OPEN	1
 #define FILELIST_OPEN	2
+#define CLASSIFY_OPEN	3
+#define GITINDEX_OPEN	4
 
 static void trim(char *);
 static char *find_read_traverse(void);
 static char *find_read_filelist(void);
+static char *find_read_gitindex(void);
 
 extern int qflag;
 #ifdef DEBUG
@@ -511,6 +517,36 @@ find_open_filelist(const char *filename, const char *root)
 	prepare_skip();
 	prepare_source();
 }
+/*
+ * find_open_gitindex: find_open like interface for the files tracked by git.
+ *
+ *	i)	root	root directory of source tree
+ *	r)		0: normal, -1: the git index is not available
+ *
+ * Files are read from the index of the working tree which has the root
+ * directory, instead of traversing the file system. They are selected
+ * in the same way as find_open_filelist().
+ */
+int
+find_open_gitindex(const char *root)
+{
+	assert(find_mode == 0);
+	if ((gitindex = gitindex_open(root)) == NULL)
+		return -1;
+	find_mode = GITINDEX_OPEN;
+
+	/*
+	 * This is temporary measures. It doesn't decide how to become final.
+	 */
+	if (getenv("GTAGSALLOWBLANK"))
+		allow_blank = 1;
+	/*
+	 * prepare regular expressions.
+	 */
+	prepare_skip();
+	prepare_source();
+	return 0;
+}
 /*
  * find_read: read path without GPATH.
  *
@@ -528,6 +564,8 @@ find_read(void)
 		path = find_read_filelist();
 	else if (find_mode == FIND_OPEN)
 		path = find_read_traverse();
+	else if (find_mode == GITINDEX_OPEN)
+		path = find_read_gitindex();
 	else
 		die("find_read: internal error.");
 	return path;
@@ -704,6 +742,104 @@ find_read_filelist(void)
 		return path;
 	}
 }
+/*
+ * find_read_gitindex: read path from the git index
+ *
+ *	r)		path
+ */
+static char *
+find_read_gitindex(void)
+{
+	static char buf[MAXPATHLEN + 1];
+	const struct gitindex_entry *entry;
+	char *path = buf + 1;
+
+	while ((entry = gitindex_read(gitindex)) != NULL) {
+		snprintf(path, sizeof(buf) - 1, "./%s", entry->path);
+		/*
+		 * Skip the following:
+		 * o file which was removed from the working tree
+		 * o dead symbolic link or link to directory
+		 */
+		if (stat(path, &gitindex_stat) < 0 || !S_ISREG(gitindex_stat.st_mode))
+			continue;
+		/*
+		 * GLOBAL cannot treat path which includes blanks.
+		 * It will be improved in the future.
+		 */
+		if (!allow_blank && locatestring(path, " ", MATCH_LAST)) {
+			warning("'%s' ignored, because it includes blank.", path + 2);
+			continue;
+		}
+		if (skipthisfile(path))
+			continue;
+		/*
+		 * A blank at the head of path means
+		 * other than source file.
+		 */
+		if (regexec(suff, path, 0, 0, 0) != 0)
+			*--path = ' ';
+		return path;
+	}
+	find_eof = 1;
+	return NULL;
+}
+/*
+ * find_stat: stat(2) for the path returned by find_read().
+ *
+ *	i)	path	path name (without the leading blank)
+ *	o)	st	stat structure
+ *	r)		0: normal, -1: error
+ *
+ * Find_read_gitindex() has already called stat(2) for the path.
+ */
+int
+find_stat(const char *path, struct stat *st)
+{
+	if (find_mode == GITINDEX_OPEN && !find_eof) {
+		*st = gitindex_stat;
+		return 0;
+	}
+	return stat(path, st);
+}
+/*
+ * find_open_classify: start classification of paths.
+ *
+ * Find_classify() is available until find_close().
+ */
+void
+find_open_classify(void)
+{
+	assert(find_mode == 0);
+	find_mode = CLASSIFY_OPEN;
+
+	if (getenv("GTAGSALLOWBLANK"))
+		allow_blank = 1;
+	prepare_source();
+	prepare_skip();
+}
+/*
+ * find_classify: classify a path in the same way as find_read().
+ *
+ *	i)	path	path name (must start with "./")
+ *			Directory path name must end with "/".
+ *	r)		FIND_SKIP: skipped
+ *			FIND_SOURCE: source file
+ *			FIND_OTHER: other file
+ *			FIND_DIRECTORY: directory to be traversed
+ */
+int
+find_classify(const char *path)
+{
+	assert(find_mode != 0);
+	if (skipthisfile(path))
+		return FIND_SKIP;
+	if (*path && path[strlen(path) - 1] == '/')
+		return FIND_DIRECTORY;
+	if (!allow_blank && locatestring(path, " ", MATCH_FIRST))
+		return FIND_SKIP;
+	return (regexec(suff, path, 0, 0, 0) == 0) ? FIND_SOURCE : FIND_OTHER;
+}
 /*
  * find_close: close iterator.
  */
@@ -721,7 +857,10 @@ find_close(void)
 		 */
 		if (ip != temp)
 			fclose(ip);
-	} else {
+	} else if (find_mode == GITINDEX_OPEN) {
+		gitindex_close(gitindex);
+		gitindex = NULL;
+	} else if (find_mode != CLASSIFY_OPEN) {
 		die("find_close: internal error.");
 	}
 	regfree(suff);
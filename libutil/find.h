@@ -21,9 +21,20 @@
 #ifndef _FIND_H_
 #define _FIND_H_
 
+#define FIND_SKIP	0
+#define FIND_SOURCE	1
+#define FIND_OTHER	2
+#define FIND_DIRECTORY	3
+
+struct stat;
+
 void find_open(const char *);
 void find_open_filelist(const char *, const char *);
+int find_open_gitindex(const char *);
 char *find_read(void);
+int find_stat(const char *, struct stat *);
+void find_open_classify(void);
+int find_classify(const char *);
 void find_close(void);
 
 #endif /* ! _FIND_H_ */
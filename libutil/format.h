@@ -51,6 +51,14 @@
  *
  * +----------------------------------------------
  * |./src/main.c main 227 main()
+ *
+ * (7) JSON format (FORMAT_JSON)
+ *
+ * +----------------------------------------------
+ * |{"tag":"main","path":"./src/main.c","lineno":227,"line":"main()"}
+ *
+ *	Each record is a JSON object in a line. Since the control characters
+ *	are escaped in the strings, a record never includes a newline.
  */
 #define FORMAT_CTAGS		1
 #define FORMAT_CTAGS_X		2
@@ -58,6 +66,7 @@
 #define FORMAT_PATH		4
 #define FORMAT_GREP		5
 #define FORMAT_CSCOPE		6
+#define FORMAT_JSON		7
 
 /*
  * FORMAT_CTAGS_X
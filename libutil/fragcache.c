@@ -0,0 +1,669 @@
+/*
+ * Copyright (c) 2010 Tama Communications Corporation
+ *
+ * This file is part of GNU GLOBAL.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#ifdef HAVE_DIRENT_H
+#include <dirent.h>
+#endif
+#include <stdio.h>
+#ifdef STDC_HEADERS
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#else
+#include <strings.h>
+#endif
+#include <time.h>
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#include <utime.h>
+
+#include "checkalloc.h"
+#include "die.h"
+#include "fragcache.h"
+#include "locatestring.h"
+#include "pool.h"
+#include "strbuf.h"
+#include "strlimcpy.h"
+#include "test.h"
+#include "varray.h"
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+/*
+ * Tag fragment cache.
+ *
+ * The records which a parser produced for a file are kept in a cache
+ * directory, keyed by the contents of the file and the configuration of
+ * parsers (fingerprint). Gtags replays them instead of parsing the file
+ * again. Since the key doesn't depend on the location of the file, the
+ * directory can be shared by many source trees, worktrees and hosts.
+ *
+ *	dir/3f/2a...c1		entry of key '3f2a...c1'
+ *
+ *	GLOBAL FRAGMENT 1
+ *	<type> <lno> <tag> <line image>
+ *	<type> <lno> <tag>			(line image is NULL)
+ *	...
+ *	end <number of records>
+ *
+ * The key is the SHA-1 digest of the fingerprint, the last component of
+ * the path (which decides the language) and the contents. An entry is
+ * written to a temporary file and renamed, so that readers never see a
+ * partial entry, even on NFS. An entry which is incomplete is ignored.
+ *
+ * The key is made again after parsing, and the records are not stored
+ * if the file was modified while it was parsed.
+ *
+ * The modification time of an entry is its last use. It is updated at
+ * most once per FRAGCACHE_TOUCH seconds to reduce writes to the directory.
+ * When the directory exceeds the size limit, the least recently used
+ * entries are removed until it falls to 90% of the limit. The size of
+ * the directory is kept in a file (see writesize()).
+ *
+ * The cache is only an accelerator. Any failure is ignored silently.
+ */
+#define FRAGCACHE_MAGIC		"GLOBAL FRAGMENT 1"
+#define FRAGCACHE_TOUCH		(60 * 60)
+#define FRAGCACHE_STALE		(24 * 60 * 60)
+
+/*
+ * SHA-1 (FIPS 180-1)
+ */
+struct sha1 {
+	unsigned int h[5];
+	unsigned long len;		/* length in bytes	*/
+	unsigned char buf[64];
+};
+#define ROL(x, n)	((((x) << (n)) | (((x) & 0xffffffffU) >> (32 - (n)))) & 0xffffffffU)
+
+static void
+sha1_block(struct sha1 *c, const unsigned char *p)
+{
+	unsigned int w[80], a, b, cc, d, e, t;
+	int i;
+
+	for (i = 0; i < 16; i++, p += 4)
+		w[i] = ((unsigned int)p[0] << 24) | ((unsigned int)p[1] << 16) | ((unsigned int)p[2] << 8) | p[3];
+	for (; i < 80; i++)
+		w[i] = ROL(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+	a = c->h[0];
+	b = c->h[1];
+	cc = c->h[2];
+	d = c->h[3];
+	e = c->h[4];
+	for (i = 0; i < 80; i++) {
+		if (i < 20)
+			t = ((b & cc) | (~b & d)) + 0x5A827999U;
+		else if (i < 40)
+			t = (b ^ cc ^ d) + 0x6ED9EBA1U;
+		else if (i < 60)
+			t = ((b & cc) | (b & d) | (cc & d)) + 0x8F1BBCDCU;
+		else
+			t = (b ^ cc ^ d) + 0xCA62C1D6U;
+		t = (ROL(a, 5) + t + e + w[i]) & 0xffffffffU;
+		e = d;
+		d = cc;
+		cc = ROL(b, 30);
+		b = a;
+		a = t;
+	}
+	c->h[0] = (c->h[0] + a) & 0xffffffffU;
+	c->h[1] = (c->h[1] + b) & 0xffffffffU;
+	c->h[2] = (c->h[2] + cc) & 0xffffffffU;
+	c->h[3] = (c->h[3] + d) & 0xffffffffU;
+	c->h[4] = (c->h[4] + e) & 0xffffffffU;
+}
+static void
+sha1_init(struct sha1 *c)
+{
+	c->h[0] = 0x67452301U;
+	c->h[1] = 0xEFCDAB89U;
+	c->h[2] = 0x98BADCFEU;
+	c->h[3] = 0x10325476U;
+	c->h[4] = 0xC3D2E1F0U;
+	c->len = 0;
+}
+static void
+sha1_update(struct sha1 *c, const void *data, unsigned long len)
+{
+	const unsigned char *p = data;
+	int used = c->len % 64;
+
+	c->len += len;
+	if (used > 0) {
+		int n = 64 - used;
+
+		if (len < (unsigned long)n) {
+			memcpy(c->buf + used, p, len);
+			return;
+		}
+		memcpy(c->buf + used, p, n);
+		sha1_block(c, c->buf);
+		p += n;
+		len -= n;
+	}
+	for (; len >= 64; p += 64, len -= 64)
+		sha1_block(c, p);
+	memcpy(c->buf, p, len);
+}
+static void
+sha1_final(struct sha1 *c, char *hex)
+{
+	static const char digits[] = "0123456789abcdef";
+	unsigned char tail[8];
+	unsigned int hi = c->len >> 29, lo = (c->len << 3) & 0xffffffffU;
+	int i;
+
+	for (i = 0; i < 4; i++) {
+		tail[i] = (hi >> (24 - i * 8)) & 0xff;
+		tail[i + 4] = (lo >> (24 - i * 8)) & 0xff;
+	}
+	sha1_update(c, "\x80", 1);
+	while (c->len % 64 != 56)
+		sha1_update(c, "", 1);
+	sha1_update(c, tail, 8);
+	for (i = 0; i < 20; i++) {
+		unsigned int v = (c->h[i / 4] >> (24 - (i % 4) * 8)) & 0xff;
+
+		*hex++ = digits[v >> 4];
+		*hex++ = digits[v & 0xf];
+	}
+	*hex = '\0';
+}
+/*
+ * makekey: make the key of a file.
+ *
+ *	i)	fc	FRAGCACHE structure
+ *	i)	path	path name
+ *	o)	key	key (41 bytes)
+ *	r)		0: normal, -1: cannot read the file
+ */
+static int
+makekey(FRAGCACHE *fc, const char *path, char *key)
+{
+	struct sha1 c;
+	const char *name = locatestring(path, "/", MATCH_LAST);
+	char buf[8192];
+	int fd, n;
+
+	if ((fd = open(path, O_RDONLY|O_BINARY)) < 0)
+		return -1;
+	name = name ? name + 1 : path;
+	sha1_init(&c);
+	sha1_update(&c, fc->fingerprint, strlen(fc->fingerprint) + 1);
+	sha1_update(&c, name, strlen(name) + 1);
+	while ((n = read(fd, buf, sizeof(buf))) > 0)
+		sha1_update(&c, buf, n);
+	close(fd);
+	if (n < 0)
+		return -1;
+	sha1_final(&c, key);
+	return 0;
+}
+/*
+ * parse_record: parse a record of an entry.
+ *
+ *	io)	pp	position (updated to the next record)
+ *	i)	end	end of the entry
+ *	i)	terminate 1: terminate strings in place
+ *	o)	type, lno, tag, image	fields of the record
+ *	r)		0: normal, -1: broken
+ */
+static int
+parse_record(char **pp, const char *end, int terminate, int *type, int *lno, char **tag, char **image)
+{
+	char *p = *pp, *q, *nl;
+
+	if ((nl = memchr(p, '\n', end - p)) == NULL)
+		return -1;
+	*type = strtol(p, &q, 10);
+	if (q == p || *q != ' ')
+		return -1;
+	p = q + 1;
+	*lno = strtol(p, &q, 10);
+	if (q == p || *q != ' ')
+		return -1;
+	*tag = p = q + 1;
+	while (p < nl && *p != ' ')
+		p++;
+	if (p == *tag)
+		return -1;
+	*image = (p < nl) ? p + 1 : NULL;
+	if (terminate) {
+		*p = '\0';
+		*nl = '\0';
+	}
+	*pp = nl + 1;
+	return 0;
+}
+/*
+ * valid: check the structure of an entry.
+ *
+ *	i)	start	start of the entry
+ *	i)	end	end of the entry
+ *	o)	body	start of the records
+ *	o)	count	number of the records
+ *	r)		1: valid, 0: invalid
+ */
+static int
+valid(char *start, char *end, char **body, int *count)
+{
+	char *p = start, *tag, *image;
+	int type, lno, n = 0;
+
+	if (end - start < (int)sizeof(FRAGCACHE_MAGIC)
+	    || strncmp(start, FRAGCACHE_MAGIC "\n", sizeof(FRAGCACHE_MAGIC)))
+		return 0;
+	p = *body = start + sizeof(FRAGCACHE_MAGIC);
+	for (;;) {
+		if (end - p > 4 && !strncmp(p, "end ", 4)) {
+			if (atoi(p + 4) != n || *(end - 1) != '\n' || memchr(p, '\n', end - p) != end - 1)
+				return 0;
+			*count = n;
+			return 1;
+		}
+		if (parse_record(&p, end, 0, &type, &lno, &tag, &image) < 0)
+			return 0;
+		n++;
+	}
+}
+/*
+ * fragcache_open: open tag fragment cache.
+ *
+ *	i)	dir		cache directory (made if it doesn't exist)
+ *	i)	fingerprint	configuration of parsers
+ *	i)	limit		maximum size of the directory (0: unlimited)
+ *	r)			FRAGCACHE structure (NULL: not available)
+ */
+FRAGCACHE *
+fragcache_open(const char *dir, const char *fingerprint, unsigned long limit)
+{
+	FRAGCACHE *fc;
+
+	if (!test("d", dir)) {
+#if defined(_WIN32) && !defined(__CYGWIN__)
+		if (mkdir(dir) < 0 && errno != EEXIST)
+#else
+		if (mkdir(dir, 0777) < 0 && errno != EEXIST)
+#endif
+			return NULL;
+	}
+	fc = check_calloc(sizeof(FRAGCACHE), 1);
+	strlimcpy(fc->dir, dir, sizeof(fc->dir));
+	fc->fingerprint = fingerprint;
+	fc->limit = limit;
+	fc->records = strbuf_open(0);
+	fc->ib = strbuf_open(0);
+	return fc;
+}
+/*
+ * fragcache_get: replay the records of a file.
+ *
+ *	i)	fc	FRAGCACHE structure
+ *	i)	path	path name
+ *	i)	put	callback routine
+ *	i)	arg	argument for callback routine
+ *	r)		1: replayed, 0: not found
+ *
+ * If not found, the records given by fragcache_put() until
+ * fragcache_commit() are stored as the entry of the file.
+ */
+int
+fragcache_get(FRAGCACHE *fc, const char *path, FRAGCACHE_CALLBACK put, void *arg)
+{
+	char entry[MAXPATHLEN + 48];
+	char buf[8192];
+	char *p, *end, *tag, *image;
+	struct stat st;
+	int fd, n, type, lno, count;
+
+	fc->key[0] = '\0';
+	fc->count = fc->broken = 0;
+	strbuf_reset(fc->records);
+	if (makekey(fc, path, fc->key) < 0) {
+		fc->key[0] = '\0';
+		return 0;
+	}
+	strlimcpy(fc->path, path, sizeof(fc->path));
+	snprintf(entry, sizeof(entry), "%s/%.2s/%s", fc->dir, fc->key, fc->key + 2);
+	if ((fd = open(entry, O_RDONLY|O_BINARY)) < 0)
+		return 0;
+	strbuf_reset(fc->ib);
+	while ((n = read(fd, buf, sizeof(buf))) > 0)
+		strbuf_nputs(fc->ib, buf, n);
+	if (n < 0 || fstat(fd, &st) < 0) {
+		close(fd);
+		return 0;
+	}
+	close(fd);
+	p = strbuf_value(fc->ib);
+	end = p + strbuf_getlen(fc->ib);
+	if (!valid(p, end, &p, &count))
+		return 0;
+	while (count-- > 0) {
+		(void)parse_record(&p, end, 1, &type, &lno, &tag, &image);
+		put(type, tag, lno, path, image, arg);
+	}
+	/*
+	 * Mark the entry as used recently.
+	 */
+	if (time(NULL) - st.st_mtime > FRAGCACHE_TOUCH)
+		(void)utime(entry, NULL);
+	fc->key[0] = '\0';
+	fc->hits++;
+	return 1;
+}
+/*
+ * fragcache_put: record a tag of the current file.
+ *
+ *	i)	fc		FRAGCACHE structure
+ *	i)	type		tag type
+ *	i)	tag		tag name
+ *	i)	lno		line number
+ *	i)	line_image	line image (may be NULL)
+ */
+void
+fragcache_put(FRAGCACHE *fc, int type, const char *tag, int lno, const char *line_image)
+{
+	if (fc->key[0] == '\0' || fc->broken)
+		return;
+	if (*tag == '\0' || strpbrk(tag, " \n") || lno < 0
+	    || (line_image && strchr(line_image, '\n'))) {
+		fc->broken = 1;
+		return;
+	}
+	strbuf_putn(fc->records, type);
+	strbuf_putc(fc->records, ' ');
+	strbuf_putn(fc->records, lno);
+	strbuf_putc(fc->records, ' ');
+	strbuf_puts(fc->records, tag);
+	if (line_image) {
+		strbuf_putc(fc->records, ' ');
+		strbuf_puts(fc->records, line_image);
+	}
+	strbuf_putc(fc->records, '\n');
+	fc->count++;
+}
+/*
+ * fragcache_commit: store the records of the current file.
+ *
+ *	i)	fc	FRAGCACHE structure
+ */
+void
+fragcache_commit(FRAGCACHE *fc)
+{
+	char subdir[MAXPATHLEN + 4], entry[MAXPATHLEN + 48], tmp[MAXPATHLEN + 128];
+	char host[64], key[41];
+	long size;
+	FILE *fp;
+
+	if (fc->key[0] == '\0' || fc->broken)
+		return;
+	/*
+	 * The parser read the file again. If it was modified in the meantime,
+	 * the records may not be of the contents which the key stands for.
+	 */
+	if (makekey(fc, fc->path, key) < 0 || strcmp(key, fc->key)) {
+		fc->key[0] = '\0';
+		return;
+	}
+	snprintf(subdir, sizeof(subdir), "%s/%.2s", fc->dir, fc->key);
+	if (!test("d", subdir)) {
+#if defined(_WIN32) && !defined(__CYGWIN__)
+		if (mkdir(subdir) < 0 && errno != EEXIST)
+#else
+		if (mkdir(subdir, 0777) < 0 && errno != EEXIST)
+#endif
+			return;
+	}
+	snprintf(entry, sizeof(entry), "%s/%s", subdir, fc->key + 2);
+	/*
+	 * The name of the temporary file is unique among hosts sharing
+	 * the directory.
+	 */
+	if (gethostname(host, sizeof(host)) < 0)
+		strlimcpy(host, "localhost", sizeof(host));
+	host[sizeof(host) - 1] = '\0';
+	snprintf(tmp, sizeof(tmp), "%s/.%s.%s.%d", subdir, fc->key + 2, host, (int)getpid());
+	if ((fp = fopen(tmp, "w")) == NULL)
+		return;
+	fputs(FRAGCACHE_MAGIC "\n", fp);
+	fwrite(strbuf_value(fc->records), strbuf_getlen(fc->records), 1, fp);
+	fprintf(fp, "end %d\n", fc->count);
+	size = ftell(fp);
+	if (ferror(fp) || size < 0) {
+		fclose(fp);
+		(void)unlink(tmp);
+		return;
+	}
+	if (fclose(fp) != 0) {
+		(void)unlink(tmp);
+		return;
+	}
+#if defined(_WIN32) || defined(__DJGPP__)
+	(void)unlink(entry);
+#endif
+	if (rename(tmp, entry) < 0) {
+		(void)unlink(tmp);
+		return;
+	}
+	fc->key[0] = '\0';
+	fc->written++;
+	fc->bytes += size;
+}
+/*
+ * Entry of the cache directory for eviction.
+ */
+struct victim {
+	time_t mtime;
+	unsigned long size;
+	const char *path;
+};
+/*
+ * compare routine for qsort(3): the least recently used first.
+ */
+static int
+compare_mtime(const void *v1, const void *v2)
+{
+	const struct victim *e1 = v1;
+	const struct victim *e2 = v2;
+
+	return e1->mtime < e2->mtime ? -1 : e1->mtime > e2->mtime ? 1 : 0;
+}
+/*
+ * evict: remove the least recently used entries to keep the limit.
+ *
+ *	i)	fc	FRAGCACHE structure
+ *	r)		total size of the entries left
+ *
+ * Temporary files left by killed processes are also removed.
+ */
+static unsigned long
+evict(FRAGCACHE *fc)
+{
+	VARRAY *vb = varray_open(sizeof(struct victim), 1000);
+	POOL *pool = pool_open();
+	char subdir[MAXPATHLEN + 260], path[MAXPATHLEN + 520];
+	unsigned long total = 0;
+	time_t now = time(NULL);
+	DIR *top, *sub;
+	struct dirent *dp, *ep;
+	struct stat st;
+	int i;
+
+	if ((top = opendir(fc->dir)) == NULL)
+		goto out;
+	while ((dp = readdir(top)) != NULL) {
+		if (!isxdigit((unsigned char)dp->d_name[0])
+		    || !isxdigit((unsigned char)dp->d_name[1]) || dp->d_name[2] != '\0')
+			continue;
+		snprintf(subdir, sizeof(subdir), "%s/%s", fc->dir, dp->d_name);
+		if ((sub = opendir(subdir)) == NULL)
+			continue;
+		while ((ep = readdir(sub)) != NULL) {
+			struct victim *v;
+
+			if (!strcmp(ep->d_name, ".") || !strcmp(ep->d_name, ".."))
+				continue;
+			snprintf(path, sizeof(path), "%s/%s", subdir, ep->d_name);
+			if (stat(path, &st) < 0 || !S_ISREG(st.st_mode))
+				continue;
+			if (ep->d_name[0] == '.') {
+				if (now - st.st_mtime > FRAGCACHE_STALE)
+					(void)unlink(path);
+				continue;
+			}
+			v = varray_append(vb);
+			v->mtime = st.st_mtime;
+			v->size = st.st_size;
+			v->path = pool_strdup(pool, path, 0);
+			total += st.st_size;
+		}
+		closedir(sub);
+	}
+	closedir(top);
+	if (total <= fc->limit)
+		goto out;
+	qsort(vb->vbuf, vb->length, sizeof(struct victim), compare_mtime);
+	for (i = 0; i < vb->length && total > fc->limit / 10 * 9; i++) {
+		struct victim *v = varray_assign(vb, i, 0);
+
+		/*
+		 * Another gtags may have removed it.
+		 */
+		if (unlink(v->path) == 0 || errno == ENOENT)
+			total -= v->size;
+	}
+out:
+	varray_close(vb);
+	pool_close(pool);
+	return total;
+}
+/*
+ * Running size of the directory.
+ *
+ * Scanning the whole directory at every run is expensive for a large
+ * (or remote) cache. The size file keeps the total size of the entries
+ * and the time when the directory was scanned last:
+ *
+ *	<total size> <time of the last scan>
+ *
+ * Each run adds the size of the entries it wrote. The directory is
+ * scanned (and the entries are evicted if needed) only when the total
+ * exceeds the limit or the last scan is older than FRAGCACHE_STALE,
+ * which corrects the total lost by concurrent updates.
+ */
+#define FRAGCACHE_SIZE		"size"
+
+/*
+ * readsize: read the size file.
+ *
+ *	i)	fc	FRAGCACHE structure
+ *	o)	total	total size
+ *	o)	scanned	time of the last scan
+ *	r)		0: normal, -1: not available
+ */
+static int
+readsize(FRAGCACHE *fc, unsigned long *total, time_t *scanned)
+{
+	char path[MAXPATHLEN + 8];
+	unsigned long t;
+	long s;
+	FILE *fp;
+	int n;
+
+	snprintf(path, sizeof(path), "%s/%s", fc->dir, FRAGCACHE_SIZE);
+	if ((fp = fopen(path, "r")) == NULL)
+		return -1;
+	n = fscanf(fp, "%lu %ld", &t, &s);
+	fclose(fp);
+	if (n != 2)
+		return -1;
+	*total = t;
+	*scanned = (time_t)s;
+	return 0;
+}
+/*
+ * writesize: write the size file.
+ *
+ *	i)	fc	FRAGCACHE structure
+ *	i)	total	total size
+ *	i)	scanned	time of the last scan
+ */
+static void
+writesize(FRAGCACHE *fc, unsigned long total, time_t scanned)
+{
+	char path[MAXPATHLEN + 8], tmp[MAXPATHLEN + 32];
+	FILE *fp;
+
+	snprintf(path, sizeof(path), "%s/%s", fc->dir, FRAGCACHE_SIZE);
+	snprintf(tmp, sizeof(tmp), "%s.%d", path, (int)getpid());
+	if ((fp = fopen(tmp, "w")) == NULL)
+		return;
+	fprintf(fp, "%lu %ld\n", total, (long)scanned);
+	if (fclose(fp) != 0) {
+		(void)unlink(tmp);
+		return;
+	}
+#if defined(_WIN32) || defined(__DJGPP__)
+	(void)unlink(path);
+#endif
+	if (rename(tmp, path) < 0)
+		(void)unlink(tmp);
+}
+/*
+ * fragcache_close: close tag fragment cache.
+ *
+ *	i)	fc	FRAGCACHE structure
+ *
+ * If entries were written, the size of the directory is checked.
+ */
+void
+fragcache_close(FRAGCACHE *fc)
+{
+	if (fc->written > 0 && fc->limit > 0) {
+		unsigned long total;
+		time_t scanned, now = time(NULL);
+
+		if (readsize(fc, &total, &scanned) < 0
+		    || now - scanned > FRAGCACHE_STALE
+		    || total + fc->bytes > fc->limit) {
+			total = evict(fc);
+			scanned = now;
+		} else
+			total += fc->bytes;
+		writesize(fc, total, scanned);
+	}
+	strbuf_close(fc->records);
+	strbuf_close(fc->ib);
+	free(fc);
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2010 Tama Communications Corporation
+ *
+ * This file is part of GNU GLOBAL.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef _FRAGCACHE_H_
+#define _FRAGCACHE_H_
+
+#include "gparam.h"
+#include "strbuf.h"
+
+/*
+ * Same as PARSER_CALLBACK of libparser.
+ */
+typedef void (*FRAGCACHE_CALLBACK)(int, const char *, int, const char *, const char *, void *);
+
+typedef struct {
+	char dir[MAXPATHLEN];		/* cache directory		*/
+	const char *fingerprint;	/* parser configuration		*/
+	unsigned long limit;		/* maximum size (0: unlimited)	*/
+	char key[41];			/* key of the current file ("": not cacheable) */
+	char path[MAXPATHLEN];		/* path of the current file	*/
+	STRBUF *records;		/* records of the current file	*/
+	int count;			/* number of the records	*/
+	int broken;			/* 1: records cannot be stored	*/
+	int written;			/* number of entries written	*/
+	unsigned long bytes;		/* size of entries written	*/
+	int hits;			/* number of entries replayed	*/
+	STRBUF *ib;			/* input buffer			*/
+} FRAGCACHE;
+
+FRAGCACHE *fragcache_open(const char *, const char *, unsigned long);
+int fragcache_get(FRAGCACHE *, const char *, FRAGCACHE_CALLBACK, void *);
+void fragcache_put(FRAGCACHE *, int, const char *, int, const char *);
+void fragcache_commit(FRAGCACHE *);
+void fragcache_close(FRAGCACHE *);
+
+#endif /* ! _FRAGCACHE_H_ */
@@ -0,0 +1,759 @@
+/*
+ * Copyright (c) 2010 Tama Communications Corporation
+ *
+ * This file is part of GNU GLOBAL.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <stdio.h>
+#ifdef STDC_HEADERS
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#else
+#include <strings.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#if !defined(_WIN32) && !defined(__DJGPP__)
+#include <sys/mman.h>
+#endif
+
+#include "checkalloc.h"
+#include "compress.h"
+#include "die.h"
+#include "frozen.h"
+#include "gpathop.h"
+#include "gtagsop.h"
+#include "hash-string.h"
+#include "makepath.h"
+#include "strbuf.h"
+#include "strlimcpy.h"
+#include "test.h"
+#include "varray.h"
+
+/*
+ * Frozen snapshot of tag files.
+ *
+ * 'gtags --freeze' dumps GTAGS, GRTAGS, GSYMS and GPATH into one read-only
+ * file (GFROZEN) which global(1) maps into memory instead of walking the
+ * B-trees. The file consists of the following page aligned sections:
+ *
+ *	+---------------------------+
+ *	|header                     | magic, version, stamps of tag files
+ *	+---------------------------+
+ *	|string pool                | '\0' terminated strings
+ *	+---------------------------+
+ *	|path table                 | struct frozen_path, sorted by path
+ *	|fid map                    | fid -> index of path table + 1
+ *	+---------------------------+
+ *	|key table (GTAGS)          | struct frozen_key, sorted by name
+ *	|displacement (GTAGS)       | minimal perfect hash
+ *	|slot table (GTAGS)         | hash slot -> index of key table
+ *	|posting (GTAGS)            | struct frozen_posting, sorted by
+ *	+---------------------------+ name, path and line number
+ *	|... (GRTAGS)               |
+ *	|... (GSYMS)                |
+ *	+---------------------------+
+ *
+ * The minimal perfect hash is the 'hash and displace' method:
+ * each key is thrown into a bucket by hash(key, 0), and each bucket
+ * is given a seed d so that hash(key, d) of its keys hit empty slots.
+ * A bucket which has only one key is placed on an empty slot directly.
+ *
+ * The snapshot is never updated. If one of the tag files is modified
+ * after freezing, frozen_open() ignores the snapshot.
+ */
+#define FROZEN_MAGIC	"GLOBAL FROZEN"
+#define FROZEN_VERSION	2
+#define FROZEN_BYTEORDER 0x01020304
+#define FROZEN_ALIGN	4096
+#define FROZEN_DIRECT	0x80000000U	/* displacement is a slot number */
+#define FROZEN_MAXDISP	0x1000000	/* give up perfect hash */
+
+static const int frozen_dbs[] = {GTAGS, GRTAGS, GSYMS};
+#define NFROZEN_DBS	(sizeof(frozen_dbs) / sizeof(frozen_dbs[0]))
+
+/*
+ * frozen_hash: hash function for the perfect hash.
+ *
+ *	i)	s	string
+ *	i)	seed	seed
+ *	r)		hash value
+ *
+ * The seeded variant of __hash_string() (__hash_buffer()) is finalized
+ * so that the lower bits, which are used for the modulo, depend on
+ * every bit.
+ */
+static unsigned int
+frozen_hash(const char *s, unsigned int seed)
+{
+	unsigned int h = (unsigned int)__hash_buffer(s, strlen(s), 0, seed);
+
+	h ^= h >> 15;
+	h *= 0x2c1b3c6dU;
+	h ^= h >> 12;
+	h *= 0x297a2d39U;
+	h ^= h >> 15;
+	return h;
+}
+
+/*----------------------------------------------------------------------
+ * Writer
+ *----------------------------------------------------------------------
+ */
+struct build_section {
+	VARRAY *keys;			/* struct frozen_key */
+	VARRAY *postings;		/* struct frozen_posting */
+	unsigned int *disp;
+	unsigned int nbuckets;
+	unsigned int *slots;
+};
+static const char *sort_strings;	/* string pool for qsort(3) */
+static const unsigned int *sort_size;	/* bucket size for qsort(3) */
+static const unsigned int *sort_fidmap;	/* fid map for qsort(3) */
+
+static unsigned int
+put_string(STRBUF *sb, const char *s)
+{
+	unsigned long offset = strbuf_getlen(sb);
+
+	if (offset > 0x7fffffffUL)
+		die("string pool of snapshot too large.");
+	strbuf_puts0(sb, s);
+	return (unsigned int)offset;
+}
+static void
+put_posting(struct build_section *bs, struct frozen_key *key, int fid, int lineno, unsigned int name, unsigned int image)
+{
+	struct frozen_posting *posting = varray_append(bs->postings);
+
+	posting->fid = fid;
+	posting->lineno = lineno;
+	posting->name = name;
+	posting->image = image;
+	key->count++;
+}
+static int
+compare_path(const void *s1, const void *s2)
+{
+	return strcmp(sort_strings + ((const struct frozen_path *)s1)->name,
+		sort_strings + ((const struct frozen_path *)s2)->name);
+}
+static int
+compare_posting(const void *s1, const void *s2)
+{
+	const struct frozen_posting *p1 = s1, *p2 = s2;
+	unsigned int i1 = sort_fidmap[p1->fid], i2 = sort_fidmap[p2->fid];
+
+	if (i1 != i2)
+		return (i1 < i2) ? -1 : 1;
+	return (p1->lineno < p2->lineno) ? -1 : (p1->lineno > p2->lineno) ? 1 : 0;
+}
+static int
+compare_bucket(const void *s1, const void *s2)
+{
+	unsigned int size1 = sort_size[*(const unsigned int *)s1];
+	unsigned int size2 = sort_size[*(const unsigned int *)s2];
+
+	return (size1 < size2) ? 1 : (size1 > size2) ? -1 : 0;
+}
+/*
+ * freeze_section: load records of a tag file.
+ *
+ *	i)	dbpath	dbpath directory
+ *	i)	root	root directory of source tree
+ *	i)	db	GTAGS, GRTAGS or GSYMS
+ *	i)	sb	string pool
+ *	o)	bs	section
+ */
+static void
+freeze_section(const char *dbpath, const char *root, int db, STRBUF *sb, struct build_section *bs)
+{
+	GTOP *gtop = gtags_open(dbpath, root, db, GTAGS_READ, 0);
+	struct frozen_key *key = NULL;
+	GTP *gtp;
+
+	bs->keys = varray_open(sizeof(struct frozen_key), 1000);
+	bs->postings = varray_open(sizeof(struct frozen_posting), 10000);
+	for (gtp = gtags_first(gtop, NULL, 0); gtp; gtp = gtags_next(gtop)) {
+		GTREC rec;
+		unsigned int name;
+		int ok;
+
+		if (key == NULL || strcmp(gtp->tag, strbuf_value(sb) + key->name)) {
+			unsigned int offset = put_string(sb, gtp->tag);
+
+			key = varray_append(bs->keys);
+			key->name = offset;
+			key->start = bs->postings->length;
+			key->count = 0;
+		}
+		ok = gtags_decode(gtop, &rec, gtp->tagline, gtp->tag, gtp->path);
+		name = (ok && strcmp(rec.name, gtp->tag)) ? put_string(sb, rec.name) : 0;
+		for (; ok; ok = gtags_decode_next(&rec))
+			put_posting(bs, key, atoi(rec.fid), rec.lineno, name,
+				rec.image ? put_string(sb, rec.image) : 0);
+	}
+	gtags_close(gtop);
+}
+/*
+ * make_perfect_hash: make minimal perfect hash for the key table.
+ *
+ *	i)	strings	string pool
+ *	io)	bs	section
+ */
+static void
+make_perfect_hash(const char *strings, struct build_section *bs)
+{
+	const struct frozen_key *keys = (const struct frozen_key *)bs->keys->vbuf;
+	unsigned int n = bs->keys->length;
+	unsigned int nb = n / 4 + 1;
+	unsigned int *head, *next, *size, *order, *slot;
+	unsigned int i, j, b, maxsize, freeslot;
+	char *used;
+
+	bs->nbuckets = nb;
+	bs->disp = check_calloc(sizeof(unsigned int), nb);
+	bs->slots = check_calloc(sizeof(unsigned int), n ? n : 1);
+	if (n == 0)
+		return;
+	head = check_malloc(sizeof(unsigned int) * nb);
+	size = check_calloc(sizeof(unsigned int), nb);
+	order = check_malloc(sizeof(unsigned int) * nb);
+	next = check_malloc(sizeof(unsigned int) * n);
+	used = check_calloc(1, n);
+	for (b = 0; b < nb; b++) {
+		head[b] = n;
+		order[b] = b;
+	}
+	for (i = 0; i < n; i++) {
+		b = frozen_hash(strings + keys[i].name, 0) % nb;
+		next[i] = head[b];
+		head[b] = i;
+		size[b]++;
+	}
+	/*
+	 * Place large buckets first, while there are many empty slots.
+	 */
+	sort_size = size;
+	qsort(order, nb, sizeof(unsigned int), compare_bucket);
+	maxsize = size[order[0]];
+	slot = check_malloc(sizeof(unsigned int) * maxsize);
+	freeslot = 0;
+	for (j = 0; j < nb && size[order[j]] > 0; j++) {
+		unsigned int d, k;
+
+		b = order[j];
+		if (size[b] == 1) {
+			while (used[freeslot])
+				freeslot++;
+			used[freeslot] = 1;
+			bs->slots[freeslot] = head[b];
+			bs->disp[b] = FROZEN_DIRECT | freeslot;
+			continue;
+		}
+		for (d = 1; d < FROZEN_MAXDISP; d++) {
+			k = 0;
+			for (i = head[b]; i < n; i = next[i]) {
+				unsigned int s = frozen_hash(strings + keys[i].name, d) % n, l;
+
+				if (used[s])
+					break;
+				for (l = 0; l < k; l++)
+					if (slot[l] == s)
+						break;
+				if (l < k)
+					break;
+				slot[k++] = s;
+			}
+			if (i >= n)
+				break;
+		}
+		if (d >= FROZEN_MAXDISP)
+			die("cannot make perfect hash.");
+		bs->disp[b] = d;
+		for (k = 0, i = head[b]; i < n; i = next[i], k++) {
+			used[slot[k]] = 1;
+			bs->slots[slot[k]] = i;
+		}
+	}
+	free(slot);
+	free(used);
+	free(next);
+	free(order);
+	free(size);
+	free(head);
+}
+/*
+ * write_section: write an array at the aligned position.
+ *
+ *	i)	fp	file
+ *	i)	data	data
+ *	i)	size	size of data
+ *	r)		offset of the data
+ */
+static unsigned int
+write_section(FILE *fp, const void *data, unsigned long size)
+{
+	long offset = ftell(fp);
+
+	while (offset % FROZEN_ALIGN) {
+		putc(0, fp);
+		offset++;
+	}
+	if (offset < 0 || (unsigned long)offset + size > 0xffffffffUL)
+		die("snapshot too large.");
+	if (size > 0 && fwrite(data, size, 1, fp) != 1)
+		die("cannot write snapshot.");
+	return (unsigned int)offset;
+}
+/*
+ * frozen_create: make frozen snapshot of tag files.
+ *
+ *	i)	dbpath	dbpath directory
+ *	i)	root	root directory of source tree
+ */
+void
+frozen_create(const char *dbpath, const char *root)
+{
+	struct frozen_header header;
+	struct build_section bs[GTAGLIM];
+	STRBUF *sb = strbuf_open(0);
+	VARRAY *paths = varray_open(sizeof(struct frozen_path), 1000);
+	unsigned int *fidmap;
+	char path[MAXPATHLEN], tmp[MAXPATHLEN];
+	int i, id, limit;
+	FILE *fp;
+
+	memset(&header, 0, sizeof(header));
+	memset(bs, 0, sizeof(bs));
+	strlimcpy(header.magic, FROZEN_MAGIC, sizeof(header.magic));
+	header.version = FROZEN_VERSION;
+	header.byteorder = FROZEN_BYTEORDER;
+	for (i = GPATH; i <= GRTAGS; i++) {
+		struct stat st;
+
+		if (stat(makepath(dbpath, dbname(i), NULL), &st) < 0)
+			die("%s not found.", dbname(i));
+		header.stamp[i].mtime = (unsigned int)st.st_mtime;
+		header.stamp[i].size = (unsigned int)st.st_size;
+	}
+	put_string(sb, "");		/* offset 0 means empty string */
+	/*
+	 * Path table.
+	 */
+	if (gpath_open(dbpath, 0) < 0)
+		die("GPATH not found.");
+	limit = gpath_nextkey();
+	for (id = 1; id < limit; id++) {
+		struct frozen_path *ent;
+		const char *name;
+		char fid[MAXFIDLEN];
+		int type;
+
+		snprintf(fid, sizeof(fid), "%d", id);
+		if ((name = gpath_fid2path(fid, &type)) == NULL)
+			continue;
+		ent = varray_append(paths);
+		ent->name = put_string(sb, name);
+		ent->fid = id;
+		ent->type = type;
+	}
+	gpath_close();
+	/*
+	 * Tag records.
+	 */
+	for (i = 0; i < NFROZEN_DBS; i++)
+		freeze_section(dbpath, root, frozen_dbs[i], sb, &bs[frozen_dbs[i]]);
+	sort_strings = strbuf_value(sb);
+	qsort(paths->vbuf, paths->length, sizeof(struct frozen_path), compare_path);
+	fidmap = check_calloc(sizeof(unsigned int), limit > 0 ? limit : 1);
+	for (i = 0; i < paths->length; i++)
+		fidmap[((struct frozen_path *)paths->vbuf)[i].fid] = i + 1;
+	/*
+	 * Sort the postings of each key by path and line number, so that
+	 * the order doesn't depend on the order of records in the tag files.
+	 */
+	sort_fidmap = fidmap;
+	for (i = 0; i < NFROZEN_DBS; i++) {
+		struct build_section *b = &bs[frozen_dbs[i]];
+		struct frozen_posting *postings = varray_assign(b->postings, 0, 0);
+		struct frozen_key *keys = varray_assign(b->keys, 0, 0);
+		int j;
+
+		for (j = 0; j < b->keys->length; j++)
+			if (keys[j].count > 1)
+				qsort(postings + keys[j].start, keys[j].count,
+					sizeof(struct frozen_posting), compare_posting);
+	}
+	for (i = 0; i < NFROZEN_DBS; i++)
+		make_perfect_hash(strbuf_value(sb), &bs[frozen_dbs[i]]);
+	/*
+	 * Write to a temporary file and rename it, so that readers never
+	 * see a partial snapshot.
+	 */
+	strlimcpy(path, makepath(dbpath, FROZEN_NAME, NULL), sizeof(path));
+	strlimcpy(tmp, makepath(dbpath, FROZEN_NAME, "tmp"), sizeof(tmp));
+	if ((fp = fopen(tmp, "wb")) == NULL)
+		die("cannot make %s.", FROZEN_NAME);
+	if (fwrite(&header, sizeof(header), 1, fp) != 1)
+		die("cannot write snapshot.");
+	header.strings_size = strbuf_getlen(sb);
+	header.strings = write_section(fp, strbuf_value(sb), header.strings_size);
+	header.npaths = paths->length;
+	header.paths = write_section(fp, paths->vbuf, sizeof(struct frozen_path) * paths->length);
+	header.nfids = limit > 0 ? limit : 0;
+	header.fidmap = write_section(fp, fidmap, sizeof(unsigned int) * header.nfids);
+	for (i = 0; i < NFROZEN_DBS; i++) {
+		struct frozen_section *sec = &header.section[frozen_dbs[i]];
+		struct build_section *b = &bs[frozen_dbs[i]];
+
+		sec->nkeys = b->keys->length;
+		sec->keys = write_section(fp, b->keys->vbuf, sizeof(struct frozen_key) * sec->nkeys);
+		sec->nbuckets = b->nbuckets;
+		sec->disp = write_section(fp, b->disp, sizeof(unsigned int) * sec->nbuckets);
+		sec->slots = write_section(fp, b->slots, sizeof(unsigned int) * sec->nkeys);
+		sec->npostings = b->postings->length;
+		sec->postings = write_section(fp, b->postings->vbuf, sizeof(struct frozen_posting) * sec->npostings);
+		varray_close(b->keys);
+		varray_close(b->postings);
+		free(b->disp);
+		free(b->slots);
+	}
+	rewind(fp);
+	if (fwrite(&header, sizeof(header), 1, fp) != 1)
+		die("cannot write snapshot.");
+	if (fclose(fp) != 0)
+		die("cannot write snapshot.");
+#if defined(_WIN32) || defined(__DJGPP__)
+	(void)unlink(path);
+#endif
+	if (rename(tmp, path) < 0)
+		die("cannot rename '%s' to '%s'.", tmp, path);
+	free(fidmap);
+	varray_close(paths);
+	strbuf_close(sb);
+}
+/*
+ * frozen_remove: remove frozen snapshot if any.
+ *
+ *	i)	dbpath	dbpath directory
+ */
+void
+frozen_remove(const char *dbpath)
+{
+	const char *path = makepath(dbpath, FROZEN_NAME, NULL);
+
+	if (test("f", path))
+		(void)unlink(path);
+}
+
+/*----------------------------------------------------------------------
+ * Reader
+ *----------------------------------------------------------------------
+ */
+static int
+inside(const FROZEN *fz, unsigned int offset, unsigned long count, unsigned long size)
+{
+	return offset <= fz->size && count <= (fz->size - offset) / size;
+}
+/*
+ * frozen_open: open frozen snapshot.
+ *
+ *	i)	dbpath	dbpath directory
+ *	r)		FROZEN structure
+ *			NULL: snapshot not found or out of date
+ */
+FROZEN *
+frozen_open(const char *dbpath)
+{
+	const struct frozen_header *header;
+	struct stat st;
+	FROZEN *fz;
+	int i;
+#if !defined(_WIN32) && !defined(__DJGPP__)
+	int fd;
+	void *map;
+
+	if ((fd = open(makepath(dbpath, FROZEN_NAME, NULL), O_RDONLY)) < 0)
+		return NULL;
+	if (fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(struct frozen_header)) {
+		close(fd);
+		return NULL;
+	}
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		return NULL;
+	fz = check_calloc(sizeof(FROZEN), 1);
+	fz->map = map;
+	fz->mapped = 1;
+#else
+	FILE *fp;
+
+	if ((fp = fopen(makepath(dbpath, FROZEN_NAME, NULL), "rb")) == NULL)
+		return NULL;
+	if (fstat(fileno(fp), &st) < 0 || st.st_size < (off_t)sizeof(struct frozen_header)) {
+		fclose(fp);
+		return NULL;
+	}
+	fz = check_calloc(sizeof(FROZEN), 1);
+	fz->map = check_malloc(st.st_size);
+	if (fread(fz->map, st.st_size, 1, fp) != 1) {
+		fclose(fp);
+		frozen_close(fz);
+		return NULL;
+	}
+	fclose(fp);
+#endif
+	fz->size = st.st_size;
+	fz->header = header = (const struct frozen_header *)fz->map;
+	if (strncmp(header->magic, FROZEN_MAGIC, sizeof(header->magic))
+	    || header->version != FROZEN_VERSION
+	    || header->byteorder != FROZEN_BYTEORDER)
+		goto stale;
+	/*
+	 * The snapshot is valid only while tag files are unchanged.
+	 */
+	for (i = GPATH; i <= GRTAGS; i++) {
+		if (stat(makepath(dbpath, dbname(i), NULL), &st) < 0
+		    || header->stamp[i].mtime != (unsigned int)st.st_mtime
+		    || header->stamp[i].size != (unsigned int)st.st_size)
+			goto stale;
+	}
+	if (header->strings_size == 0
+	    || !inside(fz, header->strings, header->strings_size, 1)
+	    || fz->map[header->strings + header->strings_size - 1] != '\0'
+	    || !inside(fz, header->paths, header->npaths, sizeof(struct frozen_path))
+	    || !inside(fz, header->fidmap, header->nfids, sizeof(unsigned int)))
+		goto stale;
+	for (i = 0; i < NFROZEN_DBS; i++) {
+		const struct frozen_section *sec = &header->section[frozen_dbs[i]];
+
+		if (sec->nbuckets == 0
+		    || !inside(fz, sec->keys, sec->nkeys, sizeof(struct frozen_key))
+		    || !inside(fz, sec->disp, sec->nbuckets, sizeof(unsigned int))
+		    || !inside(fz, sec->slots, sec->nkeys, sizeof(unsigned int))
+		    || !inside(fz, sec->postings, sec->npostings, sizeof(struct frozen_posting)))
+			goto stale;
+	}
+	fz->strings = fz->map + header->strings;
+	fz->paths = (const struct frozen_path *)(fz->map + header->paths);
+	fz->fidmap = (const unsigned int *)(fz->map + header->fidmap);
+	return fz;
+stale:
+	frozen_close(fz);
+	return NULL;
+}
+/*
+ * frozen_string: get string from string pool.
+ *
+ *	i)	fz	FROZEN structure
+ *	i)	offset	offset in string pool
+ *	r)		string
+ */
+const char *
+frozen_string(FROZEN *fz, unsigned int offset)
+{
+	if (offset >= fz->header->strings_size)
+		die("broken snapshot.");
+	return fz->strings + offset;
+}
+static const struct frozen_key *
+frozen_keys(FROZEN *fz, int db)
+{
+	return (const struct frozen_key *)(fz->map + fz->header->section[db].keys);
+}
+/*
+ * frozen_lookup: look up a tag name using perfect hash.
+ *
+ *	i)	fz	FROZEN structure
+ *	i)	db	GTAGS, GRTAGS or GSYMS
+ *	i)	name	tag name
+ *	r)		index of key table, -1: not found
+ */
+int
+frozen_lookup(FROZEN *fz, int db, const char *name)
+{
+	const struct frozen_section *sec = &fz->header->section[db];
+	const unsigned int *disp = (const unsigned int *)(fz->map + sec->disp);
+	const unsigned int *slots = (const unsigned int *)(fz->map + sec->slots);
+	unsigned int d, s, i;
+
+	if (sec->nkeys == 0)
+		return -1;
+	d = disp[frozen_hash(name, 0) % sec->nbuckets];
+	s = (d & FROZEN_DIRECT) ? (d & ~FROZEN_DIRECT) : frozen_hash(name, d) % sec->nkeys;
+	if (s >= sec->nkeys || (i = slots[s]) >= sec->nkeys)
+		return -1;
+	if (strcmp(frozen_string(fz, frozen_keys(fz, db)[i].name), name))
+		return -1;
+	return i;
+}
+/*
+ * bound: binary search in sorted strings.
+ *
+ *	i)	fz	FROZEN structure
+ *	i)	base	array
+ *	i)	n	number of elements
+ *	i)	size	size of element whose first member is string offset
+ *	i)	prefix	prefix
+ *	i)	upper	0: first element >= prefix, 1: first element > prefix*
+ *	r)		index
+ */
+static int
+bound(FROZEN *fz, const char *base, int n, int size, const char *prefix, int upper)
+{
+	int len = strlen(prefix);
+	int lo = 0, hi = n;
+
+	while (lo < hi) {
+		int mid = lo + (hi - lo) / 2;
+		const char *s = frozen_string(fz, *(const unsigned int *)(base + (long)mid * size));
+		int r = strncmp(s, prefix, len);
+
+		if (r < 0 || (upper && r == 0))
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+/*
+ * frozen_prefix: get the range of keys which start with prefix.
+ *
+ *	i)	fz	FROZEN structure
+ *	i)	db	GTAGS, GRTAGS or GSYMS
+ *	i)	prefix	prefix (NULL: all keys)
+ *	o)	end	end of range (not included)
+ *	r)		start of range
+ */
+int
+frozen_prefix(FROZEN *fz, int db, const char *prefix, int *end)
+{
+	const char *keys = (const char *)frozen_keys(fz, db);
+	int n = fz->header->section[db].nkeys;
+
+	if (prefix == NULL || *prefix == '\0') {
+		*end = n;
+		return 0;
+	}
+	*end = bound(fz, keys, n, sizeof(struct frozen_key), prefix, 1);
+	return bound(fz, keys, n, sizeof(struct frozen_key), prefix, 0);
+}
+/*
+ * frozen_keyname: get tag name of a key.
+ *
+ *	i)	fz	FROZEN structure
+ *	i)	db	GTAGS, GRTAGS or GSYMS
+ *	i)	index	index of key table
+ *	r)		tag name
+ */
+const char *
+frozen_keyname(FROZEN *fz, int db, int index)
+{
+	return frozen_string(fz, frozen_keys(fz, db)[index].name);
+}
+/*
+ * frozen_postings: get postings of a key.
+ *
+ *	i)	fz	FROZEN structure
+ *	i)	db	GTAGS, GRTAGS or GSYMS
+ *	i)	index	index of key table
+ *	o)	count	number of postings
+ *	r)		postings sorted by path and line number
+ */
+const struct frozen_posting *
+frozen_postings(FROZEN *fz, int db, int index, int *count)
+{
+	const struct frozen_section *sec = &fz->header->section[db];
+	const struct frozen_key *key = &frozen_keys(fz, db)[index];
+
+	if (key->start > sec->npostings || key->count > sec->npostings - key->start)
+		die("broken snapshot.");
+	*count = key->count;
+	return (const struct frozen_posting *)(fz->map + sec->postings) + key->start;
+}
+/*
+ * frozen_path_prefix: get the range of paths which start with prefix.
+ *
+ *	i)	fz	FROZEN structure
+ *	i)	prefix	prefix
+ *	o)	end	end of range (not included)
+ *	r)		start of range
+ */
+int
+frozen_path_prefix(FROZEN *fz, const char *prefix, int *end)
+{
+	const char *paths = (const char *)fz->paths;
+	int n = fz->header->npaths;
+
+	*end = bound(fz, paths, n, sizeof(struct frozen_path), prefix, 1);
+	return bound(fz, paths, n, sizeof(struct frozen_path), prefix, 0);
+}
+/*
+ * frozen_path: get an entry of path table.
+ *
+ *	i)	fz	FROZEN structure
+ *	i)	index	index of path table
+ *	r)		path entry
+ */
+const struct frozen_path *
+frozen_path(FROZEN *fz, int index)
+{
+	return &fz->paths[index];
+}
+/*
+ * frozen_fid2path: convert file id into path name.
+ *
+ *	i)	fz	FROZEN structure
+ *	i)	fid	file id
+ *	r)		path name, NULL: not found
+ */
+const char *
+frozen_fid2path(FROZEN *fz, unsigned int fid)
+{
+	unsigned int index;
+
+	if (fid >= fz->header->nfids || (index = fz->fidmap[fid]) == 0 || index > fz->header->npaths)
+		return NULL;
+	return frozen_string(fz, fz->paths[index - 1].name);
+}
+/*
+ * frozen_close: close frozen snapshot.
+ *
+ *	i)	fz	FROZEN structure
+ */
+void
+frozen_close(FROZEN *fz)
+{
+#if !defined(_WIN32) && !defined(__DJGPP__)
+	if (fz->mapped)
+		munmap(fz->map, fz->size);
+#else
+	free(fz->map);
+#endif
+	free(fz);
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2010 Tama Communications Corporation
+ *
+ * This file is part of GNU GLOBAL.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _FROZEN_H_
+#define _FROZEN_H_
+
+#include "gtagsop.h"
+
+#define FROZEN_NAME	"GFROZEN"
+
+/*
+ * On-disk structures. Every offset is counted from the head of the file
+ * and every string offset from the head of the string pool.
+ */
+struct frozen_stamp {
+	unsigned int mtime;		/* st_mtime of the tag file	*/
+	unsigned int size;		/* st_size of the tag file	*/
+};
+struct frozen_section {
+	unsigned int keys;		/* sorted key table		*/
+	unsigned int nkeys;
+	unsigned int disp;		/* displacements of perfect hash */
+	unsigned int nbuckets;
+	unsigned int slots;		/* hash slot -> key index	*/
+	unsigned int postings;		/* postings of all keys		*/
+	unsigned int npostings;
+};
+struct frozen_header {
+	char magic[16];
+	unsigned int version;
+	unsigned int byteorder;
+	struct frozen_stamp stamp[GTAGLIM];
+	unsigned int strings;		/* string pool			*/
+	unsigned int strings_size;
+	unsigned int paths;		/* path table sorted by path	*/
+	unsigned int npaths;
+	unsigned int fidmap;		/* fid -> path index + 1	*/
+	unsigned int nfids;
+	struct frozen_section section[GTAGLIM];
+};
+struct frozen_key {
+	unsigned int name;		/* tag name			*/
+	unsigned int start;		/* first posting		*/
+	unsigned int count;		/* number of postings		*/
+};
+struct frozen_path {
+	unsigned int name;		/* path name			*/
+	unsigned int fid;		/* file id			*/
+	unsigned int type;		/* GPATH_SOURCE or GPATH_OTHER	*/
+};
+struct frozen_posting {
+	unsigned int fid;		/* file id			*/
+	unsigned int lineno;		/* line number			*/
+	unsigned int name;		/* tag name (0: same as key)	*/
+	unsigned int image;		/* line image (0: read source)	*/
+};
+
+typedef struct {
+	char *map;			/* mapped image			*/
+	unsigned long size;		/* size of the image		*/
+	int mapped;			/* 1: mmap(2)ed, 0: malloc(3)ed	*/
+	const struct frozen_header *header;
+	const char *strings;
+	const struct frozen_path *paths;
+	const unsigned int *fidmap;
+} FROZEN;
+
+void frozen_create(const char *, const char *);
+void frozen_remove(const char *);
+FROZEN *frozen_open(const char *);
+const char *frozen_string(FROZEN *, unsigned int);
+int frozen_lookup(FROZEN *, int, const char *);
+int frozen_prefix(FROZEN *, int, const char *, int *);
+const char *frozen_keyname(FROZEN *, int, int);
+const struct frozen_posting *frozen_postings(FROZEN *, int, int, int *);
+int frozen_path_prefix(FROZEN *, const char *, int *);
+const struct frozen_path *frozen_path(FROZEN *, int);
+const char *frozen_fid2path(FROZEN *, unsigned int);
+void frozen_close(FROZEN *);
+
+#endif /* ! _FROZEN_H_ */
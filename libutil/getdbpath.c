@@ -41,6 +41,7 @@
 #include "gtagsop.h"
 #include "makepath.h"
 #include "path.h"
+#include "publish.h"
 #include "strlimcpy.h"
 #include "test.h"
 
@@ -123,6 +124,29 @@ getobjdir(const char *candidate, int verbose)
 #endif
 	return NULL;
 }
+/*
+ * publishedexist: test whether tag files published by 'gtags --atomic' exist.
+ *
+ *	i)	dir	candidate dbpath directory
+ *	o)	dbpath	current generation directory
+ *	i)	size	size of dbpath buffer
+ *	i)	verbose	verbose mode 1: on, 0: off
+ *	r)		0: not found, 1: found
+ */
+static int
+publishedexist(const char *dir, char *dbpath, int size, int verbose)
+{
+	const char *path;
+
+	if (verbose)
+		fprintf(stderr, "checking %s/%s\n", dir, PUBLISH_NAME);
+	if ((path = published(dir)) == NULL)
+		return 0;
+	if (verbose)
+		fprintf(stderr, "GTAGS found at '%s/%s'.\n", path, dbname(GTAGS));
+	strlimcpy(dbpath, path, size);
+	return 1;
+}
 /*
  * gtagsexist: test whether GTAGS's existence.
  *
@@ -135,6 +159,8 @@ getobjdir(const char *candidate, int verbose)
  * Gtagsexist locate GTAGS file in "$candidate/", "$candidate/obj/" and
  * "/usr/obj/$candidate/" in this order by default.
  * This behavior is same with BSD make(1)'s one.
+ * If the tag files are published by 'gtags --atomic', dbpath is
+ * the directory of the current generation.
  */
 int
 gtagsexist(const char *candidate, char *dbpath, int size, int verbose)
@@ -152,6 +178,8 @@ gtagsexist(const char *candidate, char *dbpath, int size, int verbose)
 		candidate_without_slash = "";
 	else
 		candidate_without_slash = candidate;
+	if (publishedexist(candidate, dbpath, size, verbose))
+		return 1;
 	snprintf(path, sizeof(path), "%s/%s", candidate_without_slash, dbname(GTAGS));
 	if (verbose)
 		fprintf(stderr, "checking %s\n", path);
@@ -161,6 +189,9 @@ gtagsexist(const char *candidate, char *dbpath, int size, int verbose)
 		snprintf(dbpath, size, "%s", candidate);
 		return 1;
 	}
+	snprintf(path, sizeof(path), "%s/%s", candidate_without_slash, makeobjdir);
+	if (publishedexist(path, dbpath, size, verbose))
+		return 1;
 	snprintf(path, sizeof(path),
 		"%s/%s/%s", candidate_without_slash, makeobjdir, dbname(GTAGS));
 	if (verbose)
@@ -172,6 +203,9 @@ gtagsexist(const char *candidate, char *dbpath, int size, int verbose)
 		return 1;
 	}
 #if !defined(_WIN32) && !defined(__DJGPP__)
+	snprintf(path, sizeof(path), "%s%s", makeobjdirprefix, candidate_without_slash);
+	if (publishedexist(path, dbpath, size, verbose))
+		return 1;
 	snprintf(path, sizeof(path),
 		"%s%s/%s", makeobjdirprefix, candidate_without_slash, dbname(GTAGS));
 	if (verbose)
@@ -234,6 +268,7 @@ void
 setupdbpath(int verbose)
 {
 	struct stat sb;
+	const char *gen;
 	char *p;
 
 	if (!getcwd(cwd, MAXPATHLEN))
@@ -260,6 +295,8 @@ setupdbpath(int verbose)
 			if (stat(p, &sb) || !S_ISDIR(sb.st_mode))
 				die("directory '%s' not found.", p);
 			strlimcpy(dbpath, getenv("GTAGSDBPATH"), MAXPATHLEN);
+			if ((gen = published(dbpath)) != NULL)
+				strlimcpy(dbpath, gen, MAXPATHLEN);
 		} else {
 			if (!gtagsexist(root, dbpath, MAXPATHLEN, verbose))
 				die_with_code(3, "GTAGS not found.");
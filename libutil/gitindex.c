@@ -0,0 +1,400 @@
+/*
+ * Copyright (c) 2010 Tama Communications Corporation
+ *
+ * This file is part of GNU GLOBAL.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <stdio.h>
+#ifdef STDC_HEADERS
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#else
+#include <strings.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#include "gparam.h"
+#include "checkalloc.h"
+#include "die.h"
+#include "gitindex.h"
+#include "makepath.h"
+#include "strbuf.h"
+#include "strlimcpy.h"
+#include "test.h"
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+/*
+ * Reader of the git index (.git/index).
+ *
+ * The index of a git working tree has the list of tracked files, sorted
+ * by path name. Reading it is a single sequential read, while traversing
+ * the file system visits build outputs and untracked files too.
+ *
+ *	+---------------------------+
+ *	|header                     | "DIRC", version, number of entries
+ *	+---------------------------+
+ *	|entry                      | stat data, mode, object name, flags
+ *	|path                       | '\0' terminated
+ *	+---------------------------+
+ *	|...                        |
+ *	+---------------------------+
+ *	|extensions                 | signature, size, data
+ *	+---------------------------+
+ *	|checksum                   |
+ *	+---------------------------+
+ *
+ * Versions 2, 3 and 4 are supported. In version 2 and 3, each entry is
+ * padded to a multiple of 8 bytes. In version 4, the path is compressed
+ * against the previous one and not padded. The length of object names
+ * is 20 (SHA-1) or 32 (SHA-256); it is decided by checking the structure.
+ * A split index (the 'link' extension) is not supported.
+ */
+#define ENTRY_FIXED	40		/* ctime, mtime, dev, ino, mode, uid, gid, size */
+#define FLAG_EXTENDED	0x4000
+#define FLAG_STAGEMASK	0x3000
+#define EXT_SKIPWORKTREE	0x4000
+#define MODE_TYPE	0170000
+#define MODE_REGULAR	0100000
+#define MODE_SYMLINK	0120000
+
+static unsigned int
+get32(const char *s)
+{
+	const unsigned char *p = (const unsigned char *)s;
+
+	return ((unsigned int)p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+static unsigned int
+get16(const char *s)
+{
+	const unsigned char *p = (const unsigned char *)s;
+
+	return (p[0] << 8) | p[1];
+}
+/*
+ * get_varint: decode the offset encoding of version 4.
+ *
+ *	io)	pp	position
+ *	i)	end	end of the image
+ *	o)	val	value
+ *	r)		0: normal, -1: broken
+ */
+static int
+get_varint(const char **pp, const char *end, unsigned int *val)
+{
+	const unsigned char *p = (const unsigned char *)*pp;
+	unsigned int c, v;
+
+	if ((const char *)p >= end)
+		return -1;
+	c = *p++;
+	v = c & 127;
+	while (c & 128) {
+		if ((const char *)p >= end)
+			return -1;
+		c = *p++;
+		v = ((v + 1) << 7) + (c & 127);
+	}
+	*pp = (const char *)p;
+	*val = v;
+	return 0;
+}
+/*
+ * next_entry: get the next entry.
+ *
+ *	i)	gi	GITINDEX structure
+ *	io)	pp	position of the entry
+ *	i)	path	path of the previous entry (version 4 only)
+ *	o)	flags	flags and extended flags
+ *	r)		0: normal, -1: broken
+ *
+ * If path is not NULL, it is updated to the path of this entry.
+ */
+static int
+next_entry(GITINDEX *gi, const char **pp, STRBUF *path, unsigned int *flags)
+{
+	const char *p = *pp;
+	const char *end = gi->buf + gi->size;
+	const char *name, *nul;
+	unsigned long fixed = ENTRY_FIXED + gi->hashlen + 2;
+
+	if ((unsigned long)(end - p) < fixed)
+		return -1;
+	*flags = get16(p + ENTRY_FIXED + gi->hashlen);
+	if (gi->version >= 3 && (*flags & FLAG_EXTENDED)) {
+		if ((unsigned long)(end - p) < fixed + 2)
+			return -1;
+		*flags |= get16(p + fixed) << 16;
+		fixed += 2;
+	}
+	name = p + fixed;
+	if (gi->version == 4) {
+		unsigned int strip;
+
+		if (get_varint(&name, end, &strip) < 0)
+			return -1;
+		if ((nul = memchr(name, '\0', end - name)) == NULL)
+			return -1;
+		if (path) {
+			if (strip > strbuf_getlen(path))
+				return -1;
+			strbuf_setlen(path, strbuf_getlen(path) - strip);
+			strbuf_nputs(path, name, nul - name);
+		}
+		*pp = nul + 1;
+	} else {
+		unsigned long size;
+
+		if ((nul = memchr(name, '\0', end - name)) == NULL)
+			return -1;
+		size = (fixed + (nul - name) + 8) & ~7UL;
+		if ((unsigned long)(end - p) < size)
+			return -1;
+		if (path) {
+			strbuf_reset(path);
+			strbuf_nputs(path, name, nul - name);
+		}
+		*pp = p + size;
+	}
+	return 0;
+}
+/*
+ * check_structure: check the structure of the image.
+ *
+ *	i)	gi	GITINDEX structure (hashlen is assumed)
+ *	r)		0: valid, -1: invalid or not supported
+ */
+static int
+check_structure(GITINDEX *gi)
+{
+	const char *end = gi->buf + gi->size;
+	const char *p = gi->buf + 12;
+	unsigned int i, flags;
+
+	for (i = 0; i < gi->count; i++)
+		if (next_entry(gi, &p, NULL, &flags) < 0)
+			return -1;
+	while ((unsigned long)(end - p) > (unsigned long)gi->hashlen) {
+		unsigned int size;
+
+		if ((unsigned long)(end - p) < 8 + (unsigned long)gi->hashlen)
+			return -1;
+		if (!strncmp(p, "link", 4))
+			return -1;
+		size = get32(p + 4);
+		if (size > (unsigned long)(end - p) - 8 - gi->hashlen)
+			return -1;
+		p += 8 + size;
+	}
+	return (end - p == gi->hashlen) ? 0 : -1;
+}
+/*
+ * locate_index: locate the index of the working tree which has root.
+ *
+ *	i)	root	root directory of source tree (absolute path)
+ *	o)	index	path of the index file
+ *	i)	size	size of index
+ *	o)	prefix	root relative to the top of working tree
+ *	r)		0: found, -1: not found
+ *
+ * '.git' is either a directory or a file which has 'gitdir: <path>'
+ * (linked worktrees and submodules).
+ */
+static int
+locate_index(const char *root, char *index, int size, STRBUF *prefix)
+{
+	char top[MAXPATHLEN];
+	char gitdir[MAXPATHLEN];
+	char *p;
+
+	strlimcpy(top, root, sizeof(top));
+	for (;;) {
+		strlimcpy(gitdir, makepath(top, ".git", NULL), sizeof(gitdir));
+		if (test("d", gitdir))
+			break;
+		if (test("f", gitdir)) {
+			char buf[MAXPATHLEN];
+			FILE *fp;
+
+			if ((fp = fopen(gitdir, "r")) == NULL)
+				return -1;
+			p = fgets(buf, sizeof(buf), fp);
+			fclose(fp);
+			if (p == NULL || strncmp(buf, "gitdir: ", 8))
+				return -1;
+			if ((p = strchr(buf, '\n')) != NULL)
+				*p = '\0';
+			p = buf + 8;
+			if (*p == '/')
+				strlimcpy(gitdir, p, sizeof(gitdir));
+			else
+				strlimcpy(gitdir, makepath(top, p, NULL), sizeof(gitdir));
+			break;
+		}
+		if ((p = strrchr(top, '/')) == NULL || *(p + 1) == '\0')
+			return -1;
+		if (p == top)
+			*(p + 1) = '\0';
+		else
+			*p = '\0';
+	}
+	strlimcpy(index, makepath(gitdir, "index", NULL), size);
+	/*
+	 * root = top + '/' + prefix
+	 */
+	strbuf_reset(prefix);
+	p = (char *)root + strlen(top);
+	while (*p == '/')
+		p++;
+	if (*p) {
+		strbuf_puts(prefix, p);
+		strbuf_putc(prefix, '/');
+	}
+	return 0;
+}
+/*
+ * gitindex_open: open the git index.
+ *
+ *	i)	root	root directory of source tree (absolute path)
+ *	r)		GITINDEX structure (NULL: not available)
+ *
+ * The source tree may be a subdirectory of the working tree.
+ */
+GITINDEX *
+gitindex_open(const char *root)
+{
+	GITINDEX *gi = check_calloc(sizeof(GITINDEX), 1);
+	char index[MAXPATHLEN];
+	struct stat st;
+	unsigned long n;
+	int fd;
+
+	gi->prefix = strbuf_open(0);
+	if (locate_index(root, index, sizeof(index), gi->prefix) < 0)
+		goto fail;
+	if ((fd = open(index, O_RDONLY|O_BINARY)) < 0)
+		goto fail;
+	if (fstat(fd, &st) < 0 || st.st_size < 12) {
+		close(fd);
+		goto fail;
+	}
+	gi->size = st.st_size;
+	gi->buf = check_malloc(gi->size);
+	for (n = 0; n < gi->size; ) {
+		int size = read(fd, gi->buf + n, gi->size - n);
+
+		if (size <= 0) {
+			close(fd);
+			goto fail;
+		}
+		n += size;
+	}
+	close(fd);
+	if (strncmp(gi->buf, "DIRC", 4))
+		goto fail;
+	gi->version = get32(gi->buf + 4);
+	if (gi->version < 2 || gi->version > 4)
+		goto fail;
+	gi->count = get32(gi->buf + 8);
+	gi->hashlen = 20;
+	if (check_structure(gi) < 0) {
+		gi->hashlen = 32;
+		if (check_structure(gi) < 0)
+			goto fail;
+	}
+	gi->p = gi->buf + 12;
+	gi->path = strbuf_open(0);
+	gi->conflict = strbuf_open(0);
+	return gi;
+fail:
+	gitindex_close(gi);
+	return NULL;
+}
+/*
+ * gitindex_read: read the next file in the source tree.
+ *
+ *	i)	gi	GITINDEX structure
+ *	r)		entry (NULL: end of index)
+ *
+ * Only regular files and symbolic links in the working tree are returned.
+ * An unmerged path is returned once.
+ */
+const struct gitindex_entry *
+gitindex_read(GITINDEX *gi)
+{
+	const char *prefix = strbuf_value(gi->prefix);
+	int prefixlen = strbuf_getlen(gi->prefix);
+
+	while (gi->seqno < gi->count) {
+		const char *entry = gi->p;
+		const char *path;
+		unsigned int flags, mode;
+
+		gi->seqno++;
+		if (next_entry(gi, &gi->p, gi->path, &flags) < 0)
+			die("git index broken.");
+		path = strbuf_value(gi->path);
+		mode = get32(entry + 24);
+		if ((mode & MODE_TYPE) != MODE_REGULAR && (mode & MODE_TYPE) != MODE_SYMLINK)
+			continue;
+		if ((flags >> 16) & EXT_SKIPWORKTREE)
+			continue;
+		if (prefixlen > 0 && strncmp(path, prefix, prefixlen))
+			continue;
+		if (flags & FLAG_STAGEMASK) {
+			if (!strcmp(path, strbuf_value(gi->conflict)))
+				continue;
+			strbuf_reset(gi->conflict);
+			strbuf_puts(gi->conflict, path);
+		}
+		gi->entry.path = path + prefixlen;
+		gi->entry.mode = mode;
+		return &gi->entry;
+	}
+	return NULL;
+}
+/*
+ * gitindex_close: close the git index.
+ *
+ *	i)	gi	GITINDEX structure
+ */
+void
+gitindex_close(GITINDEX *gi)
+{
+	if (gi->buf)
+		free(gi->buf);
+	if (gi->path)
+		strbuf_close(gi->path);
+	if (gi->prefix)
+		strbuf_close(gi->prefix);
+	if (gi->conflict)
+		strbuf_close(gi->conflict);
+	free(gi);
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2010 Tama Communications Corporation
+ *
+ * This file is part of GNU GLOBAL.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef _GITINDEX_H_
+#define _GITINDEX_H_
+
+#include "strbuf.h"
+
+/*
+ * Entry of the git index. Path is relative to the root of source tree.
+ */
+struct gitindex_entry {
+	const char *path;
+	unsigned int mode;
+};
+
+typedef struct {
+	char *buf;			/* image of the index file	*/
+	unsigned long size;		/* size of the image		*/
+	int version;			/* 2, 3 or 4			*/
+	int hashlen;			/* length of object names	*/
+	unsigned int count;		/* number of entries		*/
+	unsigned int seqno;		/* number of entries read	*/
+	const char *p;			/* current position		*/
+	STRBUF *path;			/* current path (relative to top) */
+	STRBUF *prefix;			/* root of source tree (relative to top) */
+	STRBUF *conflict;		/* last path of unmerged entries */
+	struct gitindex_entry entry;
+} GITINDEX;
+
+GITINDEX *gitindex_open(const char *);
+const struct gitindex_entry *gitindex_read(GITINDEX *);
+void gitindex_close(GITINDEX *);
+
+#endif /* ! _GITINDEX_H_ */
@@ -31,12 +31,16 @@
 #include "date.h"
 #include "dbop.h"
 #include "defined.h"
+#include "dfa.h"
 #include "die.h"
 #include "env.h"
 #include "fileop.h"
 #include "find.h"
 #include "format.h"
+#include "fragcache.h"
+#include "frozen.h"
 #include "getdbpath.h"
+#include "gitindex.h"
 #include "gpathop.h"
 #include "gtagsop.h"
 #include "idset.h"
@@ -48,12 +52,15 @@
 #include "path.h"
 #include "pathconvert.h"
 #include "pool.h"
+#include "publish.h"
+#include "rescache.h"
 #include "split.h"
 #include "statistics.h"
 #include "strbuf.h"
 #include "strhash.h"
 #include "strlimcpy.h"
 #include "strmake.h"
+#include "symtab.h"
 #include "tab.h"
 #include "test.h"
 #include "token.h"
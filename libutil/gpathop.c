@@ -30,6 +30,9 @@
 #else
 #include <strings.h>
 #endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
 
 #include "checkalloc.h"
 #include "die.h"
@@ -38,13 +41,22 @@
 #include "makepath.h"
 #include "gpathop.h"
 #include "strbuf.h"
+#include "strhash.h"
 #include "strlimcpy.h"
+#include "test.h"
 
 static DBOP *dbop;
+static DBOP *symdbop;
+static char symtabpath[MAXPATHLEN];
 static int _nextkey;
 static int _mode;
 static int opened;
 static int created;
+static int modified;
+static int generation;
+
+static void put_dirrange(void);
+static DBOP *open_symtab(int);
 
 /*
  * GPATH format version
@@ -80,9 +92,28 @@ static int created;
  *      --------------------
  *      ./aaa.c\0       11\0
  *      ./README\0      12\0o\0         <=== 'o' means other files.
+ *
+ * The DIRRANGE meta record has the fid range of each directory.
+ * It is an optional record; see put_dirrange().
+ *
+ * The GENERATION meta record is a counter which gtags(1) increments
+ * whenever it creates or updates the tag files. It is taken over when
+ * the tag files are made again. Tag files made by older gtags don't have
+ * it, and the generation is 0.
+ *
+ * The symbol table of each source file made by symtab_encode() is kept
+ * in GSYMTAB instead of GPATH, since it is as large as GRTAGS and GPATH
+ * is read by almost every command. GSYMTAB is optional: it is made only
+ * by 'gtags --symbol-table', and then kept up to date by incremental
+ * updating. GSYMTAB of an unknown format version is ignored.
+ *
+ *      key             data
+ *      --------------------
+ *      11\0            "main\nexit\n\nAT@BDA"\0
  */
 static int support_version = 2;	/* acceptable format version   */
 static int create_version = 2;	/* format version of newly created tag file */
+static int symtab_version = 2;	/* format version of GSYMTAB */
 /*
  * gpath_open: open gpath tag file
  *
@@ -108,9 +139,32 @@ gpath_open(const char *dbpath, int mode)
 	_mode = mode;
 	if (mode == 1 && created)
 		mode = 0;
+	generation = 0;
+	if (mode == 1) {
+		/*
+		 * Take over the generation of the old GPATH if any.
+		 */
+		dbop = dbop_open(makepath(dbpath, dbname(GPATH), NULL), 0, 0, 0);
+		if (dbop != NULL) {
+			const char *p = dbop_get(dbop, GENERATIONKEY);
+
+			if (p != NULL)
+				generation = atoi(p);
+			dbop_close(dbop);
+		}
+	}
 	dbop = dbop_open(makepath(dbpath, dbname(GPATH), NULL), mode, 0644, 0);
 	if (dbop == NULL)
 		return -1;
+	strlimcpy(symtabpath, makepath(dbpath, SYMTAB_NAME, NULL), sizeof(symtabpath));
+	symdbop = NULL;
+	/*
+	 * Old GSYMTAB is removed with GPATH. It is made again
+	 * if gpath_putsymtab() is called.
+	 */
+	if (mode == 1)
+		(void)unlink(symtabpath);
+	modified = 0;
 	if (mode == 1) {
 		dbop_putversion(dbop, create_version);
 		_nextkey = 1;
@@ -122,6 +176,8 @@ gpath_open(const char *dbpath, int mode)
 		if (path == NULL)
 			die("nextkey not found in GPATH.");
 		_nextkey = atoi(path);
+		if ((path = dbop_get(dbop, GENERATIONKEY)) != NULL)
+			generation = atoi(path);
 		format_version = dbop_getversion(dbop);
 		if (format_version > support_version)
 			die("GPATH seems new format. Please install the latest GLOBAL.");
@@ -170,6 +226,7 @@ gpath_put(const char *path, int type)
 	if (type == GPATH_OTHER)
 		strbuf_puts0(sb, "o");
 	dbop_put_withlen(dbop, fid, strbuf_value(sb), strbuf_getlen(sb));
+	modified = 1;
 }
 /*
  * gpath_path2fid: convert path into id
@@ -221,6 +278,7 @@ void
 gpath_delete(const char *path)
 {
 	const char *fid;
+	char s_fid[MAXFIDLEN];
 
 	assert(opened > 0);
 	assert(_mode == 2);
@@ -228,8 +286,102 @@ gpath_delete(const char *path)
 	fid = dbop_get(dbop, path);
 	if (fid == NULL)
 		return;
-	dbop_delete(dbop, fid);
+	strlimcpy(s_fid, fid, sizeof(s_fid));
+	if (open_symtab(0) != NULL)
+		dbop_delete(symdbop, s_fid);
+	dbop_delete(dbop, s_fid);
 	dbop_delete(dbop, path);
+	modified = 1;
+}
+/*
+ * open_symtab: open GSYMTAB in the mode of GPATH
+ *
+ *	i)	create	1: make GSYMTAB if it doesn't exist
+ *	r)		DBOP structure
+ *			NULL: not found
+ *
+ * GSYMTAB is opened when it is needed first. If it was made by older
+ * gtags, it is made again in the writing mode, and ignored in the
+ * reading mode.
+ */
+static DBOP *
+open_symtab(int create)
+{
+	int mode = (_mode == 1 && created) ? 0 : _mode;
+
+	if (symdbop != NULL || symtabpath[0] == '\0')
+		return symdbop;
+	if (!test("f", symtabpath)) {
+		if (!create) {
+			if (mode == 0)
+				symtabpath[0] = '\0';	/* don't try again */
+			return NULL;
+		}
+		mode = 1;
+	}
+	if ((symdbop = dbop_open(symtabpath, mode, 0644, 0)) == NULL) {
+		symtabpath[0] = '\0';		/* don't try again */
+		return NULL;
+	}
+	if (mode == 1) {
+		dbop_putversion(symdbop, symtab_version);
+	} else if (dbop_getversion(symdbop) != symtab_version) {
+		dbop_close(symdbop);
+		symdbop = NULL;
+		if (mode == 0) {
+			symtabpath[0] = '\0';
+			return NULL;
+		}
+		if ((symdbop = dbop_open(symtabpath, 1, 0644, 0)) == NULL) {
+			symtabpath[0] = '\0';
+			return NULL;
+		}
+		dbop_putversion(symdbop, symtab_version);
+	}
+	return symdbop;
+}
+/*
+ * gpath_putsymtab: put the symbol table of a file
+ *
+ *	i)	fid	file id
+ *	i)	image	image made by symtab_encode()
+ */
+void
+gpath_putsymtab(const char *fid, const char *image)
+{
+	assert(opened > 0);
+	assert(_mode == 1 || _mode == 2);
+	if (_mode == 1 && created)
+		return;
+	if (open_symtab(1) == NULL)
+		die("cannot make %s.", SYMTAB_NAME);
+	dbop_put(symdbop, fid, image);
+}
+/*
+ * gpath_getsymtab: get the symbol table of a file
+ *
+ *	i)	fid	file id
+ *	r)		image made by symtab_encode()
+ *			NULL: not found (GSYMTAB is not made)
+ */
+const char *
+gpath_getsymtab(const char *fid)
+{
+	assert(opened > 0);
+	if (open_symtab(0) == NULL)
+		return NULL;
+	return dbop_get(symdbop, fid);
+}
+/*
+ * gpath_symtab: test whether GSYMTAB exists.
+ *
+ *	r)		1: exists, 0: not exists
+ */
+int
+gpath_symtab(void)
+{
+	assert(opened > 0);
+	return open_symtab(0) != NULL;
 }
 /*
  * gpath_nextkey: return next key
@@ -242,6 +394,17 @@ gpath_nextkey(void)
 	assert(_mode != 1);
 	return _nextkey;
 }
+/*
+ * gpath_generation: get the generation of tag files
+ *
+ *	r)		generation (0: unknown)
+ */
+int
+gpath_generation(void)
+{
+	assert(opened > 0);
+	return generation;
+}
 /*
  * gpath_close: close gpath tag file
  */
@@ -253,19 +416,134 @@ gpath_close(void)
 	assert(opened > 0);
 	if (--opened > 0)
 		return;
+	if (symdbop != NULL) {
+		dbop_close(symdbop);
+		symdbop = NULL;
+	}
 	if (_mode == 1 && created) {
 		dbop_close(dbop);
 		return;
 	}
 	if (_mode == 1 || _mode == 2) {
+		if (modified)
+			put_dirrange();
 		snprintf(fid, sizeof(fid), "%d", _nextkey);
 		dbop_update(dbop, NEXTKEY, fid);
+		snprintf(fid, sizeof(fid), "%d", ++generation);
+		dbop_update(dbop, GENERATIONKEY, fid);
 	}
 	dbop_close(dbop);
 	if (_mode == 1)
 		created = 1;
 }
 
+/*
+ * gpath_dirrange: get the fid range of a directory
+ *
+ *	i)	dir	directory ('./' + path + '/')
+ *	o)	first	the first fid
+ *	o)	last	the last fid
+ *	r)		1: found, 0: not found
+ *
+ * Every source file under the directory has a fid in the range, and no
+ * other source file has. If not found, the range of the directory is unknown.
+ */
+int
+gpath_dirrange(const char *dir, int *first, int *last)
+{
+	const char *p, *name, *eol;
+	int len = strlen(dir);
+
+	assert(opened > 0);
+	if ((p = dbop_get(dbop, DIRRANGE)) == NULL)
+		return 0;
+	for (; *p; p = eol + 1) {
+		/*
+		 * <first fid> <last fid> <directory>
+		 */
+		if ((name = strchr(p, ' ')) == NULL || (name = strchr(name + 1, ' ')) == NULL)
+			break;
+		name++;
+		if ((eol = strchr(name, '\n')) == NULL)
+			break;
+		if (eol - name == len && !strncmp(name, dir, len)) {
+			*first = atoi(p);
+			*last = atoi(strchr(p, ' ') + 1);
+			return 1;
+		}
+	}
+	return 0;
+}
+/*
+ * put_dirrange: make DIRRANGE record.
+ *
+ * Since gtags(1) assigns fids in the order of traversal, the source files
+ * under a directory usually have consecutive fids. The directories whose
+ * source files make one run in the order of fid are recorded like this:
+ *
+ *      key             data
+ *      --------------------
+ *      " __.DIRRANGE"  "1 120 ./\n1 34 ./aaa/\n35 120 ./bbb/\n"
+ *
+ * Holes and other files don't break the run, since they never appear in
+ * tag files. Files added by incremental updating may break it; such
+ * directories are just omitted.
+ */
+struct dirrange {
+	int first;			/* the first fid (0: broken)	*/
+	int last;			/* the last fid			*/
+	int seq;			/* sequence number of the last	*/
+};
+static void
+put_dirrange(void)
+{
+	STRHASH *sh = strhash_open(256);
+	STRBUF *sb = strbuf_open(0);
+	struct sh_entry *entry;
+	struct dirrange *r;
+	char fid[MAXFIDLEN], dir[MAXPATHLEN];
+	int id, seq = 0;
+
+	for (id = 1; id < _nextkey; id++) {
+		const char *path;
+		char *p;
+
+		snprintf(fid, sizeof(fid), "%d", id);
+		if ((path = dbop_get(dbop, fid)) == NULL)
+			continue;
+		if (*dbop_getflag(dbop) == 'o')
+			continue;
+		seq++;
+		strlimcpy(dir, path, sizeof(dir));
+		/*
+		 * './aaa/bbb/c.c' belongs to './', './aaa/' and './aaa/bbb/'.
+		 */
+		for (p = dir; (p = strchr(p, '/')) != NULL; ) {
+			int c = *++p;
+
+			*p = '\0';
+			entry = strhash_assign(sh, dir, 1);
+			*p = c;
+			if ((r = entry->value) == NULL) {
+				r = entry->value = pool_malloc(sh->pool, sizeof(struct dirrange));
+				r->first = r->last = id;
+			} else if (r->first && r->seq == seq - 1) {
+				r->last = id;
+			} else {
+				r->first = 0;
+			}
+			r->seq = seq;
+		}
+	}
+	for (entry = strhash_first(sh); entry; entry = strhash_next(sh)) {
+		r = entry->value;
+		if (r->first)
+			strbuf_sprintf(sb, "%d %d %s\n", r->first, r->last, entry->name);
+	}
+	dbop_update(dbop, DIRRANGE, strbuf_value(sb));
+	strbuf_close(sb);
+	strhash_close(sh);
+}
 /*
  * gfind iterator using GPATH.
  *
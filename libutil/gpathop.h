@@ -26,6 +26,10 @@
 #include "dbop.h"
 
 #define NEXTKEY		" __.NEXTKEY"
+#define DIRRANGE	" __.DIRRANGE"
+#define GENERATIONKEY	" __.GENERATION"
+
+#define SYMTAB_NAME	"GSYMTAB"
 
 /*
  * File type
@@ -55,6 +59,11 @@ void gpath_put(const char *, int);
 void gpath_delete(const char *);
 void gpath_close(void);
 int gpath_nextkey(void);
+int gpath_generation(void);
+int gpath_dirrange(const char *, int *, int *);
+void gpath_putsymtab(const char *, const char *);
+const char *gpath_getsymtab(const char *);
+int gpath_symtab(void);
 GFIND *gfind_open(const char *, const char *, int);
 const char *gfind_read(GFIND *);
 void gfind_close(GFIND *);
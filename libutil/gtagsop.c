@@ -41,6 +41,7 @@
 #include "conf.h"
 #include "compress.h"
 #include "dbop.h"
+#include "dfa.h"
 #include "die.h"
 #include "format.h"
 #include "gparam.h"
@@ -57,11 +58,23 @@
 #include "varray.h"
 
 #define HASHBUCKETS	2048
+/*
+ * Whether or not the tag line is out of the range set by gtags_setlocal().
+ * Every tag line begins with a file id.
+ */
+#define out_of_local(gtop, tagline) \
+	((gtop)->local_last && (atoi(tagline) < (gtop)->local_first || atoi(tagline) > (gtop)->local_last))
+/*
+ * Whether or not the tag line is out of the kinds set by gtags_setkind().
+ */
+#define out_of_kind(gtop, tagline) \
+	((gtop)->kinds[0] && !is_kind_of(tagline, (gtop)->kinds))
 
 static int compare_path(const void *, const void *);
 static int compare_lineno(const void *, const void *);
 static int compare_tags(const void *, const void *);
 static const char *seekto(const char *, int);
+static int is_kind_of(const char *, const char *);
 static int is_defined_in_GTAGS(GTOP *, const char *);
 static void flush_pool(GTOP *, const char *);
 static void segment_read(GTOP *);
@@ -122,6 +135,28 @@ seekto(const char *string, int n)
 	}
 	return p;
 }
+/*
+ * is_kind_of: whether or not the kind of the tag record is in the list.
+ *
+ *	i)	tagline	tag record of standard format
+ *	i)	kinds	list of kind letters
+ *	r)		1: included, 0: not included
+ *
+ * The tag record whose kind is unknown is not included.
+ */
+static int
+is_kind_of(const char *tagline, const char *kinds)
+{
+	const char *p = seekto(tagline, SEEKTO_LINENO);
+
+	if (p == NULL)
+		return 0;
+	while (isdigit((unsigned char)*p))
+		p++;
+	if (*p == ' ' || *p == '\0')
+		return 0;
+	return strchr(kinds, *p) != NULL;
+}
 /*
  * Tag format
  *
@@ -131,17 +166,21 @@ seekto(const char *string, int n)
  *
  *	This format is the default format of GTAGS.
  * 
- *         <file id> <tag name> <line number> <line image>
+ *         <file id> <tag name> <line number>[<kind>] <line image>
  * 
  *                 * Separator is single blank.
  * 
  *         [example]
  *         +------------------------------------
- *         |110 func 10 int func(int a)
+ *         |110 func 10f int func(int a)
  *         |110 func 30 func(int a1, int a2)
  * 
  *         Line image might be compressed (GTAGS_COMPRESS).
  *         Tag name might be compressed (GTAGS_COMPNAME).
+ *         Kind is a letter which the parser told: 'f' (function),
+ *         'm' (macro), 't' (type) or 'v' (variable). It is omitted if
+ *         unknown. Since it follows the digits of the line number directly,
+ *         the readers which know nothing about it are not confused.
  *
  * Compact format:
  * 
@@ -434,9 +473,10 @@ gtags_open(const char *dbpath, const char *root, int db, int mode, int flags)
  *	i)	lno	line number
  *	i)	fid	file id
  *	i)	img	line image
+ *	i)	kind	kind of the tag ('f', 'm', 't', 'v' or 0: unknown)
  */
 void
-gtags_put_using(GTOP *gtop, const char *tag, int lno, const char *fid, const char *img)
+gtags_put_using(GTOP *gtop, const char *tag, int lno, const char *fid, const char *img, int kind)
 {
 	const char *key;
 
@@ -484,6 +524,8 @@ gtags_put_using(GTOP *gtop, const char *tag, int lno, const char *fid, const cha
 	strbuf_puts(gtop->sb, (gtop->format & GTAGS_COMPNAME) ? compress(tag, key) : tag);
 	strbuf_putc(gtop->sb, ' ');
 	strbuf_putn(gtop->sb, lno);
+	if (kind)
+		strbuf_putc(gtop->sb, kind);
 	strbuf_putc(gtop->sb, ' ');
 	strbuf_puts(gtop->sb, (gtop->format & GTAGS_COMPRESS) ? compress(img, key) : img);
 	dbop_put(gtop->dbop, key, strbuf_value(gtop->sb));
@@ -526,6 +568,75 @@ gtags_delete(GTOP *gtop, IDSET *deleteset)
 			dbop_delete(gtop->dbop, NULL);
 	}
 }
+/*
+ * gtags_setlocal: limit records to the files under a directory.
+ *
+ *	i)	gtop	GTOP structure
+ *	i)	local	local prefix ('./' + path + '/')
+ *	r)		1: limited, 0: not limited
+ *
+ * The records are tested with the fid range of the directory before
+ * the fid is converted into the path name. If GPATH doesn't have the range
+ * (made by older gtags or broken by incremental updating), nothing is
+ * limited and the caller should test the path names itself.
+ * GTOP_KEY read is not limited.
+ */
+int
+gtags_setlocal(GTOP *gtop, const char *local)
+{
+	gtop->local_first = gtop->local_last = 0;
+	return gpath_dirrange(local, &gtop->local_first, &gtop->local_last);
+}
+/*
+ * gtags_setkind: limit records to the definitions of the kinds.
+ *
+ *	i)	gtop	GTOP structure
+ *	i)	kinds	list of kind letters ('f', 'm', 't', 'v')
+ *			"": not limited
+ *	r)		0: done, -1: the tag file doesn't have kinds
+ *
+ * The records are tested with the kind written by gtags(1) before
+ * the line image is read. Only GTAGS of standard format has the kinds.
+ * GTOP_KEY read is not limited.
+ */
+int
+gtags_setkind(GTOP *gtop, const char *kinds)
+{
+	gtop->kinds[0] = '\0';
+	if (*kinds && (gtop->db != GTAGS || (gtop->format & GTAGS_COMPACT)))
+		return -1;
+	strlimcpy(gtop->kinds, kinds, sizeof(gtop->kinds));
+	return 0;
+}
+/*
+ * gtags_isdefined: whether or not the tag is defined as one of the kinds.
+ *
+ *	i)	gtop	GTOP structure of GTAGS
+ *	i)	name	tag name
+ *	i)	kinds	list of kind letters ('f', 'm', 't', 'v')
+ *	r)		1: defined, 0: not defined
+ *
+ * A definition whose kind is unknown is assumed to be of the kinds.
+ * Since compact format has no kind, it is enough that the tag is defined.
+ * Don't call this function while reading records with gtags_next().
+ */
+int
+gtags_isdefined(GTOP *gtop, const char *name, const char *kinds)
+{
+	const char *tagline, *p;
+
+	if (gtop->format & GTAGS_COMPACT)
+		return dbop_get(gtop->dbop, name) != NULL;
+	for (tagline = dbop_first(gtop->dbop, name, NULL, 0); tagline; tagline = dbop_next(gtop->dbop)) {
+		if ((p = seekto(tagline, SEEKTO_LINENO)) == NULL)
+			continue;
+		while (isdigit((unsigned char)*p))
+			p++;
+		if (*p == ' ' || *p == '\0' || strchr(kinds, *p) != NULL)
+			return 1;
+	}
+	return 0;
+}
 /*
  * gtags_first: return first record
  *
@@ -586,7 +697,7 @@ gtags_first(GTOP *gtop, const char *pattern, int flags)
 		 */
 		key = NULL;
 		preg = NULL;
-	} else if (isregex(pattern) && regcomp(preg, pattern, regflags) == 0) {
+	} else if (isregex(pattern) && dfa_regcomp(preg, pattern, regflags) == 0) {
 		const char *p;
 		/*
 		 * If the pattern include '^' + some non regular expression
@@ -633,6 +744,8 @@ gtags_first(GTOP *gtop, const char *pattern, int flags)
 		     tagline = dbop_next(gtop->dbop))
 		{
 			VIRTUAL_GRTAGS_GSYMS_PROCESSING(gtop);
+			if (out_of_local(gtop, tagline) || out_of_kind(gtop, tagline))
+				continue;
 			/* extract file id */
 			p = locatestring(tagline, " ", MATCH_FIRST);
 			if (p == NULL)
@@ -704,6 +817,8 @@ gtags_first(GTOP *gtop, const char *pattern, int flags)
 		 * Read a tag segment with sorting.
 		 */
 		segment_read(gtop);
+		if (gtop->gtp_index >= gtop->gtp_count)
+			return NULL;
 		return  &gtop->gtp_array[gtop->gtp_index++];
 	}
 }
@@ -747,6 +862,118 @@ gtags_next(GTOP *gtop)
 		return &gtop->gtp_array[gtop->gtp_index++];
 	}
 }
+/*
+ * gtags_decode: decode the first tag of a raw record.
+ *
+ *	i)	gtop	descripter of GTOP
+ *	o)	rec	decoded tag
+ *	i)	tagline	raw record
+ *	i)	key	tag name of the record (the key of the tag file)
+ *	i)	path	path name of the file (NULL: unknown)
+ *	r)		1: a tag is decoded, 0: no more tag
+ *
+ * This function can treat both of standard format and compact format.
+ * Use gtags_decode_next() to get the rest of tags of a compact record.
+ * The tag name and the file id are copied into rec. The line image points
+ * to tagline or the buffer of uncompress(), so it is valid until the
+ * next call of uncompress().
+ *
+ * [Usage]
+ *	for (ok = gtags_decode(gtop, &rec, tagline, key, path); ok; ok = gtags_decode_next(&rec))
+ *		printf("%s %d\n", rec.name, rec.lineno);
+ */
+int
+gtags_decode(GTOP *gtop, GTREC *rec, const char *tagline, const char *key, const char *path)
+{
+	const char *p = tagline;
+	int i;
+
+	/*
+	 * tagline = <file id> <tag name> <line number> ...
+	 */
+	for (i = 0; *p && *p != ' ' && i < sizeof(rec->fidbuf) - 1; )
+		rec->fidbuf[i++] = *p++;
+	rec->fidbuf[i] = '\0';
+	if (*p++ != ' ')
+		die("illegal tag record.\n%s", tagline);
+	for (i = 0; *p && *p != ' ' && i < sizeof(rec->namebuf) - 1; )
+		rec->namebuf[i++] = *p++;
+	rec->namebuf[i] = '\0';
+	if (*p++ != ' ')
+		die("illegal tag record.\n%s", tagline);
+	if (gtop->format & GTAGS_COMPNAME)
+		strlimcpy(rec->namebuf, uncompress(rec->namebuf, key), sizeof(rec->namebuf));
+	rec->fid = rec->fidbuf;
+	rec->path = path;
+	rec->name = rec->namebuf;
+	rec->format = gtop->format;
+	rec->kind = 0;
+	rec->image = NULL;
+	rec->last = rec->cont = 0;
+	if (gtop->format & GTAGS_COMPACT) {
+		rec->lines = p;
+		return gtags_decode_next(rec);
+	}
+	/*
+	 * <line number>[<kind>] <line image>
+	 */
+	if (!isdigit((unsigned char)*p))
+		die("illegal tag record.\n%s", tagline);
+	for (rec->lineno = 0; isdigit((unsigned char)*p); p++)
+		rec->lineno = rec->lineno * 10 + (*p - '0');
+	if (isalpha((unsigned char)*p))
+		rec->kind = *p++;
+	rec->image = (*p == ' ') ? p + 1 : p;
+	if (gtop->format & GTAGS_COMPRESS)
+		rec->image = uncompress(rec->image, key);
+	rec->lines = "";
+	return 1;
+}
+/*
+ * gtags_decode_next: decode the next tag of a raw record.
+ *
+ *	io)	rec	decoded tag
+ *	r)		1: a tag is decoded, 0: no more tag
+ *
+ * Unfold the line numbers of compact format. See flush_pool().
+ */
+int
+gtags_decode_next(GTREC *rec)
+{
+	const char *p;
+	int c, n;
+
+	if (rec->cont > rec->last) {
+		rec->lineno = ++rec->last;
+		return 1;
+	}
+	for (p = rec->lines; *p && *p != ' '; ) {
+		c = (*p == ',' || *p == '-') ? *p++ : 0;
+		if (!isdigit((unsigned char)*p))
+			die("illegal compact format.");
+		for (n = 0; isdigit((unsigned char)*p); p++)
+			n = n * 10 + (*p - '0');
+		rec->lines = p;
+		if (rec->format & GTAGS_COMPLINE) {
+			if (c == '-') {
+				rec->cont = rec->last + n;
+				if (rec->cont > rec->last) {
+					rec->lineno = ++rec->last;
+					return 1;
+				}
+				continue;
+			}
+			if (c == ',')
+				n += rec->last;
+		}
+		if (n == rec->last)
+			continue;
+		rec->lineno = rec->last = n;
+		return 1;
+	}
+	rec->lines = p;
+	return 0;
+}
 /*
  * gtags_close: close tag file
  *
@@ -933,6 +1160,7 @@ segment_read(GTOP *gtop)
 	/*
 	 * Save tag lines.
 	 */
+retry:
 	gtop->cur_tagname[0] = '\0';
 	while ((tagline = dbop_next(gtop->dbop)) != NULL) {
 		VIRTUAL_GRTAGS_GSYMS_PROCESSING(gtop);
@@ -950,6 +1178,8 @@ segment_read(GTOP *gtop)
 			dbop_unread(gtop->dbop);
 			break;
 		}
+		if (out_of_local(gtop, tagline) || out_of_kind(gtop, tagline))
+			continue;
 		gtp = varray_append(gtop->vb);
 		gtp->tagline = pool_strdup(gtop->segment_pool, tagline, 0);
 		gtp->tag = (const char *)gtop->cur_tagname;
@@ -967,6 +1197,12 @@ segment_read(GTOP *gtop)
 			die("illegal tag record.\n%s", tagline);
 		gtp->lineno = atoi(lineno);
 	}
+	/*
+	 * If every record of the segment is out of the local range,
+	 * read the next segment.
+	 */
+	if (tagline != NULL && gtop->vb->length == 0)
+		goto retry;
 	/*
 	 * Sort tag lines.
 	 */
@@ -71,6 +71,28 @@ typedef struct {
 	int lineno;
 } GTP;
 
+/*
+ * This entry corresponds to one tag decoded from a raw record.
+ * A record of compact format yields a tag per line number.
+ */
+typedef struct {
+	const char *fid;		/* file id */
+	const char *path;		/* path name given by the caller */
+	const char *name;		/* tag name */
+	int lineno;			/* line number */
+	int kind;			/* kind letter (0: unknown) */
+	const char *image;		/* line image (NULL: not recorded) */
+	/*
+	 * Stuff for gtags_decode_next().
+	 */
+	int format;
+	const char *lines;		/* rest of line numbers */
+	int last;			/* last line number */
+	int cont;			/* end of the current range */
+	char fidbuf[MAXFIDLEN];
+	char namebuf[IDENTLEN];
+} GTREC;
+
 typedef struct {
 	DBOP *dbop;			/* descripter of DBOP */
 	DBOP *gtags;			/* descripter of GTAGS */
@@ -81,6 +103,15 @@ typedef struct {
 	int openflags;			/* flags value of gtags_open() */
 	int flags;			/* flags */
 	char root[MAXPATHLEN];	/* root directory of source tree */
+	/*
+	 * Stuff for gtags_setlocal().
+	 */
+	int local_first;		/* the first fid of local files */
+	int local_last;			/* the last fid (0: no limit) */
+	/*
+	 * Stuff for gtags_setkind().
+	 */
+	char kinds[8];			/* kind letters ("": no limit) */
 	/*
 	 * Stuff for GTOP_PATH.
 	 */
@@ -108,11 +139,16 @@ typedef struct {
 
 const char *dbname(int);
 GTOP *gtags_open(const char *, const char *, int, int, int);
-void gtags_put_using(GTOP *, const char *, int, const char *, const char *);
+void gtags_put_using(GTOP *, const char *, int, const char *, const char *, int);
 void gtags_flush(GTOP *, const char *);
 void gtags_delete(GTOP *, IDSET *);
+int gtags_setlocal(GTOP *, const char *);
+int gtags_setkind(GTOP *, const char *);
+int gtags_isdefined(GTOP *, const char *, const char *);
 GTP *gtags_first(GTOP *, const char *, int);
 GTP *gtags_next(GTOP *);
+int gtags_decode(GTOP *, GTREC *, const char *, const char *, const char *);
+int gtags_decode_next(GTREC *);
 void gtags_close(GTOP *);
 
 #endif /* ! _GTOP_H_ */
@@ -23,7 +23,7 @@
 #include "strbuf.h"
 
 #define DEFAULTLANGMAP  "c:.c.h,yacc:.y,asm:.s.S,java:.java,cpp:.c++.cc.cpp.cxx.hxx.hpp.C.H,php:.php.php3.phtml,kconfig:Kconfig"
-#define DEFAULTSKIP     "GPATH,GTAGS,GRTAGS,GSYMS,HTML/,HTML.pub/,html/,tags,TAGS,ID,y.tab.c,y.tab.h,cscope.out,cscope.po.out,cscope.in.out,SCCS/,RCS/,CVS/,CVSROOT/,{arch}/,autom4te.cache/"
+#define DEFAULTSKIP     "GPATH,GTAGS,GRTAGS,GSYMS,GCACHE,GCURRENT,GFROZEN,GLOCK,GSYMTAB,HTML/,HTML.pub/,html/,tags,TAGS,ID,y.tab.c,y.tab.h,cscope.out,cscope.po.out,cscope.in.out,SCCS/,RCS/,CVS/,CVSROOT/,{arch}/,autom4te.cache/"
 
 void setup_langmap(const char *);
 const char *decide_lang(const char *);
@@ -37,13 +37,29 @@
 #include "gparam.h"
 #include "gpathop.h"
 #include "pathconvert.h"
+#include "pool.h"
 #include "strbuf.h"
+#include "strhash.h"
 #include "strlimcpy.h"
 
 static unsigned char encode[256];
 static int encoding;
 static int newline = '\n';
 
+/*
+ * Converted path name kept in the path cache.
+ * Since the results are clustered by path name, most records hit the cache.
+ */
+struct converted {
+	const char *path;		/* converted path name */
+	const char *fid;		/* file id (NULL: not looked up yet) */
+};
+/*
+ * The output is accumulated in the output buffer and written when it
+ * exceeds this size.
+ */
+#define OUTPUT_BUFSIZE	65536
+
 #define required_encode(c) encode[(unsigned char)c]
 /*
  * set_encode_chars: stores chars to be encoded.
@@ -175,6 +191,187 @@ convert_pathname(CONVERT *cv, const char *path)
 	}
 	return (const char *)path;
 }
+/*
+ * lookup: get the converted path name using the cache.
+ *
+ *	i)	cv	CONVERT structure
+ *	i)	path	path name
+ *	r)		converted entry
+ */
+static struct converted *
+lookup(CONVERT *cv, const char *path)
+{
+	struct sh_entry *entry = strhash_assign(cv->path_cache, path, 1);
+	struct converted *conv = entry->value;
+
+	if (conv == NULL) {
+		conv = pool_malloc(cv->pool, sizeof(struct converted));
+		conv->path = pool_strdup(cv->pool, convert_pathname(cv, path), 0);
+		conv->fid = NULL;
+		entry->value = conv;
+	}
+	return conv;
+}
+/*
+ * lookup_fid: get the file id of the path name using the cache.
+ *
+ *	i)	cv	CONVERT structure
+ *	i)	path	path name
+ *	r)		file id
+ */
+static const char *
+lookup_fid(CONVERT *cv, const char *path)
+{
+	struct converted *conv = lookup(cv, path);
+
+	if (conv->fid == NULL) {
+		const char *fid = gpath_path2fid(path, NULL);
+
+		if (fid == NULL)
+			die("convert_put_using: unknown file. '%s'", path);
+		conv->fid = pool_strdup(cv->pool, fid, 0);
+	}
+	return conv->fid;
+}
+/*
+ * put_padded: put string padded with blanks to the width.
+ * (same as printf("%-16s", s))
+ */
+static void
+put_padded(STRBUF *sb, const char *s, int width)
+{
+	int len = strlen(s);
+
+	strbuf_nputs(sb, s, len);
+	if (len < width)
+		strbuf_nputc(sb, ' ', width - len);
+}
+/*
+ * put_number: put number right-justified in the width.
+ * (same as printf("%4d", n))
+ */
+static void
+put_number(STRBUF *sb, int n, int width)
+{
+	char buf[32], *p = buf + sizeof(buf);
+	int neg = n < 0;
+	unsigned int u = neg ? -(unsigned int)n : n;
+
+	do {
+		*--p = '0' + u % 10;
+		u /= 10;
+	} while (u);
+	if (neg)
+		*--p = '-';
+	if (buf + sizeof(buf) - p < width)
+		strbuf_nputc(sb, ' ', width - (buf + sizeof(buf) - p));
+	strbuf_nputs(sb, p, buf + sizeof(buf) - p);
+}
+/*
+ * utf8_len: length of a valid UTF-8 sequence.
+ *
+ *	i)	s	string which starts with a byte >= 0x80
+ *	r)		length of the sequence (2-4)
+ *			0: not a valid sequence
+ *
+ * Overlong forms, surrogates and code points over U+10FFFF are invalid.
+ */
+static int
+utf8_len(const unsigned char *s)
+{
+	unsigned char min = 0x80, max = 0xbf;
+	int len, i;
+
+	if (s[0] >= 0xc2 && s[0] <= 0xdf) {
+		len = 2;
+	} else if (s[0] >= 0xe0 && s[0] <= 0xef) {
+		len = 3;
+		if (s[0] == 0xe0)
+			min = 0xa0;
+		else if (s[0] == 0xed)
+			max = 0x9f;
+	} else if (s[0] >= 0xf0 && s[0] <= 0xf4) {
+		len = 4;
+		if (s[0] == 0xf0)
+			min = 0x90;
+		else if (s[0] == 0xf4)
+			max = 0x8f;
+	} else {
+		return 0;
+	}
+	if (s[1] < min || s[1] > max)
+		return 0;
+	for (i = 2; i < len; i++)
+		if (s[i] < 0x80 || s[i] > 0xbf)
+			return 0;
+	return len;
+}
+/*
+ * put_json_string: put string as a JSON string.
+ *
+ *	o)	sb	string buffer
+ *	i)	s	string
+ *
+ * Valid UTF-8 sequences are put as is. Other bytes (for example, source
+ * files in EUC-JP or Latin-1) are put as \u00XX, that is, each of them is
+ * taken as a Latin-1 character, so that the output is always valid JSON
+ * and the original bytes can be restored. Control characters and DEL are
+ * escaped too.
+ */
+static void
+put_json_string(STRBUF *sb, const char *s)
+{
+	static const char hex[] = "0123456789abcdef";
+	int len;
+
+	strbuf_putc(sb, '"');
+	for (; *s; s++) {
+		unsigned char c = *s;
+
+		if (c == '"' || c == '\\') {
+			strbuf_putc(sb, '\\');
+			strbuf_putc(sb, c);
+		} else if (c == '\t') {
+			strbuf_puts(sb, "\\t");
+		} else if (c >= 0x20 && c < 0x7f) {
+			strbuf_putc(sb, c);
+		} else if (c >= 0x80 && (len = utf8_len((const unsigned char *)s)) > 0) {
+			strbuf_nputs(sb, s, len);
+			s += len - 1;
+		} else {
+			strbuf_puts(sb, "\\u00");
+			strbuf_putc(sb, hex[c >> 4]);
+			strbuf_putc(sb, hex[c & 0xf]);
+		}
+	}
+	strbuf_putc(sb, '"');
+}
+/*
+ * flush_output: write the output buffer.
+ *
+ *	i)	cv	CONVERT structure
+ */
+static void
+flush_output(CONVERT *cv)
+{
+	int len = strbuf_getlen(cv->ob);
+
+	if (len > 0 && fwrite(strbuf_value(cv->ob), 1, len, cv->op) != (size_t)len)
+		die("cannot write the result.");
+	strbuf_reset(cv->ob);
+}
+/*
+ * end_record: terminate a record and write the output buffer if it is full.
+ *
+ *	i)	cv	CONVERT structure
+ */
+static void
+end_record(CONVERT *cv)
+{
+	strbuf_putc(cv->ob, newline);
+	if (strbuf_getlen(cv->ob) >= OUTPUT_BUFSIZE)
+		flush_output(cv);
+}
 /*
  * convert_open: open convert filter
  *
@@ -205,6 +402,9 @@ convert_open(int type, int format, const char *root, const char *cwd, const char
 	cv->type = type;
 	cv->format = format;
 	cv->op = op;
+	cv->path_cache = strhash_open(256);
+	cv->pool = pool_open();
+	cv->ob = strbuf_open(OUTPUT_BUFSIZE);
 	/*
 	 * open GPATH.
 	 */
@@ -226,7 +426,7 @@ convert_put(CONVERT *cv, const char *ctags_x)
 	char *tagnextp = NULL;
 	int tagnextc = 0;
 	char *tag = NULL, *lineno = NULL, *path, *rest = NULL;
-	const char *fid = NULL;
+	STRBUF *sb;
 
 	if (cv->format == FORMAT_PATH)
 		die("convert_put: internal error.");	/* Use convert_put_path() */
@@ -281,57 +481,55 @@ convert_put(CONVERT *cv, const char *ctags_x)
 	 * The path name has already been encoded.
 	 */
 	path = decode_path((unsigned char *)path);
+	sb = cv->ob;
 	switch (cv->format) {
 	case FORMAT_CTAGS:
-		fputs(tag, cv->op);
-		fputc('\t', cv->op);
-		fputs(convert_pathname(cv, path), cv->op);
-		fputc('\t', cv->op);
-		fputs(lineno, cv->op);
+		strbuf_puts(sb, tag);
+		strbuf_putc(sb, '\t');
+		strbuf_puts(sb, lookup(cv, path)->path);
+		strbuf_putc(sb, '\t');
+		strbuf_puts(sb, lineno);
 		break;
 	case FORMAT_CTAGS_XID:
-		fid = gpath_path2fid(path, NULL);
-		if (fid == NULL)
-			die("convert_put: unknown file. '%s'", path);
-		fputs(fid, cv->op);
-		fputc(' ', cv->op);
+		strbuf_puts(sb, lookup_fid(cv, path));
+		strbuf_putc(sb, ' ');
 		/* PASS THROUGH */
 	case FORMAT_CTAGS_X:
 		/*
 		 * print until path name.
 		 */
 		*tagnextp = tagnextc;
-		fputs(ctags_x, cv->op);
-		fputc(' ', cv->op);
+		strbuf_puts(sb, ctags_x);
+		strbuf_putc(sb, ' ');
 		/*
 		 * print path name and the rest.
 		 */
-		fputs(convert_pathname(cv, path), cv->op);
-		fputc(' ', cv->op);
-		fputs(rest, cv->op);
+		strbuf_puts(sb, lookup(cv, path)->path);
+		strbuf_putc(sb, ' ');
+		strbuf_puts(sb, rest);
 		break;
 	case FORMAT_GREP:
-		fputs(convert_pathname(cv, path), cv->op);
-		fputc(':', cv->op);
-		fputs(lineno, cv->op);
-		fputc(':', cv->op);
-		fputs(rest, cv->op);
+		strbuf_puts(sb, lookup(cv, path)->path);
+		strbuf_putc(sb, ':');
+		strbuf_puts(sb, lineno);
+		strbuf_putc(sb, ':');
+		strbuf_puts(sb, rest);
 		break;
 	case FORMAT_CSCOPE:
-		fputs(convert_pathname(cv, path), cv->op);
-		fputc(' ', cv->op);
-		fputs(tag, cv->op);
-		fputc(' ', cv->op);
-		fputs(lineno, cv->op);
-		fputc(' ', cv->op);
+		strbuf_puts(sb, lookup(cv, path)->path);
+		strbuf_putc(sb, ' ');
+		strbuf_puts(sb, tag);
+		strbuf_putc(sb, ' ');
+		strbuf_puts(sb, lineno);
+		strbuf_putc(sb, ' ');
 		for (; *rest && isspace(*rest); rest++)
 			;
-		fputs(rest, cv->op);
+		strbuf_puts(sb, rest);
 		break;
 	default:
 		die("unknown format type.");
 	}
-	(void)fputc(newline, cv->op);
+	end_record(cv);
 }
 /*
  * convert_put_path: convert path into relative or absolute and print.
@@ -344,8 +542,8 @@ convert_put_path(CONVERT *cv, const char *path)
 {
 	if (cv->format != FORMAT_PATH)
 		die("convert_put_path: internal error.");
-	fputs(convert_pathname(cv, path), cv->op);
-	(void)fputc(newline, cv->op);
+	strbuf_puts(cv->ob, lookup(cv, path)->path);
+	end_record(cv);
 }
 /*
  * convert_put_using: convert path into relative or absolute and print.
@@ -360,56 +558,78 @@ convert_put_path(CONVERT *cv, const char *path)
 void
 convert_put_using(CONVERT *cv, const char *tag, const char *path, int lineno, const char *rest, const char *fid)
 {
+	STRBUF *sb = cv->ob;
+
 	switch (cv->format) {
 	case FORMAT_PATH:
-		fputs(convert_pathname(cv, path), cv->op);
+		strbuf_puts(sb, lookup(cv, path)->path);
 		break;
 	case FORMAT_CTAGS:
-		fputs(tag, cv->op);
-		fputc('\t', cv->op);
-		fputs(convert_pathname(cv, path), cv->op);
-		fputc('\t', cv->op);
-		fprintf(cv->op, "%d", lineno);
+		strbuf_puts(sb, tag);
+		strbuf_putc(sb, '\t');
+		strbuf_puts(sb, lookup(cv, path)->path);
+		strbuf_putc(sb, '\t');
+		put_number(sb, lineno, 0);
 		break;
 	case FORMAT_CTAGS_XID:
-		if (fid == NULL) {
-			fid = gpath_path2fid(path, NULL);
-			if (fid == NULL)
-				die("convert_put_using: unknown file. '%s'", path);
-		}
-		fputs(fid, cv->op);
-		fputc(' ', cv->op);
+		strbuf_puts(sb, fid ? fid : lookup_fid(cv, path));
+		strbuf_putc(sb, ' ');
 		/* PASS THROUGH */
 	case FORMAT_CTAGS_X:
-		fprintf(cv->op, "%-16s %4d %-16s %s",
-			tag, lineno, convert_pathname(cv, path), rest);
+		put_padded(sb, tag, 16);
+		strbuf_putc(sb, ' ');
+		put_number(sb, lineno, 4);
+		strbuf_putc(sb, ' ');
+		put_padded(sb, lookup(cv, path)->path, 16);
+		strbuf_putc(sb, ' ');
+		strbuf_puts(sb, rest);
 		break;
 	case FORMAT_GREP:
-		fputs(convert_pathname(cv, path), cv->op);
-		fputc(':', cv->op);
-		fprintf(cv->op, "%d", lineno);
-		fputc(':', cv->op);
-		fputs(rest, cv->op);
+		strbuf_puts(sb, lookup(cv, path)->path);
+		strbuf_putc(sb, ':');
+		put_number(sb, lineno, 0);
+		strbuf_putc(sb, ':');
+		strbuf_puts(sb, rest);
 		break;
 	case FORMAT_CSCOPE:
-		fputs(convert_pathname(cv, path), cv->op);
-		fputc(' ', cv->op);
-		fputs(tag, cv->op);
-		fputc(' ', cv->op);
-		fprintf(cv->op, "%d", lineno);
-		fputc(' ', cv->op);
+		strbuf_puts(sb, lookup(cv, path)->path);
+		strbuf_putc(sb, ' ');
+		strbuf_puts(sb, tag);
+		strbuf_putc(sb, ' ');
+		put_number(sb, lineno, 0);
+		strbuf_putc(sb, ' ');
 		for (; *rest && isspace(*rest); rest++)
 			;
-		fputs(rest, cv->op);
+		strbuf_puts(sb, rest);
+		break;
+	case FORMAT_JSON:
+		strbuf_puts(sb, "{\"tag\":");
+		put_json_string(sb, tag);
+		strbuf_puts(sb, ",\"path\":");
+		put_json_string(sb, lookup(cv, path)->path);
+		strbuf_puts(sb, ",\"lineno\":");
+		put_number(sb, lineno, 0);
+		strbuf_puts(sb, ",\"line\":");
+		put_json_string(sb, rest);
+		strbuf_putc(sb, '}');
 		break;
 	default:
 		die("unknown format type.");
 	}
-	(void)fputc(newline, cv->op);
+	end_record(cv);
 }
+/*
+ * convert_close: close convert filter
+ *
+ *	i)	cv	CONVERT structure
+ */
 void
 convert_close(CONVERT *cv)
 {
+	flush_output(cv);
+	strbuf_close(cv->ob);
+	strhash_close(cv->path_cache);
+	pool_close(cv->pool);
 	strbuf_close(cv->abspath);
 	gpath_close();
 	free(cv);
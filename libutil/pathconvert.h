@@ -21,7 +21,9 @@
 
 #include <stdio.h>
 #include "gparam.h"
+#include "pool.h"
 #include "strbuf.h"
+#include "strhash.h"
 
 typedef struct {
 	FILE *op;
@@ -30,7 +32,9 @@ typedef struct {
 	STRBUF *abspath;
 	char basedir[MAXPATHLEN];
 	int start_point;
-
+	STRHASH *path_cache;	/* converted path names */
+	POOL *pool;		/* memory for path_cache */
+	STRBUF *ob;		/* output buffer */
 } CONVERT;
 
 void set_encode_chars(const unsigned char *);
@@ -112,6 +112,11 @@ pool_reset(POOL *pool)
 	 * Free all memory in pool->obstack but leave it valid for further allocation.
 	 */
 	obstack_free(&pool->obstack, pool->first_object);
+	/*
+	 * Keep the first object allocated. Otherwise, obstack may release
+	 * the chunk which includes it when the next object doesn't fit in.
+	 */
+	pool->first_object = obstack_alloc(&pool->obstack, 1);
 }
 /*
  * pool_close: close memory pool
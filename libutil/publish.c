@@ -0,0 +1,332 @@
+/*
+ * Copyright (c) 2010 Tama Communications Corporation
+ *
+ * This file is part of GNU GLOBAL.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#ifdef HAVE_DIRENT_H
+#include <dirent.h>
+#endif
+#include <stdio.h>
+#ifdef STDC_HEADERS
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#else
+#include <strings.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#include <utime.h>
+
+#include "gparam.h"
+#include "die.h"
+#include "frozen.h"
+#include "gpathop.h"
+#include "gtagsop.h"
+#include "makepath.h"
+#include "publish.h"
+#include "rescache.h"
+#include "strlimcpy.h"
+#include "test.h"
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+/*
+ * Atomic publishing of tag files (gtags --atomic).
+ *
+ * Gtags usually updates GTAGS, GRTAGS and GPATH in place, and global(1)
+ * running meanwhile may see them in an inconsistent state. In the atomic
+ * mode, each generation of tag files is made in its own directory in the
+ * dbpath, and the file GCURRENT tells the name of the current one:
+ *
+ *	dbpath/GCURRENT		".gtags.3\n"
+ *	dbpath/.gtags.2/	previous generation
+ *	dbpath/.gtags.3/	current generation (GTAGS, GRTAGS, GPATH, ...)
+ *
+ * A new generation is made by copying the current one and updating it,
+ * or by making it from scratch, and it is published by renaming a new
+ * GCURRENT over the old one. Getdbpath() resolves GCURRENT only once,
+ * so a reader keeps using a consistent generation until it exits.
+ * The previous generation is kept for the readers which started before
+ * the publishing; older ones are removed.
+ *
+ * The names of generation directories start with '.', so they are
+ * skipped when gtags collects source files.
+ */
+
+/*
+ * generation_of: get the generation number of a directory name.
+ *
+ *	i)	name	directory name
+ *	r)		generation number (0: not a generation directory)
+ */
+static int
+generation_of(const char *name)
+{
+	const char *p;
+
+	if (strncmp(name, PUBLISH_PREFIX, sizeof(PUBLISH_PREFIX) - 1))
+		return 0;
+	p = name + sizeof(PUBLISH_PREFIX) - 1;
+	if (*p == '\0')
+		return 0;
+	for (; *p; p++)
+		if (!isdigit((unsigned char)*p))
+			return 0;
+	return atoi(name + sizeof(PUBLISH_PREFIX) - 1);
+}
+/*
+ * published: get the current generation of the published tag files.
+ *
+ *	i)	dir	dbpath directory
+ *	r)		generation directory (NULL: not published)
+ */
+const char *
+published(const char *dir)
+{
+	static char path[MAXPATHLEN];
+	char name[MAXPATHLEN];
+	char *p;
+	FILE *fp;
+
+	if ((fp = fopen(makepath(dir, PUBLISH_NAME, NULL), "r")) == NULL)
+		return NULL;
+	if (fgets(name, sizeof(name), fp) == NULL) {
+		fclose(fp);
+		return NULL;
+	}
+	fclose(fp);
+	if ((p = strchr(name, '\n')) != NULL)
+		*p = '\0';
+	if (generation_of(name) == 0)
+		return NULL;
+	strlimcpy(path, makepath(dir, name, NULL), sizeof(path));
+	if (!test("fr", makepath(path, dbname(GTAGS), NULL)))
+		return NULL;
+	return path;
+}
+/*
+ * publish_top: get the dbpath of a generation directory.
+ *
+ *	i)	path	directory
+ *	o)	top	dbpath directory which has GCURRENT
+ *	i)	size	size of top
+ *	r)		1: path is a generation directory, 0: not
+ */
+int
+publish_top(const char *path, char *top, int size)
+{
+	const char *p = strrchr(path, '/');
+
+	if (p == NULL || generation_of(p + 1) == 0)
+		return 0;
+	if (p == path)
+		strlimcpy(top, "/", size);
+	else
+		snprintf(top, size, "%.*s", (int)(p - path), path);
+	return test("f", makepath(top, PUBLISH_NAME, NULL)) ? 1 : 0;
+}
+/*
+ * publish_open: make a directory for the next generation.
+ *
+ *	i)	top	dbpath directory
+ *	r)		generation directory
+ */
+const char *
+publish_open(const char *top)
+{
+	static char path[MAXPATHLEN];
+	const char *current = published(top);
+	int n = 1;
+
+	if (current)
+		n = generation_of(strrchr(current, '/') + 1) + 1;
+	/*
+	 * Mkdir(2) fails if another gtags took the name.
+	 */
+	for (;; n++) {
+		snprintf(path, sizeof(path), "%s/%s%d", top, PUBLISH_PREFIX, n);
+#if defined(_WIN32) && !defined(__CYGWIN__)
+		if (mkdir(path) == 0)
+#else
+		if (mkdir(path, 0775) == 0)
+#endif
+			break;
+		if (errno != EEXIST)
+			die("cannot make directory '%s'.", path);
+	}
+	return path;
+}
+/*
+ * copyfile: copy a file keeping the modification time.
+ *
+ *	i)	from	source file
+ *	i)	to	destination file
+ *
+ * Gtags -i compares the modification time of GTAGS with source files.
+ */
+static void
+copyfile(const char *from, const char *to)
+{
+	struct stat st;
+	struct utimbuf ut;
+	char buf[8192];
+	int ip, op, size;
+
+	if ((ip = open(from, O_RDONLY|O_BINARY)) < 0)
+		die("cannot open '%s'.", from);
+	if (fstat(ip, &st) < 0)
+		die("stat failed '%s'.", from);
+	if ((op = open(to, O_WRONLY|O_CREAT|O_TRUNC|O_BINARY, 0644)) < 0)
+		die("cannot create '%s'.", to);
+	while ((size = read(ip, buf, sizeof(buf))) != 0) {
+		if (size < 0)
+			die("read error '%s'.", from);
+		if (write(op, buf, size) != size)
+			die("write error '%s'.", to);
+	}
+	if (close(op) < 0)
+		die("write error '%s'.", to);
+	close(ip);
+	ut.actime = st.st_atime;
+	ut.modtime = st.st_mtime;
+	if (utime(to, &ut) < 0)
+		die("cannot set time of '%s'.", to);
+}
+/*
+ * publish_copy: copy tag files for incremental updating.
+ *
+ *	i)	from	directory of the current tag files
+ *	i)	to	generation directory
+ */
+void
+publish_copy(const char *from, const char *to)
+{
+	char path[MAXPATHLEN];
+	int db;
+
+	for (db = GPATH; db < GTAGLIM; db++) {
+		strlimcpy(path, makepath(from, dbname(db), NULL), sizeof(path));
+		if (test("f", path))
+			copyfile(path, makepath(to, dbname(db), NULL));
+	}
+	strlimcpy(path, makepath(from, SYMTAB_NAME, NULL), sizeof(path));
+	if (test("f", path))
+		copyfile(path, makepath(to, SYMTAB_NAME, NULL));
+	strlimcpy(path, makepath(from, FROZEN_NAME, NULL), sizeof(path));
+	if (test("f", path))
+		copyfile(path, makepath(to, FROZEN_NAME, NULL));
+}
+/*
+ * removedir: remove a generation directory.
+ *
+ *	i)	path	generation directory
+ */
+static void
+removedir(const char *path)
+{
+	char buf[MAXPATHLEN];
+	DIR *dirp;
+	struct dirent *dp;
+
+	if ((dirp = opendir(path)) == NULL)
+		return;
+	while ((dp = readdir(dirp)) != NULL) {
+		if (!strcmp(dp->d_name, ".") || !strcmp(dp->d_name, ".."))
+			continue;
+		snprintf(buf, sizeof(buf), "%s/%s", path, dp->d_name);
+		(void)unlink(buf);
+	}
+	closedir(dirp);
+	(void)rmdir(path);
+}
+/*
+ * publish_close: publish a generation or discard it.
+ *
+ *	i)	top	dbpath directory
+ *	i)	path	generation directory made by publish_open()
+ *	i)	commit	1: publish, 0: discard
+ */
+void
+publish_close(const char *top, const char *path, int commit)
+{
+	const char *name = strrchr(path, '/') + 1;
+	const char *current;
+	char tmp[MAXPATHLEN + 16];
+	int lower, db;
+	FILE *fp;
+	DIR *dirp;
+	struct dirent *dp;
+
+	if (!commit) {
+		removedir(path);
+		return;
+	}
+	current = published(top);
+	lower = generation_of(name);
+	if (current && generation_of(strrchr(current, '/') + 1) < lower)
+		lower = generation_of(strrchr(current, '/') + 1);
+	/*
+	 * Readers see either the old GCURRENT or the new one.
+	 */
+	snprintf(tmp, sizeof(tmp), "%s.%d", makepath(top, PUBLISH_NAME, NULL), (int)getpid());
+	if ((fp = fopen(tmp, "w")) == NULL)
+		die("cannot make '%s'.", tmp);
+	fprintf(fp, "%s\n", name);
+	if (fclose(fp) != 0)
+		die("cannot write '%s'.", tmp);
+#if defined(_WIN32) || defined(__DJGPP__)
+	(void)unlink(makepath(top, PUBLISH_NAME, NULL));
+#endif
+	if (rename(tmp, makepath(top, PUBLISH_NAME, NULL)) < 0) {
+		(void)unlink(tmp);
+		die("cannot publish '%s'.", path);
+	}
+	/*
+	 * Remove the generations older than the previous one. The newer
+	 * ones may be being made by another gtags.
+	 */
+	if ((dirp = opendir(top)) != NULL) {
+		while ((dp = readdir(dirp)) != NULL) {
+			int n = generation_of(dp->d_name);
+
+			if (n > 0 && n < lower)
+				removedir(makepath(top, dp->d_name, NULL));
+		}
+		closedir(dirp);
+	}
+	/*
+	 * Remove the tag files made before the atomic mode, if any.
+	 */
+	for (db = GPATH; db < GTAGLIM; db++)
+		(void)unlink(makepath(top, dbname(db), NULL));
+	(void)unlink(makepath(top, SYMTAB_NAME, NULL));
+	(void)unlink(makepath(top, FROZEN_NAME, NULL));
+	(void)unlink(makepath(top, RESCACHE_NAME, NULL));
+}
@@ -0,0 +1,32 @@
+/*
+ * Copyright (c) 2010 Tama Communications Corporation
+ *
+ * This file is part of GNU GLOBAL.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _PUBLISH_H_
+#define _PUBLISH_H_
+
+#define PUBLISH_NAME	"GCURRENT"
+#define PUBLISH_PREFIX	".gtags."
+
+const char *published(const char *);
+int publish_top(const char *, char *, int);
+const char *publish_open(const char *);
+void publish_copy(const char *, const char *);
+void publish_close(const char *, const char *, int);
+
+#endif /* ! _PUBLISH_H_ */
@@ -0,0 +1,491 @@
+/*
+ * Copyright (c) 2010 Tama Communications Corporation
+ *
+ * This file is part of GNU GLOBAL.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <stdio.h>
+#ifdef STDC_HEADERS
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#else
+#include <strings.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#if !defined(_WIN32) && !defined(__DJGPP__)
+#include <sys/mman.h>
+#endif
+
+#include "checkalloc.h"
+#include "die.h"
+#include "hash-string.h"
+#include "makepath.h"
+#include "rescache.h"
+#include "strlimcpy.h"
+#include "test.h"
+
+/*
+ * Result cache of global(1).
+ *
+ * The output of a query is kept in the file GCACHE in the dbpath, keyed by
+ * the query. The file is stamped with the generation of the tag files
+ * (see gpathop.c), and the whole cache is regarded as empty when the tag
+ * files have been updated since then.
+ *
+ *	+---------------------------+
+ *	|header                     | magic, version, generation, clock
+ *	|                           | hash index (offset of the latest entry
+ *	|                           | of each bucket)
+ *	+---------------------------+
+ *	|entry                      | hash, next, lengths, lastuse
+ *	|key                        | '\0' terminated
+ *	|data                       | output of the query
+ *	+---------------------------+
+ *	|...                        |
+ *	+---------------------------+
+ *
+ * The file is read through mmap(2). A lookup follows the chain of the
+ * bucket of the key, from the latest entry to older ones. A hit only
+ * rewrites the lastuse field of the entry in place. A new entry is
+ * appended to the file and linked to the head of its bucket.
+ *
+ * Only when the file would exceed the limit, it is compacted: it is written
+ * again through a temporary file with the most recently used entries,
+ * up to half of the limit, so that compaction doesn't happen at every miss.
+ *
+ * The cache is only an accelerator. Any failure is ignored silently.
+ * An entry which is broken or lost by concurrent updating is just a miss.
+ */
+#define RESCACHE_MAGIC	"GLOBAL CACHE"
+#define RESCACHE_VERSION	3
+#define RESCACHE_BYTEORDER	0x01020304
+
+#define ALIGN4(n)	(((n) + 3) & ~3UL)
+#define ENTRYSIZE(e)	(sizeof(struct rescache_entry) + ALIGN4((e)->keylen + 1 + (e)->datalen))
+
+/*
+ * rescache_hash: hash function for keys.
+ *
+ * The value of __hash_string() is scrambled, since its lower bits, which
+ * select the bucket, depend mostly on the last characters of the key.
+ */
+static unsigned int
+rescache_hash(const char *s)
+{
+	unsigned int h = (unsigned int)__hash_string(s) * 2654435769U;
+
+	return h ^ (h >> 16);
+}
+/*
+ * valid: check the header of the cache image.
+ *
+ *	r)		1: valid, 0: invalid
+ *
+ * Entries are checked when they are read (see entry_at()).
+ */
+static int
+valid(RESCACHE *rc)
+{
+	const struct rescache_header *header = (const struct rescache_header *)rc->map;
+
+	if (rc->size < sizeof(struct rescache_header)
+	    || strncmp(header->magic, RESCACHE_MAGIC, sizeof(header->magic))
+	    || header->version != RESCACHE_VERSION
+	    || header->byteorder != RESCACHE_BYTEORDER
+	    || header->generation != rc->generation)
+		return 0;
+	return 1;
+}
+/*
+ * entry_at: get the entry at the offset.
+ *
+ *	i)	rc	RESCACHE structure
+ *	i)	offset	offset of the entry
+ *	r)		entry
+ *			NULL: none, broken or out of the mapped image
+ *
+ * An entry is always linked to older (lower) entries, so that a broken
+ * chain never makes a loop.
+ */
+static const struct rescache_entry *
+entry_at(RESCACHE *rc, unsigned int offset)
+{
+	const struct rescache_entry *e;
+
+	if (offset < sizeof(struct rescache_header) || offset % 4 != 0
+	    || offset > rc->size || rc->size - offset < sizeof(struct rescache_entry))
+		return NULL;
+	e = (const struct rescache_entry *)(rc->map + offset);
+	if (e->next >= offset || e->keylen > rc->size || e->datalen > rc->size
+	    || rc->size - offset < ENTRYSIZE(e)
+	    || rc->map[offset + sizeof(struct rescache_entry) + e->keylen] != '\0')
+		return NULL;
+	return e;
+}
+/*
+ * putint: write an unsigned int field of the cache file in place.
+ *
+ *	i)	rc	RESCACHE structure
+ *	i)	field	address of the field in the mapped image
+ *	i)	value	value
+ */
+static void
+putint(RESCACHE *rc, const unsigned int *field, unsigned int value)
+{
+	if (rc->fd < 0)
+		return;
+	if (lseek(rc->fd, (off_t)((const char *)field - rc->map), SEEK_SET) >= 0)
+		(void)write(rc->fd, &value, sizeof(value));
+}
+/*
+ * rescache_open: open result cache.
+ *
+ *	i)	dbpath		dbpath directory
+ *	i)	generation	generation of tag files
+ *	i)	limit		maximum size of the cache file
+ *	r)			RESCACHE structure
+ *
+ * The cache is empty if the file doesn't exist or is out of date.
+ */
+RESCACHE *
+rescache_open(const char *dbpath, unsigned int generation, unsigned long limit)
+{
+	RESCACHE *rc = check_calloc(sizeof(RESCACHE), 1);
+	struct stat st;
+
+	strlimcpy(rc->path, makepath(dbpath, RESCACHE_NAME, NULL), sizeof(rc->path));
+	rc->generation = generation;
+	rc->limit = limit;
+	rc->fd = -1;
+#if !defined(_WIN32) && !defined(__DJGPP__)
+	{
+		void *map;
+
+		if ((rc->fd = open(rc->path, O_RDWR)) < 0
+		    && (rc->fd = open(rc->path, O_RDONLY)) < 0)
+			return rc;
+		if (fstat(rc->fd, &st) < 0 || st.st_size < (off_t)sizeof(struct rescache_header))
+			return rc;
+		map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, rc->fd, 0);
+		if (map == MAP_FAILED)
+			return rc;
+		rc->map = map;
+		rc->mapped = 1;
+	}
+#else
+	{
+		FILE *fp;
+
+		if ((fp = fopen(rc->path, "rb")) == NULL)
+			return rc;
+		if (fstat(fileno(fp), &st) < 0 || st.st_size < (off_t)sizeof(struct rescache_header)) {
+			fclose(fp);
+			return rc;
+		}
+		rc->map = check_malloc(st.st_size);
+		if (fread(rc->map, st.st_size, 1, fp) != 1) {
+			fclose(fp);
+			return rc;
+		}
+		fclose(fp);
+	}
+#endif
+	rc->size = st.st_size;
+	if (valid(rc))
+		rc->header = (const struct rescache_header *)rc->map;
+	return rc;
+}
+/*
+ * rescache_get: get the cached data of a key.
+ *
+ *	i)	rc	RESCACHE structure
+ *	i)	key	key
+ *	o)	len	length of the data
+ *	r)		data (NULL: not found)
+ *
+ * The data is valid until rescache_close().
+ */
+const char *
+rescache_get(RESCACHE *rc, const char *key, int *len)
+{
+	const struct rescache_entry *e;
+	unsigned int hash = rescache_hash(key);
+	unsigned int offset;
+
+	if (rc->header == NULL)
+		return NULL;
+	offset = rc->header->bucket[hash % RESCACHE_BUCKETS];
+	while ((e = entry_at(rc, offset)) != NULL) {
+		const char *k = (const char *)e + sizeof(struct rescache_entry);
+
+		if (e->hash == hash && !strcmp(k, key)) {
+			/*
+			 * Mark the entry as used recently.
+			 */
+			unsigned int clock = rc->header->clock + 1;
+
+			putint(rc, &rc->header->clock, clock);
+			putint(rc, &e->lastuse, clock);
+			*len = e->datalen;
+			return k + e->keylen + 1;
+		}
+		offset = e->next;
+	}
+	return NULL;
+}
+/*
+ * append: append an entry to the cache file.
+ *
+ *	i)	rc	RESCACHE structure
+ *	i)	entry	entry (hash, keylen and datalen are set)
+ *	i)	key	key
+ *	i)	data	data
+ *	r)		0: appended, -1: not appended
+ *
+ * The entry is written before it is linked to the bucket, so that readers
+ * never see a partial entry. If the file would exceed the limit, it is not
+ * appended.
+ */
+static int
+append(RESCACHE *rc, struct rescache_entry *entry, const char *key, const char *data)
+{
+	unsigned int slot = entry->hash % RESCACHE_BUCKETS;
+	unsigned long size = ENTRYSIZE(entry);
+	struct stat st;
+	off_t end;
+	char *buf;
+	int fd, error = -1;
+
+	if (rc->header == NULL || rc->fd < 0)
+		return -1;
+	if ((fd = open(rc->path, O_WRONLY|O_APPEND)) < 0)
+		return -1;
+	if (fstat(fd, &st) < 0 || st.st_size % 4 != 0
+	    || (unsigned long)st.st_size + size > rc->limit)
+		goto out;
+	entry->next = rc->header->bucket[slot];
+	entry->lastuse = rc->header->clock + 1;
+	buf = check_calloc(size, 1);
+	memcpy(buf, entry, sizeof(struct rescache_entry));
+	memcpy(buf + sizeof(struct rescache_entry), key, entry->keylen + 1);
+	if (entry->datalen > 0)
+		memcpy(buf + sizeof(struct rescache_entry) + entry->keylen + 1, data, entry->datalen);
+	if (write(fd, buf, size) == (ssize_t)size && (end = lseek(fd, 0, SEEK_CUR)) >= (off_t)size) {
+		putint(rc, &rc->header->clock, entry->lastuse);
+		putint(rc, &rc->header->bucket[slot], (unsigned int)(end - size));
+		error = 0;
+	}
+	free(buf);
+out:
+	close(fd);
+	return error;
+}
+/*
+ * compare routine for qsort(3): the most recently used first.
+ */
+static int
+compare_lastuse(const void *v1, const void *v2)
+{
+	const struct rescache_entry *e1 = *(const struct rescache_entry **)v1;
+	const struct rescache_entry *e2 = *(const struct rescache_entry **)v2;
+
+	return e1->lastuse < e2->lastuse ? 1 : e1->lastuse > e2->lastuse ? -1 : 0;
+}
+/*
+ * compact: write the cache file again with a new entry.
+ *
+ *	i)	rc	RESCACHE structure
+ *	i)	entry	entry (hash, keylen and datalen are set)
+ *	i)	key	key
+ *	i)	data	data
+ *
+ * The most recently used entries are kept up to half of the limit.
+ * The file is also made here when it doesn't exist or is out of date.
+ */
+static void
+compact(RESCACHE *rc, struct rescache_entry *entry, const char *key, const char *data)
+{
+	static const char pad[4];
+	struct rescache_header header;
+	const struct rescache_entry **olds = NULL, *e;
+	struct rescache_entry ent;
+	unsigned long total, offset;
+	unsigned int i, j, n = 0, max = 0, slot;
+	int padlen;
+	char tmp[MAXPATHLEN + 16];
+	FILE *fp;
+
+	memset(&header, 0, sizeof(header));
+	strlimcpy(header.magic, RESCACHE_MAGIC, sizeof(header.magic));
+	header.version = RESCACHE_VERSION;
+	header.byteorder = RESCACHE_BYTEORDER;
+	header.generation = rc->generation;
+	header.clock = rc->header ? rc->header->clock + 1 : 1;
+	entry->lastuse = header.clock;
+	total = sizeof(struct rescache_header) + ENTRYSIZE(entry);
+	/*
+	 * Collect the live entries. The latest one of the same key comes
+	 * first in a bucket.
+	 */
+	if (rc->header) {
+		for (slot = 0; slot < RESCACHE_BUCKETS; slot++) {
+			unsigned int first = n;
+
+			for (offset = rc->header->bucket[slot]; (e = entry_at(rc, offset)) != NULL; offset = e->next) {
+				const char *k = (const char *)e + sizeof(struct rescache_entry);
+
+				if (!strcmp(k, key))
+					continue;
+				for (j = first; j < n; j++)
+					if (!strcmp((const char *)olds[j] + sizeof(struct rescache_entry), k))
+						break;
+				if (j < n)
+					continue;
+				if (n >= max) {
+					max = max ? max * 2 : 64;
+					olds = check_realloc(olds, sizeof(struct rescache_entry *) * max);
+				}
+				olds[n++] = e;
+			}
+		}
+		qsort(olds, n, sizeof(struct rescache_entry *), compare_lastuse);
+		for (i = 0; i < n; i++) {
+			if (total + ENTRYSIZE(olds[i]) > rc->limit / 2)
+				break;
+			total += ENTRYSIZE(olds[i]);
+		}
+		n = i;
+	}
+	/*
+	 * Write to a temporary file and rename it, so that readers never
+	 * see a partial cache. The name is unique for concurrent writers.
+	 * The entries are written from the least recently used one, and the
+	 * new entry is the last. The header with the hash index follows them.
+	 */
+	snprintf(tmp, sizeof(tmp), "%s.%d", rc->path, (int)getpid());
+	if ((fp = fopen(tmp, "wb")) == NULL)
+		goto out;
+	if (fseek(fp, sizeof(header), SEEK_SET) < 0)
+		goto fail;
+	offset = sizeof(struct rescache_header);
+	for (i = n; i > 0; i--) {
+		e = olds[i - 1];
+		ent = *e;
+		slot = ent.hash % RESCACHE_BUCKETS;
+		ent.next = header.bucket[slot];
+		header.bucket[slot] = offset;
+		if (fwrite(&ent, sizeof(ent), 1, fp) != 1
+		    || fwrite((const char *)e + sizeof(ent), ENTRYSIZE(e) - sizeof(ent), 1, fp) != 1)
+			goto fail;
+		offset += ENTRYSIZE(e);
+	}
+	slot = entry->hash % RESCACHE_BUCKETS;
+	entry->next = header.bucket[slot];
+	header.bucket[slot] = offset;
+	padlen = ALIGN4(entry->keylen + 1 + entry->datalen) - (entry->keylen + 1 + entry->datalen);
+	if (fwrite(entry, sizeof(*entry), 1, fp) != 1
+	    || fwrite(key, entry->keylen + 1, 1, fp) != 1
+	    || (entry->datalen > 0 && fwrite(data, entry->datalen, 1, fp) != 1)
+	    || (padlen > 0 && fwrite(pad, padlen, 1, fp) != 1))
+		goto fail;
+	if (fseek(fp, 0, SEEK_SET) < 0 || fwrite(&header, sizeof(header), 1, fp) != 1)
+		goto fail;
+	if (fclose(fp) != 0) {
+		fp = NULL;
+		goto fail;
+	}
+#if defined(_WIN32) || defined(__DJGPP__)
+	(void)unlink(rc->path);
+#endif
+	if (rename(tmp, rc->path) < 0)
+		(void)unlink(tmp);
+	goto out;
+fail:
+	if (fp)
+		fclose(fp);
+	(void)unlink(tmp);
+out:
+	if (olds)
+		free(olds);
+}
+/*
+ * rescache_put: put data into the cache.
+ *
+ *	i)	rc	RESCACHE structure
+ *	i)	key	key
+ *	i)	data	data
+ *	i)	len	length of the data
+ *
+ * The entry is appended to the cache file. If the file would exceed the
+ * limit, the least recently used entries are dropped (see compact()).
+ * If the data alone exceeds the limit, it is not cached.
+ */
+void
+rescache_put(RESCACHE *rc, const char *key, const char *data, int len)
+{
+	struct rescache_entry entry;
+
+	memset(&entry, 0, sizeof(entry));
+	entry.hash = rescache_hash(key);
+	entry.keylen = strlen(key);
+	entry.datalen = len;
+	if (sizeof(struct rescache_header) + ENTRYSIZE(&entry) > rc->limit)
+		return;
+	if (append(rc, &entry, key, data) < 0)
+		compact(rc, &entry, key, data);
+}
+/*
+ * rescache_close: close result cache.
+ *
+ *	i)	rc	RESCACHE structure
+ */
+void
+rescache_close(RESCACHE *rc)
+{
+#if !defined(_WIN32) && !defined(__DJGPP__)
+	if (rc->mapped)
+		munmap(rc->map, rc->size);
+#else
+	if (rc->map)
+		free(rc->map);
+#endif
+	if (rc->fd >= 0)
+		close(rc->fd);
+	free(rc);
+}
+/*
+ * rescache_remove: remove result cache if any.
+ *
+ *	i)	dbpath	dbpath directory
+ */
+void
+rescache_remove(const char *dbpath)
+{
+	const char *path = makepath(dbpath, RESCACHE_NAME, NULL);
+
+	if (test("f", path))
+		(void)unlink(path);
+}
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2010 Tama Communications Corporation
+ *
+ * This file is part of GNU GLOBAL.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _RESCACHE_H_
+#define _RESCACHE_H_
+
+#include "gparam.h"
+
+#define RESCACHE_NAME	"GCACHE"
+
+/*
+ * On-disk structures. The file is a header followed by entries.
+ * Each entry is followed by the key ('\0' terminated) and the data,
+ * and padded to a multiple of 4 bytes. Offsets are from the top of the file.
+ */
+#define RESCACHE_BUCKETS	1024
+
+struct rescache_header {
+	char magic[16];
+	unsigned int version;
+	unsigned int byteorder;
+	unsigned int generation;	/* generation of tag files	*/
+	unsigned int clock;		/* last value of lastuse	*/
+	unsigned int bucket[RESCACHE_BUCKETS];	/* latest entry (0: none) */
+};
+struct rescache_entry {
+	unsigned int hash;		/* hash value of the key	*/
+	unsigned int next;		/* older entry in the bucket	*/
+	unsigned int keylen;		/* length of the key		*/
+	unsigned int datalen;		/* length of the data		*/
+	unsigned int lastuse;		/* clock of the last use	*/
+};
+
+typedef struct {
+	char *map;			/* mapped image			*/
+	unsigned long size;		/* size of the image		*/
+	int mapped;			/* 1: mmap(2)ed, 0: malloc(3)ed	*/
+	int fd;				/* for updating lastuse (-1: none) */
+	const struct rescache_header *header;	/* NULL: empty	*/
+	unsigned int generation;
+	unsigned long limit;		/* maximum size of the file	*/
+	char path[MAXPATHLEN];
+} RESCACHE;
+
+RESCACHE *rescache_open(const char *, unsigned int, unsigned long);
+const char *rescache_get(RESCACHE *, const char *, int *);
+void rescache_put(RESCACHE *, const char *, const char *, int);
+void rescache_close(RESCACHE *);
+void rescache_remove(const char *);
+
+#endif /* ! _RESCACHE_H_ */
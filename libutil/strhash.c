@@ -34,7 +34,7 @@
 
 String Hash (associative array): usage and memory status
 
-hash = strhash_open(10);			// allocate hash buckets.
+hash = strhash_open(10);			// allocate hash slots.
 
 entry = strhash_assign(hash, "name1", 0);	// get entry for the name.
 
@@ -74,22 +74,84 @@ strhash_close(hash);				// free resources.
 #define obstack_chunk_alloc check_malloc
 #define obstack_chunk_free free
 
+/*
+ * The hash table is an array of slots with linear probing. Each slot holds
+ * the hash value of the name beside the pointer to the entry, so lookups
+ * seldom touch the entry and growing the table needn't rehash any name.
+ * The entries and names are allocated in the pool and never move, so the
+ * pointers returned by strhash_assign() stay valid until strhash_reset().
+ *
+ * The table is doubled when it becomes three quarters full.
+ */
+#define MINBUCKETS	16
+#define HASHBITS	32
+#define full(sh)	((sh)->entries * 4 >= (unsigned long)(sh)->buckets * 3)
+/*
+ * Fibonacci hashing: the upper bits of the product are used as the index,
+ * since the lower bits of __hash_string() depend mostly on the last
+ * characters (e.g. '.c' of path names).
+ */
+#define slotindex(sh, hash) \
+	(int)((((hash) * 2654435769UL) & 0xffffffffUL) >> (sh)->shift)
+
+/*
+ * alloc_slots: allocate empty slot table.
+ *
+ *	i)	sh	STRHASH structure
+ *	i)	buckets	number of slots (power of 2)
+ */
+static void
+alloc_slots(STRHASH *sh, int buckets)
+{
+	int bits = 0;
+
+	while ((1 << bits) < buckets)
+		bits++;
+	sh->htab = (struct sh_slot *)check_calloc(sizeof(struct sh_slot), buckets);
+	sh->buckets = buckets;
+	sh->shift = HASHBITS - bits;
+}
+/*
+ * grow: double the slot table.
+ *
+ *	i)	sh	STRHASH structure
+ */
+static void
+grow(STRHASH *sh)
+{
+	struct sh_slot *old = sh->htab;
+	int i, oldbuckets = sh->buckets;
+
+	alloc_slots(sh, oldbuckets * 2);
+	for (i = 0; i < oldbuckets; i++) {
+		int mask = sh->buckets - 1;
+		int n;
+
+		if (old[i].entry == NULL)
+			continue;
+		for (n = slotindex(sh, old[i].hash); sh->htab[n].entry; n = (n + 1) & mask)
+			;
+		sh->htab[n] = old[i];
+	}
+	free(old);
+}
 /*
  * strhash_open: open string hash table.
  *
- *	i)	buckets	 size of bucket table
+ *	i)	buckets	initial size of slot table
  *	r)	sh	STRHASH structure
+ *
+ * The table grows as needed, so buckets is only a hint.
  */
 STRHASH *
 strhash_open(int buckets)
 {
 	STRHASH *sh = (STRHASH *)check_calloc(sizeof(STRHASH), 1);
-	int i;
+	int size = MINBUCKETS;
 
-	sh->htab = (struct sh_head *)check_calloc(sizeof(struct sh_head), buckets);
-	for (i = 0; i < buckets; i++)
-		SLIST_INIT(&sh->htab[i]);
-	sh->buckets = buckets;
+	while (size < buckets)
+		size *= 2;
+	alloc_slots(sh, size);
 	sh->pool = pool_open();
 	sh->entries = 0;
 	return sh;
@@ -109,26 +171,37 @@ strhash_open(int buckets)
 struct sh_entry *
 strhash_assign(STRHASH *sh, const char *name, int force)
 {
-	struct sh_head *head = &sh->htab[__hash_string(name) % sh->buckets];
-	struct sh_entry *entry;
+	unsigned long hash = __hash_string(name);
+	int mask = sh->buckets - 1;
+	struct sh_slot *slot;
+	int n;
 
 	/*
 	 * Lookup the name's entry.
 	 */
-	SLIST_FOREACH(entry, head, ptr)
-		if (strcmp(entry->name, name) == 0)
-			break;
+	for (n = slotindex(sh, hash); sh->htab[n].entry; n = (n + 1) & mask) {
+		slot = &sh->htab[n];
+		if (slot->hash == hash && strcmp(slot->entry->name, name) == 0)
+			return slot->entry;
+	}
+	if (!force)
+		return NULL;
 	/*
 	 * If not found, allocate an entry.
 	 */
-	if (entry == NULL && force) {
-		entry = pool_malloc(sh->pool, sizeof(struct sh_entry));
-		entry->name = pool_strdup(sh->pool, name, 0);
-		entry->value = NULL;
-		SLIST_INSERT_HEAD(head, entry, ptr);
-		sh->entries++;
+	if (full(sh)) {
+		grow(sh);
+		mask = sh->buckets - 1;
+		for (n = slotindex(sh, hash); sh->htab[n].entry; n = (n + 1) & mask)
+			;
 	}
-	return entry;
+	slot = &sh->htab[n];
+	slot->hash = hash;
+	slot->entry = pool_malloc(sh->pool, sizeof(struct sh_entry));
+	slot->entry->name = pool_strdup(sh->pool, name, 0);
+	slot->entry->value = NULL;
+	sh->entries++;
+	return slot->entry;
 }
 /*
  * strhash_strdup: allocate memory and copy string.
@@ -153,48 +226,35 @@ struct sh_entry *
 strhash_first(STRHASH *sh)
 {
 	sh->cur_bucket = -1;		/* to start from index 0. */
-	sh->cur_entry = NULL;
 	return strhash_next(sh);
 }
 /*
  * strhash_next: get next entry
  *
  *	i)	sh	STRHASH structure
+ *
+ * Don't add entries while iterating, since it may rearrange the table.
  */
 struct sh_entry *
 strhash_next(STRHASH *sh)
 {
-	struct sh_entry *entry = NULL;
-
-	if (sh->buckets > 0 && sh->cur_bucket < sh->buckets) {
-		entry = sh->cur_entry;
-		if (entry == NULL) {
-			while (++sh->cur_bucket < sh->buckets) {
-				entry = SLIST_FIRST(&sh->htab[sh->cur_bucket]);
-				if (entry)
-					break;
-			}
-		}
-		sh->cur_entry = (entry) ? SLIST_NEXT(entry, ptr) : NULL;
-	}
-	return entry;
+	while (++sh->cur_bucket < sh->buckets)
+		if (sh->htab[sh->cur_bucket].entry)
+			return sh->htab[sh->cur_bucket].entry;
+	sh->cur_bucket = sh->buckets;
+	return NULL;
 }
 /*
  * strhash_reset: reset string hash.
  *
  *	i)	sh	STRHASH structure
+ *
+ * The slot table keeps its size for reuse.
  */
 void
 strhash_reset(STRHASH *sh)
 {
-	int i;
-
-	/*
-	 * Free and reinitialize entries for each bucket.
-	 */
-	for (i = 0; i < sh->buckets; i++) {
-		SLIST_INIT(&sh->htab[i]);
-	}
+	memset(sh->htab, 0, sizeof(struct sh_slot) * sh->buckets);
 	/*
 	 * Free all memory in sh->pool but leave it valid for further allocation.
 	 */
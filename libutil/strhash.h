@@ -20,25 +20,26 @@
 #define _STRHASH_H
 
 #include "pool.h"
-#include "queue.h"
 
 struct sh_entry {
-	SLIST_ENTRY(sh_entry) ptr;
 	char *name;			/* name:  hash key		*/
 	void *value;			/* value: user structure	*/
 };
 
-SLIST_HEAD(sh_head, sh_entry);
+struct sh_slot {
+	unsigned long hash;		/* hash value of the name	*/
+	struct sh_entry *entry;		/* entry (NULL: empty slot)	*/
+};
 
 typedef struct {
-	int buckets;			/* number of buckets		*/
-	struct sh_head *htab;		/* hash buckets			*/
+	int buckets;			/* number of slots (power of 2)	*/
+	int shift;			/* bits not used for slot index	*/
+	struct sh_slot *htab;		/* open addressing slot table	*/
 	POOL *pool;			/* memory pool			*/
 	unsigned long entries;		/* number of entries		*/
 	/*
 	 * iterator
 	 */
-	struct sh_entry *cur_entry;
 	int cur_bucket;
 } STRHASH;
 
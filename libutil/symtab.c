@@ -0,0 +1,362 @@
+/*
+ * Copyright (c) 2010 Tama Communications Corporation
+ *
+ * This file is part of GNU GLOBAL.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#include <stdlib.h>
+#ifdef HAVE_STRING_H
+#include <string.h>
+#else
+#include <strings.h>
+#endif
+
+#include "checkalloc.h"
+#include "die.h"
+#include "symtab.h"
+
+struct symtab_scope {
+	int level;			/* block level of the definition */
+	int lineno;			/* line number of the definition */
+	int index;			/* index of the definition */
+	int entered;			/* the block has been entered */
+};
+
+/*
+
+Symbol table of a file: usage
+
+symtab = symtab_open();
+
+symtab_put(symtab, SYMTAB_DEF, "main", 10, 0);	// register symbols.
+symtab_put(symtab, SYMTAB_REF, "exit", 11, 1);	// with block level.
+symtab_put(symtab, SYMTAB_REF, "printf", 12, 1);
+
+image = symtab_encode(symtab);			// encode.
+
+	image == "main\nexit\nprintf\n\nAT@BBABBB"
+
+symtab_decode(symtab, image);			// load the image.
+for (entry = symtab_first(symtab); entry; entry = symtab_next(symtab))
+	...					// entries in the order of registration.
+
+symtab_close(symtab);
+
+The image begins with the name table, which has each name of the file once
+in the order of appearance, and an empty line ends it. Since a name appears
+many times in a file, each entry refers to the name by the index in the table.
+
+Each entry follows as three numbers: <block level * 2 + (1 if definition)>,
+<line number delta> and <name index>. The delta is the difference from the
+line number of the previous entry. Since it can be negative, it is mapped to
+0, -1, 1, -2, 2 ... = 0, 1, 2, 3, 4 .... A number is written in base 32 from
+the highest digit: the last digit is '@' + digit and the others are
+' ' + digit, so that numbers less than 32 take only one character.
+The enclosing definitions are not written, since they are computed again
+from the block levels when the image is loaded.
+
+The enclosing definition of an entry is the last definition of lower block
+level which is not closed yet. For example, the references in the body of a
+C function are enclosed by the function. Until the block of a definition is
+entered, the references of the same level also belong to it (parameters of
+a Java method, initializer of a C variable on the same line). Entries whose
+block level is unknown should be registered with level 0.
+
+The entries keep the order of registration, that is, the order in which
+the parser found them. It is the order of line number in most cases, and
+'global -f' can reproduce the output of the parser exactly. Since a parser
+may go back, the delta can be negative.
+
+*/
+
+/*
+ * symtab_open: open symbol table.
+ *
+ *	r)		SYMTAB structure
+ */
+SYMTAB *
+symtab_open(void)
+{
+	SYMTAB *symtab = (SYMTAB *)check_calloc(sizeof(SYMTAB), 1);
+
+	symtab->vb = varray_open(sizeof(struct symtab_entry), 100);
+	symtab->pool = pool_open();
+	symtab->sb = strbuf_open(0);
+	symtab->names = strhash_open(256);
+	symtab->namevb = varray_open(sizeof(char *), 256);
+	symtab->stack = varray_open(sizeof(struct symtab_scope), 32);
+	return symtab;
+}
+/*
+ * put_entry: append an entry.
+ *
+ *	i)	symtab	SYMTAB structure
+ *	i)	type	SYMTAB_DEF or SYMTAB_REF
+ *	i)	name	tag name (kept in the pool)
+ *	i)	lineno	line number
+ *	i)	level	block level
+ */
+static void
+put_entry(SYMTAB *symtab, int type, const char *name, int lineno, int level)
+{
+	struct symtab_entry *entry;
+	struct symtab_scope *scope = NULL;
+	VARRAY *stack = symtab->stack;
+	int index = symtab->vb->length;
+
+	/*
+	 * Leave the definitions whose block has been closed.
+	 */
+	while (stack->length > 0) {
+		scope = varray_assign(stack, stack->length - 1, 0);
+		if (scope->level < level) {
+			scope->entered = 1;
+			break;
+		}
+		if (scope->level == level && !scope->entered && type != SYMTAB_DEF
+		    && (level > 0 || scope->lineno == lineno))
+			break;
+		stack->length--;
+		scope = NULL;
+	}
+	entry = varray_append(symtab->vb);
+	entry->type = type;
+	entry->lineno = lineno;
+	entry->name = name;
+	entry->level = level;
+	entry->scope = scope ? scope->index : -1;
+	if (type == SYMTAB_DEF) {
+		scope = varray_append(stack);
+		scope->level = level;
+		scope->lineno = lineno;
+		scope->index = index;
+		scope->entered = 0;
+	}
+}
+/*
+ * symtab_put: register a symbol.
+ *
+ *	i)	symtab	SYMTAB structure
+ *	i)	type	SYMTAB_DEF or SYMTAB_REF
+ *	i)	name	tag name
+ *	i)	lineno	line number
+ *	i)	level	block level
+ */
+void
+symtab_put(SYMTAB *symtab, int type, const char *name, int lineno, int level)
+{
+	put_entry(symtab, type, pool_strdup(symtab->pool, name, 0), lineno, level < 0 ? 0 : level);
+}
+/*
+ * putnum: put a number in the base 32 form.
+ *
+ *	o)	sb	STRBUF structure
+ *	i)	n	number (>= 0)
+ */
+static void
+putnum(STRBUF *sb, unsigned int n)
+{
+	char buf[8];
+	int i = sizeof(buf);
+
+	buf[--i] = '@' + (n & 31);
+	while ((n >>= 5) > 0)
+		buf[--i] = ' ' + (n & 31);
+	strbuf_nputs(sb, buf + i, sizeof(buf) - i);
+}
+/*
+ * getnum: get a number in the base 32 form.
+ *
+ *	io)	pp	pointer to the number, pointer to the next is returned
+ *	r)		number
+ */
+static int
+getnum(const char **pp)
+{
+	const unsigned char *p = (const unsigned char *)*pp;
+	unsigned int n = 0;
+
+	for (; *p >= ' ' && *p < '@'; p++)
+		n = (n << 5) | (*p - ' ');
+	if (*p < '@' || *p > '_')
+		die("illegal symbol table.");
+	n = (n << 5) | (*p++ - '@');
+	*pp = (const char *)p;
+	return (int)n;
+}
+/*
+ * symtab_get: get the entry by index.
+ *
+ *	i)	symtab	SYMTAB structure
+ *	i)	index	index of the entry
+ *	r)		entry (NULL: out of range)
+ */
+struct symtab_entry *
+symtab_get(SYMTAB *symtab, int index)
+{
+	if (index < 0 || index >= symtab->vb->length)
+		return NULL;
+	return varray_assign(symtab->vb, index, 0);
+}
+/*
+ * symtab_encode: make the image of the symbol table.
+ *
+ *	i)	symtab	SYMTAB structure
+ *	r)		image (valid until the next call)
+ */
+const char *
+symtab_encode(SYMTAB *symtab)
+{
+	struct symtab_entry *entry;
+	struct sh_entry *sh;
+	int last = 0, count = 0, delta;
+
+	strbuf_reset(symtab->sb);
+	strhash_reset(symtab->names);
+	/*
+	 * Name table.
+	 */
+	for (entry = symtab_first(symtab); entry; entry = symtab_next(symtab)) {
+		sh = strhash_assign(symtab->names, entry->name, 1);
+		if (sh->value == NULL) {
+			sh->value = pool_malloc(symtab->names->pool, sizeof(int));
+			*(int *)sh->value = count++;
+			strbuf_puts(symtab->sb, entry->name);
+			strbuf_putc(symtab->sb, '\n');
+		}
+	}
+	strbuf_putc(symtab->sb, '\n');
+	/*
+	 * Entries.
+	 */
+	for (entry = symtab_first(symtab); entry; entry = symtab_next(symtab)) {
+		putnum(symtab->sb, entry->level * 2 + (entry->type == SYMTAB_DEF));
+		delta = entry->lineno - last;
+		putnum(symtab->sb, delta < 0 ? -delta * 2 - 1 : delta * 2);
+		sh = strhash_assign(symtab->names, entry->name, 0);
+		putnum(symtab->sb, *(int *)sh->value);
+		last = entry->lineno;
+	}
+	return strbuf_value(symtab->sb);
+}
+/*
+ * symtab_decode: load the image of a symbol table.
+ *
+ *	i)	symtab	SYMTAB structure
+ *	i)	image	image made by symtab_encode()
+ *
+ * The entries loaded before are discarded.
+ */
+void
+symtab_decode(SYMTAB *symtab, const char *image)
+{
+	const char *p;
+	char **names, *q;
+	int last = 0, n, delta, name;
+
+	symtab_reset(symtab);
+	/*
+	 * Name table.
+	 */
+	p = image;
+	if (*p != '\n') {
+		const char *end = strstr(p, "\n\n");
+		char *tail;
+
+		if (end == NULL)
+			die("illegal symbol table.");
+		q = pool_malloc(symtab->pool, end - p + 1);
+		memcpy(q, p, end - p + 1);
+		for (tail = q + (end - p); q <= tail; q++) {
+			*(char **)varray_append(symtab->namevb) = q;
+			q = strchr(q, '\n');
+			*q = '\0';
+		}
+		p = end + 1;
+	}
+	p++;
+	names = varray_assign(symtab->namevb, 0, 0);
+	/*
+	 * Entries.
+	 */
+	while (*p) {
+		n = getnum(&p);
+		delta = getnum(&p);
+		last += (delta & 1) ? -(delta + 1) / 2 : delta / 2;
+		name = getnum(&p);
+		if (name >= symtab->namevb->length)
+			die("illegal symbol table.");
+		put_entry(symtab, (n & 1) ? SYMTAB_DEF : SYMTAB_REF, names[name], last, n / 2);
+	}
+}
+/*
+ * symtab_first: get the first entry
+ *
+ *	i)	symtab	SYMTAB structure
+ *	r)		entry (NULL: no entry)
+ */
+struct symtab_entry *
+symtab_first(SYMTAB *symtab)
+{
+	symtab->index = 0;
+	return symtab_next(symtab);
+}
+/*
+ * symtab_next: get the next entry
+ *
+ *	i)	symtab	SYMTAB structure
+ *	r)		entry (NULL: no more entry)
+ */
+struct symtab_entry *
+symtab_next(SYMTAB *symtab)
+{
+	if (symtab->index >= symtab->vb->length)
+		return NULL;
+	return varray_assign(symtab->vb, symtab->index++, 0);
+}
+/*
+ * symtab_reset: discard all entries.
+ *
+ *	i)	symtab	SYMTAB structure
+ */
+void
+symtab_reset(SYMTAB *symtab)
+{
+	varray_reset(symtab->vb);
+	pool_reset(symtab->pool);
+	varray_reset(symtab->namevb);
+	varray_reset(symtab->stack);
+	symtab->index = 0;
+}
+/*
+ * symtab_close: close symbol table.
+ *
+ *	i)	symtab	SYMTAB structure
+ */
+void
+symtab_close(SYMTAB *symtab)
+{
+	varray_close(symtab->vb);
+	pool_close(symtab->pool);
+	strbuf_close(symtab->sb);
+	strhash_close(symtab->names);
+	varray_close(symtab->namevb);
+	varray_close(symtab->stack);
+	free(symtab);
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2010 Tama Communications Corporation
+ *
+ * This file is part of GNU GLOBAL.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _SYMTAB_H
+#define _SYMTAB_H
+
+#include "pool.h"
+#include "strbuf.h"
+#include "strhash.h"
+#include "varray.h"
+
+#define SYMTAB_DEF	'D'		/* definition			*/
+#define SYMTAB_REF	'R'		/* reference or other symbol	*/
+
+struct symtab_entry {
+	int type;			/* SYMTAB_DEF or SYMTAB_REF	*/
+	int lineno;			/* line number			*/
+	const char *name;		/* tag name			*/
+	int level;			/* block level			*/
+	int scope;			/* index of the enclosing	*/
+					/* definition (-1: none)	*/
+};
+
+typedef struct {
+	VARRAY *vb;			/* entries			*/
+	POOL *pool;			/* names			*/
+	STRBUF *sb;			/* encoded image		*/
+	STRHASH *names;			/* name table for encoding	*/
+	VARRAY *namevb;			/* name table for decoding	*/
+	VARRAY *stack;			/* definitions being entered	*/
+	int index;			/* iterator			*/
+} SYMTAB;
+
+SYMTAB *symtab_open(void);
+void symtab_put(SYMTAB *, int, const char *, int, int);
+struct symtab_entry *symtab_get(SYMTAB *, int);
+const char *symtab_encode(SYMTAB *);
+void symtab_decode(SYMTAB *, const char *);
+struct symtab_entry *symtab_first(SYMTAB *);
+struct symtab_entry *symtab_next(SYMTAB *);
+void symtab_reset(SYMTAB *);
+void symtab_close(SYMTAB *);
+
+#endif /* ! _SYMTAB_H */